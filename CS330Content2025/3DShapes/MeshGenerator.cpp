@@ -0,0 +1,554 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerator.cpp
+// =================
+// generate the vertex and index data of the parameterized 3D primitives:
+//		cone, cylinder, sphere, torus
+//
+// The vertex layouts and orderings match the draw commands of ShapeMeshes.
+//
+// The sines and cosines around a ring are looked up in tables that are built
+// once per slice count, and the vertices of a ring are written four at a time
+// with the GLM SIMD functions.  They need GLM_FORCE_INTRINSICS, which the
+// projects define for every file, so GLM is configured the same way across
+// the program.  Without it the vertices are written one value at a time.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "meshgenerator.h"
+
+#include <glm/simd/common.h>
+#include <glm/simd/matrix.h>
+
+#include <algorithm> // Required for std::max
+#include <cmath>     // Required for std::sin and std::cos
+#include <map>
+#include <mutex>
+
+namespace
+{
+	constexpr float g_Pi = 3.14159265358979f;
+
+	// cosine, sine and fraction of every step around a ring
+	// of slices - the last step repeats the first angle so
+	// that seams close exactly, and the tables are padded to
+	// a multiple of four entries for the four lane writes
+	struct RING_TABLE
+	{
+		std::vector<float> cosines;
+		std::vector<float> sines;
+		std::vector<float> fractions;
+	};
+
+	///////////////////////////////////////////////////
+	//	GetRingTable()
+	//
+	//	Return the ring table for the passed in number of
+	//	slices, building it the first time it is needed.
+	///////////////////////////////////////////////////
+	const RING_TABLE& GetRingTable(int slices)
+	{
+		static std::map<int, RING_TABLE> s_ringTables;
+		static std::mutex s_ringTablesMutex;
+
+		std::lock_guard<std::mutex> lock(s_ringTablesMutex);
+
+		auto found = s_ringTables.find(slices);
+		if (found != s_ringTables.end())
+		{
+			return(found->second);
+		}
+
+		RING_TABLE& table = s_ringTables[slices];
+		size_t paddedCount = ((static_cast<size_t>(slices) + 1 + 3) / 4) * 4;
+		table.cosines.resize(paddedCount);
+		table.sines.resize(paddedCount);
+		table.fractions.resize(paddedCount);
+
+		float angleStep = 2.0f * g_Pi / slices;
+		for (size_t i = 0; i < paddedCount; ++i)
+		{
+			size_t step = (i == static_cast<size_t>(slices)) ? 0 : i;
+			table.cosines[i] = std::cos(step * angleStep);
+			table.sines[i] = std::sin(step * angleStep);
+			table.fractions[i] = static_cast<float>(i) / slices;
+		}
+		return(table);
+	}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	// four values of one vertex component
+	typedef glm_vec4 LANES;
+
+	inline LANES LoadLanes(const float* values) { return(_mm_loadu_ps(values)); }
+	inline LANES SplatLanes(float value) { return(_mm_set1_ps(value)); }
+	inline LANES AddLanes(LANES a, LANES b) { return(glm_vec4_add(a, b)); }
+	inline LANES SubLanes(LANES a, LANES b) { return(glm_vec4_sub(a, b)); }
+	inline LANES MulLanes(LANES a, LANES b) { return(glm_vec4_mul(a, b)); }
+
+	///////////////////////////////////////////////////
+	//	StoreVertices()
+	//
+	//	Transpose the eight components of four vertices
+	//	into interleaved vertices, and store the first
+	//	count of them stride vertices apart.
+	///////////////////////////////////////////////////
+	inline void StoreVertices(MeshGenerator::VERTEX* out, size_t stride, size_t count, const LANES components[8])
+	{
+		glm_vec4 first[4];
+		glm_vec4 second[4];
+		glm_mat4_transpose(components, first);
+		glm_mat4_transpose(components + 4, second);
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			float* vertex = reinterpret_cast<float*>(out + k * stride);
+			_mm_storeu_ps(vertex, first[k]);
+			_mm_storeu_ps(vertex + 4, second[k]);
+		}
+	}
+#else
+	// four values of one vertex component, for the platforms
+	// without a GLM SIMD path
+	struct LANES
+	{
+		float values[4];
+	};
+
+	inline LANES LoadLanes(const float* values) { return(LANES{ { values[0], values[1], values[2], values[3] } }); }
+	inline LANES SplatLanes(float value) { return(LANES{ { value, value, value, value } }); }
+	inline LANES AddLanes(LANES a, LANES b) { return(LANES{ { a.values[0] + b.values[0], a.values[1] + b.values[1], a.values[2] + b.values[2], a.values[3] + b.values[3] } }); }
+	inline LANES SubLanes(LANES a, LANES b) { return(LANES{ { a.values[0] - b.values[0], a.values[1] - b.values[1], a.values[2] - b.values[2], a.values[3] - b.values[3] } }); }
+	inline LANES MulLanes(LANES a, LANES b) { return(LANES{ { a.values[0] * b.values[0], a.values[1] * b.values[1], a.values[2] * b.values[2], a.values[3] * b.values[3] } }); }
+
+	inline void StoreVertices(MeshGenerator::VERTEX* out, size_t stride, size_t count, const LANES components[8])
+	{
+		for (size_t k = 0; k < count; ++k)
+		{
+			float* vertex = reinterpret_cast<float*>(out + k * stride);
+			for (int component = 0; component < 8; ++component)
+			{
+				vertex[component] = components[component].values[k];
+			}
+		}
+	}
+#endif
+
+	///////////////////////////////////////////////////
+	//	WriteVertex()
+	//
+	//	Store one interleaved vertex and return the
+	//	position after it.
+	///////////////////////////////////////////////////
+	inline MeshGenerator::VERTEX* WriteVertex(
+		MeshGenerator::VERTEX* out,
+		float x, float y, float z,
+		float nx, float ny, float nz,
+		float u, float v)
+	{
+		out->position = glm::vec3(x, y, z);
+		out->normal = glm::vec3(nx, ny, nz);
+		out->uv = glm::vec2(u, v);
+		return(out + 1);
+	}
+
+	///////////////////////////////////////////////////
+	//	WriteCircle()
+	//
+	//	Store the center and rim vertices of a flat
+	//	circle at the passed in height, facing up or down.
+	///////////////////////////////////////////////////
+	MeshGenerator::VERTEX* WriteCircle(
+		MeshGenerator::VERTEX* out,
+		float radius, float height, float normalY, int numSlices)
+	{
+		const RING_TABLE& ring = GetRingTable(numSlices);
+
+		// center vertex of the circle
+		out = WriteVertex(out, 0.0f, height, 0.0f, 0.0f, normalY, 0.0f, 0.5f, 0.5f);
+
+		const LANES radiusLanes = SplatLanes(radius);
+		const LANES half = SplatLanes(0.5f);
+		const LANES zero = SplatLanes(0.0f);
+		size_t count = static_cast<size_t>(numSlices) + 1;
+		for (size_t i = 0; i < count; i += 4)
+		{
+			LANES cosAngle = LoadLanes(&ring.cosines[i]);
+			LANES sinAngle = LoadLanes(&ring.sines[i]);
+
+			const LANES components[8] = {
+				MulLanes(radiusLanes, cosAngle), SplatLanes(height), MulLanes(radiusLanes, sinAngle),
+				zero, SplatLanes(normalY), zero,
+				AddLanes(half, MulLanes(half, cosAngle)), AddLanes(half, MulLanes(half, sinAngle)) };
+			StoreVertices(out + i, 1, std::min<size_t>(4, count - i), components);
+		}
+		return(out + count);
+	}
+
+	///////////////////////////////////////////////////
+	//	WriteSides()
+	//
+	//	Store the side vertices of a cone or cylinder as
+	//	pairs of bottom and top vertices for every slice.
+	///////////////////////////////////////////////////
+	MeshGenerator::VERTEX* WriteSides(
+		MeshGenerator::VERTEX* out,
+		float bottomRadius, float topRadius, float height,
+		float bottomV, float topV, int numSlices)
+	{
+		const RING_TABLE& ring = GetRingTable(numSlices);
+
+		const LANES bottomRadiusLanes = SplatLanes(bottomRadius);
+		const LANES topRadiusLanes = SplatLanes(topRadius);
+		const LANES zero = SplatLanes(0.0f);
+		size_t count = static_cast<size_t>(numSlices) + 1;
+		for (size_t i = 0; i < count; i += 4)
+		{
+			LANES nx = LoadLanes(&ring.cosines[i]);
+			LANES nz = LoadLanes(&ring.sines[i]);
+			LANES u = LoadLanes(&ring.fractions[i]);
+			size_t lanes = std::min<size_t>(4, count - i);
+
+			const LANES bottom[8] = {
+				MulLanes(bottomRadiusLanes, nx), zero, MulLanes(bottomRadiusLanes, nz),
+				nx, zero, nz,
+				u, SplatLanes(bottomV) };
+			StoreVertices(out + 2 * i, 2, lanes, bottom);
+
+			const LANES top[8] = {
+				MulLanes(topRadiusLanes, nx), SplatLanes(height), MulLanes(topRadiusLanes, nz),
+				nx, zero, nz,
+				u, SplatLanes(topV) };
+			StoreVertices(out + 2 * i + 1, 2, lanes, top);
+		}
+		return(out + 2 * count);
+	}
+}
+
+namespace MeshGenerator
+{
+	///////////////////////////////////////////////////
+	//	Get...Count()
+	//
+	//	Return the number of vertices or indices that
+	//	the generator of a shape writes.
+	///////////////////////////////////////////////////
+	size_t GetConeVertexCount(int numSlices)
+	{
+		// bottom center and rim, then a bottom and apex
+		// vertex for every side slice
+		return(1 + 3 * (static_cast<size_t>(numSlices) + 1));
+	}
+
+	size_t GetCylinderVertexCount(int numSlices)
+	{
+		// bottom and top circles, then a bottom and top
+		// vertex for every side slice
+		return(2 + 4 * (static_cast<size_t>(numSlices) + 1));
+	}
+
+	size_t GetSphereVertexCount(int latitudeSegments, int longitudeSegments)
+	{
+		return((static_cast<size_t>(latitudeSegments) + 1) * (static_cast<size_t>(longitudeSegments) + 1));
+	}
+
+	size_t GetSphereIndexCount(int latitudeSegments, int longitudeSegments)
+	{
+		return(6 * static_cast<size_t>(latitudeSegments) * static_cast<size_t>(longitudeSegments));
+	}
+
+	size_t GetTorusVertexCount(int mainSegments, int tubeSegments)
+	{
+		return((static_cast<size_t>(mainSegments) + 1) * (static_cast<size_t>(tubeSegments) + 1));
+	}
+
+	size_t GetTorusIndexCount(int mainSegments, int tubeSegments)
+	{
+		return(6 * static_cast<size_t>(mainSegments) * static_cast<size_t>(tubeSegments));
+	}
+
+	size_t GetExtraTorusVertexCount(int mainSegments, int tubeSegments)
+	{
+		// seven vertices are written for every segment quad
+		return(7 * static_cast<size_t>(mainSegments) * static_cast<size_t>(tubeSegments));
+	}
+
+	///////////////////////////////////////////////////
+	//	WriteCone()
+	//
+	//	Write the cone vertices - drawn as a triangle fan
+	//	for the bottom followed by a triangle strip for
+	//	the sides.
+	///////////////////////////////////////////////////
+	void WriteCone(float radius, float height, int numSlices, VERTEX* vertices)
+	{
+		VERTEX* out = WriteCircle(vertices, radius, 0.0f, -1.0f, numSlices);
+		WriteSides(out, radius, 0.0f, height, 1.0f, 0.0f, numSlices);
+	}
+
+	///////////////////////////////////////////////////
+	//	WriteCylinder()
+	//
+	//	Write the cylinder vertices - drawn as triangle
+	//	fans for the bottom and top followed by a
+	//	triangle strip for the sides.
+	///////////////////////////////////////////////////
+	void WriteCylinder(float radius, float height, int numSlices, VERTEX* vertices)
+	{
+		VERTEX* out = WriteCircle(vertices, radius, 0.0f, -1.0f, numSlices);
+		out = WriteCircle(out, radius, height, 1.0f, numSlices);
+		WriteSides(out, radius, radius, height, 0.0f, 1.0f, numSlices);
+	}
+
+	///////////////////////////////////////////////////
+	//	WriteSphere()
+	//
+	//	Write the sphere vertices, one row for every
+	//	latitude, and the indices of its triangles.
+	///////////////////////////////////////////////////
+	void WriteSphere(int latitudeSegments, int longitudeSegments, float radius, VERTEX* vertices, unsigned int* indices)
+	{
+		// the latitudes are the first half of a ring with
+		// twice as many slices
+		const RING_TABLE& latitudes = GetRingTable(2 * latitudeSegments);
+		const RING_TABLE& longitudes = GetRingTable(longitudeSegments);
+
+		const LANES radiusLanes = SplatLanes(radius);
+		const LANES one = SplatLanes(1.0f);
+		size_t rowCount = static_cast<size_t>(longitudeSegments) + 1;
+
+		VERTEX* out = vertices;
+		for (int lat = 0; lat <= latitudeSegments; ++lat)
+		{
+			// the poles sit exactly on the axis
+			float sinTheta = ((lat == 0) || (lat == latitudeSegments)) ? 0.0f : latitudes.sines[lat];
+			float cosTheta = latitudes.cosines[lat];
+			float v = 1.0f - latitudes.fractions[2 * lat];
+
+			const LANES sinThetaLanes = SplatLanes(sinTheta);
+			const LANES ny = SplatLanes(cosTheta);
+			const LANES vLanes = SplatLanes(v);
+			for (size_t lon = 0; lon < rowCount; lon += 4)
+			{
+				LANES nx = MulLanes(sinThetaLanes, LoadLanes(&longitudes.cosines[lon]));
+				LANES nz = MulLanes(sinThetaLanes, LoadLanes(&longitudes.sines[lon]));
+
+				const LANES components[8] = {
+					MulLanes(radiusLanes, nx), MulLanes(radiusLanes, ny), MulLanes(radiusLanes, nz),
+					nx, ny, nz,
+					SubLanes(one, LoadLanes(&longitudes.fractions[lon])), vLanes };
+				StoreVertices(out + lon, 1, std::min<size_t>(4, rowCount - lon), components);
+			}
+			out += rowCount;
+		}
+
+		unsigned int* index = indices;
+		for (int lat = 0; lat < latitudeSegments; ++lat)
+		{
+			for (int lon = 0; lon < longitudeSegments; ++lon)
+			{
+				unsigned int first = lat * (longitudeSegments + 1) + lon;
+				unsigned int second = first + longitudeSegments + 1;
+
+				// two triangles for each quad of the grid
+				index[0] = first;
+				index[1] = second;
+				index[2] = first + 1;
+				index[3] = second;
+				index[4] = second + 1;
+				index[5] = first + 1;
+				index += 6;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	WriteTorus()
+	//
+	//	Write the torus vertices, one ring for every main
+	//	segment, and the indices of its triangles.
+	///////////////////////////////////////////////////
+	void WriteTorus(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments, VERTEX* vertices, unsigned int* indices)
+	{
+		const RING_TABLE& mainRing = GetRingTable(mainSegments);
+		const RING_TABLE& tubeRing = GetRingTable(tubeSegments);
+
+		const LANES mainRadiusLanes = SplatLanes(mainRadius);
+		const LANES tubeRadiusLanes = SplatLanes(tubeRadius);
+		size_t ringCount = static_cast<size_t>(tubeSegments) + 1;
+
+		VERTEX* out = vertices;
+		for (int i = 0; i <= mainSegments; ++i)
+		{
+			const LANES cosMain = SplatLanes(mainRing.cosines[i]);
+			const LANES sinMain = SplatLanes(mainRing.sines[i]);
+			const LANES u = SplatLanes(mainRing.fractions[i]);
+
+			for (size_t j = 0; j < ringCount; j += 4)
+			{
+				LANES cosTube = LoadLanes(&tubeRing.cosines[j]);
+				LANES sinTube = LoadLanes(&tubeRing.sines[j]);
+				LANES ringRadius = AddLanes(mainRadiusLanes, MulLanes(tubeRadiusLanes, cosTube));
+
+				// the normal points away from the center of the tube
+				const LANES components[8] = {
+					MulLanes(ringRadius, cosMain), MulLanes(ringRadius, sinMain), MulLanes(tubeRadiusLanes, sinTube),
+					MulLanes(cosTube, cosMain), MulLanes(cosTube, sinMain), sinTube,
+					u, LoadLanes(&tubeRing.fractions[j]) };
+				StoreVertices(out + j, 1, std::min<size_t>(4, ringCount - j), components);
+			}
+			out += ringCount;
+		}
+
+		unsigned int* index = indices;
+		for (int i = 0; i < mainSegments; ++i)
+		{
+			for (int j = 0; j < tubeSegments; ++j)
+			{
+				unsigned int current = i * (tubeSegments + 1) + j;
+				unsigned int next = (i + 1) * (tubeSegments + 1) + j;
+
+				// two triangles for each quad of the grid
+				index[0] = current;
+				index[1] = next;
+				index[2] = current + 1;
+				index[3] = current + 1;
+				index[4] = next;
+				index[5] = next + 1;
+				index += 6;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	WriteExtraTorus()
+	//
+	//	Write the vertices of the extra torus meshes -
+	//	seven vertices are written for every quad between
+	//	neighbouring segments, with the last segments
+	//	wrapping around to the first, and the normals
+	//	point away from the center of the torus.
+	//
+	//	The vertices are copies of the four corners of
+	//	each quad, so they are written one at a time.
+	///////////////////////////////////////////////////
+	void WriteExtraTorus(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments, VERTEX* vertices)
+	{
+		const RING_TABLE& mainRing = GetRingTable(mainSegments);
+		const RING_TABLE& tubeRing = GetRingTable(tubeSegments);
+		float horizontalStep = 1.0f / mainSegments;
+		float verticalStep = 1.0f / tubeSegments;
+
+		// the last entries of the ring tables repeat the first
+		// angle, so the corners of the last quads wrap around
+		auto surfacePosition = [&](int i, int j)
+		{
+			float ringRadius = mainRadius + tubeRadius * tubeRing.cosines[j];
+			return(glm::vec3(
+				ringRadius * mainRing.cosines[i],
+				ringRadius * mainRing.sines[i],
+				tubeRadius * tubeRing.sines[j]));
+		};
+
+		VERTEX* out = vertices;
+		for (int i = 0; i < mainSegments; i++)
+		{
+			bool bLastI = ((i + 1) == mainSegments);
+			float u = i * horizontalStep;
+			float nextU = bLastI ? 0.0f : u + horizontalStep;
+
+			for (int j = 0; j < tubeSegments; j++)
+			{
+				bool bLastJ = ((j + 1) == tubeSegments);
+				float v = j * verticalStep;
+				float nextV = bLastJ ? 0.0f : v + verticalStep;
+
+				VERTEX p00 = { surfacePosition(i, j), glm::vec3(0.0f), glm::vec2(u, v) };
+				VERTEX p01 = { surfacePosition(i, j + 1), glm::vec3(0.0f), glm::vec2(u, nextV) };
+				VERTEX p10 = { surfacePosition(i + 1, j), glm::vec3(0.0f), glm::vec2(nextU, v) };
+				VERTEX p11 = { surfacePosition(i + 1, j + 1), glm::vec3(0.0f), glm::vec2(nextU, nextV) };
+				p00.normal = glm::normalize(p00.position);
+				p01.normal = glm::normalize(p01.position);
+				p10.normal = glm::normalize(p10.position);
+				p11.normal = glm::normalize(p11.position);
+
+				// quads that do not wrap around have always used
+				// a lower texture coordinate for their sixth vertex
+				VERTEX sixth = p11;
+				if (!bLastI && !bLastJ)
+				{
+					sixth.uv.y = v - verticalStep;
+				}
+
+				out[0] = p00;
+				out[1] = p01;
+				out[2] = p11;
+				out[3] = p00;
+				out[4] = p10;
+				out[5] = sixth;
+				out[6] = p00;
+				out += 7;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	Generate...()
+	//
+	//	Size the passed in mesh data for a shape and
+	//	write the shape into it.
+	///////////////////////////////////////////////////
+	void GenerateCone(MESH_DATA& mesh, float radius, float height, int numSlices)
+	{
+		numSlices = std::max(3, numSlices);
+
+		mesh.vertices.resize(GetConeVertexCount(numSlices));
+		mesh.indices.clear();
+		WriteCone(radius, height, numSlices, mesh.vertices.data());
+	}
+
+	void GenerateCylinder(MESH_DATA& mesh, float radius, float height, int numSlices)
+	{
+		numSlices = std::max(3, numSlices);
+
+		mesh.vertices.resize(GetCylinderVertexCount(numSlices));
+		mesh.indices.clear();
+		WriteCylinder(radius, height, numSlices, mesh.vertices.data());
+	}
+
+	void GenerateSphere(MESH_DATA& mesh, int latitudeSegments, int longitudeSegments, float radius)
+	{
+		latitudeSegments = std::max(2, latitudeSegments);
+		longitudeSegments = std::max(3, longitudeSegments);
+
+		mesh.vertices.resize(GetSphereVertexCount(latitudeSegments, longitudeSegments));
+		mesh.indices.resize(GetSphereIndexCount(latitudeSegments, longitudeSegments));
+		WriteSphere(latitudeSegments, longitudeSegments, radius, mesh.vertices.data(), mesh.indices.data());
+	}
+
+	void GenerateTorus(MESH_DATA& mesh, float mainRadius, float tubeRadius, int mainSegments, int tubeSegments)
+	{
+		mainSegments = std::max(3, mainSegments);
+		tubeSegments = std::max(3, tubeSegments);
+		tubeRadius = std::max(0.01f, tubeRadius);
+
+		mesh.vertices.resize(GetTorusVertexCount(mainSegments, tubeSegments));
+		mesh.indices.resize(GetTorusIndexCount(mainSegments, tubeSegments));
+		WriteTorus(mainRadius, tubeRadius, mainSegments, tubeSegments, mesh.vertices.data(), mesh.indices.data());
+	}
+
+	void GenerateExtraTorus(MESH_DATA& mesh, float thickness, int mainSegments, int tubeSegments)
+	{
+		mainSegments = std::max(3, mainSegments);
+		tubeSegments = std::max(3, tubeSegments);
+
+		// thicknesses above the main radius keep the thin tube
+		float tubeRadius = 0.1f;
+		if (thickness <= 1.0f)
+		{
+			tubeRadius = thickness;
+		}
+
+		mesh.vertices.resize(GetExtraTorusVertexCount(mainSegments, tubeSegments));
+		mesh.indices.clear();
+		WriteExtraTorus(1.0f, tubeRadius, mainSegments, tubeSegments, mesh.vertices.data());
+	}
+}
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerator.h
+// ===============
+// generate the vertex and index data of the parameterized 3D primitives:
+//     cone, cylinder, sphere, torus
+//
+// The generators do not use OpenGL, so meshes of any tessellation can be
+// built and checked on the CPU without a rendering context.  Each generator
+// sizes its output once and writes every vertex in place, so regenerating a
+// mesh into the same MESH_DATA does not allocate unless the mesh grows.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace MeshGenerator
+{
+	// one interleaved vertex, laid out to match the position,
+	// normal and texture coordinate attributes of the meshes
+	struct VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// the generated vertices and indices of one mesh - the
+	// indices are empty for meshes drawn without indexing
+	struct MESH_DATA
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	// number of vertices and indices written by the generators
+	size_t GetConeVertexCount(int numSlices);
+	size_t GetCylinderVertexCount(int numSlices);
+	size_t GetSphereVertexCount(int latitudeSegments, int longitudeSegments);
+	size_t GetSphereIndexCount(int latitudeSegments, int longitudeSegments);
+	size_t GetTorusVertexCount(int mainSegments, int tubeSegments);
+	size_t GetTorusIndexCount(int mainSegments, int tubeSegments);
+	size_t GetExtraTorusVertexCount(int mainSegments, int tubeSegments);
+
+	// methods for writing the mesh data into output spans that
+	// already hold the number of vertices and indices above
+	void WriteCone(float radius, float height, int numSlices, VERTEX* vertices);
+	void WriteCylinder(float radius, float height, int numSlices, VERTEX* vertices);
+	void WriteSphere(int latitudeSegments, int longitudeSegments, float radius, VERTEX* vertices, unsigned int* indices);
+	void WriteTorus(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments, VERTEX* vertices, unsigned int* indices);
+	void WriteExtraTorus(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments, VERTEX* vertices);
+
+	// methods for sizing the passed in mesh data and generating
+	// the mesh into it - the parameters are clamped to the
+	// smallest tessellation that forms a closed shape
+	void GenerateCone(MESH_DATA& mesh, float radius = 1.0f, float height = 1.0f, int numSlices = 36);
+	void GenerateCylinder(MESH_DATA& mesh, float radius = 1.0f, float height = 1.0f, int numSlices = 36);
+	void GenerateSphere(MESH_DATA& mesh, int latitudeSegments = 16, int longitudeSegments = 16, float radius = 1.0f);
+	void GenerateTorus(MESH_DATA& mesh, float mainRadius = 1.0f, float tubeRadius = 0.3f, int mainSegments = 30, int tubeSegments = 30);
+	void GenerateExtraTorus(MESH_DATA& mesh, float thickness, int mainSegments = 30, int tubeSegments = 30);
+}
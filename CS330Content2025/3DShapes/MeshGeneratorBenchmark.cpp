@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgeneratorbenchmark.cpp
+// ==========================
+// measure the time the mesh generators take per generated vertex
+//
+// The benchmark is run by the 1-2 sample with --bench-meshes.  It does not
+// need OpenGL, so it can also be built on its own from the mesh generator
+// and GLM, with a main() of its own, for example:
+//
+//     g++ -O2 -std=c++17 -DGLM_FORCE_INTRINSICS -DMESH_GENERATOR_BENCHMARK_MAIN -I../Libraries/glm MeshGenerator.cpp MeshGeneratorBenchmark.cpp
+//     cl /O2 /EHsc /std:c++17 /DGLM_FORCE_INTRINSICS /DMESH_GENERATOR_BENCHMARK_MAIN /I..\Libraries\glm MeshGenerator.cpp MeshGeneratorBenchmark.cpp
+//
+// Each shape is generated repeatedly into the same mesh data, the way the
+// loaders reuse it, and the fastest run is reported.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshGeneratorBenchmark.h"
+
+#include "meshgenerator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	// number of timed runs for every shape
+	const int g_RunCount = 20;
+
+	///////////////////////////////////////////////////
+	//	BenchmarkShape()
+	//
+	//	Generate a shape repeatedly and print the time
+	//	of the fastest run per generated vertex.
+	///////////////////////////////////////////////////
+	void BenchmarkShape(
+		const char* name,
+		MeshGenerator::MESH_DATA& mesh,
+		const std::function<void(MeshGenerator::MESH_DATA&)>& generate)
+	{
+		// the first run sizes the mesh data
+		generate(mesh);
+
+		double bestSeconds = 0.0;
+		for (int run = 0; run < g_RunCount; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			generate(mesh);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			if ((run == 0) || (elapsed.count() < bestSeconds))
+			{
+				bestSeconds = elapsed.count();
+			}
+		}
+
+		double nanosecondsPerVertex = (bestSeconds * 1.0e9) / mesh.vertices.size();
+		std::cout << std::left << std::setw(20) << name
+			<< std::right << std::setw(10) << mesh.vertices.size() << " vertices "
+			<< std::setw(10) << mesh.indices.size() << " indices "
+			<< std::fixed << std::setprecision(3)
+			<< std::setw(10) << (bestSeconds * 1000.0) << " ms "
+			<< std::setw(8) << nanosecondsPerVertex << " ns/vertex" << std::endl;
+	}
+}
+
+///////////////////////////////////////////////////
+//	MeshGeneratorBenchmark::Run()
+//
+//	Time the generation of every shape, from a few
+//	segments to a few thousand.
+///////////////////////////////////////////////////
+void MeshGeneratorBenchmark::Run()
+{
+	MeshGenerator::MESH_DATA mesh;
+
+	BenchmarkShape("cone 4096", mesh, [](MeshGenerator::MESH_DATA& data)
+		{ MeshGenerator::GenerateCone(data, 1.0f, 1.0f, 4096); });
+	BenchmarkShape("cylinder 4096", mesh, [](MeshGenerator::MESH_DATA& data)
+		{ MeshGenerator::GenerateCylinder(data, 1.0f, 1.0f, 4096); });
+	BenchmarkShape("sphere 16x16", mesh, [](MeshGenerator::MESH_DATA& data)
+		{ MeshGenerator::GenerateSphere(data, 16, 16, 1.0f); });
+	BenchmarkShape("sphere 512x512", mesh, [](MeshGenerator::MESH_DATA& data)
+		{ MeshGenerator::GenerateSphere(data, 512, 512, 1.0f); });
+	BenchmarkShape("torus 30x30", mesh, [](MeshGenerator::MESH_DATA& data)
+		{ MeshGenerator::GenerateTorus(data, 1.0f, 0.3f, 30, 30); });
+	BenchmarkShape("torus 512x512", mesh, [](MeshGenerator::MESH_DATA& data)
+		{ MeshGenerator::GenerateTorus(data, 1.0f, 0.3f, 512, 512); });
+	BenchmarkShape("extra torus 30x30", mesh, [](MeshGenerator::MESH_DATA& data)
+		{ MeshGenerator::GenerateExtraTorus(data, 0.4f, 30, 30); });
+}
+
+#ifdef MESH_GENERATOR_BENCHMARK_MAIN
+/***********************************************************
+ *  main()
+ *
+ *  Run the mesh generator benchmark when it is built on its
+ *  own.
+ ***********************************************************/
+int main()
+{
+	MeshGeneratorBenchmark::Run();
+
+	exit(EXIT_SUCCESS);
+}
+#endif
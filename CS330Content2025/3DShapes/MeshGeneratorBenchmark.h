@@ -0,0 +1,17 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgeneratorbenchmark.h
+// ========================
+// measure the time the mesh generators take per generated vertex
+//
+// Each shape is generated repeatedly into the same mesh data, the way the
+// loaders reuse it, and the fastest run is printed.  The benchmark makes no
+// GL calls, so it runs without a window or a GL context.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace MeshGeneratorBenchmark
+{
+	// time the generation of every shape and print the results
+	void Run();
+}
@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgeneratortests.cpp
+// ======================
+// check the meshes that the mesh generators write
+//
+// The generators do not need OpenGL, so the checks are built on their own
+// from the mesh generator and GLM, without a window or a GL context:
+//
+//     g++ -O2 -std=c++17 -DGLM_FORCE_INTRINSICS -I../Libraries/glm MeshGenerator.cpp MeshGeneratorTests.cpp
+//     cl /O2 /EHsc /std:c++17 /DGLM_FORCE_INTRINSICS /I..\Libraries\glm MeshGenerator.cpp MeshGeneratorTests.cpp
+//
+// For a few tessellations of every shape, the number of vertices and
+// indices is checked against the tessellation, the vertices on the seams
+// where the texture wraps around are checked to be duplicated, and every
+// normal is checked to be of unit length and every texture coordinate to be
+// within [0,1].  The program exits with a failure when any check fails.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "meshgenerator.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+	// tolerance of the positions, normals and texture coordinates
+	const float g_Tolerance = 1.0e-4f;
+
+	// number of checks that failed
+	int g_FailedCount = 0;
+
+	///////////////////////////////////////////////////
+	//	Check()
+	//
+	//	Count and print a check that failed.
+	///////////////////////////////////////////////////
+	void Check(bool bPassed, const std::string& name, const std::string& what)
+	{
+		if (false == bPassed)
+		{
+			std::cout << "FAILED: " << name << ": " << what << std::endl;
+			g_FailedCount++;
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	IsNear()
+	//
+	//	Return true when two vectors are equal within
+	//	the tolerance.
+	///////////////////////////////////////////////////
+	template <typename VECTOR>
+	bool IsNear(const VECTOR& a, const VECTOR& b)
+	{
+		for (int i = 0; i < a.length(); i++)
+		{
+			if (std::fabs(a[i] - b[i]) > g_Tolerance)
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	///////////////////////////////////////////////////
+	//	CheckCounts()
+	//
+	//	Check the number of vertices and indices of a
+	//	mesh, and that every index is a vertex.
+	///////////////////////////////////////////////////
+	void CheckCounts(const std::string& name, const MeshGenerator::MESH_DATA& mesh,
+		size_t vertexCount, size_t indexCount)
+	{
+		Check(mesh.vertices.size() == vertexCount, name,
+			std::to_string(mesh.vertices.size()) + " vertices, expected " + std::to_string(vertexCount));
+		Check(mesh.indices.size() == indexCount, name,
+			std::to_string(mesh.indices.size()) + " indices, expected " + std::to_string(indexCount));
+
+		bool bInRange = true;
+		for (unsigned int index : mesh.indices)
+		{
+			bInRange = bInRange && (index < mesh.vertices.size());
+		}
+		Check(bInRange, name, "an index is not a vertex");
+	}
+
+	///////////////////////////////////////////////////
+	//	CheckVertices()
+	//
+	//	Check that every normal is of unit length and
+	//	every texture coordinate is within [0,1].
+	///////////////////////////////////////////////////
+	void CheckVertices(const std::string& name, const MeshGenerator::MESH_DATA& mesh)
+	{
+		bool bUnitNormals = true;
+		bool bUVsInRange = true;
+		for (const MeshGenerator::VERTEX& vertex : mesh.vertices)
+		{
+			bUnitNormals = bUnitNormals && (std::fabs(glm::length(vertex.normal) - 1.0f) <= g_Tolerance);
+			bUVsInRange = bUVsInRange &&
+				(vertex.uv.x >= 0.0f) && (vertex.uv.x <= 1.0f) &&
+				(vertex.uv.y >= 0.0f) && (vertex.uv.y <= 1.0f);
+		}
+		Check(bUnitNormals, name, "a normal is not of unit length");
+		Check(bUVsInRange, name, "a texture coordinate is not within [0,1]");
+	}
+
+	///////////////////////////////////////////////////
+	//	CheckSeam()
+	//
+	//	Check that the first and last vertex of a ring
+	//	are the same point with the same normal, and
+	//	that the texture wraps from one side to the
+	//	other between them, or for a component of -1,
+	//	that they have the same texture coordinate.
+	///////////////////////////////////////////////////
+	void CheckSeam(const std::string& name, const MeshGenerator::MESH_DATA& mesh,
+		size_t first, size_t last, int uvComponent)
+	{
+		const MeshGenerator::VERTEX& a = mesh.vertices[first];
+		const MeshGenerator::VERTEX& b = mesh.vertices[last];
+
+		bool bWrapped = (uvComponent < 0) ? IsNear(a.uv, b.uv) :
+			(std::fabs(std::fabs(a.uv[uvComponent] - b.uv[uvComponent]) - 1.0f) <= g_Tolerance);
+		bool bDuplicated = IsNear(a.position, b.position) && IsNear(a.normal, b.normal) && bWrapped;
+		Check(bDuplicated, name, "the seam vertices " + std::to_string(first) + " and " +
+			std::to_string(last) + " are not duplicated");
+	}
+
+	///////////////////////////////////////////////////
+	//	CheckCone()
+	//
+	//	Check a cone - the bottom circle, whose texture
+	//	does not wrap around, then a bottom and apex
+	//	vertex for every side slice.
+	///////////////////////////////////////////////////
+	void CheckCone(int numSlices)
+	{
+		std::string name = "cone " + std::to_string(numSlices);
+		MeshGenerator::MESH_DATA mesh;
+		MeshGenerator::GenerateCone(mesh, 1.0f, 2.0f, numSlices);
+
+		size_t rimCount = static_cast<size_t>(numSlices) + 1;
+		CheckCounts(name, mesh, 1 + 3 * rimCount, 0);
+		CheckVertices(name, mesh);
+		CheckSeam(name, mesh, 1, rimCount, -1);
+		CheckSeam(name, mesh, 1 + rimCount, 1 + rimCount + 2 * numSlices, 0);
+		Check(IsNear(mesh.vertices[1 + rimCount + 1].position, glm::vec3(0.0f, 2.0f, 0.0f)), name,
+			"the side does not end at the apex");
+	}
+
+	///////////////////////////////////////////////////
+	//	CheckCylinder()
+	//
+	//	Check a cylinder - the bottom and top circles,
+	//	then a bottom and top vertex for every slice.
+	///////////////////////////////////////////////////
+	void CheckCylinder(int numSlices)
+	{
+		std::string name = "cylinder " + std::to_string(numSlices);
+		MeshGenerator::MESH_DATA mesh;
+		MeshGenerator::GenerateCylinder(mesh, 1.0f, 2.0f, numSlices);
+
+		size_t rimCount = static_cast<size_t>(numSlices) + 1;
+		size_t sideStart = 2 * (1 + rimCount);
+		CheckCounts(name, mesh, 2 + 4 * rimCount, 0);
+		CheckVertices(name, mesh);
+		CheckSeam(name, mesh, 1, rimCount, -1);
+		CheckSeam(name, mesh, 2 + rimCount, 1 + 2 * rimCount, -1);
+		CheckSeam(name, mesh, sideStart, sideStart + 2 * numSlices, 0);
+		CheckSeam(name, mesh, sideStart + 1, sideStart + 2 * numSlices + 1, 0);
+	}
+
+	///////////////////////////////////////////////////
+	//	CheckSphere()
+	//
+	//	Check a sphere - a row of vertices for every
+	//	latitude, with the first and last vertex of a
+	//	row on the seam, and the first and last rows on
+	//	the poles.
+	///////////////////////////////////////////////////
+	void CheckSphere(int latitudeSegments, int longitudeSegments)
+	{
+		std::string name = "sphere " + std::to_string(latitudeSegments) + "x" + std::to_string(longitudeSegments);
+		MeshGenerator::MESH_DATA mesh;
+		MeshGenerator::GenerateSphere(mesh, latitudeSegments, longitudeSegments, 1.5f);
+
+		size_t rowCount = static_cast<size_t>(longitudeSegments) + 1;
+		CheckCounts(name, mesh, (static_cast<size_t>(latitudeSegments) + 1) * rowCount,
+			6 * static_cast<size_t>(latitudeSegments) * longitudeSegments);
+		CheckVertices(name, mesh);
+
+		bool bOnSphere = true;
+		for (const MeshGenerator::VERTEX& vertex : mesh.vertices)
+		{
+			bOnSphere = bOnSphere && (std::fabs(glm::length(vertex.position) - 1.5f) <= g_Tolerance);
+		}
+		Check(bOnSphere, name, "a vertex is not on the sphere");
+
+		for (int lat = 1; lat < latitudeSegments; lat++)
+		{
+			CheckSeam(name, mesh, lat * rowCount, lat * rowCount + longitudeSegments, 0);
+		}
+		Check(IsNear(mesh.vertices.front().position, glm::vec3(0.0f, 1.5f, 0.0f)) &&
+			IsNear(mesh.vertices.back().position, glm::vec3(0.0f, -1.5f, 0.0f)), name,
+			"the first and last rows are not on the poles");
+	}
+
+	///////////////////////////////////////////////////
+	//	CheckTorus()
+	//
+	//	Check a torus - a ring of vertices for every main
+	//	segment, with seams around the tube and around
+	//	the main ring.
+	///////////////////////////////////////////////////
+	void CheckTorus(int mainSegments, int tubeSegments)
+	{
+		std::string name = "torus " + std::to_string(mainSegments) + "x" + std::to_string(tubeSegments);
+		MeshGenerator::MESH_DATA mesh;
+		MeshGenerator::GenerateTorus(mesh, 1.0f, 0.3f, mainSegments, tubeSegments);
+
+		size_t ringCount = static_cast<size_t>(tubeSegments) + 1;
+		CheckCounts(name, mesh, (static_cast<size_t>(mainSegments) + 1) * ringCount,
+			6 * static_cast<size_t>(mainSegments) * tubeSegments);
+		CheckVertices(name, mesh);
+
+		for (int i = 0; i <= mainSegments; i++)
+		{
+			CheckSeam(name, mesh, i * ringCount, i * ringCount + tubeSegments, 1);
+		}
+		for (int j = 0; j <= tubeSegments; j++)
+		{
+			CheckSeam(name, mesh, j, mainSegments * ringCount + j, 0);
+		}
+	}
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  Run the mesh generator checks.
+ ***********************************************************/
+int main()
+{
+	CheckCone(3);
+	CheckCone(36);
+	CheckCone(101);
+	CheckCylinder(3);
+	CheckCylinder(36);
+	CheckCylinder(101);
+	CheckSphere(2, 3);
+	CheckSphere(16, 16);
+	CheckSphere(17, 23);
+	CheckSphere(512, 512);
+	CheckTorus(3, 3);
+	CheckTorus(30, 30);
+	CheckTorus(31, 29);
+
+	// the tessellations are clamped to the smallest closed shapes
+	MeshGenerator::MESH_DATA mesh;
+	MeshGenerator::GenerateCone(mesh, 1.0f, 1.0f, 1);
+	Check(mesh.vertices.size() == MeshGenerator::GetConeVertexCount(3), "cone 1", "not clamped to 3 slices");
+	MeshGenerator::GenerateSphere(mesh, 1, 1, 1.0f);
+	Check(mesh.vertices.size() == MeshGenerator::GetSphereVertexCount(2, 3), "sphere 1x1", "not clamped to 2x3");
+
+	if (g_FailedCount > 0)
+	{
+		std::cout << g_FailedCount << " mesh generator checks failed" << std::endl;
+		exit(EXIT_FAILURE);
+	}
+
+	std::cout << "INFO: The mesh generator checks passed" << std::endl;
+	exit(EXIT_SUCCESS);
+}
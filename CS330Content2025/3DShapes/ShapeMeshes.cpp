@@ -9,6 +9,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "shapemeshes.h"
+#include "GLStateCache.h"
+#include "ZoneProfiler.h"
 
 // GLM Math Header inclusions
 #define GLM_ENABLE_EXPERIMENTAL
@@ -17,6 +19,7 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm> // Required for std::max
 #include <array> // Required for std::array
 #include <vector> // Required for std::vector
 #include <cmath>  // Required for math functions like sqrt and cos
@@ -34,9 +37,360 @@ namespace Constants
 
 using namespace Constants;
 
+namespace
+{
+	///////////////////////////////////////////////////
+	//	ChordError()
+	//
+	//	Return the largest distance between a circle and
+	//	a polygon with the passed in number of sides,
+	//	relative to the radius of the circle.
+	///////////////////////////////////////////////////
+	float ChordError(int sides)
+	{
+		return(1.0f - static_cast<float>(std::cos(Pi / sides)));
+	}
+
+	///////////////////////////////////////////////////
+	//	Get...Error()
+	//
+	//	Return the geometric error of a tessellation of a
+	//	shape, relative to the radius of its bounds.
+	///////////////////////////////////////////////////
+	float GetSphereError(int latitudeSegments, int longitudeSegments)
+	{
+		// the latitudes cover half of a circle
+		return(std::max(ChordError(longitudeSegments), ChordError(2 * latitudeSegments)));
+	}
+
+	float GetTorusError(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments)
+	{
+		float boundingRadius = mainRadius + tubeRadius;
+		return(std::max(ChordError(mainSegments), ChordError(tubeSegments) * tubeRadius / boundingRadius));
+	}
+
+	float GetCylinderError(float radius, float height, int numSlices)
+	{
+		float boundingRadius = std::sqrt(radius * radius + 0.25f * height * height);
+		return(ChordError(numSlices) * radius / boundingRadius);
+	}
+}
+
+// the constant is passed by reference to std::min and std::max,
+// which needs a definition before C++17 made it inline
+constexpr int ShapeMeshes::MAX_LOD_LEVELS;
+
 ShapeMeshes::ShapeMeshes()
 {
 	m_bMemoryLayoutDone = false;
+	m_instanceVBO = 0;
+	m_bPackedLoad = false;
+	m_PackedMesh = {};
+	m_pDrawRecorder = nullptr;
+	m_pDrawFilter = nullptr;
+	m_pInstanceModels = nullptr;
+	m_pInstanceColors = nullptr;
+	m_bPackedIndicesDirty = false;
+	m_indirectBuffer = 0;
+	m_objectIndexVBO = 0;
+	m_objectIndexCount = 0;
+	m_drawCallCount = 0;
+
+	// until the LOD chains are loaded, they hold the single
+	// level of the regular meshes
+	GLMesh* chainMeshes[3] = { &m_SphereMesh, &m_TorusMesh, &m_CylinderMesh };
+	LOD_CHAIN* chains[3] = { &m_SphereLOD, &m_TorusLOD, &m_CylinderLOD };
+	for (int i = 0; i < 3; i++)
+	{
+		*chains[i] = {};
+		chains[i]->levels[0] = chainMeshes[i];
+		chains[i]->levelCount = 1;
+	}
+	m_lodView = {};
+}
+
+///////////////////////////////////////////////////
+//	BeginPackedLoad()
+//
+//	Start collecting the meshes loaded after this call
+//	into one shared vertex buffer and index buffer.
+//	The meshes cannot be drawn until EndPackedLoad()
+//	has been called.
+///////////////////////////////////////////////////
+void ShapeMeshes::BeginPackedLoad()
+{
+	if (m_PackedMesh.vao != 0) {
+		std::cerr << "Error: Packed meshes have already been created." << std::endl;
+		return;
+	}
+
+	m_bPackedLoad = true;
+}
+
+///////////////////////////////////////////////////
+//	EndPackedLoad()
+//
+//	Store the collected mesh data in GPU memory with a
+//	single VAO that is shared by all of the packed
+//	meshes.  Each mesh keeps its base vertex and first
+//	index into the shared buffers.
+///////////////////////////////////////////////////
+void ShapeMeshes::EndPackedLoad()
+{
+	if (m_bPackedLoad == false) {
+		return;
+	}
+	m_bPackedLoad = false;
+
+	if (m_packedVertices.empty()) {
+		return;
+	}
+
+	glGenVertexArrays(1, &m_PackedMesh.vao);
+	GLStateCache::BindVertexArray(m_PackedMesh.vao);
+
+	glGenBuffers(2, m_PackedMesh.vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, m_PackedMesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, m_packedVertices.size() * sizeof(GLfloat), m_packedVertices.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_PackedMesh.vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_packedIndices.size() * sizeof(GLuint), m_packedIndices.data(), GL_STATIC_DRAW);
+
+	SetShaderMemoryLayout();
+
+	GLStateCache::BindVertexArray(0);
+
+	m_PackedMesh.nVertices = static_cast<GLuint>(m_packedVertices.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
+	m_PackedMesh.nIndices = static_cast<GLuint>(m_packedIndices.size());
+
+	// every packed mesh now draws from the shared buffers
+	for (GLMesh* pMesh : m_packedMeshes)
+	{
+		pMesh->vao = m_PackedMesh.vao;
+		pMesh->vbos[0] = m_PackedMesh.vbos[0];
+		pMesh->vbos[1] = m_PackedMesh.vbos[1];
+	}
+
+	// the vertex data is in GPU memory, so free the CPU copy - the
+	// indices are kept so that strip and fan ranges can be appended
+	// as triangle lists for the indirect draw commands
+	std::vector<GLfloat>().swap(m_packedVertices);
+	m_packedMeshes.clear();
+}
+
+///////////////////////////////////////////////////
+//	SetDrawRecorder()
+//
+//	Set the recorder that receives the triangle draws
+//	of the packed meshes instead of OpenGL.  Pass
+//	nullptr to issue the draws directly again.
+///////////////////////////////////////////////////
+void ShapeMeshes::SetDrawRecorder(DrawRecorder* pRecorder)
+{
+	m_pDrawRecorder = pRecorder;
+	m_pInstanceModels = nullptr;
+	m_pInstanceColors = nullptr;
+}
+
+///////////////////////////////////////////////////
+//	SetDrawFilter()
+//
+//	Set the filter that is asked before every draw
+//	whether the mesh is drawn.  Pass nullptr to draw
+//	every mesh again.
+///////////////////////////////////////////////////
+void ShapeMeshes::SetDrawFilter(DrawFilter* pFilter)
+{
+	m_pDrawFilter = pFilter;
+}
+
+///////////////////////////////////////////////////
+//	HasPackedMeshes()
+//
+//	The draws can only be recorded once the meshes
+//	were loaded into the packed buffers.
+///////////////////////////////////////////////////
+bool ShapeMeshes::HasPackedMeshes() const
+{
+	return (m_PackedMesh.vao != 0);
+}
+
+///////////////////////////////////////////////////
+//	IsIndirectDrawSupported()
+//
+//	Indirect drawing needs the packed meshes and
+//	multi-draw-indirect with base instance support.
+///////////////////////////////////////////////////
+bool ShapeMeshes::IsIndirectDrawSupported() const
+{
+	if (m_PackedMesh.vao == 0) {
+		return false;
+	}
+
+	return (GLEW_VERSION_4_3 ||
+		(GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance));
+}
+
+///////////////////////////////////////////////////
+//	SetIndirectDrawCommands()
+//
+//	Upload the recorded draw commands into the indirect
+//	buffer.  Every drawn instance gets a per-object index
+//	attribute (baseInstance + instance) so the shaders
+//	can find the values of the object being drawn.
+///////////////////////////////////////////////////
+void ShapeMeshes::SetIndirectDrawCommands(const DRAW_COMMAND* commands, size_t count)
+{
+	// Attribute location definition
+	constexpr GLuint OBJECT_INDEX_ATTR_LOCATION = 8;
+
+	if (m_PackedMesh.vao == 0 || commands == nullptr || count == 0) {
+		return;
+	}
+
+	BindMesh(m_PackedMesh);
+	UploadPackedIndices();
+
+	if (m_indirectBuffer == 0) {
+		glGenBuffers(1, &m_indirectBuffer);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+	// orphan the previous contents so the upload does not
+	// have to wait for earlier draws to finish with them
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, count * sizeof(DRAW_COMMAND), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, count * sizeof(DRAW_COMMAND), commands);
+
+	// the per-object index attribute only has to grow when
+	// more objects are drawn than ever before
+	size_t objectCount = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		objectCount = std::max(objectCount, static_cast<size_t>(commands[i].baseInstance) + commands[i].instanceCount);
+	}
+
+	if (objectCount > m_objectIndexCount)
+	{
+		std::vector<GLint> objectIndices(objectCount);
+		for (size_t i = 0; i < objectCount; i++)
+		{
+			objectIndices[i] = static_cast<GLint>(i);
+		}
+
+		if (m_objectIndexVBO == 0) {
+			glGenBuffers(1, &m_objectIndexVBO);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, m_objectIndexVBO);
+		glBufferData(GL_ARRAY_BUFFER, objectCount * sizeof(GLint), objectIndices.data(), GL_STATIC_DRAW);
+		glVertexAttribIPointer(OBJECT_INDEX_ATTR_LOCATION, 1, GL_INT, sizeof(GLint), nullptr);
+		glVertexAttribDivisor(OBJECT_INDEX_ATTR_LOCATION, 1);
+		m_objectIndexCount = objectCount;
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawIndirectCommands()
+//
+//	Draw a range of the uploaded indirect draw commands
+//	with a single multi-draw call.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawIndirectCommands(size_t first, size_t count)
+{
+	PROFILE_ZONE("ShapeMeshes::DrawIndirectCommands");
+
+	// Attribute location definition
+	constexpr GLuint OBJECT_INDEX_ATTR_LOCATION = 8;
+
+	if (m_indirectBuffer == 0 || count == 0) {
+		return;
+	}
+
+	BindMesh(m_PackedMesh);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+
+	// the object index is only read by indirect draws, so it
+	// is not left enabled for the direct draws of the VAO
+	glEnableVertexAttribArray(OBJECT_INDEX_ATTR_LOCATION);
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		GL_UNSIGNED_INT,
+		reinterpret_cast<const void*>(first * sizeof(DRAW_COMMAND)),
+		static_cast<GLsizei>(count),
+		0);
+	glDisableVertexAttribArray(OBJECT_INDEX_ATTR_LOCATION);
+	m_drawCallCount++;
+}
+
+///////////////////////////////////////////////////
+//	DrawRecordedCommand()
+//
+//	Draw one recorded command of the packed meshes with
+//	a direct draw call.  The models and colors are only
+//	passed for the draws of the instanced methods, and
+//	the base instance of the command is not used.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawRecordedCommand(const DRAW_COMMAND& command, const glm::mat4* models, const glm::vec4* colors)
+{
+	PROFILE_ZONE("ShapeMeshes::DrawRecordedCommand");
+
+	if (m_PackedMesh.vao == 0 || command.count == 0) {
+		return;
+	}
+
+	BindMesh(m_PackedMesh);
+	UploadPackedIndices();
+
+	const void* indexOffset = reinterpret_cast<const void*>(command.firstIndex * sizeof(GLuint));
+
+	if (models == nullptr) {
+		glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, indexOffset, command.baseVertex);
+	}
+	else {
+		UploadInstanceData(m_PackedMesh, models, colors, command.instanceCount);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, indexOffset, command.instanceCount, command.baseVertex);
+		DetachInstanceData();
+	}
+	m_drawCallCount++;
+}
+
+///////////////////////////////////////////////////
+//	UploadPackedIndices()
+//
+//	Upload the packed index buffer again when triangle
+//	lists were added for strip and fan ranges since it
+//	was last uploaded.  The packed VAO must be bound.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadPackedIndices()
+{
+	if (m_bPackedIndicesDirty)
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_PackedMesh.vbos[1]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_packedIndices.size() * sizeof(GLuint), m_packedIndices.data(), GL_STATIC_DRAW);
+		m_PackedMesh.nIndices = static_cast<GLuint>(m_packedIndices.size());
+		m_bPackedIndicesDirty = false;
+	}
+}
+
+///////////////////////////////////////////////////
+//	GetDrawCallCount()
+//
+//	Get the number of draw calls issued to OpenGL
+//	since the count was last reset.  A multi-draw
+//	counts as a single call.
+///////////////////////////////////////////////////
+unsigned int ShapeMeshes::GetDrawCallCount() const
+{
+	return m_drawCallCount;
+}
+
+///////////////////////////////////////////////////
+//	ResetDrawCallCount()
+//
+//	Reset the number of issued draw calls, usually
+//	at the start of each frame.
+///////////////////////////////////////////////////
+void ShapeMeshes::ResetDrawCallCount()
+{
+	m_drawCallCount = 0;
 }
 
 //**************************************************************************
@@ -107,25 +461,8 @@ void ShapeMeshes::LoadBoxMesh()
 	m_BoxMesh.nVertices = verts.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV);
 	m_BoxMesh.nIndices = indices.size();
 
-	// Generate VAO and VBOs
-	glGenVertexArrays(1, &m_BoxMesh.vao);
-	glBindVertexArray(m_BoxMesh.vao);
-
-	glGenBuffers(2, m_BoxMesh.vbos);
-
-	// Upload vertex data
-	glBindBuffer(GL_ARRAY_BUFFER, m_BoxMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
-
-
-	// Upload index data
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BoxMesh.vbos[1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-	// Ensure shader memory layout is set
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
+	// store the mesh data in GPU memory
+	UploadMesh(m_BoxMesh, verts.data(), verts.size(), indices.data(), indices.size());
 }
 
 ///////////////////////////////////////////////////
@@ -140,58 +477,17 @@ void ShapeMeshes::LoadBoxMesh()
 //	glDrawArrays(GL_TRIANGLE_FAN, 0, numSlices + 2);	// bottom
 //	glDrawArrays(GL_TRIANGLE_STRIP, numSlices + 2, numSlices * 2);	// sides
 ///////////////////////////////////////////////////
-void ShapeMeshes::LoadConeMesh(float radius, float height, int numSlices) {
+void ShapeMeshes::LoadConeMesh(float radius, float height, int numSlices)
+{
 	// Validate inputs
 	if (numSlices < 3) numSlices = 3;
 	m_ConeMesh.numSlices = numSlices; // Store number of slices in the mesh structure
 
-	std::vector<GLfloat> vertices;
-
-	// Generate bottom circle vertices
-	float angleStep = 2.0f * Pi / numSlices;
-
-	// Center vertex of bottom circle
-	vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f });
-
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		vertices.insert(vertices.end(), { x, 0.0f, z, 0.0f, -1.0f, 0.0f, 0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle) });
-	}
-
-	// Generate side vertices
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		float nx = cos(angle);
-		float nz = sin(angle);
-
-		// Bottom vertex
-		vertices.insert(vertices.end(), { x, 0.0f, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 1.0f });
-		// Apex vertex
-		vertices.insert(vertices.end(), { 0.0f, height, 0.0f, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 0.0f });
-	}
-
-	// Store vertex count
-	m_ConeMesh.nVertices = static_cast<GLsizei>(vertices.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
-	m_ConeMesh.nIndices = 0; // Not used since we're drawing with glDrawArrays
-
-	// Generate VAO and VBO
-	glGenVertexArrays(1, &m_ConeMesh.vao);
-	glBindVertexArray(m_ConeMesh.vao);
-
-	glGenBuffers(1, m_ConeMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ConeMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
+	// generate the vertices into the reused mesh data
+	MeshGenerator::GenerateCone(m_generatedMesh, radius, height, numSlices);
 
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	// store the mesh data in GPU memory
+	UploadGeneratedMesh(m_ConeMesh);
 }
 
 ///////////////////////////////////////////////////
@@ -208,68 +504,22 @@ void ShapeMeshes::LoadConeMesh(float radius, float height, int numSlices) {
 //	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
 ///////////////////////////////////////////////////
 
-void ShapeMeshes::LoadCylinderMesh(float radius, float height, int numSlices) {
+void ShapeMeshes::LoadCylinderMesh(float radius, float height, int numSlices)
+{
 	// Validate inputs
 	if (numSlices < 3) numSlices = 3;
 	m_CylinderMesh.numSlices = numSlices; // Store number of slices in the mesh structure
 
-	std::vector<GLfloat> vertices;
-
-	// Generate bottom circle vertices
-	float angleStep = 2.0f * Pi / numSlices;
-
-	// Center vertex of bottom circle
-	vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f });
-
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		vertices.insert(vertices.end(), { x, 0.0f, z, 0.0f, -1.0f, 0.0f, 0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle) });
-	}
-
-	// Generate top circle vertices
-	vertices.insert(vertices.end(), { 0.0f, height, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f });
-
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		vertices.insert(vertices.end(), { x, height, z, 0.0f, 1.0f, 0.0f, 0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle) });
-	}
-
-	// Generate side vertices
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		float nx = cos(angle);
-		float nz = sin(angle);
+	// generate the vertices into the reused mesh data
+	MeshGenerator::GenerateCylinder(m_generatedMesh, radius, height, numSlices);
 
-		// Bottom vertex
-		vertices.insert(vertices.end(), { x, 0.0f, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 0.0f });
-		// Top vertex
-		vertices.insert(vertices.end(), { x, height, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 1.0f });
-	}
-
-	// Store vertex count
-	m_CylinderMesh.nVertices = static_cast<GLsizei>(vertices.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
-	m_CylinderMesh.nIndices = 0; // Not used since we're drawing with glDrawArrays
-
-	// Generate VAO and VBO
-	glGenVertexArrays(1, &m_CylinderMesh.vao);
-	glBindVertexArray(m_CylinderMesh.vao);
-
-	glGenBuffers(1, m_CylinderMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_CylinderMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
+	// store the mesh data in GPU memory
+	UploadGeneratedMesh(m_CylinderMesh);
 
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	// the mesh is the only level of its LOD chain until
+	// the coarser levels are loaded
+	m_CylinderLOD.levelCount = 1;
+	m_CylinderLOD.levelErrors[0] = GetCylinderError(radius, height, numSlices);
 }
 
 ///////////////////////////////////////////////////
@@ -308,24 +558,8 @@ void ShapeMeshes::LoadPlaneMesh(float width, float height) {
 	m_PlaneMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
 	m_PlaneMesh.nIndices = sizeof(indices) / sizeof(indices[0]);
 
-	// Generate the VAO for the mesh
-	glGenVertexArrays(1, &m_PlaneMesh.vao);
-	glBindVertexArray(m_PlaneMesh.vao); // Activate the VAO
-
-	// Create VBOs for the mesh
-	glGenBuffers(2, m_PlaneMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_PlaneMesh.vbos[0]); // Activate the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Send data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_PlaneMesh.vbos[1]); // Activate the buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
-
-	// Unbind the VAO for safety
-	glBindVertexArray(0);
+	// store the mesh data in GPU memory
+	UploadMesh(m_PlaneMesh, verts, sizeof(verts) / sizeof(verts[0]), indices, sizeof(indices) / sizeof(indices[0]));
 }
 
 void ShapeMeshes::LoadPrismMesh()
@@ -381,18 +615,8 @@ void ShapeMeshes::LoadPrismMesh()
 
 	m_PrismMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
 
-	glGenVertexArrays(1, &m_PrismMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_PrismMesh.vao);
-
-	// Create 2 buffers: first one for the vertex data; second one for the indices
-	glGenBuffers(1, m_PrismMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_PrismMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	// store the mesh data in GPU memory
+	UploadMesh(m_PrismMesh, verts, sizeof(verts) / sizeof(verts[0]));
 }
 
 
@@ -473,19 +697,8 @@ void ShapeMeshes::LoadPyramid3Mesh()
 	// Store vertex count
 	m_Pyramid3Mesh.nVertices = verts.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV);
 
-	// Create VAO
-	glGenVertexArrays(1, &m_Pyramid3Mesh.vao);
-	glBindVertexArray(m_Pyramid3Mesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, m_Pyramid3Mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_Pyramid3Mesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
-
-	if (!m_bMemoryLayoutDone)
-	{
-		SetShaderMemoryLayout();
-	}
+	// store the mesh data in GPU memory
+	UploadMesh(m_Pyramid3Mesh, verts.data(), verts.size());
 }
 
 ///////////////////////////////////////////////////
@@ -557,22 +770,8 @@ void ShapeMeshes::LoadPyramid4Mesh(float baseSize, float height)
 	// Store vertex count
 	m_Pyramid4Mesh.nVertices = verts.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV);
 
-	// Generate VAO and VBO
-	glGenVertexArrays(1, &m_Pyramid4Mesh.vao);
-	glBindVertexArray(m_Pyramid4Mesh.vao);
-
-	glGenBuffers(1, m_Pyramid4Mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_Pyramid4Mesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
-
-	// Set shader memory layout if not done
-	if (!m_bMemoryLayoutDone)
-	{
-		SetShaderMemoryLayout();
-	}
-
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	// store the mesh data in GPU memory
+	UploadMesh(m_Pyramid4Mesh, verts.data(), verts.size());
 }
 
 ///////////////////////////////////////////////////
@@ -584,94 +783,16 @@ void ShapeMeshes::LoadPyramid4Mesh(float baseSize, float height)
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadSphereMesh(int latitudeSegments, int longitudeSegments, float radius)
 {
-	std::vector<GLfloat> vertices;
-	std::vector<GLuint> indices;
-
-	// Generate vertices, normals, and texture coordinates
-	for (int lat = 0; lat <= latitudeSegments; ++lat)
-	{
-		float theta = lat * Pi / latitudeSegments; // Latitude angle [0, PI]
-		float sinTheta = sin(theta);
-		float cosTheta = cos(theta);
-
-		for (int lon = 0; lon <= longitudeSegments; ++lon)
-		{
-			float phi = lon * 2 * Pi / longitudeSegments; // Longitude angle [0, 2*PI]
-			float sinPhi = sin(phi);
-			float cosPhi = cos(phi);
-
-			// Compute vertex position
-			float x = radius * sinTheta * cosPhi;
-			float y = radius * cosTheta;
-			float z = radius * sinTheta * sinPhi;
-
-			// Compute normal
-			float nx = sinTheta * cosPhi;
-			float ny = cosTheta;
-			float nz = sinTheta * sinPhi;
-
-			// Compute texture coordinates
-			float u = 1.0f - (float)lon / longitudeSegments;
-			float v = 1.0f - (float)lat / latitudeSegments;
-
-			// Push vertex data
-			vertices.push_back(x); // Position
-			vertices.push_back(y);
-			vertices.push_back(z);
-			vertices.push_back(nx); // Normal
-			vertices.push_back(ny);
-			vertices.push_back(nz);
-			vertices.push_back(u); // Texture coordinate
-			vertices.push_back(v);
-		}
-	}
-
-	// Generate indices for GL_TRIANGLES
-	for (int lat = 0; lat < latitudeSegments; ++lat)
-	{
-		for (int lon = 0; lon < longitudeSegments; ++lon)
-		{
-			int first = lat * (longitudeSegments + 1) + lon;
-			int second = first + longitudeSegments + 1;
-
-			// Triangle 1
-			indices.push_back(first);
-			indices.push_back(second);
-			indices.push_back(first + 1);
-
-			// Triangle 2
-			indices.push_back(second);
-			indices.push_back(second + 1);
-			indices.push_back(first + 1);
-		}
-	}
-
-	// Store vertex and index count
-	m_SphereMesh.nVertices = static_cast<GLuint>(vertices.size() / 8); // 8 floats per vertex
-	m_SphereMesh.nIndices = static_cast<GLuint>(indices.size());
-
-	// Create VAO
-	glGenVertexArrays(1, &m_SphereMesh.vao);
-	glBindVertexArray(m_SphereMesh.vao);
+	// generate the vertices into the reused mesh data
+	MeshGenerator::GenerateSphere(m_generatedMesh, latitudeSegments, longitudeSegments, radius);
 
-	// Create VBO for vertices
-	glGenBuffers(1, &m_SphereMesh.vbos[0]);
-	glBindBuffer(GL_ARRAY_BUFFER, m_SphereMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+	// store the mesh data in GPU memory
+	UploadGeneratedMesh(m_SphereMesh);
 
-	// Create EBO for indices
-	glGenBuffers(1, &m_SphereMesh.vbos[1]);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SphereMesh.vbos[1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-	// Ensure shader memory layout is set
-	if (!m_bMemoryLayoutDone)
-	{
-		SetShaderMemoryLayout();
-	}
-
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	// the mesh is the only level of its LOD chain until
+	// the coarser levels are loaded
+	m_SphereLOD.levelCount = 1;
+	m_SphereLOD.levelErrors[0] = GetSphereError(latitudeSegments, longitudeSegments);
 }
 
 ///////////////////////////////////////////////////
@@ -919,19 +1040,8 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 	m_TaperedCylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
 	m_TaperedCylinderMesh.nIndices = 0;
 
-	// Create VAO
-	glGenVertexArrays(1, &m_TaperedCylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, m_TaperedCylinderMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_TaperedCylinderMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	// store the mesh data in GPU memory
+	UploadMesh(m_TaperedCylinderMesh, verts, sizeof(verts) / sizeof(verts[0]));
 }
 
 ///////////////////////////////////////////////////
@@ -945,109 +1055,18 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 //
 //	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices);
 ///////////////////////////////////////////////////
-void ShapeMeshes::LoadTorusMesh(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments) {
-	// Validate input parameters
-	mainSegments = std::max(3, mainSegments);
-	tubeSegments = std::max(3, tubeSegments);
-	tubeRadius = std::max(0.01f, tubeRadius);
-
-	float mainSegmentStep = 2.0f * Pi / mainSegments;
-	float tubeSegmentStep = 2.0f * Pi / tubeSegments;
-
-	std::vector<GLfloat> vertices;
-	std::vector<GLuint> indices;
-
-	// Generate vertices and normals
-	for (int i = 0; i <= mainSegments; ++i) {
-		float mainAngle = i * mainSegmentStep;
-		float cosMain = cos(mainAngle);
-		float sinMain = sin(mainAngle);
-
-		for (int j = 0; j <= tubeSegments; ++j) {
-			float tubeAngle = j * tubeSegmentStep;
-			float cosTube = cos(tubeAngle);
-			float sinTube = sin(tubeAngle);
-
-			// Vertex position
-			float x = (mainRadius + tubeRadius * cosTube) * cosMain;
-			float y = (mainRadius + tubeRadius * cosTube) * sinMain;
-			float z = tubeRadius * sinTube;
-
-			// Normal vector
-			glm::vec3 center(mainRadius * cosMain, mainRadius * sinMain, 0.0f);
-			glm::vec3 vertex(x, y, z);
-			glm::vec3 normal = glm::normalize(vertex - center);
-
-			// Texture coordinates
-			float u = (float)i / mainSegments;
-			float v = (float)j / tubeSegments;
-
-			// Store interleaved vertex data
-			vertices.push_back(x);    // Position x
-			vertices.push_back(y);    // Position y
-			vertices.push_back(z);    // Position z
-			vertices.push_back(normal.x); // Normal x
-			vertices.push_back(normal.y); // Normal y
-			vertices.push_back(normal.z); // Normal z
-			vertices.push_back(u);    // Texture u
-			vertices.push_back(v);    // Texture v
-		}
-	}
-
-	// Generate indices for triangle strips
-	for (int i = 0; i < mainSegments; ++i) {
-		for (int j = 0; j < tubeSegments; ++j) {
-			int current = i * (tubeSegments + 1) + j;
-			int next = (i + 1) * (tubeSegments + 1) + j;
-
-			// First triangle
-			indices.push_back(current);
-			indices.push_back(next);
-			indices.push_back(current + 1);
-
-			// Second triangle
-			indices.push_back(current + 1);
-			indices.push_back(next);
-			indices.push_back(next + 1);
-		}
-	}
-
-	// Store vertex and index counts
-	m_TorusMesh.nVertices = static_cast<GLuint>(vertices.size() / 8); // 8 floats per vertex
-	m_TorusMesh.nIndices = static_cast<GLuint>(indices.size());
-
-	// Create VAO
-	glGenVertexArrays(1, &m_TorusMesh.vao);
-	glBindVertexArray(m_TorusMesh.vao);
-
-	// Create VBO for vertices
-	GLuint vertexBuffer;
-	glGenBuffers(1, &vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-	// Create EBO for indices
-	GLuint indexBuffer;
-	glGenBuffers(1, &indexBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-	// Define vertex attributes
-	GLint stride = sizeof(GLfloat) * 8;
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);                      // Position
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat))); // Normal
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(GLfloat))); // Texture coords
-	glEnableVertexAttribArray(2);
+void ShapeMeshes::LoadTorusMesh(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments)
+{
+	// generate the vertices into the reused mesh data
+	MeshGenerator::GenerateTorus(m_generatedMesh, mainRadius, tubeRadius, mainSegments, tubeSegments);
 
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	// store the mesh data in GPU memory
+	UploadGeneratedMesh(m_TorusMesh);
 
-	// Mark memory layout as complete
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
+	// the mesh is the only level of its LOD chain until
+	// the coarser levels are loaded
+	m_TorusLOD.levelCount = 1;
+	m_TorusLOD.levelErrors[0] = GetTorusError(mainRadius, tubeRadius, mainSegments, tubeSegments);
 }
 
 
@@ -1064,186 +1083,12 @@ void ShapeMeshes::LoadTorusMesh(float mainRadius, float tubeRadius, int mainSegm
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadExtraTorusMesh1(float thickness)
 {
-	int _mainSegments = 30;
-	int _tubeSegments = 30;
-	float _mainRadius = 1.0f;
-	float _tubeRadius = .1f;
+	// generate the vertices into the reused mesh data
+	MeshGenerator::GenerateExtraTorus(m_generatedMesh, thickness);
 
-	if (thickness <= 1.0)
-	{
-		_tubeRadius = thickness;
-	}
-
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
-
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
-
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
-	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
-
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
-
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
-		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
-
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
-	}
-
-	float horizontalStep = 1.0 / _mainSegments;
-	float verticalStep = 1.0 / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
-
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
-	{
-		for (int j = 0; j < _tubeSegments; j++)
-		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
-			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-
-			}
-			v += verticalStep;
-		}
-		v = 0.0;
-		u += horizontalStep;
-	}
-
-	std::vector<GLfloat> combined_values;
-
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
-	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
-
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
-	}
-
-	// store vertex and index count
-	m_ExtraTorusMesh1.nVertices = vertex_list.size();
-	m_ExtraTorusMesh1.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_ExtraTorusMesh1.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_ExtraTorusMesh1.vao);
-
-	// Create VBOs
-	glGenBuffers(1, m_ExtraTorusMesh1.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ExtraTorusMesh1.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
-}
+	// store the mesh data in GPU memory
+	UploadGeneratedMesh(m_ExtraTorusMesh1);
+}
 
 ///////////////////////////////////////////////////
 //	LoadExtraTorusMesh2()
@@ -1258,184 +1103,120 @@ void ShapeMeshes::LoadExtraTorusMesh1(float thickness)
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadExtraTorusMesh2(float thickness)
 {
-	int _mainSegments = 30;
-	int _tubeSegments = 30;
-	float _mainRadius = 1.0f;
-	float _tubeRadius = .1f;
+	// generate the vertices into the reused mesh data
+	MeshGenerator::GenerateExtraTorus(m_generatedMesh, thickness);
 
-	if (thickness <= 1.0)
-	{
-		_tubeRadius = thickness;
-	}
+	// store the mesh data in GPU memory
+	UploadGeneratedMesh(m_ExtraTorusMesh2);
+}
 
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
+///////////////////////////////////////////////////
+//	LoadSphereMeshLOD()
+//
+//	Load the sphere mesh followed by up to three
+//	coarser levels of detail.  The latitude count of
+//	every level stays even, so that the half sphere
+//	draws end at the equator.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadSphereMeshLOD(int levelCount, int latitudeSegments, int longitudeSegments, float radius)
+{
+	levelCount = std::min(std::max(1, levelCount), MAX_LOD_LEVELS);
 
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
+	LoadSphereMesh(latitudeSegments, longitudeSegments, radius);
 
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
+	int previousLatitudes = latitudeSegments;
+	int previousLongitudes = longitudeSegments;
+	for (int level = 1; level < levelCount; level++)
 	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
+		int levelLatitudes = std::max(4, ((latitudeSegments >> level) + 1) & ~1);
+		int levelLongitudes = std::max(6, longitudeSegments >> level);
 
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
-
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
+		// stop once the smallest tessellation has been reached
+		if (levelLatitudes >= previousLatitudes && levelLongitudes >= previousLongitudes) {
+			break;
 		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
+		previousLatitudes = levelLatitudes;
+		previousLongitudes = levelLongitudes;
+
+		GLMesh& mesh = m_SphereLODMeshes[level - 1];
+		MeshGenerator::GenerateSphere(m_generatedMesh, levelLatitudes, levelLongitudes, radius);
+		UploadGeneratedMesh(mesh);
 
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
+		m_SphereLOD.levels[level] = &mesh;
+		m_SphereLOD.levelErrors[level] = GetSphereError(levelLatitudes, levelLongitudes);
+		m_SphereLOD.levelCount = level + 1;
 	}
+}
+
+///////////////////////////////////////////////////
+//	LoadTorusMeshLOD()
+//
+//	Load the torus mesh followed by up to three
+//	coarser levels of detail.  The main segment count
+//	of every level stays even, so that the half torus
+//	draws end halfway around.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadTorusMeshLOD(int levelCount, float mainRadius, float tubeRadius, int mainSegments, int tubeSegments)
+{
+	levelCount = std::min(std::max(1, levelCount), MAX_LOD_LEVELS);
 
-	float horizontalStep = 1.0 / _mainSegments;
-	float verticalStep = 1.0 / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
+	LoadTorusMesh(mainRadius, tubeRadius, mainSegments, tubeSegments);
 
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
+	int previousMainSegments = mainSegments;
+	int previousTubeSegments = tubeSegments;
+	for (int level = 1; level < levelCount; level++)
 	{
-		for (int j = 0; j < _tubeSegments; j++)
-		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
-			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
+		int levelMainSegments = std::max(6, ((mainSegments >> level) + 1) & ~1);
+		int levelTubeSegments = std::max(4, tubeSegments >> level);
 
-			}
-			v += verticalStep;
+		// stop once the smallest tessellation has been reached
+		if (levelMainSegments >= previousMainSegments && levelTubeSegments >= previousTubeSegments) {
+			break;
 		}
-		v = 0.0;
-		u += horizontalStep;
-	}
+		previousMainSegments = levelMainSegments;
+		previousTubeSegments = levelTubeSegments;
 
-	std::vector<GLfloat> combined_values;
-
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
-	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
+		GLMesh& mesh = m_TorusLODMeshes[level - 1];
+		MeshGenerator::GenerateTorus(m_generatedMesh, mainRadius, tubeRadius, levelMainSegments, levelTubeSegments);
+		UploadGeneratedMesh(mesh);
 
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
+		m_TorusLOD.levels[level] = &mesh;
+		m_TorusLOD.levelErrors[level] = GetTorusError(mainRadius, tubeRadius, levelMainSegments, levelTubeSegments);
+		m_TorusLOD.levelCount = level + 1;
 	}
+}
 
-	// store vertex and index count
-	m_ExtraTorusMesh2.nVertices = vertex_list.size();
-	m_ExtraTorusMesh2.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_ExtraTorusMesh2.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_ExtraTorusMesh2.vao);
+///////////////////////////////////////////////////
+//	LoadCylinderMeshLOD()
+//
+//	Load the cylinder mesh followed by up to three
+//	coarser levels of detail.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadCylinderMeshLOD(int levelCount, float radius, float height, int numSlices)
+{
+	levelCount = std::min(std::max(1, levelCount), MAX_LOD_LEVELS);
 
-	// Create VBOs
-	glGenBuffers(1, m_ExtraTorusMesh2.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ExtraTorusMesh2.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	LoadCylinderMesh(radius, height, numSlices);
 
-	if (m_bMemoryLayoutDone == false)
+	int previousSlices = m_CylinderMesh.numSlices;
+	for (int level = 1; level < levelCount; level++)
 	{
-		SetShaderMemoryLayout();
+		int levelSlices = std::max(6, m_CylinderMesh.numSlices >> level);
+
+		// stop once the smallest tessellation has been reached
+		if (levelSlices >= previousSlices) {
+			break;
+		}
+		previousSlices = levelSlices;
+
+		GLMesh& mesh = m_CylinderLODMeshes[level - 1];
+		mesh.numSlices = levelSlices;
+		MeshGenerator::GenerateCylinder(m_generatedMesh, radius, height, levelSlices);
+		UploadGeneratedMesh(mesh);
+
+		m_CylinderLOD.levels[level] = &mesh;
+		m_CylinderLOD.levelErrors[level] = GetCylinderError(radius, height, levelSlices);
+		m_CylinderLOD.levelCount = level + 1;
 	}
 }
 
@@ -1456,9 +1237,9 @@ void ShapeMeshes::DrawBoxMesh() const
 		return;
 	}
 
-	glBindVertexArray(m_BoxMesh.vao);
-	glDrawElements(GL_TRIANGLES, m_BoxMesh.nIndices, GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
+	BindMesh(m_BoxMesh);
+	DrawMeshElements(m_BoxMesh, GL_TRIANGLES, m_BoxMesh.nIndices);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1475,7 +1256,7 @@ void ShapeMeshes::DrawBoxMeshSide(BoxSide side) const
 		return;
 	}
 
-	glBindVertexArray(m_BoxMesh.vao);
+	BindMesh(m_BoxMesh);
 
 	// Mapping side to starting vertex index
 	constexpr GLint sideStartIndices[] = {
@@ -1489,12 +1270,12 @@ void ShapeMeshes::DrawBoxMeshSide(BoxSide side) const
 
 	if (side < back || side > front) {
 		std::cerr << "Error: Invalid box side specified." << std::endl;
-		glBindVertexArray(0);
+		UnbindMesh();
 		return;
 	}
 
-	glDrawArrays(GL_TRIANGLE_FAN, sideStartIndices[side], 4);
-	glBindVertexArray(0);
+	DrawMeshArrays(m_BoxMesh, GL_TRIANGLE_FAN, sideStartIndices[side], 4);
+	UnbindMesh();
 }
 
 
@@ -1511,13 +1292,12 @@ void ShapeMeshes::DrawBoxMeshLines() const
 		return;
 	}
 
-	glBindVertexArray(m_BoxMesh.vao);
+	BindMesh(m_BoxMesh);
 
 	// Draw the box using line primitives for outlining edges
-	glDrawElements(GL_LINE_STRIP, m_BoxMesh.nIndices, GL_UNSIGNED_INT, nullptr);
+	DrawMeshElements(m_BoxMesh, GL_LINE_STRIP, m_BoxMesh.nIndices);
 
-	glBindVertexArray(0);
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 
@@ -1528,7 +1308,7 @@ void ShapeMeshes::DrawBoxMeshLines() const
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawConeMesh(bool bDrawBottom) {
-	glBindVertexArray(m_ConeMesh.vao);
+	BindMesh(m_ConeMesh);
 
 	// Bottom circle vertex count: numSlices + 2 (center + all slices + closing slice)
 	int bottomVertexCount = m_ConeMesh.numSlices + 2;
@@ -1536,11 +1316,11 @@ void ShapeMeshes::DrawConeMesh(bool bDrawBottom) {
 	int sideVertexCount = m_ConeMesh.numSlices * 2;
 
 	if (bDrawBottom) {
-		glDrawArrays(GL_TRIANGLE_FAN, 0, bottomVertexCount); // Bottom circle
+		DrawMeshArrays(m_ConeMesh, GL_TRIANGLE_FAN, 0, bottomVertexCount); // Bottom circle
 	}
-	glDrawArrays(GL_TRIANGLE_STRIP, bottomVertexCount, sideVertexCount); // Cone sides
+	DrawMeshArrays(m_ConeMesh, GL_TRIANGLE_STRIP, bottomVertexCount, sideVertexCount); // Cone sides
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1550,7 +1330,7 @@ void ShapeMeshes::DrawConeMesh(bool bDrawBottom) {
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawConeMeshLines(bool bDrawBottom) {
-	glBindVertexArray(m_ConeMesh.vao);
+	BindMesh(m_ConeMesh);
 
 	// Bottom circle vertex count: numSlices + 2 (center + all slices + closing slice)
 	int bottomVertexCount = m_ConeMesh.numSlices + 2;
@@ -1558,11 +1338,11 @@ void ShapeMeshes::DrawConeMeshLines(bool bDrawBottom) {
 	int sideVertexCount = m_ConeMesh.numSlices * 2;
 
 	if (bDrawBottom) {
-		glDrawArrays(GL_LINES, 0, bottomVertexCount); // Bottom circle
+		DrawMeshArrays(m_ConeMesh, GL_LINES, 0, bottomVertexCount); // Bottom circle
 	}
-	glDrawArrays(GL_LINE_STRIP, bottomVertexCount, sideVertexCount); // Cone sides
+	DrawMeshArrays(m_ConeMesh, GL_LINE_STRIP, bottomVertexCount, sideVertexCount); // Cone sides
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 
@@ -1577,29 +1357,7 @@ void ShapeMeshes::DrawCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_CylinderMesh.vao);
-
-	// Calculate vertex counts
-	int bottomVertexCount = m_CylinderMesh.numSlices + 2; // Center + all slices + closing slice
-	int topVertexCount = m_CylinderMesh.numSlices + 2;    // Same as bottom
-	int sideVertexCount = (m_CylinderMesh.numSlices + 1) * 2; // Two vertices per slice, +1 for closing strip
-
-	// Draw the bottom circle
-	if (bDrawBottom) {
-		glDrawArrays(GL_TRIANGLE_FAN, 0, bottomVertexCount);
-	}
-
-	// Draw the top circle
-	if (bDrawTop) {
-		glDrawArrays(GL_TRIANGLE_FAN, bottomVertexCount, topVertexCount);
-	}
-
-	// Draw the sides
-	if (bDrawSides) {
-		glDrawArrays(GL_TRIANGLE_STRIP, bottomVertexCount + topVertexCount, sideVertexCount);
-	}
-
-	glBindVertexArray(0);
+	DrawCylinderParts(m_CylinderMesh, bDrawTop, bDrawBottom, bDrawSides);
 }
 
 ///////////////////////////////////////////////////
@@ -1614,7 +1372,7 @@ void ShapeMeshes::DrawCylinderMeshLines(
 	bool bDrawSides
 )
 {
-	glBindVertexArray(m_CylinderMesh.vao);
+	BindMesh(m_CylinderMesh);
 
 	// Calculate vertex counts
 	int bottomVertexCount = m_CylinderMesh.numSlices + 2; // Center + all slices + closing slice
@@ -1623,20 +1381,20 @@ void ShapeMeshes::DrawCylinderMeshLines(
 
 	// Draw the bottom circle lines
 	if (bDrawBottom) {
-		glDrawArrays(GL_LINE_LOOP, 1, m_CylinderMesh.numSlices); // Skip the center vertex for a proper loop
+		DrawMeshArrays(m_CylinderMesh, GL_LINE_LOOP, 1, m_CylinderMesh.numSlices); // Skip the center vertex for a proper loop
 	}
 
 	// Draw the top circle lines
 	if (bDrawTop) {
-		glDrawArrays(GL_LINE_LOOP, bottomVertexCount + 1, m_CylinderMesh.numSlices); // Skip the center vertex for a proper loop
+		DrawMeshArrays(m_CylinderMesh, GL_LINE_LOOP, bottomVertexCount + 1, m_CylinderMesh.numSlices); // Skip the center vertex for a proper loop
 	}
 
 	// Draw the side lines
 	if (bDrawSides) {
-		glDrawArrays(GL_LINE_STRIP, bottomVertexCount + topVertexCount, sideVertexCount);
+		DrawMeshArrays(m_CylinderMesh, GL_LINE_STRIP, bottomVertexCount + topVertexCount, sideVertexCount);
 	}
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 
@@ -1648,11 +1406,11 @@ void ShapeMeshes::DrawCylinderMeshLines(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPlaneMesh()
 {
-	glBindVertexArray(m_PlaneMesh.vao);
+	BindMesh(m_PlaneMesh);
 
-	glDrawElements(GL_TRIANGLE_STRIP, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawMeshElements(m_PlaneMesh, GL_TRIANGLE_STRIP, m_PlaneMesh.nIndices);
 	
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1663,11 +1421,11 @@ void ShapeMeshes::DrawPlaneMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPlaneMeshLines()
 {
-	glBindVertexArray(m_PlaneMesh.vao);
+	BindMesh(m_PlaneMesh);
 
-	glDrawElements(GL_LINE_STRIP, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawMeshElements(m_PlaneMesh, GL_LINE_STRIP, m_PlaneMesh.nIndices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1677,12 +1435,12 @@ void ShapeMeshes::DrawPlaneMeshLines()
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMesh() {
-	glBindVertexArray(m_PrismMesh.vao);
+	BindMesh(m_PrismMesh);
 
 	// Draw the base and slanted faces
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
+	DrawMeshArrays(m_PrismMesh, GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
 
-	glBindVertexArray(0); // Unbind the VAO after drawing
+	UnbindMesh(); // Unbind the VAO after drawing
 }
 
 ///////////////////////////////////////////////////
@@ -1692,12 +1450,12 @@ void ShapeMeshes::DrawPrismMesh() {
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMeshLines() {
-	glBindVertexArray(m_PrismMesh.vao);
+	BindMesh(m_PrismMesh);
 
 	// Use GL_LINE_LOOP or GL_LINE_STRIP for wireframe rendering
-	glDrawArrays(GL_LINE_STRIP, 0, m_PrismMesh.nVertices);
+	DrawMeshArrays(m_PrismMesh, GL_LINE_STRIP, 0, m_PrismMesh.nVertices);
 
-	glBindVertexArray(0); // Unbind the VAO after drawing
+	UnbindMesh(); // Unbind the VAO after drawing
 }
 
 ///////////////////////////////////////////////////
@@ -1713,11 +1471,11 @@ void ShapeMeshes::DrawPyramid3Mesh()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid3Mesh.vao);
+	BindMesh(m_Pyramid3Mesh);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
+	DrawMeshArrays(m_Pyramid3Mesh, GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1733,11 +1491,11 @@ void ShapeMeshes::DrawPyramid3MeshLines()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid3Mesh.vao);
+	BindMesh(m_Pyramid3Mesh);
 
-	glDrawArrays(GL_LINE_STRIP, 0, m_Pyramid3Mesh.nVertices);
+	DrawMeshArrays(m_Pyramid3Mesh, GL_LINE_STRIP, 0, m_Pyramid3Mesh.nVertices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1753,11 +1511,11 @@ void ShapeMeshes::DrawPyramid4Mesh()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid4Mesh.vao);
+	BindMesh(m_Pyramid4Mesh);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+	DrawMeshArrays(m_Pyramid4Mesh, GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1773,11 +1531,11 @@ void ShapeMeshes::DrawPyramid4MeshLines()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid4Mesh.vao);
+	BindMesh(m_Pyramid4Mesh);
 
-	glDrawArrays(GL_LINE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+	DrawMeshArrays(m_Pyramid4Mesh, GL_LINE_STRIP, 0, m_Pyramid4Mesh.nVertices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 
@@ -1789,21 +1547,21 @@ void ShapeMeshes::DrawSphereMesh()
 		return;
 	}
 
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh);
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices, GL_UNSIGNED_INT, nullptr);
+	DrawMeshElements(m_SphereMesh, GL_TRIANGLES, m_SphereMesh.nIndices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 
 void ShapeMeshes::DrawSphereMeshLines()
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh);
 
-	glDrawElements(GL_LINE_STRIP, m_SphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawMeshElements(m_SphereMesh, GL_LINE_STRIP, m_SphereMesh.nIndices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 void ShapeMeshes::DrawHalfSphereMesh()
@@ -1814,11 +1572,11 @@ void ShapeMeshes::DrawHalfSphereMesh()
 		return;
 	}
 
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh);
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices / 2, GL_UNSIGNED_INT, nullptr);
+	DrawMeshElements(m_SphereMesh, GL_TRIANGLES, m_SphereMesh.nIndices / 2);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 void ShapeMeshes::DrawHalfSphereMeshLines()
@@ -1829,11 +1587,11 @@ void ShapeMeshes::DrawHalfSphereMeshLines()
 		return;
 	}
 
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh);
 
-	glDrawElements(GL_LINES, m_SphereMesh.nIndices / 2, GL_UNSIGNED_INT, nullptr);
+	DrawMeshElements(m_SphereMesh, GL_LINES, m_SphereMesh.nIndices / 2);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1847,22 +1605,22 @@ void ShapeMeshes::DrawTaperedCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	BindMesh(m_TaperedCylinderMesh);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_TRIANGLE_FAN, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 72);	//top
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_TRIANGLE_FAN, 36, 72);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_TRIANGLE_STRIP, 72, 146);	//sides
 	}
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1876,22 +1634,22 @@ void ShapeMeshes::DrawTaperedCylinderMeshLines(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	BindMesh(m_TaperedCylinderMesh);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_LINES, 0, 36);	//bottom
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_LINES, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_LINES, 36, 72);	//top
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_LINES, 36, 72);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_LINE_STRIP, 72, 146);	//sides
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_LINE_STRIP, 72, 146);	//sides
 	}
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1902,12 +1660,12 @@ void ShapeMeshes::DrawTaperedCylinderMeshLines(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh);
 
 	// Use indexed drawing
-	glDrawElements(GL_TRIANGLES, m_TorusMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawMeshElements(m_TorusMesh, GL_TRIANGLES, m_TorusMesh.nIndices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1918,12 +1676,12 @@ void ShapeMeshes::DrawTorusMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawTorusMeshLines()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh);
 
 	// Use indexed drawing for lines
-	glDrawElements(GL_LINES, m_TorusMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawMeshElements(m_TorusMesh, GL_LINES, m_TorusMesh.nIndices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 
@@ -1935,11 +1693,11 @@ void ShapeMeshes::DrawTorusMeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawExtraTorusMesh1()
 {
-	glBindVertexArray(m_ExtraTorusMesh1.vao);
+	BindMesh(m_ExtraTorusMesh1);
 
-	glDrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh1.nVertices);
+	DrawMeshArrays(m_ExtraTorusMesh1, GL_TRIANGLES, 0, m_ExtraTorusMesh1.nVertices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1950,11 +1708,11 @@ void ShapeMeshes::DrawExtraTorusMesh1()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawExtraTorusMesh2()
 {
-	glBindVertexArray(m_ExtraTorusMesh2.vao);
+	BindMesh(m_ExtraTorusMesh2);
 
-	glDrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh2.nVertices);
+	DrawMeshArrays(m_ExtraTorusMesh2, GL_TRIANGLES, 0, m_ExtraTorusMesh2.nVertices);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1965,12 +1723,12 @@ void ShapeMeshes::DrawExtraTorusMesh2()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh);
 
 	// Use indexed drawing for half the indices
-	glDrawElements(GL_TRIANGLES, m_TorusMesh.nIndices / 2, GL_UNSIGNED_INT, (void*)0);
+	DrawMeshElements(m_TorusMesh, GL_TRIANGLES, m_TorusMesh.nIndices / 2);
 
-	glBindVertexArray(0);
+	UnbindMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1981,14 +1739,756 @@ void ShapeMeshes::DrawHalfTorusMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfTorusMeshLines()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh);
 
 	// Use indexed drawing for half the indices in line mode
-	glDrawElements(GL_LINES, m_TorusMesh.nIndices / 2, GL_UNSIGNED_INT, (void*)0);
+	DrawMeshElements(m_TorusMesh, GL_LINES, m_TorusMesh.nIndices / 2);
+
+	UnbindMesh();
+}
+
+//**************************************************************************
+// The following set of methods are called to draw many copies of the basic
+// 3D shapes with a single draw call.  The model matrix of each copy, and an
+// optional color that is multiplied with the object color, are passed to the
+// vertex shader as per-instance attributes.  When no colors are passed, every
+// copy uses the object color as is.
+//**************************************************************************
+
+///////////////////////////////////////////////////
+//	DrawBoxMeshInstanced()
+//
+//	Draw a copy of the box mesh for every passed in
+//	model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawBoxMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (SetInstanceData(m_BoxMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	DrawMeshElements(m_BoxMesh, GL_TRIANGLES, m_BoxMesh.nIndices, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawConeMeshInstanced()
+//
+//	Draw a copy of the cone mesh for every passed in
+//	model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawConeMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count, bool bDrawBottom)
+{
+	if (SetInstanceData(m_ConeMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	int bottomVertexCount = m_ConeMesh.numSlices + 2;
+	int sideVertexCount = m_ConeMesh.numSlices * 2;
+
+	if (bDrawBottom) {
+		DrawMeshArrays(m_ConeMesh, GL_TRIANGLE_FAN, 0, bottomVertexCount, count);
+	}
+	DrawMeshArrays(m_ConeMesh, GL_TRIANGLE_STRIP, bottomVertexCount, sideVertexCount, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawCylinderMeshInstanced()
+//
+//	Draw a copy of the cylinder mesh for every passed
+//	in model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawCylinderMeshInstanced(
+	const glm::mat4* models,
+	const glm::vec4* colors,
+	size_t count,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	if (SetInstanceData(m_CylinderMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	int bottomVertexCount = m_CylinderMesh.numSlices + 2;
+	int topVertexCount = m_CylinderMesh.numSlices + 2;
+	int sideVertexCount = (m_CylinderMesh.numSlices + 1) * 2;
+
+	if (bDrawBottom) {
+		DrawMeshArrays(m_CylinderMesh, GL_TRIANGLE_FAN, 0, bottomVertexCount, count);
+	}
+	if (bDrawTop) {
+		DrawMeshArrays(m_CylinderMesh, GL_TRIANGLE_FAN, bottomVertexCount, topVertexCount, count);
+	}
+	if (bDrawSides) {
+		DrawMeshArrays(m_CylinderMesh, GL_TRIANGLE_STRIP, bottomVertexCount + topVertexCount, sideVertexCount, count);
+	}
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawPlaneMeshInstanced()
+//
+//	Draw a copy of the plane mesh for every passed in
+//	model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPlaneMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (SetInstanceData(m_PlaneMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	DrawMeshElements(m_PlaneMesh, GL_TRIANGLE_STRIP, m_PlaneMesh.nIndices, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawPrismMeshInstanced()
+//
+//	Draw a copy of the prism mesh for every passed in
+//	model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPrismMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (SetInstanceData(m_PrismMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	DrawMeshArrays(m_PrismMesh, GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawPyramid3MeshInstanced()
+//
+//	Draw a copy of the 3-sided pyramid mesh for every
+//	passed in model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPyramid3MeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (SetInstanceData(m_Pyramid3Mesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	DrawMeshArrays(m_Pyramid3Mesh, GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawPyramid4MeshInstanced()
+//
+//	Draw a copy of the 4-sided pyramid mesh for every
+//	passed in model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPyramid4MeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (SetInstanceData(m_Pyramid4Mesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	DrawMeshArrays(m_Pyramid4Mesh, GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawSphereMeshInstanced()
+//
+//	Draw a copy of the sphere mesh for every passed in
+//	model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawSphereMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (SetInstanceData(m_SphereMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	DrawMeshElements(m_SphereMesh, GL_TRIANGLES, m_SphereMesh.nIndices, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawTaperedCylinderMeshInstanced()
+//
+//	Draw a copy of the tapered cylinder mesh for every
+//	passed in model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawTaperedCylinderMeshInstanced(
+	const glm::mat4* models,
+	const glm::vec4* colors,
+	size_t count,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	if (SetInstanceData(m_TaperedCylinderMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	if (bDrawBottom == true)
+	{
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_TRIANGLE_FAN, 0, 36, count);	//bottom
+	}
+	if (bDrawTop == true)
+	{
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_TRIANGLE_FAN, 36, 72, count);	//top
+	}
+	if (bDrawSides == true)
+	{
+		DrawMeshArrays(m_TaperedCylinderMesh, GL_TRIANGLE_STRIP, 72, 146, count);	//sides
+	}
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawTorusMeshInstanced()
+//
+//	Draw a copy of the torus mesh for every passed in
+//	model matrix.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawTorusMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (SetInstanceData(m_TorusMesh, models, colors, count) == false)
+	{
+		return;
+	}
+
+	DrawMeshElements(m_TorusMesh, GL_TRIANGLES, m_TorusMesh.nIndices, count);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	SetLODView()
+//
+//	Set the camera values used to select the levels
+//	of detail of the LOD chains.
+///////////////////////////////////////////////////
+void ShapeMeshes::SetLODView(const LOD_VIEW& view)
+{
+	m_lodView = view;
+}
+
+///////////////////////////////////////////////////
+//	Get...Bounds()
+//
+//	Return the bounding sphere of the loaded sphere,
+//	torus or cylinder mesh in its own coordinates.
+//	The coarser levels of detail share these bounds.
+///////////////////////////////////////////////////
+ShapeMeshes::BOUNDING_SPHERE ShapeMeshes::GetSphereBounds() const
+{
+	return(m_SphereMesh.bounds);
+}
+
+ShapeMeshes::BOUNDING_SPHERE ShapeMeshes::GetTorusBounds() const
+{
+	return(m_TorusMesh.bounds);
+}
+
+ShapeMeshes::BOUNDING_SPHERE ShapeMeshes::GetCylinderBounds() const
+{
+	return(m_CylinderMesh.bounds);
+}
+
+///////////////////////////////////////////////////
+//	DrawSphereMeshLOD()
+//
+//	Draw the level of the sphere mesh selected for
+//	the passed in world-space bounds.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawSphereMeshLOD(const BOUNDING_SPHERE& worldBounds)
+{
+	const GLMesh& mesh = SelectLODLevel(m_SphereLOD, worldBounds);
+
+	BindMesh(mesh);
+
+	DrawMeshElements(mesh, GL_TRIANGLES, mesh.nIndices);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawHalfSphereMeshLOD()
+//
+//	Draw the top half of the level of the sphere mesh
+//	selected for the passed in world-space bounds.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawHalfSphereMeshLOD(const BOUNDING_SPHERE& worldBounds)
+{
+	const GLMesh& mesh = SelectLODLevel(m_SphereLOD, worldBounds);
+
+	BindMesh(mesh);
+
+	DrawMeshElements(mesh, GL_TRIANGLES, mesh.nIndices / 2);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawTorusMeshLOD()
+//
+//	Draw the level of the torus mesh selected for
+//	the passed in world-space bounds.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawTorusMeshLOD(const BOUNDING_SPHERE& worldBounds)
+{
+	const GLMesh& mesh = SelectLODLevel(m_TorusLOD, worldBounds);
+
+	BindMesh(mesh);
+
+	DrawMeshElements(mesh, GL_TRIANGLES, mesh.nIndices);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawHalfTorusMeshLOD()
+//
+//	Draw half of the level of the torus mesh selected
+//	for the passed in world-space bounds.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawHalfTorusMeshLOD(const BOUNDING_SPHERE& worldBounds)
+{
+	const GLMesh& mesh = SelectLODLevel(m_TorusLOD, worldBounds);
+
+	BindMesh(mesh);
+
+	DrawMeshElements(mesh, GL_TRIANGLES, mesh.nIndices / 2);
+
+	UnbindMesh();
+}
+
+///////////////////////////////////////////////////
+//	DrawCylinderMeshLOD()
+//
+//	Draw the parts of the level of the cylinder mesh
+//	selected for the passed in world-space bounds.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawCylinderMeshLOD(
+	const BOUNDING_SPHERE& worldBounds,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	DrawCylinderParts(SelectLODLevel(m_CylinderLOD, worldBounds), bDrawTop, bDrawBottom, bDrawSides);
+}
+
+///////////////////////////////////////////////////
+//	SetInstanceData()
+//
+//	Upload the per-instance model matrices and colors
+//	into the instance buffer and attach them to the
+//	VAO of the passed in mesh.  The VAO is left bound
+//	for drawing.
+///////////////////////////////////////////////////
+bool ShapeMeshes::SetInstanceData(const GLMesh& mesh, const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	if (mesh.vao == 0) {
+		std::cerr << "Error: Mesh not loaded before instanced drawing." << std::endl;
+		return false;
+	}
+	if (models == nullptr || count == 0) {
+		return false;
+	}
+
+	// the draw filter and the recorder read the instance data
+	// of the following draws
+	m_pInstanceModels = models;
+	m_pInstanceColors = colors;
+
+	// recorded draws keep the instance data with the draw
+	// commands, so nothing is uploaded here
+	if (m_pDrawRecorder != nullptr && mesh.vao == m_PackedMesh.vao)
+	{
+		return true;
+	}
+
+	UploadInstanceData(mesh, models, colors, count);
+
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	UploadInstanceData()
+//
+//	Upload the per-instance model matrices and colors
+//	and attach them to the VAO of the passed in mesh,
+//	which is left bound.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadInstanceData(const GLMesh& mesh, const glm::mat4* models, const glm::vec4* colors, size_t count)
+{
+	// Attribute location definitions - a mat4 attribute
+	// takes up four consecutive locations
+	constexpr GLuint INSTANCE_MODEL_ATTR_LOCATION = 3;
+	constexpr GLuint INSTANCE_COLOR_ATTR_LOCATION = 7;
+
+	if (m_instanceVBO == 0) {
+		glGenBuffers(1, &m_instanceVBO);
+	}
+
+	GLsizeiptr modelsSize = sizeof(glm::mat4) * count;
+	GLsizeiptr colorsSize = (colors != nullptr) ? sizeof(glm::vec4) * count : 0;
+
+	BindMesh(mesh);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+
+	// orphan the previous contents so the upload does not
+	// have to wait for earlier draws to finish with them
+	glBufferData(GL_ARRAY_BUFFER, modelsSize + colorsSize, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, modelsSize, models);
+	if (colors != nullptr) {
+		glBufferSubData(GL_ARRAY_BUFFER, modelsSize, colorsSize, colors);
+	}
+
+	// one column of the model matrix per attribute location
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(
+			INSTANCE_MODEL_ATTR_LOCATION + column,
+			4,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(glm::mat4),
+			reinterpret_cast<void*>(sizeof(glm::vec4) * column));
+		glEnableVertexAttribArray(INSTANCE_MODEL_ATTR_LOCATION + column);
+		glVertexAttribDivisor(INSTANCE_MODEL_ATTR_LOCATION + column, 1);
+	}
+
+	if (colors != nullptr)
+	{
+		glVertexAttribPointer(
+			INSTANCE_COLOR_ATTR_LOCATION,
+			4,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(glm::vec4),
+			reinterpret_cast<void*>(modelsSize));
+		glEnableVertexAttribArray(INSTANCE_COLOR_ATTR_LOCATION);
+		glVertexAttribDivisor(INSTANCE_COLOR_ATTR_LOCATION, 1);
+	}
+	else
+	{
+		// without per-instance colors the object color is used as is
+		glDisableVertexAttribArray(INSTANCE_COLOR_ATTR_LOCATION);
+		glVertexAttrib4f(INSTANCE_COLOR_ATTR_LOCATION, 1.0f, 1.0f, 1.0f, 1.0f);
+	}
+}
+
+///////////////////////////////////////////////////
+//	DetachInstanceData()
+//
+//	Disable the per-instance attributes of the bound
+//	VAO and clear their divisors.  The instance buffer
+//	is only sized for the last instanced draw, so the
+//	later draws of the VAO must not source from it.
+///////////////////////////////////////////////////
+void ShapeMeshes::DetachInstanceData() const
+{
+	// Attribute location definitions - a mat4 attribute
+	// takes up four consecutive locations
+	constexpr GLuint INSTANCE_MODEL_ATTR_LOCATION = 3;
+	constexpr GLuint INSTANCE_COLOR_ATTR_LOCATION = 7;
+
+	for (GLuint location = INSTANCE_MODEL_ATTR_LOCATION; location <= INSTANCE_COLOR_ATTR_LOCATION; location++)
+	{
+		glDisableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 0);
+	}
+}
+
+///////////////////////////////////////////////////
+//	UploadMesh()
+//
+//	Store the passed in vertex and index data for a
+//	mesh in GPU memory.  Outside of packed loading the
+//	mesh gets its own VAO and buffers; while packing,
+//	the data is appended to the shared buffers and the
+//	mesh records where its data starts.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadMesh(
+	GLMesh& mesh,
+	const GLfloat* vertices,
+	size_t vertexFloatCount,
+	const GLuint* indices,
+	size_t indexCount)
+{
+	mesh.vbos[0] = 0;
+	mesh.vbos[1] = 0;
+
+	// the bounding sphere is centered on the box around the
+	// vertex positions and reaches the farthest vertex
+	const GLuint floatsPerVertex = FloatsPerVertex + FloatsPerNormal + FloatsPerUV;
+	glm::vec3 minimum(0.0f);
+	glm::vec3 maximum(0.0f);
+	for (size_t i = 0; i < vertexFloatCount; i += floatsPerVertex)
+	{
+		glm::vec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+		minimum = (i == 0) ? position : glm::min(minimum, position);
+		maximum = (i == 0) ? position : glm::max(maximum, position);
+	}
+	mesh.bounds.center = 0.5f * (minimum + maximum);
+	mesh.bounds.radius = 0.0f;
+	for (size_t i = 0; i < vertexFloatCount; i += floatsPerVertex)
+	{
+		glm::vec3 position(vertices[i], vertices[i + 1], vertices[i + 2]);
+		mesh.bounds.radius = std::max(mesh.bounds.radius, glm::length(position - mesh.bounds.center));
+	}
+
+	if (m_bPackedLoad)
+	{
+		mesh.vao = 0;
+		mesh.baseVertex = static_cast<GLint>(m_packedVertices.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
+		mesh.firstIndex = static_cast<GLuint>(m_packedIndices.size());
+
+		m_packedVertices.insert(m_packedVertices.end(), vertices, vertices + vertexFloatCount);
+		if (indexCount > 0) {
+			m_packedIndices.insert(m_packedIndices.end(), indices, indices + indexCount);
+		}
+		m_packedMeshes.push_back(&mesh);
+		return;
+	}
+
+	mesh.baseVertex = 0;
+	mesh.firstIndex = 0;
+
+	// Generate VAO and VBOs
+	glGenVertexArrays(1, &mesh.vao);
+	GLStateCache::BindVertexArray(mesh.vao);
+
+	glGenBuffers((indexCount > 0) ? 2 : 1, mesh.vbos);
+
+	// Upload vertex data
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, vertexFloatCount * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
+
+	// Upload index data
+	if (indexCount > 0) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
+	}
+
+	if (!m_bMemoryLayoutDone) {
+		SetShaderMemoryLayout();
+	}
 
-	glBindVertexArray(0);
+	// Unbind VAO for safety
+	GLStateCache::BindVertexArray(0);
+}
+
+///////////////////////////////////////////////////
+//	UploadGeneratedMesh()
+//
+//	Store the mesh data last written by the mesh
+//	generator for the passed in mesh.  The generated
+//	vertices are already interleaved in the layout of
+//	the vertex buffer, so they are uploaded as they are.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadGeneratedMesh(GLMesh& mesh)
+{
+	static_assert(sizeof(MeshGenerator::VERTEX) == (FloatsPerVertex + FloatsPerNormal + FloatsPerUV) * sizeof(GLfloat),
+		"generated vertices must match the vertex buffer layout");
+
+	const std::vector<MeshGenerator::VERTEX>& vertices = m_generatedMesh.vertices;
+	const std::vector<unsigned int>& indices = m_generatedMesh.indices;
+
+	mesh.nVertices = static_cast<GLuint>(vertices.size());
+	mesh.nIndices = static_cast<GLuint>(indices.size());
+
+	UploadMesh(
+		mesh,
+		reinterpret_cast<const GLfloat*>(vertices.data()),
+		vertices.size() * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV),
+		indices.empty() ? nullptr : indices.data(),
+		indices.size());
+}
+
+///////////////////////////////////////////////////
+//	BindMesh()
+//
+//	Bind the VAO of the passed in mesh for drawing.
+//	The state cache skips the bind when the VAO is
+//	already active, as for the shared packed VAO.
+///////////////////////////////////////////////////
+void ShapeMeshes::BindMesh(const GLMesh& mesh) const
+{
+	GLStateCache::BindVertexArray(mesh.vao);
+}
+
+///////////////////////////////////////////////////
+//	UnbindMesh()
+//
+//	End the draw of a mesh.  The VAO stays bound, so
+//	that drawing the same mesh again does not bind it,
+//	and every VAO is bound through the state cache.
+///////////////////////////////////////////////////
+void ShapeMeshes::UnbindMesh() const
+{
+	// the instance data of an instanced draw ends with the draw
+	if (m_pInstanceModels != nullptr) {
+		DetachInstanceData();
+	}
+	m_pInstanceModels = nullptr;
+	m_pInstanceColors = nullptr;
+}
+
+///////////////////////////////////////////////////
+//	DrawMeshArrays()
+//
+//	Draw a range of the mesh vertices, offset by the
+//	base vertex of the mesh.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawMeshArrays(const GLMesh& mesh, GLenum mode, GLint first, GLsizei count, size_t instanceCount) const
+{
+	PROFILE_ZONE("ShapeMeshes::DrawMeshArrays");
+
+	if (m_pDrawFilter != nullptr &&
+		m_pDrawFilter->AcceptDraw(mesh.bounds, m_pInstanceModels, instanceCount) == false) {
+		return;
+	}
+	if (RecordMeshDraw(mesh, mode, first, count, false, instanceCount)) {
+		return;
+	}
+
+	m_drawCallCount++;
+
+	if (instanceCount == 1) {
+		glDrawArrays(mode, mesh.baseVertex + first, count);
+	}
+	else {
+		glDrawArraysInstanced(mode, mesh.baseVertex + first, count, static_cast<GLsizei>(instanceCount));
+	}
 }
 
+///////////////////////////////////////////////////
+//	DrawMeshElements()
+//
+//	Draw the first count indices of the mesh, offset
+//	by the first index and base vertex of the mesh.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawMeshElements(const GLMesh& mesh, GLenum mode, GLsizei count, size_t instanceCount) const
+{
+	PROFILE_ZONE("ShapeMeshes::DrawMeshElements");
+
+	if (m_pDrawFilter != nullptr &&
+		m_pDrawFilter->AcceptDraw(mesh.bounds, m_pInstanceModels, instanceCount) == false) {
+		return;
+	}
+	if (RecordMeshDraw(mesh, mode, 0, count, true, instanceCount)) {
+		return;
+	}
+
+	m_drawCallCount++;
+
+	const void* indexOffset = reinterpret_cast<const void*>(mesh.firstIndex * sizeof(GLuint));
+
+	if (instanceCount == 1) {
+		glDrawElementsBaseVertex(mode, count, GL_UNSIGNED_INT, indexOffset, mesh.baseVertex);
+	}
+	else {
+		glDrawElementsInstancedBaseVertex(mode, count, GL_UNSIGNED_INT, indexOffset, static_cast<GLsizei>(instanceCount), mesh.baseVertex);
+	}
+}
+
+///////////////////////////////////////////////////
+//	RecordMeshDraw()
+//
+//	Pass a draw of a packed mesh to the draw recorder as
+//	an indexed triangle list command.  Strip and fan
+//	ranges are converted to triangle lists once and
+//	appended to the packed index buffer.  Any other draw
+//	flushes the recorder and must be issued directly.
+///////////////////////////////////////////////////
+bool ShapeMeshes::RecordMeshDraw(const GLMesh& mesh, GLenum mode, GLint first, GLsizei count, bool bIndexed, size_t instanceCount) const
+{
+	if (m_pDrawRecorder == nullptr) {
+		return false;
+	}
+
+	if (mesh.vao == 0 || mesh.vao != m_PackedMesh.vao ||
+		(mode != GL_TRIANGLES && mode != GL_TRIANGLE_STRIP && mode != GL_TRIANGLE_FAN))
+	{
+		// the recorded draws bind the packed VAO, so the mesh
+		// is bound again for the direct draw
+		m_pDrawRecorder->FlushDraws();
+		if (mesh.vao != 0) {
+			BindMesh(mesh);
+		}
+		return false;
+	}
+
+	DRAW_COMMAND command;
+	command.count = static_cast<GLuint>(count);
+	command.instanceCount = static_cast<GLuint>(instanceCount);
+	command.firstIndex = mesh.firstIndex;
+	command.baseVertex = mesh.baseVertex;
+	command.baseInstance = 0;
+
+	if (mode != GL_TRIANGLES || bIndexed == false)
+	{
+		// indexed ranges keep indices relative to the base vertex,
+		// vertex ranges are converted to absolute vertex indices
+		GLuint start = bIndexed ? mesh.firstIndex : static_cast<GLuint>(mesh.baseVertex + first);
+		std::array<GLuint, 4> key = { static_cast<GLuint>(mode), bIndexed ? 1u : 0u, start, static_cast<GLuint>(count) };
+
+		auto range = m_triangleRanges.find(key);
+		if (range == m_triangleRanges.end())
+		{
+			std::vector<GLuint> source(count);
+			for (GLsizei i = 0; i < count; i++)
+			{
+				source[i] = bIndexed ? m_packedIndices[start + i] : start + i;
+			}
+
+			std::vector<GLuint> triangles;
+			for (GLsizei i = 0; i + 2 < count; i++)
+			{
+				if (mode == GL_TRIANGLE_FAN) {
+					triangles.insert(triangles.end(), { source[0], source[i + 1], source[i + 2] });
+				}
+				else if (mode == GL_TRIANGLE_STRIP && (i % 2) == 1) {
+					// odd strip triangles are flipped to keep the winding
+					triangles.insert(triangles.end(), { source[i + 1], source[i], source[i + 2] });
+				}
+				else {
+					triangles.insert(triangles.end(), { source[i], source[i + 1], source[i + 2] });
+				}
+			}
+
+			range = m_triangleRanges.insert(std::make_pair(key, static_cast<GLuint>(m_packedIndices.size()))).first;
+			m_packedIndices.insert(m_packedIndices.end(), triangles.begin(), triangles.end());
+			m_bPackedIndicesDirty = true;
+		}
+
+		command.count = (count > 2) ? static_cast<GLuint>(count - 2) * 3 : 0;
+		command.firstIndex = range->second;
+		command.baseVertex = bIndexed ? mesh.baseVertex : 0;
+	}
+
+	if (command.count > 0) {
+		m_pDrawRecorder->RecordDraw(command, m_pInstanceModels, m_pInstanceColors);
+	}
+
+	return true;
+}
 
 glm::vec3 ShapeMeshes::QuadCrossProduct(
 	glm::vec3 pnt0, glm::vec3 pnt1, glm::vec3 pnt2, glm::vec3 pnt3)
@@ -2072,3 +2572,76 @@ void ShapeMeshes::SetShaderMemoryLayout()
     );
     glEnableVertexAttribArray(UV_ATTR_LOCATION);
 }
+
+///////////////////////////////////////////////////
+//	SelectLODLevel()
+//
+//	Return the coarsest level of the LOD chain whose
+//	geometric error, projected at the distance of the
+//	nearest point of the passed in world-space bounds,
+//	stays under the pixel threshold of the LOD view.
+///////////////////////////////////////////////////
+const ShapeMeshes::GLMesh& ShapeMeshes::SelectLODLevel(const LOD_CHAIN& chain, const BOUNDING_SPHERE& worldBounds) const
+{
+	if (chain.levelCount <= 1 || m_lodView.pixelThreshold <= 0.0f) {
+		return *chain.levels[0];
+	}
+
+	float pixelsPerUnit = m_lodView.projectionScale;
+	if (!m_lodView.bOrthographic)
+	{
+		float distance = glm::length(worldBounds.center - m_lodView.cameraPosition) - worldBounds.radius;
+
+		// the camera is inside the bounds of the object
+		if (distance <= 0.0f) {
+			return *chain.levels[0];
+		}
+		pixelsPerUnit /= distance;
+	}
+
+	for (int level = chain.levelCount - 1; level > 0; level--)
+	{
+		float pixelError = chain.levelErrors[level] * worldBounds.radius * pixelsPerUnit;
+		if (pixelError <= m_lodView.pixelThreshold) {
+			return *chain.levels[level];
+		}
+	}
+	return *chain.levels[0];
+}
+
+///////////////////////////////////////////////////
+//	DrawCylinderParts()
+//
+//	Draw the top, bottom and sides of the passed in
+//	cylinder mesh.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawCylinderParts(
+	const GLMesh& mesh,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	BindMesh(mesh);
+
+	// Calculate vertex counts
+	int bottomVertexCount = mesh.numSlices + 2; // Center + all slices + closing slice
+	int topVertexCount = mesh.numSlices + 2;    // Same as bottom
+	int sideVertexCount = (mesh.numSlices + 1) * 2; // Two vertices per slice, +1 for closing strip
+
+	// Draw the bottom circle
+	if (bDrawBottom) {
+		DrawMeshArrays(mesh, GL_TRIANGLE_FAN, 0, bottomVertexCount);
+	}
+
+	// Draw the top circle
+	if (bDrawTop) {
+		DrawMeshArrays(mesh, GL_TRIANGLE_FAN, bottomVertexCount, topVertexCount);
+	}
+
+	// Draw the sides
+	if (bDrawSides) {
+		DrawMeshArrays(mesh, GL_TRIANGLE_STRIP, bottomVertexCount + topVertexCount, sideVertexCount);
+	}
+
+	UnbindMesh();
+}
@@ -12,8 +12,14 @@
 
 #include <GL/glew.h>
 
+#include "meshgenerator.h"
+
 #include <glm/glm.hpp>
 
+#include <array>
+#include <map>
+#include <vector>
+
 /***********************************************************
  *  ShapeMeshes
  *
@@ -26,6 +32,63 @@ public:
 	// constructor
 	ShapeMeshes();
 
+	// layout of one glMultiDrawElementsIndirect command
+	struct DRAW_COMMAND
+	{
+		GLuint count;          // Number of indices to draw
+		GLuint instanceCount;  // Number of instances to draw
+		GLuint firstIndex;     // First index in the packed index buffer
+		GLint baseVertex;      // Value added to every index
+		GLuint baseInstance;   // First per-object index for the draw
+	};
+
+	// receives the draws of the packed meshes instead of having
+	// them issued to OpenGL, so that they can be batched into
+	// indirect draw commands - the models and colors are only
+	// set for the instanced drawing methods
+	class DrawRecorder
+	{
+	public:
+		virtual ~DrawRecorder() {}
+		virtual void RecordDraw(const DRAW_COMMAND& command, const glm::mat4* models, const glm::vec4* colors) = 0;
+		// called before a draw that cannot be recorded is issued
+		virtual void FlushDraws() = 0;
+	};
+
+	// sphere that bounds a mesh or a drawn object
+	struct BOUNDING_SPHERE
+	{
+		glm::vec3 center;
+		float radius;
+	};
+
+	// camera values used to select the level of detail
+	// of the meshes loaded as LOD chains
+	struct LOD_VIEW
+	{
+		glm::vec3 cameraPosition;
+		// pixels covered by one world unit at a distance of one,
+		// or at any distance for orthographic projections
+		float projectionScale;
+		bool bOrthographic;
+		// largest screen-space error allowed for a coarser level,
+		// in pixels - zero always selects the finest level
+		float pixelThreshold;
+	};
+
+	// largest number of levels in a LOD chain
+	static constexpr int MAX_LOD_LEVELS = 4;
+
+	// decides whether each draw of a mesh is issued, so that
+	// the objects outside of the view can be skipped - the
+	// models are only set for the instanced drawing methods
+	class DrawFilter
+	{
+	public:
+		virtual ~DrawFilter() {}
+		virtual bool AcceptDraw(const BOUNDING_SPHERE& meshBounds, const glm::mat4* models, size_t instanceCount) = 0;
+	};
+
 private:
 
 	// stores the GL data relative to a given mesh
@@ -36,6 +99,9 @@ private:
 		GLuint nVertices;	// Number of vertices for the mesh
 		GLuint nIndices;    // Number of indices for the mesh
 		int numSlices;      // Number of slices (specific to cone or other parameterized shapes)
+		GLint baseVertex;   // First vertex of the mesh in its vertex buffer
+		GLuint firstIndex;  // First index of the mesh in its index buffer
+		BOUNDING_SPHERE bounds; // Sphere around the vertices of the mesh
 	};
 
 	// the available 3D shapes
@@ -53,8 +119,65 @@ private:
 	GLMesh m_ExtraTorusMesh1;
 	GLMesh m_ExtraTorusMesh2;
 
+	// levels of detail of a parameterized mesh, finest first
+	struct LOD_CHAIN
+	{
+		GLMesh* levels[MAX_LOD_LEVELS];
+		// largest distance between each level and the smooth
+		// surface, relative to the bounding radius
+		float levelErrors[MAX_LOD_LEVELS];
+		int levelCount;
+	};
+
+	// the coarser levels of the sphere, torus and cylinder meshes
+	// - the finest level of each chain is the mesh above
+	GLMesh m_SphereLODMeshes[MAX_LOD_LEVELS - 1];
+	GLMesh m_TorusLODMeshes[MAX_LOD_LEVELS - 1];
+	GLMesh m_CylinderLODMeshes[MAX_LOD_LEVELS - 1];
+	LOD_CHAIN m_SphereLOD;
+	LOD_CHAIN m_TorusLOD;
+	LOD_CHAIN m_CylinderLOD;
+	// camera values for the level of detail selection
+	LOD_VIEW m_lodView;
+
 	bool m_bMemoryLayoutDone;
 
+	// buffer holding the per-instance model matrices and
+	// colors for the instanced drawing methods
+	GLuint m_instanceVBO;
+
+	// when packing, loaded meshes are collected into one
+	// shared vertex buffer and index buffer with one VAO
+	bool m_bPackedLoad;
+	GLMesh m_PackedMesh;
+	std::vector<GLfloat> m_packedVertices;
+	// (the indices grow when ranges are recorded as triangle lists)
+	mutable std::vector<GLuint> m_packedIndices;
+	std::vector<GLMesh*> m_packedMeshes;
+
+	// when set, the triangle draws of packed meshes are passed
+	// to the recorder as indirect draw commands
+	DrawRecorder* m_pDrawRecorder;
+	// when set, every draw is issued only if the filter accepts it
+	DrawFilter* m_pDrawFilter;
+	// per-instance data of the current instanced draw
+	mutable const glm::mat4* m_pInstanceModels;
+	mutable const glm::vec4* m_pInstanceColors;
+	// strip and fan ranges converted to triangle lists in the
+	// packed index buffer, keyed by mode, indexing, start and count
+	mutable std::map<std::array<GLuint, 4>, GLuint> m_triangleRanges;
+	mutable bool m_bPackedIndicesDirty;
+	// buffers for the indirect draw commands and the per-object
+	// index attribute that is read by the indirect draws
+	GLuint m_indirectBuffer;
+	GLuint m_objectIndexVBO;
+	size_t m_objectIndexCount;
+	// number of draw calls issued since the last reset
+	mutable unsigned int m_drawCallCount;
+	// output of the mesh generator, reused by every loaded
+	// shape so that loading does not reallocate it
+	MeshGenerator::MESH_DATA m_generatedMesh;
+
 public:
         enum BoxSide
 	{
@@ -66,6 +189,30 @@ public:
 		bottom
 	}; 
 
+	// methods for packing all of the meshes loaded between
+	// them into one shared vertex and index buffer, so that
+	// mixed shapes can be drawn without switching VAOs
+	void BeginPackedLoad();
+	void EndPackedLoad();
+
+	// methods for batching the draws of the packed meshes
+	// into indirect draw commands
+	void SetDrawRecorder(DrawRecorder* pRecorder);
+	bool HasPackedMeshes() const;
+	bool IsIndirectDrawSupported() const;
+	void SetIndirectDrawCommands(const DRAW_COMMAND* commands, size_t count);
+	void DrawIndirectCommands(size_t first, size_t count);
+	// draw one recorded command with a direct draw call, for
+	// when the recorded draws are not drawn indirectly
+	void DrawRecordedCommand(const DRAW_COMMAND& command, const glm::mat4* models, const glm::vec4* colors);
+
+	// method for skipping the draws that the filter rejects
+	void SetDrawFilter(DrawFilter* pFilter);
+
+	// methods for counting the issued draw calls
+	unsigned int GetDrawCallCount() const;
+	void ResetDrawCallCount();
+
 	// methods for loading the shape mesh data 
 	// into memory
 	void LoadBoxMesh();
@@ -82,6 +229,14 @@ public:
 	void LoadExtraTorusMesh1(float thickness = 0.4);
 	void LoadExtraTorusMesh2(float thickness = 0.6);
 
+	// methods for loading the sphere, torus and cylinder as LOD
+	// chains - each level halves the tessellation of the level
+	// before it, down to a minimum, and the finest level is the
+	// mesh drawn by the regular drawing methods
+	void LoadSphereMeshLOD(int levelCount = MAX_LOD_LEVELS, int latitudeSegments = 16, int longitudeSegments = 16, float radius = 1.0f);
+	void LoadTorusMeshLOD(int levelCount = MAX_LOD_LEVELS, float mainRadius = 1.0f, float tubeRadius = 0.3f, int mainSegments = 30, int tubeSegments = 30);
+	void LoadCylinderMeshLOD(int levelCount = MAX_LOD_LEVELS, float radius = 1.0f, float height = 1.0f, int numSlices = 36);
+
 	// methods for drawing the filled shape mesh in the
 	// display window
 
@@ -123,6 +278,33 @@ public:
 	void DrawExtraTorusMesh1();
 	void DrawExtraTorusMesh2();
 
+	// methods for drawing many copies of a filled shape mesh
+	// with one draw call - the vertex shader reads the model
+	// matrix and color of each copy as per-instance attributes
+	void DrawBoxMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count);
+	void DrawConeMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count, bool bDrawBottom = true);
+	void DrawCylinderMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count, bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true);
+	void DrawPlaneMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count);
+	void DrawPrismMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count);
+	void DrawPyramid3MeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count);
+	void DrawPyramid4MeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count);
+	void DrawSphereMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count);
+	void DrawTaperedCylinderMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count, bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true);
+	void DrawTorusMeshInstanced(const glm::mat4* models, const glm::vec4* colors, size_t count);
+
+	// methods for drawing the LOD chains - the coarsest level
+	// whose screen-space error at the world-space bounds of the
+	// drawn object stays under the pixel threshold is selected
+	void SetLODView(const LOD_VIEW& view);
+	// the bounding spheres of the meshes in their own coordinates
+	BOUNDING_SPHERE GetSphereBounds() const;
+	BOUNDING_SPHERE GetTorusBounds() const;
+	BOUNDING_SPHERE GetCylinderBounds() const;
+	void DrawSphereMeshLOD(const BOUNDING_SPHERE& worldBounds);
+	void DrawHalfSphereMeshLOD(const BOUNDING_SPHERE& worldBounds);
+	void DrawTorusMeshLOD(const BOUNDING_SPHERE& worldBounds);
+	void DrawHalfTorusMeshLOD(const BOUNDING_SPHERE& worldBounds);
+	void DrawCylinderMeshLOD(const BOUNDING_SPHERE& worldBounds, bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true);
 
 private:
 
@@ -137,4 +319,46 @@ private:
 	// called to set the memory layout 
 	// template for shader data
 	void SetShaderMemoryLayout();
+
+	// called to store the vertex and index data of a mesh
+	// in its own buffers or in the shared packed buffers
+	void UploadMesh(
+		GLMesh& mesh,
+		const GLfloat* vertices,
+		size_t vertexFloatCount,
+		const GLuint* indices = nullptr,
+		size_t indexCount = 0);
+	// called to store the mesh data of the mesh generator
+	void UploadGeneratedMesh(GLMesh& mesh);
+
+	// called to bind and unbind the VAO of a mesh
+	void BindMesh(const GLMesh& mesh) const;
+	void UnbindMesh() const;
+
+	// called to draw a range of the mesh vertices or
+	// indices, relative to the start of the mesh data
+	void DrawMeshArrays(const GLMesh& mesh, GLenum mode, GLint first, GLsizei count, size_t instanceCount = 1) const;
+	void DrawMeshElements(const GLMesh& mesh, GLenum mode, GLsizei count, size_t instanceCount = 1) const;
+
+	// called to upload the per-instance data and attach it
+	// to the passed in vertex array object
+	bool SetInstanceData(const GLMesh& mesh, const glm::mat4* models, const glm::vec4* colors, size_t count);
+	void UploadInstanceData(const GLMesh& mesh, const glm::mat4* models, const glm::vec4* colors, size_t count);
+	// called to detach the per-instance data from the bound
+	// vertex array object after an instanced draw
+	void DetachInstanceData() const;
+
+	// called to upload the triangle lists that were added to
+	// the packed index buffer for recorded strip and fan ranges
+	void UploadPackedIndices();
+
+	// called to pass a draw of a packed mesh to the draw
+	// recorder - returns false if the draw must be issued
+	bool RecordMeshDraw(const GLMesh& mesh, GLenum mode, GLint first, GLsizei count, bool bIndexed, size_t instanceCount) const;
+
+	// called to select the level of a LOD chain for an object
+	// with the passed in world-space bounds
+	const GLMesh& SelectLODLevel(const LOD_CHAIN& chain, const BOUNDING_SPHERE& worldBounds) const;
+	// called to draw the parts of a cylinder mesh
+	void DrawCylinderParts(const GLMesh& mesh, bool bDrawTop, bool bDrawBottom, bool bDrawSides);
 };
\ No newline at end of file
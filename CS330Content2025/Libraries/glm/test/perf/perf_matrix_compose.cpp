@@ -0,0 +1,110 @@
+#define GLM_FORCE_INLINE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/matrix_relational.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/gtx/transform.hpp>
+#include <TransformBuilder.h>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+struct transforms
+{
+	std::vector<glm::vec3> Scales;
+	std::vector<glm::vec3> Rotations;
+	std::vector<glm::vec3> Positions;
+};
+
+static void init_transforms(transforms& T, std::size_t Samples)
+{
+	T.Scales.resize(Samples);
+	T.Rotations.resize(Samples);
+	T.Positions.resize(Samples);
+
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		float const f = static_cast<float>(i);
+		T.Scales[i] = glm::vec3(0.5f + 0.001f * static_cast<float>(i % 1000), 1.0f, 2.0f - 0.001f * static_cast<float>(i % 997));
+		T.Rotations[i] = glm::vec3(static_cast<float>(i % 360), static_cast<float>((i * 7) % 720) - 360.0f, static_cast<float>((i * 13) % 360) * 0.5f);
+		T.Positions[i] = glm::vec3(f * 0.01f, -f * 0.02f, 3.0f);
+	}
+}
+
+static void test_mat_compose_rotate(transforms const& T, std::vector<glm::mat4>& O)
+{
+	for(std::size_t i = 0, n = O.size(); i < n; ++i)
+	{
+		glm::mat4 const Scale = glm::scale(T.Scales[i]);
+		glm::mat4 const RotationX = glm::rotate(glm::radians(T.Rotations[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::mat4 const RotationY = glm::rotate(glm::radians(T.Rotations[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 const RotationZ = glm::rotate(glm::radians(T.Rotations[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 const Translation = glm::translate(T.Positions[i]);
+		O[i] = Translation * RotationZ * RotationY * RotationX * Scale;
+	}
+}
+
+static void test_mat_compose_direct(transforms const& T, std::vector<glm::mat4>& O)
+{
+	for(std::size_t i = 0, n = O.size(); i < n; ++i)
+		O[i] = TransformBuilder::ComposeTransform(T.Scales[i], T.Rotations[i], T.Positions[i]);
+}
+
+static void test_mat_compose_batched(transforms const& T, std::vector<glm::mat4>& O)
+{
+	TransformBuilder::ComposeTransforms(&T.Scales[0], &T.Rotations[0], &T.Positions[0], &O[0], O.size());
+}
+
+template <typename testFunc>
+static int launch_mat_compose(testFunc Test, transforms const& T, std::vector<glm::mat4>& O, std::size_t Samples)
+{
+	O.resize(Samples);
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	Test(T, O);
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+}
+
+static int comp_mat4_compose(std::size_t Samples)
+{
+	int Error = 0;
+
+	transforms T;
+	init_transforms(T, Samples);
+
+	std::vector<glm::mat4> Rotate;
+	std::printf("- translate * rotate * scale: %d us\n", launch_mat_compose(test_mat_compose_rotate, T, Rotate, Samples));
+
+	std::vector<glm::mat4> Direct;
+	std::printf("- direct: %d us\n", launch_mat_compose(test_mat_compose_direct, T, Direct, Samples));
+
+	std::vector<glm::mat4> Batched;
+	std::printf("- batched SIMD: %d us\n", launch_mat_compose(test_mat_compose_batched, T, Batched, Samples));
+
+	for(std::size_t i = 0; i < Samples; ++i)
+	{
+		Error += glm::all(glm::equal(Rotate[i], Direct[i], 0.001f)) ? 0 : 1;
+		Error += glm::all(glm::equal(Rotate[i], Batched[i], 0.001f)) ? 0 : 1;
+	}
+
+	return Error;
+}
+
+int main()
+{
+	int Error = 0;
+
+	std::printf("compose mat4 from TRS, 10k objects:\n");
+	Error += comp_mat4_compose(10000);
+
+	std::printf("compose mat4 from TRS, 100k objects:\n");
+	Error += comp_mat4_compose(100000);
+
+	// the 4 wide path and the one at a time remainder
+	std::printf("compose mat4 from TRS, 7 objects:\n");
+	Error += comp_mat4_compose(7);
+
+	return Error;
+}
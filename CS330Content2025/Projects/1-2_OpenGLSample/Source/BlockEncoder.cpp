@@ -0,0 +1,716 @@
+///////////////////////////////////////////////////////////////////////////////
+// blockencoder.cpp
+// ================
+// compress texture images into BC1 and BC3 blocks on the CPU
+//
+// The endpoints of a color block are the two texels at the ends of the
+// principal axis of the block colors, which is found by power iteration on
+// their covariance.  Each texel takes the index of the nearest of the four
+// palette colors, and the endpoints are then fitted to those indices by least
+// squares, which is kept when it lowers the error of the block.  The nearest
+// palette colors are found for four texels at a time with SSE2 where it is
+// available.  GLM includes the SSE2 intrinsics since the project defines
+// GLM_FORCE_INTRINSICS, like for the transform builder.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BlockEncoder.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// the texels of a 4x4 block, with the color components in
+	// separate arrays so four texels can be loaded at once
+	struct TEXEL_BLOCK
+	{
+		alignas(16) float red[16];
+		alignas(16) float green[16];
+		alignas(16) float blue[16];
+		unsigned char alpha[16];
+	};
+
+	// the four colors a color block can choose from
+	struct COLOR_PALETTE
+	{
+		float red[4];
+		float green[4];
+		float blue[4];
+	};
+
+	// least rows of blocks worth a thread of their own
+	const int MIN_ROWS_PER_THREAD = 8;
+
+	///////////////////////////////////////////////////
+	//	LoadBlock()
+	//
+	//	Read the texels of a block from the image, with
+	//	the texels at the edges repeated outside of it.
+	///////////////////////////////////////////////////
+	void LoadBlock(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int colorChannels,
+		int blockX,
+		int blockY,
+		TEXEL_BLOCK& block)
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			int pixelY = (blockY * 4 + y < height) ? blockY * 4 + y : height - 1;
+			for (int x = 0; x < 4; x++)
+			{
+				int pixelX = (blockX * 4 + x < width) ? blockX * 4 + x : width - 1;
+				const unsigned char* pixel = pixels + (static_cast<size_t>(pixelY) * width + pixelX) * colorChannels;
+				int i = y * 4 + x;
+				block.red[i] = pixel[0];
+				block.green[i] = pixel[1];
+				block.blue[i] = pixel[2];
+				block.alpha[i] = (colorChannels == 4) ? pixel[3] : 255;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	QuantizeColor()
+	//
+	//	Round a color to the nearest 5:6:5 color.
+	///////////////////////////////////////////////////
+	unsigned int QuantizeColor(float red, float green, float blue)
+	{
+		auto quantize = [](float value, int maximum)
+		{
+			value = (value < 0.0f) ? 0.0f : ((value > 255.0f) ? 255.0f : value);
+			return static_cast<unsigned int>(value * maximum / 255.0f + 0.5f);
+		};
+		return((quantize(red, 31) << 11) | (quantize(green, 63) << 5) | quantize(blue, 31));
+	}
+
+	///////////////////////////////////////////////////
+	//	ExpandColor()
+	//
+	//	Expand a 5:6:5 color to 8 bits per component, the
+	//	way the hardware does.
+	///////////////////////////////////////////////////
+	void ExpandColor(unsigned int color, int& red, int& green, int& blue)
+	{
+		int red5 = (color >> 11) & 31;
+		int green6 = (color >> 5) & 63;
+		int blue5 = color & 31;
+		red = (red5 << 3) | (red5 >> 2);
+		green = (green6 << 2) | (green6 >> 4);
+		blue = (blue5 << 3) | (blue5 >> 2);
+	}
+
+	///////////////////////////////////////////////////
+	//	MakePalette()
+	//
+	//	Build the colors of a block from its endpoints.
+	//	The blocks without alpha in BC1 use the third
+	//	color for the middle and the fourth for black
+	//	when the first endpoint is not the greater one.
+	///////////////////////////////////////////////////
+	void MakePalette(unsigned int color0, unsigned int color1, bool bFourColors, int palette[4][3])
+	{
+		ExpandColor(color0, palette[0][0], palette[0][1], palette[0][2]);
+		ExpandColor(color1, palette[1][0], palette[1][1], palette[1][2]);
+		for (int c = 0; c < 3; c++)
+		{
+			if ((true == bFourColors) || (color0 > color1))
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	FindIndices()
+	//
+	//	Find the nearest palette color of every texel of
+	//	a block.  Returns the total squared error, which
+	//	is exact since every term is a small integer.
+	///////////////////////////////////////////////////
+	float FindIndices(const TEXEL_BLOCK& block, const COLOR_PALETTE& palette, unsigned int indices[16])
+	{
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+		__m128 totalError = _mm_setzero_ps();
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128 red = _mm_load_ps(block.red + i);
+			__m128 green = _mm_load_ps(block.green + i);
+			__m128 blue = _mm_load_ps(block.blue + i);
+
+			__m128 bestError = _mm_setzero_ps();
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int k = 0; k < 4; k++)
+			{
+				__m128 dr = _mm_sub_ps(red, _mm_set1_ps(palette.red[k]));
+				__m128 dg = _mm_sub_ps(green, _mm_set1_ps(palette.green[k]));
+				__m128 db = _mm_sub_ps(blue, _mm_set1_ps(palette.blue[k]));
+				__m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+				if (k == 0)
+				{
+					bestError = error;
+					continue;
+				}
+				// the first of equally near colors is kept
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_si128(
+					_mm_and_si128(closer, _mm_set1_epi32(k)),
+					_mm_andnot_si128(closer, bestIndex));
+			}
+			totalError = _mm_add_ps(totalError, bestError);
+
+			alignas(16) int laneIndices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(laneIndices), bestIndex);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				indices[i + lane] = static_cast<unsigned int>(laneIndices[lane]);
+			}
+		}
+
+		alignas(16) float laneErrors[4];
+		_mm_store_ps(laneErrors, totalError);
+		return(laneErrors[0] + laneErrors[1] + laneErrors[2] + laneErrors[3]);
+#else
+		float totalError = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float bestError = 0.0f;
+			unsigned int bestIndex = 0;
+			for (int k = 0; k < 4; k++)
+			{
+				float dr = block.red[i] - palette.red[k];
+				float dg = block.green[i] - palette.green[k];
+				float db = block.blue[i] - palette.blue[k];
+				float error = dr * dr + dg * dg + db * db;
+				if ((k == 0) || (error < bestError))
+				{
+					bestError = error;
+					bestIndex = k;
+				}
+			}
+			indices[i] = bestIndex;
+			totalError += bestError;
+		}
+		return(totalError);
+#endif
+	}
+
+	///////////////////////////////////////////////////
+	//	FindEndpoints()
+	//
+	//	Find the texels at the two ends of the principal
+	//	axis of the colors of a block.
+	///////////////////////////////////////////////////
+	void FindEndpoints(const TEXEL_BLOCK& block, unsigned int& color0, unsigned int& color1)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		float minimum[3] = { 255.0f, 255.0f, 255.0f };
+		float maximum[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			float texel[3] = { block.red[i], block.green[i], block.blue[i] };
+			for (int c = 0; c < 3; c++)
+			{
+				mean[c] += texel[c] / 16.0f;
+				minimum[c] = (texel[c] < minimum[c]) ? texel[c] : minimum[c];
+				maximum[c] = (texel[c] > maximum[c]) ? texel[c] : maximum[c];
+			}
+		}
+
+		// the upper half of the symmetric covariance matrix
+		float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			float r = block.red[i] - mean[0];
+			float g = block.green[i] - mean[1];
+			float b = block.blue[i] - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+
+		// start from the diagonal of the bounding box, which is
+		// already close to the axis for most blocks
+		float axis[3] = { maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2] };
+		for (int iteration = 0; iteration < 4; iteration++)
+		{
+			float next[3] = {
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+			float length = std::fabs(next[0]);
+			length = (std::fabs(next[1]) > length) ? std::fabs(next[1]) : length;
+			length = (std::fabs(next[2]) > length) ? std::fabs(next[2]) : length;
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+
+		int lowest = 0;
+		int highest = 0;
+		float lowestDistance = 0.0f;
+		float highestDistance = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float distance = block.red[i] * axis[0] + block.green[i] * axis[1] + block.blue[i] * axis[2];
+			if ((i == 0) || (distance < lowestDistance))
+			{
+				lowest = i;
+				lowestDistance = distance;
+			}
+			if ((i == 0) || (distance > highestDistance))
+			{
+				highest = i;
+				highestDistance = distance;
+			}
+		}
+
+		color0 = QuantizeColor(block.red[highest], block.green[highest], block.blue[highest]);
+		color1 = QuantizeColor(block.red[lowest], block.green[lowest], block.blue[lowest]);
+	}
+
+	///////////////////////////////////////////////////
+	//	RefineEndpoints()
+	//
+	//	Fit the endpoints to the chosen indices by least
+	//	squares.  Returns false when all of the texels
+	//	chose the same weight, so there is nothing to fit.
+	///////////////////////////////////////////////////
+	bool RefineEndpoints(const TEXEL_BLOCK& block, const unsigned int indices[16], unsigned int& color0, unsigned int& color1)
+	{
+		// the weight of the first endpoint for each index
+		const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		float aa = 0.0f;
+		float bb = 0.0f;
+		float ab = 0.0f;
+		float ax[3] = { 0.0f, 0.0f, 0.0f };
+		float bx[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			float a = weights[indices[i]];
+			float b = 1.0f - a;
+			float texel[3] = { block.red[i], block.green[i], block.blue[i] };
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += a * texel[c];
+				bx[c] += b * texel[c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			return(false);
+		}
+
+		float endpoint0[3];
+		float endpoint1[3];
+		for (int c = 0; c < 3; c++)
+		{
+			endpoint0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+			endpoint1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+		}
+		color0 = QuantizeColor(endpoint0[0], endpoint0[1], endpoint0[2]);
+		color1 = QuantizeColor(endpoint1[0], endpoint1[1], endpoint1[2]);
+		return(true);
+	}
+
+	///////////////////////////////////////////////////
+	//	FitColors()
+	//
+	//	Order the endpoints for the four color mode, and
+	//	find the indices and the error of the block.
+	///////////////////////////////////////////////////
+	float FitColors(const TEXEL_BLOCK& block, unsigned int& color0, unsigned int& color1, unsigned int indices[16])
+	{
+		if (color0 < color1)
+		{
+			unsigned int swap = color0;
+			color0 = color1;
+			color1 = swap;
+		}
+
+		int colors[4][3];
+		MakePalette(color0, color1, true, colors);
+		COLOR_PALETTE palette;
+		for (int k = 0; k < 4; k++)
+		{
+			palette.red[k] = static_cast<float>(colors[k][0]);
+			palette.green[k] = static_cast<float>(colors[k][1]);
+			palette.blue[k] = static_cast<float>(colors[k][2]);
+		}
+		return(FindIndices(block, palette, indices));
+	}
+
+	///////////////////////////////////////////////////
+	//	EncodeColorBlock()
+	//
+	//	Compress the colors of a block into 8 bytes.
+	///////////////////////////////////////////////////
+	void EncodeColorBlock(const TEXEL_BLOCK& block, unsigned char* output)
+	{
+		unsigned int color0 = 0;
+		unsigned int color1 = 0;
+		unsigned int indices[16];
+		FindEndpoints(block, color0, color1);
+		float error = FitColors(block, color0, color1, indices);
+
+		unsigned int refined0 = 0;
+		unsigned int refined1 = 0;
+		unsigned int refinedIndices[16];
+		if ((0.0f < error) && (true == RefineEndpoints(block, indices, refined0, refined1)))
+		{
+			float refinedError = FitColors(block, refined0, refined1, refinedIndices);
+			if (refinedError < error)
+			{
+				color0 = refined0;
+				color1 = refined1;
+				memcpy(indices, refinedIndices, sizeof(indices));
+			}
+		}
+
+		// with equal endpoints every index picks the same color
+		unsigned int packedIndices = 0;
+		if (color0 != color1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				packedIndices |= indices[i] << (2 * i);
+			}
+		}
+
+		output[0] = static_cast<unsigned char>(color0 & 0xFF);
+		output[1] = static_cast<unsigned char>(color0 >> 8);
+		output[2] = static_cast<unsigned char>(color1 & 0xFF);
+		output[3] = static_cast<unsigned char>(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			output[4 + i] = static_cast<unsigned char>((packedIndices >> (8 * i)) & 0xFF);
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	MakeAlphaPalette()
+	//
+	//	Build the alpha values of a block from its
+	//	endpoints, eight of them when the first endpoint
+	//	is the greater one and six with 0 and 255 if not.
+	///////////////////////////////////////////////////
+	void MakeAlphaPalette(int alpha0, int alpha1, int palette[8])
+	{
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		if (alpha0 > alpha1)
+		{
+			for (int k = 1; k < 7; k++)
+			{
+				palette[k + 1] = ((7 - k) * alpha0 + k * alpha1) / 7;
+			}
+		}
+		else
+		{
+			for (int k = 1; k < 5; k++)
+			{
+				palette[k + 1] = ((5 - k) * alpha0 + k * alpha1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	EncodeAlphaBlock()
+	//
+	//	Compress the alpha values of a block into 8
+	//	bytes, with the lowest and the highest value as
+	//	the endpoints.
+	///////////////////////////////////////////////////
+	void EncodeAlphaBlock(const TEXEL_BLOCK& block, unsigned char* output)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			alpha0 = (block.alpha[i] > alpha0) ? block.alpha[i] : alpha0;
+			alpha1 = (block.alpha[i] < alpha1) ? block.alpha[i] : alpha1;
+		}
+
+		int palette[8];
+		MakeAlphaPalette(alpha0, alpha1, palette);
+
+		unsigned long long packedIndices = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestError = 256;
+			for (int k = 0; k < 8; k++)
+			{
+				int error = std::abs(block.alpha[i] - palette[k]);
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = k;
+				}
+			}
+			packedIndices |= static_cast<unsigned long long>(bestIndex) << (3 * i);
+		}
+
+		output[0] = static_cast<unsigned char>(alpha0);
+		output[1] = static_cast<unsigned char>(alpha1);
+		for (int i = 0; i < 6; i++)
+		{
+			output[2 + i] = static_cast<unsigned char>((packedIndices >> (8 * i)) & 0xFF);
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	DecodeColorBlock()
+	//
+	//	Decompress the colors of a block into 16 texels.
+	///////////////////////////////////////////////////
+	void DecodeColorBlock(const unsigned char* input, bool bFourColors, unsigned char texels[16][4])
+	{
+		unsigned int color0 = input[0] | (input[1] << 8);
+		unsigned int color1 = input[2] | (input[3] << 8);
+		unsigned int packedIndices = input[4] | (input[5] << 8) | (input[6] << 16) | (static_cast<unsigned int>(input[7]) << 24);
+
+		int palette[4][3];
+		MakePalette(color0, color1, bFourColors, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			unsigned int index = (packedIndices >> (2 * i)) & 3;
+			texels[i][0] = static_cast<unsigned char>(palette[index][0]);
+			texels[i][1] = static_cast<unsigned char>(palette[index][1]);
+			texels[i][2] = static_cast<unsigned char>(palette[index][2]);
+			texels[i][3] = ((false == bFourColors) && (color0 <= color1) && (index == 3)) ? 0 : 255;
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	DecodeAlphaBlock()
+	//
+	//	Decompress the alpha values of a block into 16
+	//	texels.
+	///////////////////////////////////////////////////
+	void DecodeAlphaBlock(const unsigned char* input, unsigned char texels[16][4])
+	{
+		int palette[8];
+		MakeAlphaPalette(input[0], input[1], palette);
+
+		unsigned long long packedIndices = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			packedIndices |= static_cast<unsigned long long>(input[2 + i]) << (8 * i);
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			texels[i][3] = static_cast<unsigned char>(palette[(packedIndices >> (3 * i)) & 7]);
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	EncodeRows()
+	//
+	//	Compress a range of rows of blocks of an image.
+	///////////////////////////////////////////////////
+	void EncodeRows(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int colorChannels,
+		BlockEncoder::BLOCK_FORMAT format,
+		unsigned char* blocks,
+		int firstRow,
+		int lastRow)
+	{
+		int blocksX = (width + 3) / 4;
+		size_t blockSize = BlockEncoder::GetBlockSize(format);
+
+		TEXEL_BLOCK block;
+		for (int blockY = firstRow; blockY < lastRow; blockY++)
+		{
+			unsigned char* output = blocks + static_cast<size_t>(blockY) * blocksX * blockSize;
+			for (int blockX = 0; blockX < blocksX; blockX++)
+			{
+				LoadBlock(pixels, width, height, colorChannels, blockX, blockY, block);
+				if (BlockEncoder::BLOCK_BC3 == format)
+				{
+					EncodeAlphaBlock(block, output);
+					output += 8;
+				}
+				EncodeColorBlock(block, output);
+				output += 8;
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////
+//	BlockEncoder::GetBlockSize()
+//
+//	Get the size of one block of the passed in
+//	format.
+///////////////////////////////////////////////////
+size_t BlockEncoder::GetBlockSize(BLOCK_FORMAT format)
+{
+	return((BLOCK_BC3 == format) ? 16 : 8);
+}
+
+///////////////////////////////////////////////////
+//	BlockEncoder::GetImageSize()
+//
+//	Get the size of an image in the passed in
+//	format, which is rounded up to whole blocks.
+///////////////////////////////////////////////////
+size_t BlockEncoder::GetImageSize(BLOCK_FORMAT format, int width, int height)
+{
+	size_t blocksX = static_cast<size_t>((width + 3) / 4);
+	size_t blocksY = static_cast<size_t>((height + 3) / 4);
+	return(blocksX * blocksY * GetBlockSize(format));
+}
+
+///////////////////////////////////////////////////
+//	BlockEncoder::EncodeImage()
+//
+//	Compress an image, with the rows of blocks split
+//	evenly between the threads.  The calling thread
+//	compresses the first share of the rows, and small
+//	images are compressed on it alone.
+///////////////////////////////////////////////////
+void BlockEncoder::EncodeImage(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	int colorChannels,
+	BLOCK_FORMAT format,
+	unsigned char* blocks,
+	unsigned int threadCount)
+{
+	int blocksY = (height + 3) / 4;
+	int maxThreads = blocksY / MIN_ROWS_PER_THREAD;
+	int usedThreads = (static_cast<int>(threadCount) < maxThreads) ? static_cast<int>(threadCount) : maxThreads;
+	usedThreads = (usedThreads > 1) ? usedThreads : 1;
+
+	std::vector<std::thread> threads;
+	for (int t = 1; t < usedThreads; t++)
+	{
+		threads.push_back(std::thread(EncodeRows, pixels, width, height, colorChannels, format, blocks,
+			blocksY * t / usedThreads, blocksY * (t + 1) / usedThreads));
+	}
+	EncodeRows(pixels, width, height, colorChannels, format, blocks, 0, blocksY / usedThreads);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+///////////////////////////////////////////////////
+//	BlockEncoder::DecodeImage()
+//
+//	Decompress the blocks of an image.
+///////////////////////////////////////////////////
+void BlockEncoder::DecodeImage(
+	const unsigned char* blocks,
+	int width,
+	int height,
+	int colorChannels,
+	BLOCK_FORMAT format,
+	unsigned char* pixels)
+{
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+
+	unsigned char texels[16][4];
+	for (int blockY = 0; blockY < blocksY; blockY++)
+	{
+		for (int blockX = 0; blockX < blocksX; blockX++)
+		{
+			if (BLOCK_BC3 == format)
+			{
+				DecodeColorBlock(blocks + 8, true, texels);
+				DecodeAlphaBlock(blocks, texels);
+			}
+			else
+			{
+				DecodeColorBlock(blocks, false, texels);
+			}
+			blocks += GetBlockSize(format);
+
+			for (int y = 0; y < 4; y++)
+			{
+				int pixelY = blockY * 4 + y;
+				for (int x = 0; x < 4; x++)
+				{
+					int pixelX = blockX * 4 + x;
+					if ((pixelX < width) && (pixelY < height))
+					{
+						memcpy(pixels + (static_cast<size_t>(pixelY) * width + pixelX) * colorChannels,
+							texels[y * 4 + x], colorChannels);
+					}
+				}
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////
+//	BlockEncoder::CalculatePSNR()
+//
+//	Calculate the peak signal to noise ratio of the
+//	compressed image against the original.  An image
+//	that was compressed without any error is given
+//	100 dB.
+///////////////////////////////////////////////////
+double BlockEncoder::CalculatePSNR(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	int colorChannels,
+	BLOCK_FORMAT format,
+	const unsigned char* blocks)
+{
+	size_t valueCount = static_cast<size_t>(width) * height * colorChannels;
+	std::vector<unsigned char> decoded(valueCount);
+	DecodeImage(blocks, width, height, colorChannels, format, &decoded[0]);
+
+	double squaredError = 0.0;
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		double difference = static_cast<double>(pixels[i]) - decoded[i];
+		squaredError += difference * difference;
+	}
+	if (squaredError <= 0.0)
+	{
+		return(100.0);
+	}
+
+	double meanSquaredError = squaredError / valueCount;
+	return(10.0 * std::log10(255.0 * 255.0 / meanSquaredError));
+}
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// blockencoder.h
+// ==============
+// compress texture images into BC1 and BC3 blocks on the CPU
+//
+// Each block of 4x4 texels is stored as two 5:6:5 endpoint colors and a
+// 2-bit index per texel into the four colors on the line between them, in 8
+// bytes for BC1.  BC3 adds 8 bytes of alpha, with two 8-bit endpoints and a
+// 3-bit index per texel into eight values between them.  BC1 keeps an
+// opaque image in an eighth of the memory of RGBA8, and BC3 in a quarter.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+namespace BlockEncoder
+{
+	// the block formats, BC1 for opaque and BC3 for transparent images
+	enum BLOCK_FORMAT
+	{
+		BLOCK_BC1 = 1,
+		BLOCK_BC3 = 2
+	};
+
+	// size of one compressed block of 4x4 texels
+	size_t GetBlockSize(BLOCK_FORMAT format);
+	// size of a compressed image with the passed in size
+	size_t GetImageSize(BLOCK_FORMAT format, int width, int height);
+
+	// compress an image of RGB or RGBA texels into blocks, with the
+	// rows of blocks split between a number of threads - the texels
+	// at the right and top edges are repeated to fill the blocks
+	void EncodeImage(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int colorChannels,
+		BLOCK_FORMAT format,
+		unsigned char* blocks,
+		unsigned int threadCount);
+
+	// decompress blocks into an image of RGB or RGBA texels
+	void DecodeImage(
+		const unsigned char* blocks,
+		int width,
+		int height,
+		int colorChannels,
+		BLOCK_FORMAT format,
+		unsigned char* pixels);
+
+	// peak signal to noise ratio in dB of the compressed image
+	// against the original, over all of the color channels
+	double CalculatePSNR(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int colorChannels,
+		BLOCK_FORMAT format,
+		const unsigned char* blocks);
+}
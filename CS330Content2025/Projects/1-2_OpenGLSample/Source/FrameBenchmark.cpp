@@ -0,0 +1,512 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.cpp
+// ==================
+// This file contains the implementation of the `FrameBenchmark` class, which
+// measures the CPU time, GPU time and draw calls of the rendered frames and
+// saves the results for comparing the performance of the 3D scene.
+//
+// RESPONSIBILITIES:
+// - Create the offscreen framebuffer used for headless rendering.
+// - Time every frame on the CPU, and take its GPU time from the profiler.
+// - Write the frame times to CSV and the last frame to PNG.
+// - Compare the last frame against a reference PNG image.
+//
+// NOTE: The PNG files are written with uncompressed deflate blocks, so no
+// compression library is needed.  Reference images are read with `stb_image`.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameBenchmark.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// declaration of global variables and defines
+namespace
+{
+	// largest per-channel difference accepted when comparing images
+	const int g_CompareTolerance = 2;
+
+	/***********************************************************
+	 *  PNGChecksum()
+	 *
+	 *  This function is used for calculating the CRC-32 of a
+	 *  PNG chunk type and data.
+	 ***********************************************************/
+	unsigned int PNGChecksum(const unsigned char* data, size_t size, unsigned int crc)
+	{
+		static unsigned int crcTable[256] = { 0 };
+		if (crcTable[1] == 0)
+		{
+			for (unsigned int n = 0; n < 256; n++)
+			{
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				crcTable[n] = c;
+			}
+		}
+
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return(crc);
+	}
+
+	/***********************************************************
+	 *  AppendBigEndian()
+	 *
+	 *  This function is used for adding a 32-bit value to the
+	 *  PNG data in network byte order.
+	 ***********************************************************/
+	void AppendBigEndian(std::vector<unsigned char>& data, unsigned int value)
+	{
+		data.push_back((value >> 24) & 0xFF);
+		data.push_back((value >> 16) & 0xFF);
+		data.push_back((value >> 8) & 0xFF);
+		data.push_back(value & 0xFF);
+	}
+
+	/***********************************************************
+	 *  AppendChunk()
+	 *
+	 *  This function is used for adding a chunk with its
+	 *  length, type and checksum to the PNG data.
+	 ***********************************************************/
+	void AppendChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& chunkData)
+	{
+		AppendBigEndian(png, static_cast<unsigned int>(chunkData.size()));
+
+		size_t typeStart = png.size();
+		png.insert(png.end(), type, type + 4);
+		png.insert(png.end(), chunkData.begin(), chunkData.end());
+
+		unsigned int crc = PNGChecksum(&png[typeStart], png.size() - typeStart, 0xFFFFFFFFu);
+		AppendBigEndian(png, crc ^ 0xFFFFFFFFu);
+	}
+}
+
+/***********************************************************
+ *  FrameBenchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameBenchmark::FrameBenchmark(int frameCount)
+{
+	m_frameCount = frameCount;
+	m_frames.reserve(frameCount);
+	m_pGPUProfiler = NULL;
+	m_firstGPUFrame = 0;
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ~FrameBenchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameBenchmark::~FrameBenchmark()
+{
+	// free the offscreen render target
+	if (0 != m_framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+	}
+}
+
+/***********************************************************
+ *  CreateRenderTarget()
+ *
+ *  This method is used for creating the offscreen framebuffer
+ *  that the frames are rendered into when there is no window
+ *  to display them.  The framebuffer stays bound.
+ ***********************************************************/
+bool FrameBenchmark::CreateRenderTarget(int width, int height)
+{
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Offscreen framebuffer is not complete" << std::endl;
+		return(false);
+	}
+
+	glViewport(0, 0, width, height);
+	SetFrameSize(width, height);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetFrameSize()
+ *
+ *  This method is used for setting the size of the frames
+ *  that are read back for the PNG output.
+ ***********************************************************/
+void FrameBenchmark::SetFrameSize(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+}
+
+/***********************************************************
+ *  SetGPUProfiler()
+ *
+ *  This method is used for setting the profiler whose frame
+ *  times are the GPU times of the measured frames.  The
+ *  profiler frames have to be inside of the benchmark ones.
+ ***********************************************************/
+void FrameBenchmark::SetGPUProfiler(GPUProfiler* pProfiler)
+{
+	m_pGPUProfiler = pProfiler;
+	if (NULL != m_pGPUProfiler)
+	{
+		m_pGPUProfiler->KeepFrameTimes(true);
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is called before the rendering of a frame to
+ *  start the CPU timer.
+ ***********************************************************/
+void FrameBenchmark::BeginFrame()
+{
+	m_frameStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is called after the rendering of a frame to
+ *  record its CPU time, draw calls, the numbers of drawn
+ *  and culled objects and the number of GL calls that the
+ *  state cache skipped.  After the last frame
+ *  the profiler is waited for, so that every frame it has
+ *  not dropped gets its GPU time.
+ ***********************************************************/
+void FrameBenchmark::EndFrame(unsigned int drawCalls, unsigned int drawnObjects, unsigned int culledObjects, unsigned int elidedCalls)
+{
+	std::chrono::duration<double, std::milli> cpuTime =
+		std::chrono::steady_clock::now() - m_frameStart;
+
+	if ((NULL != m_pGPUProfiler) && (m_frames.size() == 0))
+	{
+		m_firstGPUFrame = m_pGPUProfiler->GetFrameNumber();
+	}
+
+	FRAME_TIMING frame;
+	frame.cpuMilliseconds = cpuTime.count();
+	frame.gpuMilliseconds = -1.0;
+	frame.drawCalls = drawCalls;
+	frame.drawnObjects = drawnObjects;
+	frame.culledObjects = culledObjects;
+	frame.elidedCalls = elidedCalls;
+	m_frames.push_back(frame);
+
+	if ((NULL != m_pGPUProfiler) && (true == IsComplete()))
+	{
+		m_pGPUProfiler->ReadAll();
+	}
+	TakeGPUTimes();
+}
+
+/***********************************************************
+ *  IsComplete()
+ *
+ *  This method returns true once all of the frames have
+ *  been measured.
+ ***********************************************************/
+bool FrameBenchmark::IsComplete() const
+{
+	return(static_cast<int>(m_frames.size()) >= m_frameCount);
+}
+
+/***********************************************************
+ *  TakeGPUTimes()
+ *
+ *  This method is used for putting the frame times that the
+ *  profiler has read into the timings of the measured frames.
+ ***********************************************************/
+void FrameBenchmark::TakeGPUTimes()
+{
+	if (NULL == m_pGPUProfiler)
+	{
+		return;
+	}
+
+	m_pGPUProfiler->TakeFrameTimes(m_gpuFrameTimes);
+	for (const GPUProfiler::FRAME_TIME& frameTime : m_gpuFrameTimes)
+	{
+		// the frames before the benchmark are not measured
+		if (frameTime.frameNumber < m_firstGPUFrame)
+		{
+			continue;
+		}
+
+		unsigned long long frameIndex = frameTime.frameNumber - m_firstGPUFrame;
+		if (frameIndex < m_frames.size())
+		{
+			m_frames[frameIndex].gpuMilliseconds = frameTime.milliseconds;
+		}
+	}
+}
+
+/***********************************************************
+ *  PrintSummary()
+ *
+ *  This method is used for printing the average, minimum
+ *  and maximum frame times of the measured frames.
+ ***********************************************************/
+void FrameBenchmark::PrintSummary()
+{
+	if (m_frames.size() == 0)
+	{
+		return;
+	}
+
+	double cpuTotal = 0.0;
+	double gpuTotal = 0.0;
+	size_t gpuFrameCount = 0;
+	double cpuMin = m_frames[0].cpuMilliseconds;
+	double cpuMax = m_frames[0].cpuMilliseconds;
+	unsigned long long drawCallTotal = 0;
+	unsigned long long drawnObjectTotal = 0;
+	unsigned long long culledObjectTotal = 0;
+	unsigned long long elidedCallTotal = 0;
+	for (const FRAME_TIMING& frame : m_frames)
+	{
+		cpuTotal += frame.cpuMilliseconds;
+		if (frame.gpuMilliseconds >= 0.0)
+		{
+			gpuTotal += frame.gpuMilliseconds;
+			gpuFrameCount++;
+		}
+		cpuMin = std::min(cpuMin, frame.cpuMilliseconds);
+		cpuMax = std::max(cpuMax, frame.cpuMilliseconds);
+		drawCallTotal += frame.drawCalls;
+		drawnObjectTotal += frame.drawnObjects;
+		culledObjectTotal += frame.culledObjects;
+		elidedCallTotal += frame.elidedCalls;
+	}
+
+	std::cout << "INFO: Rendered " << m_frames.size() << " frames" << std::endl;
+	std::cout << "INFO: CPU frame time (ms): average " << cpuTotal / m_frames.size()
+		<< ", min " << cpuMin << ", max " << cpuMax << std::endl;
+	if (gpuFrameCount > 0)
+	{
+		std::cout << "INFO: GPU frame time (ms): average " << gpuTotal / gpuFrameCount
+			<< ", " << m_frames.size() - gpuFrameCount << " frames not measured" << std::endl;
+	}
+	else
+	{
+		std::cout << "INFO: GPU frame time not measured" << std::endl;
+	}
+	std::cout << "INFO: Draw calls per frame: " << drawCallTotal / m_frames.size() << std::endl;
+	std::cout << "INFO: Objects per frame: drawn " << drawnObjectTotal / m_frames.size()
+		<< ", culled " << culledObjectTotal / m_frames.size() << std::endl;
+	std::cout << "INFO: Skipped GL calls per frame: " << elidedCallTotal / m_frames.size() << std::endl;
+}
+
+/***********************************************************
+ *  WriteCSV()
+ *
+ *  This method is used for writing the measurements of
+ *  every frame to a CSV file.  The GPU time is left empty
+ *  for a frame that was not measured.
+ ***********************************************************/
+bool FrameBenchmark::WriteCSV(const std::string& filename)
+{
+	FILE* file = fopen(filename.c_str(), "w");
+	if (NULL == file)
+	{
+		std::cout << "Could not write frame times to " << filename << std::endl;
+		return(false);
+	}
+
+	fprintf(file, "frame,cpu_ms,gpu_ms,draw_calls,drawn_objects,culled_objects,elided_calls\n");
+	for (size_t i = 0; i < m_frames.size(); i++)
+	{
+		fprintf(file, "%zu,%.4f,", i, m_frames[i].cpuMilliseconds);
+		if (m_frames[i].gpuMilliseconds >= 0.0)
+		{
+			fprintf(file, "%.4f", m_frames[i].gpuMilliseconds);
+		}
+		fprintf(file, ",%u,%u,%u,%u\n",
+			m_frames[i].drawCalls,
+			m_frames[i].drawnObjects,
+			m_frames[i].culledObjects,
+			m_frames[i].elidedCalls);
+	}
+	fclose(file);
+
+	std::cout << "INFO: Frame times written to " << filename << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  ReadFramePixels()
+ *
+ *  This method is used for reading the RGB pixels of the
+ *  last rendered frame from the bound framebuffer.
+ ***********************************************************/
+std::vector<unsigned char> FrameBenchmark::ReadFramePixels() const
+{
+	std::vector<unsigned char> pixels(static_cast<size_t>(m_width) * m_height * 3);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	return(pixels);
+}
+
+/***********************************************************
+ *  WritePNG()
+ *
+ *  This method is used for writing the last rendered frame
+ *  to a PNG file.
+ ***********************************************************/
+bool FrameBenchmark::WritePNG(const std::string& filename) const
+{
+	std::vector<unsigned char> pixels = ReadFramePixels();
+	size_t rowSize = static_cast<size_t>(m_width) * 3;
+
+	// the image rows, top row first, each one starting with
+	// a filter type byte of zero for no filtering
+	std::vector<unsigned char> rows;
+	rows.reserve((rowSize + 1) * m_height);
+	for (int y = m_height - 1; y >= 0; y--)
+	{
+		rows.push_back(0);
+		rows.insert(rows.end(), pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize);
+	}
+
+	// zlib stream made of uncompressed deflate blocks
+	std::vector<unsigned char> imageData = { 0x78, 0x01 };
+	size_t offset = 0;
+	do
+	{
+		size_t blockSize = std::min(rows.size() - offset, static_cast<size_t>(65535));
+		bool bFinal = (offset + blockSize == rows.size());
+		imageData.push_back(bFinal ? 1 : 0);
+		imageData.push_back(blockSize & 0xFF);
+		imageData.push_back((blockSize >> 8) & 0xFF);
+		imageData.push_back(~blockSize & 0xFF);
+		imageData.push_back((~blockSize >> 8) & 0xFF);
+		imageData.insert(imageData.end(), rows.begin() + offset, rows.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < rows.size());
+
+	// Adler-32 checksum of the uncompressed data
+	unsigned int adlerA = 1;
+	unsigned int adlerB = 0;
+	for (unsigned char value : rows)
+	{
+		adlerA = (adlerA + value) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	AppendBigEndian(imageData, (adlerB << 16) | adlerA);
+
+	// 8-bit RGB image header
+	std::vector<unsigned char> header;
+	AppendBigEndian(header, m_width);
+	AppendBigEndian(header, m_height);
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+	std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	AppendChunk(png, "IHDR", header);
+	AppendChunk(png, "IDAT", imageData);
+	AppendChunk(png, "IEND", std::vector<unsigned char>());
+
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (NULL == file)
+	{
+		std::cout << "Could not write frame image to " << filename << std::endl;
+		return(false);
+	}
+	fwrite(png.data(), 1, png.size(), file);
+	fclose(file);
+
+	std::cout << "INFO: Last frame written to " << filename << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  ComparePNG()
+ *
+ *  This method is used for comparing the last rendered frame
+ *  against a reference image.  Returns false if the sizes
+ *  differ or any color channel differs by more than the
+ *  comparison tolerance.
+ ***********************************************************/
+bool FrameBenchmark::ComparePNG(const std::string& filename) const
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	// flip the reference so its rows match the OpenGL row order
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(filename.c_str(), &width, &height, &colorChannels, 3);
+	if (NULL == image)
+	{
+		std::cout << "Could not load reference image:" << filename << std::endl;
+		return(false);
+	}
+
+	if ((width != m_width) || (height != m_height))
+	{
+		std::cout << "Reference image size " << width << "x" << height
+			<< " does not match the frame size " << m_width << "x" << m_height << std::endl;
+		stbi_image_free(image);
+		return(false);
+	}
+
+	std::vector<unsigned char> pixels = ReadFramePixels();
+	size_t differentPixels = 0;
+	int maxDifference = 0;
+	for (size_t i = 0; i < pixels.size(); i += 3)
+	{
+		int pixelDifference = 0;
+		for (size_t channel = 0; channel < 3; channel++)
+		{
+			pixelDifference = std::max(pixelDifference, std::abs(pixels[i + channel] - image[i + channel]));
+		}
+		if (pixelDifference > g_CompareTolerance)
+		{
+			differentPixels++;
+		}
+		maxDifference = std::max(maxDifference, pixelDifference);
+	}
+	stbi_image_free(image);
+
+	std::cout << "INFO: Compared to " << filename << ": " << differentPixels
+		<< " pixels differ, largest channel difference " << maxDifference << std::endl;
+
+	return(differentPixels == 0);
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.h
+// ================
+// Defines the `FrameBenchmark` class, which measures the rendering of a fixed
+// number of frames so that the performance of the 3D scene can be compared
+// between builds, including on headless machines without a display.
+//
+// RESPONSIBILITIES:
+// - Provide an offscreen framebuffer to render into when there is no window.
+// - Record the CPU time, GPU time, draw call count, the number of drawn
+//   and culled objects and the number of skipped GL calls of every frame.
+// - Write the recorded frame times to a CSV file.
+// - Write the last rendered frame to a PNG file, or compare it against a
+//   reference PNG file for image-diff regression tests.
+//
+// NOTE: The GPU times of the frames are taken from the `GPUProfiler`, which
+// reads its timestamp queries a few frames later without waiting for them.
+// A frame that the profiler had to drop has no GPU time.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GPUProfiler.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameBenchmark
+ *
+ *  This class contains the code for timing the rendered
+ *  frames and saving the results.
+ ***********************************************************/
+class FrameBenchmark
+{
+public:
+	// constructor
+	FrameBenchmark(int frameCount);
+	// destructor
+	~FrameBenchmark();
+
+	// measurements for one rendered frame - the GPU time is
+	// negative until it is measured
+	struct FRAME_TIMING
+	{
+		double cpuMilliseconds;
+		double gpuMilliseconds;
+		unsigned int drawCalls;
+		unsigned int drawnObjects;
+		unsigned int culledObjects;
+		unsigned int elidedCalls;
+	};
+
+private:
+	// total number of frames to measure
+	int m_frameCount;
+	// measurements of the frames rendered so far
+	std::vector<FRAME_TIMING> m_frames;
+	// CPU start time of the current frame
+	std::chrono::steady_clock::time_point m_frameStart;
+	// profiler that measures the GPU times of the frames, and
+	// its number for the first measured frame
+	GPUProfiler* m_pGPUProfiler;
+	unsigned long long m_firstGPUFrame;
+	std::vector<GPUProfiler::FRAME_TIME> m_gpuFrameTimes;
+	// offscreen render target used when there is no window
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_width;
+	int m_height;
+
+	// take the GPU times that the profiler has read so far
+	void TakeGPUTimes();
+	// read the pixels of the last rendered frame, bottom row first
+	std::vector<unsigned char> ReadFramePixels() const;
+
+public:
+	// create the offscreen render target for headless rendering
+	bool CreateRenderTarget(int width, int height);
+	// set the size of the window that is rendered into
+	void SetFrameSize(int width, int height);
+	// set the profiler whose frames are timed on the GPU
+	void SetGPUProfiler(GPUProfiler* pProfiler);
+
+	// mark the start and end of the rendering of one frame
+	void BeginFrame();
+	void EndFrame(unsigned int drawCalls, unsigned int drawnObjects, unsigned int culledObjects, unsigned int elidedCalls);
+	// true once all of the frames have been rendered
+	bool IsComplete() const;
+
+	// save or check the results after the last frame
+	void PrintSummary();
+	bool WriteCSV(const std::string& filename);
+	bool WritePNG(const std::string& filename) const;
+	bool ComparePNG(const std::string& filename) const;
+};
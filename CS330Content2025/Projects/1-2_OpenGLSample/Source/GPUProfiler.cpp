@@ -0,0 +1,423 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuprofiler.cpp
+// ===============
+// This file contains the implementation of the `GPUProfiler` class, which
+// times named regions of the frames with GPU timestamp queries.
+//
+// RESPONSIBILITIES:
+// - Keep a ring of frames with the timestamp queries of their regions.
+// - Read each frame back once all of its queries are available.
+// - Calculate the averages and percentiles of the region times.
+// - Keep the whole frame times when they are asked for.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+/***********************************************************
+ *  GPUProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GPUProfiler::GPUProfiler()
+{
+	// timestamp queries are core in OpenGL 3.3
+	m_bSupported = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+	m_bInFrame = false;
+	m_frameNumber = 0;
+	m_droppedFrames = 0;
+	m_bKeepFrameTimes = false;
+	for (int i = 0; i < FRAME_SLOTS; i++)
+	{
+		m_slots[i].frameEndQuery = 0;
+		m_slots[i].usedQueries = 0;
+		m_slots[i].bPending = false;
+		m_slotFrames[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~GPUProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GPUProfiler::~GPUProfiler()
+{
+	for (int i = 0; i < FRAME_SLOTS; i++)
+	{
+		if (m_slots[i].queries.size() > 0)
+		{
+			glDeleteQueries(static_cast<GLsizei>(m_slots[i].queries.size()), m_slots[i].queries.data());
+		}
+	}
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method returns true when the GPU times can be
+ *  measured with timestamp queries.
+ ***********************************************************/
+bool GPUProfiler::IsSupported() const
+{
+	return(m_bSupported);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is called before the rendering of a frame.
+ *  The frames that were rendered at least READ_LATENCY
+ *  frames ago are read if the GPU has finished them, and
+ *  the queries of the oldest frame are reused, starting
+ *  with the timestamp of the start of the frame.
+ ***********************************************************/
+void GPUProfiler::BeginFrame()
+{
+	if (false == m_bSupported)
+	{
+		return;
+	}
+
+	m_frameNumber++;
+	for (int i = 0; i < FRAME_SLOTS; i++)
+	{
+		if ((true == m_slots[i].bPending) && (m_slotFrames[i] + READ_LATENCY <= m_frameNumber))
+		{
+			ReadSlot(i, false);
+		}
+	}
+
+	int slotIndex = static_cast<int>(m_frameNumber % FRAME_SLOTS);
+	FRAME_SLOT& slot = m_slots[slotIndex];
+	if (true == slot.bPending)
+	{
+		// waiting for the frame would stall the pipeline
+		m_droppedFrames++;
+		slot.bPending = false;
+	}
+	slot.usedQueries = 0;
+	slot.frameEndQuery = 0;
+	slot.marks.clear();
+	m_slotFrames[slotIndex] = m_frameNumber;
+	m_openMarks.clear();
+	m_bInFrame = true;
+
+	AddTimestamp();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is called after the rendering of a frame,
+ *  to place the timestamp of the end of the frame.  The
+ *  regions that were left open are not measured.
+ ***********************************************************/
+void GPUProfiler::EndFrame()
+{
+	if (false == m_bInFrame)
+	{
+		return;
+	}
+
+	FRAME_SLOT& slot = m_slots[m_frameNumber % FRAME_SLOTS];
+	slot.frameEndQuery = AddTimestamp();
+	slot.bPending = true;
+	m_bInFrame = false;
+}
+
+/***********************************************************
+ *  GetFrameNumber()
+ *
+ *  This method returns the number of the current frame, or
+ *  of the last one when no frame is being rendered.
+ ***********************************************************/
+unsigned long long GPUProfiler::GetFrameNumber() const
+{
+	return(m_frameNumber);
+}
+
+/***********************************************************
+ *  KeepFrameTimes()
+ *
+ *  This method is used for turning on or off the keeping of
+ *  the whole frame times.  The times pile up until they are
+ *  taken, so only a caller that takes them turns this on.
+ ***********************************************************/
+void GPUProfiler::KeepFrameTimes(bool bKeep)
+{
+	m_bKeepFrameTimes = bKeep;
+	if (false == bKeep)
+	{
+		m_frameTimes.clear();
+	}
+}
+
+/***********************************************************
+ *  TakeFrameTimes()
+ *
+ *  This method is used for getting the whole frame times
+ *  that were read since they were last taken.  The frames
+ *  that were dropped have no time.
+ ***********************************************************/
+void GPUProfiler::TakeFrameTimes(std::vector<FRAME_TIME>& frameTimes)
+{
+	frameTimes.clear();
+	frameTimes.swap(m_frameTimes);
+}
+
+/***********************************************************
+ *  BeginRegion()
+ *
+ *  This method is used for starting a region of the current
+ *  frame.  Regions outside of a frame are ignored.
+ ***********************************************************/
+void GPUProfiler::BeginRegion(const char* name)
+{
+	if (false == m_bInFrame)
+	{
+		return;
+	}
+
+	FRAME_SLOT& slot = m_slots[m_frameNumber % FRAME_SLOTS];
+
+	REGION_MARK mark;
+	mark.region = FindRegion(name);
+	mark.startQuery = AddTimestamp();
+	mark.endQuery = mark.startQuery;
+
+	m_openMarks.push_back(slot.marks.size());
+	slot.marks.push_back(mark);
+}
+
+/***********************************************************
+ *  EndRegion()
+ *
+ *  This method is used for ending the region of the current
+ *  frame that was started last.
+ ***********************************************************/
+void GPUProfiler::EndRegion()
+{
+	if ((false == m_bInFrame) || (m_openMarks.size() == 0))
+	{
+		return;
+	}
+
+	FRAME_SLOT& slot = m_slots[m_frameNumber % FRAME_SLOTS];
+	slot.marks[m_openMarks.back()].endQuery = AddTimestamp();
+	m_openMarks.pop_back();
+}
+
+/***********************************************************
+ *  ReadAll()
+ *
+ *  This method is used for reading the results of all of
+ *  the outstanding frames, waiting for the GPU to finish
+ *  them.  It is meant for the end of a run.
+ ***********************************************************/
+void GPUProfiler::ReadAll()
+{
+	for (int i = 0; i < FRAME_SLOTS; i++)
+	{
+		if (true == m_slots[i].bPending)
+		{
+			ReadSlot(i, true);
+		}
+	}
+}
+
+/***********************************************************
+ *  FindRegion()
+ *
+ *  This method is used for finding the region with the
+ *  passed in name, and adding it when it is new.  The name
+ *  pointer is compared first, since the names are normally
+ *  string literals.
+ ***********************************************************/
+int GPUProfiler::FindRegion(const char* name)
+{
+	for (size_t i = 0; i < m_regions.size(); i++)
+	{
+		if ((m_regions[i].key == name) || (m_regions[i].name == name))
+		{
+			return(static_cast<int>(i));
+		}
+	}
+
+	REGION region;
+	region.name = name;
+	region.key = name;
+	region.nextSample = 0;
+	region.totalSamples = 0;
+	region.totalMilliseconds = 0.0;
+	m_regions.push_back(region);
+
+	return(static_cast<int>(m_regions.size()) - 1);
+}
+
+/***********************************************************
+ *  AddTimestamp()
+ *
+ *  This method is used for placing a timestamp query into
+ *  the current frame.  The queries of a frame slot are kept
+ *  for the later frames that use the same slot.
+ ***********************************************************/
+size_t GPUProfiler::AddTimestamp()
+{
+	FRAME_SLOT& slot = m_slots[m_frameNumber % FRAME_SLOTS];
+	if (slot.usedQueries == slot.queries.size())
+	{
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		slot.queries.push_back(query);
+	}
+
+	size_t queryIndex = slot.usedQueries++;
+	glQueryCounter(slot.queries[queryIndex], GL_TIMESTAMP);
+
+	return(queryIndex);
+}
+
+/***********************************************************
+ *  ReadSlot()
+ *
+ *  This method is used for reading the region times of a
+ *  frame.  Unless told to wait, nothing is read until all
+ *  of the queries of the frame are available.
+ ***********************************************************/
+bool GPUProfiler::ReadSlot(int slotIndex, bool bWait)
+{
+	FRAME_SLOT& slot = m_slots[slotIndex];
+	if (false == bWait)
+	{
+		for (size_t i = 0; i < slot.usedQueries; i++)
+		{
+			GLint bAvailable = GL_FALSE;
+			glGetQueryObjectiv(slot.queries[i], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+			if (GL_FALSE == bAvailable)
+			{
+				return(false);
+			}
+		}
+	}
+
+	for (const REGION_MARK& mark : slot.marks)
+	{
+		// a region that was never ended has no end query
+		if (mark.endQuery == mark.startQuery)
+		{
+			continue;
+		}
+
+		GLuint64 startNanoseconds = 0;
+		GLuint64 endNanoseconds = 0;
+		glGetQueryObjectui64v(slot.queries[mark.startQuery], GL_QUERY_RESULT, &startNanoseconds);
+		glGetQueryObjectui64v(slot.queries[mark.endQuery], GL_QUERY_RESULT, &endNanoseconds);
+		if (endNanoseconds >= startNanoseconds)
+		{
+			AddSample(m_regions[mark.region], (endNanoseconds - startNanoseconds) / 1000000.0);
+		}
+	}
+
+	if ((true == m_bKeepFrameTimes) && (slot.frameEndQuery > 0))
+	{
+		GLuint64 startNanoseconds = 0;
+		GLuint64 endNanoseconds = 0;
+		glGetQueryObjectui64v(slot.queries[0], GL_QUERY_RESULT, &startNanoseconds);
+		glGetQueryObjectui64v(slot.queries[slot.frameEndQuery], GL_QUERY_RESULT, &endNanoseconds);
+		if (endNanoseconds >= startNanoseconds)
+		{
+			FRAME_TIME frameTime;
+			frameTime.frameNumber = m_slotFrames[slotIndex];
+			frameTime.milliseconds = (endNanoseconds - startNanoseconds) / 1000000.0;
+			m_frameTimes.push_back(frameTime);
+		}
+	}
+	slot.bPending = false;
+
+	return(true);
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used for adding a measured time to a
+ *  region, over its oldest time once the window is full.
+ ***********************************************************/
+void GPUProfiler::AddSample(REGION& region, double milliseconds)
+{
+	if (region.samples.size() < SAMPLE_WINDOW)
+	{
+		region.samples.push_back(milliseconds);
+	}
+	else
+	{
+		region.samples[region.nextSample] = milliseconds;
+	}
+	region.nextSample = (region.nextSample + 1) % SAMPLE_WINDOW;
+	region.totalSamples++;
+	region.totalMilliseconds += milliseconds;
+}
+
+/***********************************************************
+ *  GetRegionStats()
+ *
+ *  This method is used for getting the times of every
+ *  region.  The average covers all of the measured times,
+ *  and the percentiles the most recent SAMPLE_WINDOW times.
+ ***********************************************************/
+void GPUProfiler::GetRegionStats(std::vector<REGION_STATS>& stats) const
+{
+	stats.clear();
+	for (const REGION& region : m_regions)
+	{
+		REGION_STATS regionStats = {};
+		regionStats.name = region.name;
+		regionStats.sampleCount = region.totalSamples;
+
+		if (region.samples.size() > 0)
+		{
+			std::vector<double> sorted = region.samples;
+			std::sort(sorted.begin(), sorted.end());
+			size_t last = sorted.size() - 1;
+
+			regionStats.averageMilliseconds = region.totalMilliseconds / region.totalSamples;
+			regionStats.medianMilliseconds = sorted[last / 2];
+			regionStats.p95Milliseconds = sorted[(last * 95) / 100];
+			regionStats.p99Milliseconds = sorted[(last * 99) / 100];
+			regionStats.maxMilliseconds = sorted[last];
+		}
+		stats.push_back(regionStats);
+	}
+}
+
+/***********************************************************
+ *  PrintSummary()
+ *
+ *  This method is used for printing the times of every
+ *  measured region.
+ ***********************************************************/
+void GPUProfiler::PrintSummary() const
+{
+	if (false == m_bSupported)
+	{
+		std::cout << "INFO: GPU region times are not supported" << std::endl;
+		return;
+	}
+
+	std::vector<REGION_STATS> stats;
+	GetRegionStats(stats);
+
+	std::cout << "INFO: GPU region times (ms), " << m_droppedFrames << " frames dropped:" << std::endl;
+	for (const REGION_STATS& region : stats)
+	{
+		std::cout << "INFO:   " << region.name << ": average " << region.averageMilliseconds
+			<< ", median " << region.medianMilliseconds
+			<< ", p95 " << region.p95Milliseconds
+			<< ", p99 " << region.p99Milliseconds
+			<< ", max " << region.maxMilliseconds
+			<< " (" << region.sampleCount << " samples)" << std::endl;
+	}
+}
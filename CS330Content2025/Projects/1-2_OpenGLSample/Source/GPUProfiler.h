@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuprofiler.h
+// =============
+// Defines the `GPUProfiler` class, which measures how long the GPU spends on
+// named regions of each frame, such as the scene submission and each batch
+// of indirect draws.
+//
+// RESPONSIBILITIES:
+// - Place a pair of GPU timestamp queries around every region.
+// - Read the query results back a few frames later, without waiting.
+// - Keep the recent times of every region, and report their averages and
+//   percentiles for logging or for display.
+// - Time every whole frame, and keep those times for a frame benchmark.
+//
+// NOTE: The queries of each frame are kept in a ring of frames, and a frame
+// is read once the GPU has finished it, normally two or three frames later.
+// A frame that is still not finished when its queries are needed again is
+// dropped rather than waited for.  GL_TIMESTAMP queries are used instead of
+// GL_TIME_ELAPSED, since they can be nested and work on Mesa software GL.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  GPUProfiler
+ *
+ *  This class contains the code for timing regions of the
+ *  frames on the GPU.
+ ***********************************************************/
+class GPUProfiler
+{
+public:
+	// constructor
+	GPUProfiler();
+	// destructor
+	~GPUProfiler();
+
+	// the measured times of one region, in milliseconds
+	struct REGION_STATS
+	{
+		std::string name;
+		size_t sampleCount;
+		double averageMilliseconds;
+		double medianMilliseconds;
+		double p95Milliseconds;
+		double p99Milliseconds;
+		double maxMilliseconds;
+	};
+
+	// the measured time of a whole frame
+	struct FRAME_TIME
+	{
+		unsigned long long frameNumber;
+		double milliseconds;
+	};
+
+private:
+	// number of frames whose queries are kept, and the number of
+	// frames before the results of a frame are first looked for
+	static const int FRAME_SLOTS = 4;
+	static const int READ_LATENCY = 2;
+	// number of recent times of each region used for the percentiles
+	static const size_t SAMPLE_WINDOW = 1024;
+
+	// a region of a frame, with its start and end queries
+	struct REGION_MARK
+	{
+		int region;
+		size_t startQuery;
+		size_t endQuery;
+	};
+
+	// the queries of one frame in the ring - the first query
+	// is the start of the frame
+	struct FRAME_SLOT
+	{
+		std::vector<GLuint> queries;
+		size_t frameEndQuery;
+		size_t usedQueries;
+		std::vector<REGION_MARK> marks;
+		bool bPending;
+	};
+
+	// the recent times of a named region
+	struct REGION
+	{
+		std::string name;
+		const char* key;
+		std::vector<double> samples;
+		size_t nextSample;
+		size_t totalSamples;
+		double totalMilliseconds;
+	};
+
+	// true when the timestamp queries are supported
+	bool m_bSupported;
+	// true between BeginFrame() and EndFrame()
+	bool m_bInFrame;
+	// number of frames begun so far
+	unsigned long long m_frameNumber;
+	// number of frames dropped because they were not finished in time
+	unsigned int m_droppedFrames;
+	FRAME_SLOT m_slots[FRAME_SLOTS];
+	unsigned long long m_slotFrames[FRAME_SLOTS];
+	std::vector<REGION> m_regions;
+	// marks of the regions that are still open
+	std::vector<size_t> m_openMarks;
+	// whole frame times that were read and not yet taken
+	bool m_bKeepFrameTimes;
+	std::vector<FRAME_TIME> m_frameTimes;
+
+	// find or add the region with the passed in name
+	int FindRegion(const char* name);
+	// place a timestamp query into the current frame
+	size_t AddTimestamp();
+	// read the results of a frame when they are available, or
+	// wait for them - returns false if they are not available
+	bool ReadSlot(int slotIndex, bool bWait);
+	// add a measured time to a region
+	void AddSample(REGION& region, double milliseconds);
+
+public:
+	// true when the GPU times can be measured
+	bool IsSupported() const;
+
+	// mark the start and end of a frame
+	void BeginFrame();
+	void EndFrame();
+	// get the number of the current frame, counted from 1
+	unsigned long long GetFrameNumber() const;
+	// keep the times of the whole frames until they are taken
+	void KeepFrameTimes(bool bKeep);
+	void TakeFrameTimes(std::vector<FRAME_TIME>& frameTimes);
+	// mark the start and end of a region of the current frame -
+	// regions can be nested, and the name must stay valid
+	void BeginRegion(const char* name);
+	void EndRegion();
+
+	// read the results of all of the outstanding frames
+	void ReadAll();
+	// get the times of every region measured so far
+	void GetRegionStats(std::vector<REGION_STATS>& stats) const;
+	void PrintSummary() const;
+};
@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+// lockfreequeue.h
+// ===============
+// Defines the `LockFreeQueue` class template, a bounded queue that any number
+// of threads can push to and pop from without taking a lock.
+//
+// RESPONSIBILITIES:
+// - Hand values from the threads that produce them to the threads that use
+//   them, such as decoded images from the loader threads to the GL thread.
+//
+// NOTE: Every cell of the ring has a sequence number that tells whether it
+// is ready to be written or to be read in the current pass over the ring.
+// A thread claims a cell by advancing the push or pop position with a
+// compare-and-swap, and hands it over by storing its next sequence number.
+// A push to a full queue and a pop from an empty queue fail right away.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/***********************************************************
+ *  LockFreeQueue
+ *
+ *  This class template contains the code for a bounded
+ *  queue of values, whose capacity is a power of two.
+ ***********************************************************/
+template <typename T, size_t CAPACITY>
+class LockFreeQueue
+{
+	static_assert((CAPACITY >= 2) && ((CAPACITY & (CAPACITY - 1)) == 0),
+		"the capacity of a LockFreeQueue must be a power of two");
+
+public:
+	// constructor
+	LockFreeQueue()
+	{
+		for (size_t i = 0; i < CAPACITY; i++)
+		{
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		m_pushPosition.store(0, std::memory_order_relaxed);
+		m_popPosition.store(0, std::memory_order_relaxed);
+	}
+
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+	// add a value - returns false if the queue is full
+	bool Push(const T& value)
+	{
+		CELL* cell = NULL;
+		size_t position = m_pushPosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[position & (CAPACITY - 1)];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+			if (difference == 0)
+			{
+				// the cell is free in this pass, so try to claim it
+				if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// the cell still holds a value from the last pass
+				return(false);
+			}
+			else
+			{
+				// another thread claimed the cell first
+				position = m_pushPosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->value = value;
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return(true);
+	}
+
+	// take the oldest value - returns false if the queue is empty
+	bool Pop(T& value)
+	{
+		CELL* cell = NULL;
+		size_t position = m_popPosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[position & (CAPACITY - 1)];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position + 1);
+			if (difference == 0)
+			{
+				// the cell holds a value, so try to claim it
+				if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// the cell has not been written in this pass
+				return(false);
+			}
+			else
+			{
+				// another thread claimed the cell first
+				position = m_popPosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		value = cell->value;
+		// the cell is free again for the next pass over the ring
+		cell->sequence.store(position + CAPACITY, std::memory_order_release);
+		return(true);
+	}
+
+private:
+	// a cell of the ring, with the sequence number that marks
+	// whether it is free or holds a value
+	struct CELL
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	CELL m_cells[CAPACITY];
+	// the positions are kept on their own cache lines, so the
+	// threads that push and pop do not slow each other down
+	alignas(64) std::atomic<size_t> m_pushPosition;
+	alignas(64) std::atomic<size_t> m_popPosition;
+};
@@ -19,6 +19,10 @@
 // - Integrate `SceneManager`, `ViewManager`, and `ShaderManager` for 
 //   rendering the 3D scene.
 // - Handle user input and manage the main rendering loop.
+// - Optionally render a fixed number of frames, with or without a window,
+//   and save the frame times and the last frame for benchmarking.
+// - Optionally write the profiler zones to a Chrome trace file on exit.
+// - Optionally time regions of the frames on the GPU and log their times.
 //
 // NOTE: This implementation uses GLEW for handling OpenGL extensions, GLFW 
 // for window and input management, and GLM for mathematical operations.
@@ -26,6 +30,7 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <string>           // command line options
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -40,6 +45,12 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "FrameBenchmark.h"
+#include "RegistryBenchmark.h"
+#include "MeshGeneratorBenchmark.h"
+#include "GPUProfiler.h"
+#include "ZoneProfiler.h"
 
 // Namespace for declaring global variables
 namespace
@@ -56,12 +67,40 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame benchmark object for timing a fixed number of frames
+	FrameBenchmark* g_FrameBenchmark = nullptr;
+	// GPU profiler object for timing regions of the frames
+	GPUProfiler* g_GPUProfiler = nullptr;
+
+	// default number of frames rendered in headless mode
+	const int DEFAULT_HEADLESS_FRAMES = 100;
+
+	// options read from the command line
+	bool g_bHeadless = false;
+	bool g_bImmediate = false;
+	bool g_bGPURegions = false;
+	bool g_bProgramCache = true;
+	bool g_bAsyncShaders = true;
+	bool g_bAsyncTextures = true;
+	bool g_bBuildTextureCache = false;
+	bool g_bCompressTextures = false;
+	bool g_bTextureArrays = true;
+	bool g_bBenchRegistry = false;
+	bool g_bBenchMeshes = false;
+	bool g_bVerbose = false;
+	int g_FrameCount = 0;
+	std::string g_CSVFilename;
+	std::string g_PNGFilename;
+	std::string g_CompareFilename;
+	std::string g_TraceFilename;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
+bool ParseCommandLine(int argc, char* argv[]);
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool SaveBenchmarkResults();
 
 
 /***********************************************************
@@ -72,6 +111,36 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	bool bBenchmarkPassed = true;
+
+	PROFILE_THREAD_NAME("Main");
+
+	// if the command line options are not valid, then terminate the application
+	if (ParseCommandLine(argc, argv) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the texture cache is built without a window or a GL
+	// context, so the cache files can be made ahead of time
+	if (true == g_bBuildTextureCache)
+	{
+		return((true == SceneManager::BuildTextureCache(true, g_bCompressTextures)) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// the tag lookups are timed without a window either
+	if (true == g_bBenchRegistry)
+	{
+		return((true == RegistryBenchmark::Run(1000, 1000000)) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// and so are the mesh generators
+	if (true == g_bBenchMeshes)
+	{
+		MeshGeneratorBenchmark::Run();
+		return(EXIT_SUCCESS);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -84,8 +153,20 @@ int main(int argc, char* argv[])
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
 
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	// try to create the main display window, or the hidden
+	// window for rendering without a display
+	if (true == g_bHeadless)
+	{
+		g_Window = g_ViewManager->CreateHeadlessWindow(WINDOW_TITLE);
+		if (NULL == g_Window)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
+	else
+	{
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
@@ -93,16 +174,73 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
+	// load the shader code from the external GLSL files - the scene
+	// only draws with variants of it, which are compiled in the
+	// background while the scene loads, and the linked programs are
+	// cached, so only the first start compiles them
+	g_ShaderManager->setProgramCacheEnabled(g_bProgramCache);
+	g_ShaderManager->setAsyncCompileEnabled(g_bAsyncShaders);
+	g_ShaderManager->LoadShaderVariants(
 		"shaders/vertexShader.glsl",
 		"shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetAsyncTextureLoading(g_bAsyncTextures);
+	g_SceneManager->SetTextureCompression(g_bCompressTextures);
+	g_SceneManager->SetTextureArrays(g_bTextureArrays);
 	g_SceneManager->PrepareScene();
 
+	// the scene is drawn in batches when supported - the
+	// --immediate option issues one draw call per object instead
+	if (true == g_bImmediate)
+	{
+		g_SceneManager->SetBatchedRendering(false);
+	}
+	// the GPU region times are read back a few frames late,
+	// so measuring them does not stall the rendering - the
+	// timed frames also take their GPU times from the profiler
+	if ((true == g_bGPURegions) || (g_FrameCount > 0))
+	{
+		g_GPUProfiler = new GPUProfiler();
+	}
+	if (true == g_bGPURegions)
+	{
+		g_SceneManager->SetGPUProfiler(g_GPUProfiler);
+	}
+
+	std::cout << "INFO: Scene drawing mode: "
+		<< (g_SceneManager->IsBatchedRendering() ? "batched indirect draws" : "one draw call per object")
+		<< std::endl;
+
+	// when a number of frames is requested, time each of them -
+	// headless frames are rendered into an offscreen framebuffer
+	if (g_FrameCount > 0)
+	{
+		// the timed frames are drawn with the real shader programs
+		// and textures, not with what stands in while they load
+		g_ShaderManager->finishProgramVariants();
+		g_SceneManager->FinishTextureLoading();
+
+		int frameWidth = 0;
+		int frameHeight = 0;
+		glfwGetFramebufferSize(g_Window, &frameWidth, &frameHeight);
+
+		g_FrameBenchmark = new FrameBenchmark(g_FrameCount);
+		g_FrameBenchmark->SetGPUProfiler(g_GPUProfiler);
+		if (true == g_bHeadless)
+		{
+			if (g_FrameBenchmark->CreateRenderTarget(frameWidth, frameHeight) == false)
+			{
+				return(EXIT_FAILURE);
+			}
+		}
+		else
+		{
+			g_FrameBenchmark->SetFrameSize(frameWidth, frameHeight);
+		}
+	}
+
 	std::cout << "\n*** KEY FUNCTIONS: ***\n";
 	std::cout << "ESC - close the window and exit\n";
 	std::cout << "W - zoom in\t" << "S - zoom out\n";
@@ -117,8 +255,27 @@ int main(int argc, char* argv[])
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		PROFILE_ZONE("Frame");
+
+		if (NULL != g_FrameBenchmark)
+		{
+			g_FrameBenchmark->BeginFrame();
+		}
+
+		if (NULL != g_GPUProfiler)
+		{
+			g_GPUProfiler->BeginFrame();
+		}
+
+		// count the GL calls skipped by the state cache per frame
+		GLStateCache::ResetElidedCallCount();
+
+		// pick up the shader programs that the driver has finished
+		// compiling in the background, without waiting for the others
+		g_ShaderManager->pollProgramVariants();
+
 		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		GLStateCache::SetCapability(GL_DEPTH_TEST, true);
 
 		// Clear the frame and z buffers
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -126,19 +283,92 @@ int main(int argc, char* argv[])
 
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetLODView(g_ViewManager->GetLODView());
+		g_SceneManager->SetViewFrustum(g_ViewManager->GetViewFrustum());
 
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
 
+		if (NULL != g_GPUProfiler)
+		{
+			g_GPUProfiler->EndFrame();
+		}
+
+		// with --verbose, report the scene object in the middle of
+		// the view when the left mouse button has been pressed
+		glm::vec3 rayOrigin;
+		glm::vec3 rayDirection;
+		if ((true == g_ViewManager->GetPickRay(rayOrigin, rayDirection)) && (true == g_bVerbose))
+		{
+			float distance = 0.0f;
+			int pickedObject = g_SceneManager->PickObject(rayOrigin, rayDirection, distance);
+			if (pickedObject >= 0)
+			{
+				std::cout << "Picked scene object " << pickedObject
+					<< " at distance " << distance << std::endl;
+			}
+		}
+
+		// after the last timed frame, save the results while the
+		// frame is still in the buffer and close the window
+		if (NULL != g_FrameBenchmark)
+		{
+			g_FrameBenchmark->EndFrame(
+				g_SceneManager->GetDrawCallCount(),
+				g_SceneManager->GetDrawnObjectCount(),
+				g_SceneManager->GetCulledObjectCount(),
+				GLStateCache::GetElidedCallCount());
+			if (true == g_FrameBenchmark->IsComplete())
+			{
+				bBenchmarkPassed = SaveBenchmarkResults();
+				glfwSetWindowShouldClose(g_Window, true);
+			}
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		// There is nothing to display in headless mode.
+		if (false == g_bHeadless)
+		{
+			PROFILE_ZONE("glfwSwapBuffers");
+			glfwSwapBuffers(g_Window);
+		}
 
 		// query the latest GLFW events
 		glfwPollEvents();
 	}
 
+	// the profiler zones are only recorded when the profiler
+	// is compiled in with ENABLE_ZONE_PROFILER
+	if (false == g_TraceFilename.empty())
+	{
+#ifdef ENABLE_ZONE_PROFILER
+		PROFILE_WRITE_TRACE(g_TraceFilename);
+#else
+		std::cout << "INFO: No profiler trace written - the profiler is not compiled in" << std::endl;
+#endif
+	}
+
 	// clear the allocated manager objects from memory
+	if (NULL != g_GPUProfiler)
+	{
+		if (true == g_bGPURegions)
+		{
+			g_GPUProfiler->ReadAll();
+			g_GPUProfiler->PrintSummary();
+		}
+		g_SceneManager->SetGPUProfiler(NULL);
+		if (NULL != g_FrameBenchmark)
+		{
+			g_FrameBenchmark->SetGPUProfiler(NULL);
+		}
+		delete g_GPUProfiler;
+		g_GPUProfiler = NULL;
+	}
+	if (NULL != g_FrameBenchmark)
+	{
+		delete g_FrameBenchmark;
+		g_FrameBenchmark = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -151,14 +381,137 @@ int main(int argc, char* argv[])
 	}
 	if (NULL != g_ShaderManager)
 	{
+		std::cout << "INFO: " << g_ShaderManager->getUniformLookupsAvoided()
+			<< " uniform location lookups served from the cache" << std::endl;
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
 
-	// Terminates the program successfully
+	// Terminates the program successfully, unless the last
+	// frame did not match the reference image
+	if (false == bBenchmarkPassed)
+	{
+		exit(EXIT_FAILURE);
+	}
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the command line options.
+ *  Returns false if an option is not recognized.
+ ***********************************************************/
+bool ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		bool bHasValue = (i + 1 < argc);
+
+		if (option == "--headless")
+		{
+			g_bHeadless = true;
+		}
+		else if (option == "--immediate")
+		{
+			g_bImmediate = true;
+		}
+		else if (option == "--gpu-regions")
+		{
+			g_bGPURegions = true;
+		}
+		else if (option == "--no-program-cache")
+		{
+			g_bProgramCache = false;
+		}
+		else if (option == "--serial-shaders")
+		{
+			g_bAsyncShaders = false;
+		}
+		else if (option == "--serial-textures")
+		{
+			g_bAsyncTextures = false;
+		}
+		else if (option == "--compress-textures")
+		{
+			g_bCompressTextures = true;
+		}
+		else if (option == "--separate-textures")
+		{
+			g_bTextureArrays = false;
+		}
+		else if (option == "--bench-registry")
+		{
+			g_bBenchRegistry = true;
+		}
+		else if (option == "--bench-meshes")
+		{
+			g_bBenchMeshes = true;
+		}
+		else if (option == "--verbose")
+		{
+			g_bVerbose = true;
+		}
+		else if (option == "--build-texture-cache")
+		{
+			g_bBuildTextureCache = true;
+		}
+		else if ((option == "--frames") && (true == bHasValue))
+		{
+			g_FrameCount = std::atoi(argv[++i]);
+		}
+		else if ((option == "--csv") && (true == bHasValue))
+		{
+			g_CSVFilename = argv[++i];
+		}
+		else if ((option == "--png") && (true == bHasValue))
+		{
+			g_PNGFilename = argv[++i];
+		}
+		else if ((option == "--compare") && (true == bHasValue))
+		{
+			g_CompareFilename = argv[++i];
+		}
+		else if ((option == "--trace") && (true == bHasValue))
+		{
+			g_TraceFilename = argv[++i];
+		}
+		else
+		{
+			std::cout << "Unknown option: " << option << "\n\n";
+			std::cout << "Options:\n";
+			std::cout << "  --headless         render offscreen without a window\n";
+			std::cout << "  --frames <count>   render and time a number of frames, then exit\n";
+			std::cout << "  --csv <file>       write the time of each frame to a CSV file\n";
+			std::cout << "  --png <file>       write the last frame to a PNG file\n";
+			std::cout << "  --compare <file>   compare the last frame to a PNG file\n";
+			std::cout << "  --immediate        issue one draw call per object\n";
+			std::cout << "  --trace <file>     write the profiler zones to a Chrome trace file (Debug builds)\n";
+			std::cout << "  --gpu-regions      time regions of the frames on the GPU and log them\n";
+			std::cout << "  --no-program-cache compile the shaders without the program binary cache\n";
+			std::cout << "  --serial-shaders   compile each shader program when it is first used\n";
+			std::cout << "  --serial-textures  load the textures one after the other before drawing\n";
+			std::cout << "  --compress-textures compress the textures into BC1 or BC3 blocks\n";
+			std::cout << "  --separate-textures keep each texture in its own texture unit\n";
+			std::cout << "  --build-texture-cache  rebuild the texture cache files, then exit\n";
+			std::cout << "  --bench-registry   time the lookups of 1000 material tags, then exit\n";
+			std::cout << "  --verbose          log the scene object picked with the left mouse button\n";
+			std::cout << "  --bench-meshes     time the mesh generators per vertex, then exit\n";
+			return(false);
+		}
+	}
+
+	// a headless run has no window to close, so it always
+	// stops after a number of frames
+	if ((true == g_bHeadless) && (g_FrameCount <= 0))
+	{
+		g_FrameCount = DEFAULT_HEADLESS_FRAMES;
+	}
+
+	return(true);
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
@@ -168,6 +521,12 @@ bool InitializeGLFW()
 {
 	// GLFW: initialize and configure library
 	// --------------------------------------
+	// headless rendering uses the null platform, which needs
+	// no display, with a software rendered OpenGL context
+	if (true == g_bHeadless)
+	{
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	}
 	glfwInit();
 
 #ifdef __APPLE__
@@ -181,6 +540,13 @@ bool InitializeGLFW()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #endif
+	// software OpenGL may not offer version 4.6 - the newest
+	// version it supports is used for a 3.3 core request
+	if (true == g_bHeadless)
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	}
 	// GLFW: end -------------------------------
 
 	return(true);
@@ -211,4 +577,34 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
+}
+
+/***********************************************************
+ *	SaveBenchmarkResults()
+ *
+ *  This function is used to save the frame times and the
+ *  last frame after the timed frames have been rendered.
+ *  Returns false if the last frame did not match the
+ *  reference image.
+ ***********************************************************/
+bool SaveBenchmarkResults()
+{
+	bool bPassed = true;
+
+	g_FrameBenchmark->PrintSummary();
+
+	if (false == g_CSVFilename.empty())
+	{
+		g_FrameBenchmark->WriteCSV(g_CSVFilename);
+	}
+	if (false == g_PNGFilename.empty())
+	{
+		g_FrameBenchmark->WritePNG(g_PNGFilename);
+	}
+	if (false == g_CompareFilename.empty())
+	{
+		bPassed = g_FrameBenchmark->ComparePNG(g_CompareFilename);
+	}
+
+	return(bPassed);
 }
\ No newline at end of file
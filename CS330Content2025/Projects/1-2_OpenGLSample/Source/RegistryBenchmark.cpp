@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////////////
+// registrybenchmark.cpp
+// =====================
+// time the ways of finding a material by its tag
+//
+// The tags are looked up from character pointers, the way the string
+// literals of the scene code were passed, so the linear scan pays for the
+// std::string that every call used to build.  Each way adds up the handles it
+// found and the shininess of the found materials, which keeps the compiler
+// from dropping the lookups and shows that all of them found the same ones.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RegistryBenchmark.h"
+
+#include "TagRegistry.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// a material like the ones of the scene manager
+	struct BENCHMARK_MATERIAL
+	{
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		std::string tag;
+	};
+
+	// the sums a way of looking up adds up
+	struct LOOKUP_SUMS
+	{
+		long long handleSum;
+		double shininessSum;
+	};
+
+	///////////////////////////////////////////////////
+	//	FindMaterialLinear()
+	//
+	//	Find a material the way the scene manager did
+	//	before the tags were registered, with the tag
+	//	passed by value and compared to every material.
+	///////////////////////////////////////////////////
+	int FindMaterialLinear(const std::vector<BENCHMARK_MATERIAL>& materials, std::string tag)
+	{
+		int materialIndex = -1;
+		int index = 0;
+		bool bFound = false;
+
+		while ((index < static_cast<int>(materials.size())) && (bFound == false))
+		{
+			if (materials[index].tag.compare(tag) == 0)
+			{
+				materialIndex = index;
+				bFound = true;
+			}
+			else
+			{
+				index++;
+			}
+		}
+
+		return(materialIndex);
+	}
+
+	///////////////////////////////////////////////////
+	//	AddLookup()
+	//
+	//	Add a found material to the sums.
+	///////////////////////////////////////////////////
+	void AddLookup(LOOKUP_SUMS& sums, const std::vector<BENCHMARK_MATERIAL>& materials, int handle)
+	{
+		sums.handleSum += handle;
+		if (handle >= 0)
+		{
+			sums.shininessSum += materials[handle].shininess;
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	PrintTime()
+	//
+	//	Print the time of one lookup.
+	///////////////////////////////////////////////////
+	void PrintTime(const char* name, std::chrono::steady_clock::duration time, int lookupCount)
+	{
+		double nanoseconds = std::chrono::duration<double, std::nano>(time).count() / lookupCount;
+		char line[128];
+		snprintf(line, sizeof(line), "  %-20s %10.2f ns per lookup", name, nanoseconds);
+		std::cout << line << std::endl;
+	}
+}
+
+///////////////////////////////////////////////////
+//	RegistryBenchmark::Run()
+//
+//	Define the materials, and time the same random
+//	sequence of lookups each way.  The sequence is
+//	made by a fixed linear congruential generator,
+//	so every run looks up the same materials.
+///////////////////////////////////////////////////
+bool RegistryBenchmark::Run(int materialCount, int lookupCount)
+{
+	if ((materialCount <= 0) || (lookupCount <= 0))
+	{
+		return(false);
+	}
+
+	std::vector<BENCHMARK_MATERIAL> materials(materialCount);
+	TagRegistry registry;
+	for (int i = 0; i < materialCount; i++)
+	{
+		char tag[32];
+		snprintf(tag, sizeof(tag), "material_%04d", i);
+
+		float shade = static_cast<float>(i) / materialCount;
+		materials[i].diffuseColor = glm::vec3(shade, 0.5f, 1.0f - shade);
+		materials[i].specularColor = glm::vec3(0.5f);
+		materials[i].shininess = 1.0f + static_cast<float>(i % 64);
+		materials[i].tag = tag;
+		registry.Register(materials[i].tag);
+	}
+
+	std::vector<int> handles(lookupCount);
+	std::vector<const char*> tags(lookupCount);
+	uint32_t state = 12345U;
+	for (int i = 0; i < lookupCount; i++)
+	{
+		state = state * 1664525U + 1013904223U;
+		handles[i] = static_cast<int>((state >> 8) % static_cast<uint32_t>(materialCount));
+		tags[i] = materials[handles[i]].tag.c_str();
+	}
+
+	LOOKUP_SUMS linearSums = { 0, 0.0 };
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookupCount; i++)
+	{
+		AddLookup(linearSums, materials, FindMaterialLinear(materials, tags[i]));
+	}
+	std::chrono::steady_clock::duration linearTime = std::chrono::steady_clock::now() - startTime;
+
+	LOOKUP_SUMS hashedSums = { 0, 0.0 };
+	startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookupCount; i++)
+	{
+		AddLookup(hashedSums, materials, registry.Find(tags[i]));
+	}
+	std::chrono::steady_clock::duration hashedTime = std::chrono::steady_clock::now() - startTime;
+
+	LOOKUP_SUMS handleSums = { 0, 0.0 };
+	startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookupCount; i++)
+	{
+		AddLookup(handleSums, materials, handles[i]);
+	}
+	std::chrono::steady_clock::duration handleTime = std::chrono::steady_clock::now() - startTime;
+
+	std::cout << "INFO: " << lookupCount << " lookups of " << materialCount << " materials" << std::endl;
+	PrintTime("linear tag scan", linearTime, lookupCount);
+	PrintTime("hashed tag lookup", hashedTime, lookupCount);
+	PrintTime("handle", handleTime, lookupCount);
+
+	bool bMatched = (linearSums.handleSum == handleSums.handleSum) &&
+		(hashedSums.handleSum == handleSums.handleSum) &&
+		(linearSums.shininessSum == handleSums.shininessSum) &&
+		(hashedSums.shininessSum == handleSums.shininessSum);
+	if (false == bMatched)
+	{
+		std::cout << "ERROR: The lookups did not find the same materials" << std::endl;
+	}
+
+	return(bMatched);
+}
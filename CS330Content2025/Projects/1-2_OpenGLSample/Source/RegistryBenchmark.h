@@ -0,0 +1,21 @@
+///////////////////////////////////////////////////////////////////////////////
+// registrybenchmark.h
+// ===================
+// time the ways of finding a material by its tag
+//
+// A number of materials is defined with tags like the scene ones, and the
+// same random sequence of materials is looked up three ways: by walking the
+// materials and comparing the tag of each, like the scene manager used to
+// for every draw, through the hash table of a tag registry, and by a handle
+// that was found once.  The time of a lookup is printed for each, so the
+// benchmark runs without a window or a GL context.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace RegistryBenchmark
+{
+	// time the lookups of a number of materials - returns false
+	// if the ways of looking them up do not find the same ones
+	bool Run(int materialCount, int lookupCount);
+}
@@ -0,0 +1,231 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ===============
+// This file contains the implementation of the `RenderQueue` class, which
+// sorts the draw packets of a frame by their 64-bit sort keys.
+//
+// RESPONSIBILITIES:
+// - Pack the state and depth of a draw into the bits of its key.
+// - Sort the keys with a least significant digit radix sort.
+//
+// NOTE: The sort key layout, from the highest bits down, is
+//   pass (2) | translucent (1) | program (2) | mesh (12) | texture (7) |
+//   material (8) | depth (32)
+// for the opaque draws, and
+//   pass (2) | translucent (1) | inverted depth (32) | program (2) |
+//   mesh (12) | texture (7) | material (8)
+// for the translucent draws.  The depth is kept as the bits of a positive
+// float, which sort in the same order as the values.  A value that does not
+// fit into the bits of its field fails an assert in the Debug builds.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <cassert>
+#include <cstring>
+
+// declaration of global variables and defines
+namespace
+{
+	// number of bits of each field of the sort key
+	const int g_PassBits = 2;
+	const int g_ProgramBits = 2;
+	const int g_MeshBits = 12;
+	const int g_TextureBits = 7;
+	const int g_MaterialBits = 8;
+	const int g_DepthBits = 32;
+
+	static_assert(g_PassBits + 1 + g_ProgramBits + g_MeshBits + g_TextureBits + g_MaterialBits + g_DepthBits <= 64,
+		"the sort key fields do not fit into 64 bits");
+
+	// the keys are sorted one byte at a time
+	const int g_RadixBits = 8;
+	const int g_RadixSize = 1 << g_RadixBits;
+	const int g_RadixPasses = 64 / g_RadixBits;
+
+	/***********************************************************
+	 *  AppendField()
+	 *
+	 *  Shift the key up by the bits of a field and put the
+	 *  field value below them.  A larger value would be cut
+	 *  to the bits and sort as a different one.
+	 ***********************************************************/
+	inline uint64_t AppendField(uint64_t key, uint64_t value, int bits)
+	{
+		assert((value >> bits) == 0 && "the value does not fit into its sort key field");
+		return((key << bits) | value);
+	}
+
+	/***********************************************************
+	 *  GetDepthBits()
+	 *
+	 *  Get the bits of the depth value, with the points behind
+	 *  the camera sorted as the nearest ones.
+	 ***********************************************************/
+	inline uint32_t GetDepthBits(float depth)
+	{
+		uint32_t bits = 0;
+
+		// the comparison is also false for a NaN depth
+		if (depth > 0.0f)
+		{
+			std::memcpy(&bits, &depth, sizeof(bits));
+		}
+
+		return(bits);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+}
+
+/***********************************************************
+ *  MakeSortKey()
+ *
+ *  This method is used for building the sort key of a draw.
+ *  Opaque draws are grouped by state and drawn front-to-
+ *  back within a group, while translucent draws are drawn
+ *  back-to-front after all of the opaque draws.
+ ***********************************************************/
+uint64_t RenderQueue::MakeSortKey(const SORT_FIELDS& fields)
+{
+	uint32_t depth = GetDepthBits(fields.depth);
+	uint64_t key = 0;
+
+	key = AppendField(key, fields.pass, g_PassBits);
+	key = AppendField(key, (true == fields.bTranslucent) ? 1 : 0, 1);
+	if (true == fields.bTranslucent)
+	{
+		key = AppendField(key, ~depth, g_DepthBits);
+	}
+	key = AppendField(key, fields.program, g_ProgramBits);
+	key = AppendField(key, fields.mesh, g_MeshBits);
+	key = AppendField(key, fields.texture, g_TextureBits);
+	key = AppendField(key, fields.material, g_MaterialBits);
+	if (false == fields.bTranslucent)
+	{
+		key = AppendField(key, depth, g_DepthBits);
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the queued draws,
+ *  keeping the memory for the next frame.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_entries.clear();
+}
+
+/***********************************************************
+ *  AddPacket()
+ *
+ *  This method is used for queueing a draw with its key.
+ ***********************************************************/
+void RenderQueue::AddPacket(uint64_t key, uint32_t packet)
+{
+	QUEUE_ENTRY entry;
+	entry.key = key;
+	entry.packet = packet;
+	m_entries.push_back(entry);
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the queued draws by their
+ *  keys, one byte at a time from the lowest byte up.  The
+ *  counts of all of the bytes are taken in one pass over the
+ *  keys, and a byte that is the same in every key is skipped,
+ *  which leaves most of the bytes of a small scene unsorted.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	size_t entryCount = m_entries.size();
+	if (entryCount < 2)
+	{
+		return;
+	}
+
+	std::vector<size_t> counts(g_RadixPasses * g_RadixSize, 0);
+	for (const QUEUE_ENTRY& entry : m_entries)
+	{
+		for (int pass = 0; pass < g_RadixPasses; pass++)
+		{
+			size_t digit = static_cast<size_t>((entry.key >> (pass * g_RadixBits)) & (g_RadixSize - 1));
+			counts[pass * g_RadixSize + digit]++;
+		}
+	}
+
+	m_sortBuffer.resize(entryCount);
+	for (int pass = 0; pass < g_RadixPasses; pass++)
+	{
+		size_t* passCounts = &counts[pass * g_RadixSize];
+		int shift = pass * g_RadixBits;
+
+		// every key has the same byte, so the order is kept
+		size_t firstDigit = static_cast<size_t>((m_entries[0].key >> shift) & (g_RadixSize - 1));
+		if (passCounts[firstDigit] == entryCount)
+		{
+			continue;
+		}
+
+		// turn the counts into the first position of each digit
+		size_t position = 0;
+		for (int digit = 0; digit < g_RadixSize; digit++)
+		{
+			size_t count = passCounts[digit];
+			passCounts[digit] = position;
+			position += count;
+		}
+
+		for (const QUEUE_ENTRY& entry : m_entries)
+		{
+			size_t digit = static_cast<size_t>((entry.key >> shift) & (g_RadixSize - 1));
+			m_sortBuffer[passCounts[digit]++] = entry;
+		}
+		m_entries.swap(m_sortBuffer);
+	}
+}
+
+/***********************************************************
+ *  GetPacketCount()
+ *
+ *  This method returns the number of queued draws.
+ ***********************************************************/
+size_t RenderQueue::GetPacketCount() const
+{
+	return(m_entries.size());
+}
+
+/***********************************************************
+ *  GetPacket()
+ *
+ *  This method returns the packet number of the queued draw
+ *  at a position of the queue.
+ ***********************************************************/
+uint32_t RenderQueue::GetPacket(size_t position) const
+{
+	return(m_entries[position].packet);
+}
+
+/***********************************************************
+ *  GetSortKey()
+ *
+ *  This method returns the sort key of the queued draw at a
+ *  position of the queue.
+ ***********************************************************/
+uint64_t RenderQueue::GetSortKey(size_t position) const
+{
+	return(m_entries[position].key);
+}
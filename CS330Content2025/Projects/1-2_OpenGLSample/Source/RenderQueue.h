@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// =============
+// Defines the `RenderQueue` class, which collects the draws of a frame as
+// packets with a 64-bit sort key, so that they can be submitted in the order
+// that changes the least state between consecutive draws.
+//
+// RESPONSIBILITIES:
+// - Build the sort keys from the pass, opacity, program, mesh, texture,
+//   material and depth of a draw.
+// - Keep the key and the packet number of every queued draw.
+// - Sort the queued draws by their keys with a radix sort.
+//
+// NOTE: The opaque draws are keyed by their state first and front-to-back
+// within the same state.  The translucent draws are keyed by their depth
+// first, back-to-front, since blending is enabled for the whole scene and
+// they have to be drawn over everything behind them.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class contains the code for sorting the draw
+ *  packets of a frame by their state and depth.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// constructor
+	RenderQueue();
+
+	// the values that a draw is sorted by - the numbers have
+	// to fit into the bits of their field in the key
+	struct SORT_FIELDS
+	{
+		unsigned int pass;      // render pass, drawn in order
+		bool bTranslucent;      // drawn after the opaque draws
+		unsigned int program;   // shader program
+		unsigned int mesh;      // mesh or range of the packed meshes
+		unsigned int texture;   // texture, 0 for an untextured draw
+		unsigned int material;  // object material
+		float depth;            // distance from the camera
+	};
+
+private:
+	// a queued draw - the packet number is owned by the caller
+	struct QUEUE_ENTRY
+	{
+		uint64_t key;
+		uint32_t packet;
+	};
+
+	// the queued draws, and the buffer used while sorting
+	std::vector<QUEUE_ENTRY> m_entries;
+	std::vector<QUEUE_ENTRY> m_sortBuffer;
+
+public:
+	// build the sort key of a draw
+	static uint64_t MakeSortKey(const SORT_FIELDS& fields);
+
+	// remove every queued draw
+	void Clear();
+	// queue a draw with its sort key
+	void AddPacket(uint64_t key, uint32_t packet);
+	// sort the queued draws by their keys, keeping the order
+	// in which draws with the same key were queued
+	void Sort();
+
+	// the queued draws, in sorted order after Sort()
+	size_t GetPacketCount() const;
+	uint32_t GetPacket(size_t position) const;
+	uint64_t GetSortKey(size_t position) const;
+};
@@ -0,0 +1,608 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.cpp
+// ============
+// This file contains the implementation of the `SceneBVH` class, which builds
+// and queries a bounding volume hierarchy over the boxes of the scene objects.
+//
+// RESPONSIBILITIES:
+// - Split the objects with a binned surface area heuristic.
+// - Refit the node boxes bottom-up in a single pass over the nodes.
+// - Answer frustum, sphere and box queries by skipping whole subtrees.
+// - Trace rays through the nodes nearest first for picking.
+//
+// NOTE: Every node keeps the range of the ordered objects below it, so a
+// subtree that is completely inside of a query volume is added without
+// visiting its nodes.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+// declaration of global variables and defines
+namespace
+{
+	// subtrees deeper than this are split at the middle object
+	// so that the traversal stacks below cannot overflow
+	const int g_MaxSplitDepth = 64;
+	const int g_TraversalStackSize = 128;
+
+	/***********************************************************
+	 *  EmptyBox()
+	 *
+	 *  This function returns a box that contains nothing, so
+	 *  that growing it by any box gives that box.
+	 ***********************************************************/
+	SceneBVH::BOX EmptyBox()
+	{
+		SceneBVH::BOX box;
+		box.minimum = glm::vec3(FLT_MAX);
+		box.maximum = glm::vec3(-FLT_MAX);
+		return(box);
+	}
+
+	/***********************************************************
+	 *  GrowBox()
+	 *
+	 *  This function is used for growing a box to contain
+	 *  another box.
+	 ***********************************************************/
+	void GrowBox(SceneBVH::BOX& box, const SceneBVH::BOX& other)
+	{
+		box.minimum = glm::min(box.minimum, other.minimum);
+		box.maximum = glm::max(box.maximum, other.maximum);
+	}
+
+	/***********************************************************
+	 *  GetSurfaceArea()
+	 *
+	 *  This function returns the surface area of a box, or
+	 *  zero for an empty box.
+	 ***********************************************************/
+	float GetSurfaceArea(const SceneBVH::BOX& box)
+	{
+		glm::vec3 size = box.maximum - box.minimum;
+		if ((size.x < 0.0f) || (size.y < 0.0f) || (size.z < 0.0f))
+		{
+			return(0.0f);
+		}
+		return(2.0f * (size.x * size.y + size.y * size.z + size.z * size.x));
+	}
+
+	/***********************************************************
+	 *  BoxesOverlap()
+	 *
+	 *  This function returns true when two boxes overlap.
+	 ***********************************************************/
+	bool BoxesOverlap(const SceneBVH::BOX& a, const SceneBVH::BOX& b)
+	{
+		return(glm::all(glm::lessThanEqual(a.minimum, b.maximum)) &&
+			glm::all(glm::lessThanEqual(b.minimum, a.maximum)));
+	}
+
+	/***********************************************************
+	 *  BoxTouchesSphere()
+	 *
+	 *  This function returns true when the point of the box
+	 *  closest to the center of a sphere is inside of it.
+	 ***********************************************************/
+	bool BoxTouchesSphere(const SceneBVH::BOX& box, const glm::vec3& center, float radius)
+	{
+		glm::vec3 closest = glm::clamp(center, box.minimum, box.maximum);
+		glm::vec3 offset = closest - center;
+		return(glm::dot(offset, offset) <= radius * radius);
+	}
+
+	/***********************************************************
+	 *  IntersectBox()
+	 *
+	 *  This function is used for finding the distance along a
+	 *  ray at which it enters a box, with the slab method.  The
+	 *  distance is zero when the ray starts inside of the box.
+	 ***********************************************************/
+	bool IntersectBox(
+		const SceneBVH::BOX& box,
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		float maxDistance,
+		float& distance)
+	{
+		glm::vec3 t0 = (box.minimum - origin) * inverseDirection;
+		glm::vec3 t1 = (box.maximum - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+
+		float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		if (enter > exit)
+		{
+			return(false);
+		}
+
+		distance = enter;
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  SceneBVH()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneBVH::SceneBVH()
+{
+	m_bRefitNeeded = false;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the hierarchy over the
+ *  passed in object boxes, replacing any earlier hierarchy.
+ ***********************************************************/
+void SceneBVH::Build(const std::vector<BOX>& objectBoxes)
+{
+	Clear();
+	if (objectBoxes.size() == 0)
+	{
+		return;
+	}
+
+	m_objectBoxes = objectBoxes;
+	m_objectOrder.resize(objectBoxes.size());
+	for (size_t i = 0; i < m_objectOrder.size(); i++)
+	{
+		m_objectOrder[i] = static_cast<int>(i);
+	}
+
+	// a binary tree with one object per leaf at most has
+	// twice as many nodes as objects
+	m_nodes.reserve(2 * objectBoxes.size());
+
+	NODE root;
+	root.firstChild = -1;
+	root.firstObject = 0;
+	root.objectCount = static_cast<int>(objectBoxes.size());
+	root.bounds = GetRangeBounds(root.firstObject, root.objectCount);
+	m_nodes.push_back(root);
+
+	SplitNode(0, 0);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the objects.
+ ***********************************************************/
+void SceneBVH::Clear()
+{
+	m_nodes.clear();
+	m_objectOrder.clear();
+	m_objectBoxes.clear();
+	m_bRefitNeeded = false;
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method returns the number of objects that the
+ *  hierarchy was built over.
+ ***********************************************************/
+size_t SceneBVH::GetObjectCount() const
+{
+	return(m_objectBoxes.size());
+}
+
+/***********************************************************
+ *  GetRangeBounds()
+ *
+ *  This method is used for calculating the box around the
+ *  objects in a range of the object order.
+ ***********************************************************/
+SceneBVH::BOX SceneBVH::GetRangeBounds(int firstObject, int objectCount) const
+{
+	BOX bounds = EmptyBox();
+	for (int i = firstObject; i < firstObject + objectCount; i++)
+	{
+		GrowBox(bounds, m_objectBoxes[m_objectOrder[i]]);
+	}
+	return(bounds);
+}
+
+/***********************************************************
+ *  SplitNode()
+ *
+ *  This method is used for splitting the objects of a node
+ *  between two children.  The object centers are sorted
+ *  into bins along the longest axis of their bounds, and
+ *  the bin boundary with the lowest surface area cost is
+ *  used for the split.
+ ***********************************************************/
+void SceneBVH::SplitNode(int nodeIndex, int depth)
+{
+	int firstObject = m_nodes[nodeIndex].firstObject;
+	int objectCount = m_nodes[nodeIndex].objectCount;
+
+	if (objectCount <= MAX_LEAF_OBJECTS)
+	{
+		return;
+	}
+
+	// the bounds of the object centers select the split axis
+	BOX centerBounds = EmptyBox();
+	for (int i = firstObject; i < firstObject + objectCount; i++)
+	{
+		const BOX& box = m_objectBoxes[m_objectOrder[i]];
+		glm::vec3 center = 0.5f * (box.minimum + box.maximum);
+		centerBounds.minimum = glm::min(centerBounds.minimum, center);
+		centerBounds.maximum = glm::max(centerBounds.maximum, center);
+	}
+	glm::vec3 extent = centerBounds.maximum - centerBounds.minimum;
+	int axis = 0;
+	if (extent.y > extent[axis])
+	{
+		axis = 1;
+	}
+	if (extent.z > extent[axis])
+	{
+		axis = 2;
+	}
+
+	int splitObject = firstObject + objectCount / 2;
+	if ((extent[axis] > 0.0f) && (depth < g_MaxSplitDepth))
+	{
+		// sort the objects into bins by their centers
+		int binCounts[SPLIT_BIN_COUNT] = {};
+		BOX binBounds[SPLIT_BIN_COUNT];
+		for (int bin = 0; bin < SPLIT_BIN_COUNT; bin++)
+		{
+			binBounds[bin] = EmptyBox();
+		}
+
+		float binScale = SPLIT_BIN_COUNT / extent[axis];
+		auto GetBin = [&](int objectIndex)
+		{
+			const BOX& box = m_objectBoxes[objectIndex];
+			float center = 0.5f * (box.minimum[axis] + box.maximum[axis]);
+			int bin = static_cast<int>((center - centerBounds.minimum[axis]) * binScale);
+			return(std::min(bin, SPLIT_BIN_COUNT - 1));
+		};
+
+		for (int i = firstObject; i < firstObject + objectCount; i++)
+		{
+			int bin = GetBin(m_objectOrder[i]);
+			binCounts[bin]++;
+			GrowBox(binBounds[bin], m_objectBoxes[m_objectOrder[i]]);
+		}
+
+		// the cost of the objects below each bin boundary is
+		// gathered from the left, and above it from the right
+		float leftCosts[SPLIT_BIN_COUNT - 1];
+		BOX sweepBounds = EmptyBox();
+		int sweepCount = 0;
+		for (int bin = 0; bin < SPLIT_BIN_COUNT - 1; bin++)
+		{
+			GrowBox(sweepBounds, binBounds[bin]);
+			sweepCount += binCounts[bin];
+			leftCosts[bin] = GetSurfaceArea(sweepBounds) * sweepCount;
+		}
+
+		float bestCost = FLT_MAX;
+		int bestBin = -1;
+		sweepBounds = EmptyBox();
+		sweepCount = 0;
+		for (int bin = SPLIT_BIN_COUNT - 1; bin > 0; bin--)
+		{
+			GrowBox(sweepBounds, binBounds[bin]);
+			sweepCount += binCounts[bin];
+			float cost = leftCosts[bin - 1] + GetSurfaceArea(sweepBounds) * sweepCount;
+			if ((sweepCount > 0) && (sweepCount < objectCount) && (cost < bestCost))
+			{
+				bestCost = cost;
+				bestBin = bin;
+			}
+		}
+
+		if (bestBin > 0)
+		{
+			int* first = m_objectOrder.data() + firstObject;
+			int* middle = std::partition(first, first + objectCount,
+				[&](int objectIndex) { return(GetBin(objectIndex) < bestBin); });
+			splitObject = static_cast<int>(middle - m_objectOrder.data());
+		}
+	}
+
+	// objects that cannot be told apart by their centers are
+	// split at the middle of the range
+	if ((splitObject <= firstObject) || (splitObject >= firstObject + objectCount))
+	{
+		splitObject = firstObject + objectCount / 2;
+	}
+
+	NODE left;
+	left.firstChild = -1;
+	left.firstObject = firstObject;
+	left.objectCount = splitObject - firstObject;
+	left.bounds = GetRangeBounds(left.firstObject, left.objectCount);
+
+	NODE right;
+	right.firstChild = -1;
+	right.firstObject = splitObject;
+	right.objectCount = firstObject + objectCount - splitObject;
+	right.bounds = GetRangeBounds(right.firstObject, right.objectCount);
+
+	int firstChild = static_cast<int>(m_nodes.size());
+	m_nodes[nodeIndex].firstChild = firstChild;
+	m_nodes.push_back(left);
+	m_nodes.push_back(right);
+
+	SplitNode(firstChild, depth + 1);
+	SplitNode(firstChild + 1, depth + 1);
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method is used for changing the box of an object
+ *  that has moved.  The nodes above it are updated by the
+ *  next refit.
+ ***********************************************************/
+void SceneBVH::UpdateObject(int objectIndex, const BOX& bounds)
+{
+	if ((objectIndex < 0) || (objectIndex >= static_cast<int>(m_objectBoxes.size())))
+	{
+		return;
+	}
+
+	m_objectBoxes[objectIndex] = bounds;
+	m_bRefitNeeded = true;
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the node boxes after
+ *  objects have moved.  The children of every node come
+ *  after it, so one pass from the last node to the first
+ *  updates each node after its children.
+ ***********************************************************/
+void SceneBVH::Refit()
+{
+	if (false == m_bRefitNeeded)
+	{
+		return;
+	}
+
+	for (int i = static_cast<int>(m_nodes.size()) - 1; i >= 0; i--)
+	{
+		NODE& node = m_nodes[i];
+		if (node.firstChild < 0)
+		{
+			node.bounds = GetRangeBounds(node.firstObject, node.objectCount);
+		}
+		else
+		{
+			node.bounds = m_nodes[node.firstChild].bounds;
+			GrowBox(node.bounds, m_nodes[node.firstChild + 1].bounds);
+		}
+	}
+
+	m_bRefitNeeded = false;
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for finding the objects whose boxes
+ *  are at least partly inside of the view frustum.
+ ***********************************************************/
+void SceneBVH::QueryFrustum(const ViewFrustum& frustum, std::vector<int>& objects) const
+{
+	if (m_nodes.size() == 0)
+	{
+		return;
+	}
+
+	int stack[g_TraversalStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[stack[--stackSize]];
+
+		ViewFrustum::FRUSTUM_TEST test = frustum.ClassifyBox(node.bounds.minimum, node.bounds.maximum);
+		if (test == ViewFrustum::TEST_OUTSIDE)
+		{
+			continue;
+		}
+
+		if ((test == ViewFrustum::TEST_INSIDE) || (node.firstChild < 0))
+		{
+			// every object of a subtree inside of the frustum is
+			// visible, and leaf objects are tested on their own
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				const BOX& box = m_objectBoxes[m_objectOrder[i]];
+				if ((test == ViewFrustum::TEST_INSIDE) ||
+					(frustum.ClassifyBox(box.minimum, box.maximum) != ViewFrustum::TEST_OUTSIDE))
+				{
+					objects.push_back(m_objectOrder[i]);
+				}
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.firstChild;
+		stack[stackSize++] = node.firstChild + 1;
+	}
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for finding the objects whose boxes
+ *  touch a sphere, such as the objects near a point.
+ ***********************************************************/
+void SceneBVH::QuerySphere(const glm::vec3& center, float radius, std::vector<int>& objects) const
+{
+	if (m_nodes.size() == 0)
+	{
+		return;
+	}
+
+	int stack[g_TraversalStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[stack[--stackSize]];
+		if (false == BoxTouchesSphere(node.bounds, center, radius))
+		{
+			continue;
+		}
+
+		if (node.firstChild < 0)
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				if (true == BoxTouchesSphere(m_objectBoxes[m_objectOrder[i]], center, radius))
+				{
+					objects.push_back(m_objectOrder[i]);
+				}
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.firstChild;
+		stack[stackSize++] = node.firstChild + 1;
+	}
+}
+
+/***********************************************************
+ *  QueryBox()
+ *
+ *  This method is used for finding the objects whose boxes
+ *  overlap the passed in box.
+ ***********************************************************/
+void SceneBVH::QueryBox(const BOX& bounds, std::vector<int>& objects) const
+{
+	if (m_nodes.size() == 0)
+	{
+		return;
+	}
+
+	int stack[g_TraversalStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[stack[--stackSize]];
+		if (false == BoxesOverlap(node.bounds, bounds))
+		{
+			continue;
+		}
+
+		if (node.firstChild < 0)
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				if (true == BoxesOverlap(m_objectBoxes[m_objectOrder[i]], bounds))
+				{
+					objects.push_back(m_objectOrder[i]);
+				}
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.firstChild;
+		stack[stackSize++] = node.firstChild + 1;
+	}
+}
+
+/***********************************************************
+ *  IntersectRay()
+ *
+ *  This method is used for finding the object whose box is
+ *  entered first by a ray.  The nearer child of every node
+ *  is visited first, so the subtrees behind the closest
+ *  hit found so far are skipped.  The distance is in units
+ *  of the ray direction.
+ ***********************************************************/
+int SceneBVH::IntersectRay(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+	int hitObject = -1;
+	float hitDistance = FLT_MAX;
+
+	if (m_nodes.size() == 0)
+	{
+		return(hitObject);
+	}
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+
+	int stack[g_TraversalStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[stack[--stackSize]];
+
+		// a closer hit may have been found since the node was pushed
+		float nodeDistance = 0.0f;
+		if (false == IntersectBox(node.bounds, origin, inverseDirection, hitDistance, nodeDistance))
+		{
+			continue;
+		}
+
+		if (node.firstChild < 0)
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				float objectDistance = 0.0f;
+				if (true == IntersectBox(m_objectBoxes[m_objectOrder[i]], origin, inverseDirection, hitDistance, objectDistance))
+				{
+					hitDistance = objectDistance;
+					hitObject = m_objectOrder[i];
+				}
+			}
+			continue;
+		}
+
+		float nearDistance = 0.0f;
+		float farDistance = 0.0f;
+		int nearChild = node.firstChild;
+		int farChild = node.firstChild + 1;
+		bool bHitNear = IntersectBox(m_nodes[nearChild].bounds, origin, inverseDirection, hitDistance, nearDistance);
+		bool bHitFar = IntersectBox(m_nodes[farChild].bounds, origin, inverseDirection, hitDistance, farDistance);
+		if ((true == bHitNear) && (true == bHitFar) && (farDistance < nearDistance))
+		{
+			std::swap(nearChild, farChild);
+		}
+
+		// the nearer child is pushed last so that it is visited first
+		if ((true == bHitNear) && (true == bHitFar))
+		{
+			stack[stackSize++] = farChild;
+			stack[stackSize++] = nearChild;
+		}
+		else if (true == bHitNear)
+		{
+			stack[stackSize++] = node.firstChild;
+		}
+		else if (true == bHitFar)
+		{
+			stack[stackSize++] = node.firstChild + 1;
+		}
+	}
+
+	if (hitObject >= 0)
+	{
+		distance = hitDistance;
+	}
+	return(hitObject);
+}
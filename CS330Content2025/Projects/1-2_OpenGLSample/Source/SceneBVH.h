@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.h
+// ==========
+// Defines the `SceneBVH` class, a bounding volume hierarchy over the boxes of
+// the scene objects, which answers the spatial queries of the scene without
+// visiting every object.
+//
+// RESPONSIBILITIES:
+// - Build the hierarchy with the surface area heuristic.
+// - Refit the node boxes after objects have moved, without rebuilding.
+// - Find the objects inside of a view frustum, a sphere or a box.
+// - Find the nearest object hit by a ray, for picking.
+//
+// NOTE: The objects are identified by their index in the list of boxes the
+// hierarchy was built from.  Refitting keeps the tree, so the queries slow
+// down if objects move far from where they were at build time - rebuild the
+// hierarchy when that happens.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ViewFrustum.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneBVH
+ *
+ *  This class contains the code for building and querying
+ *  a bounding volume hierarchy over the scene objects.
+ ***********************************************************/
+class SceneBVH
+{
+public:
+	// constructor
+	SceneBVH();
+
+	// axis-aligned box around a scene object
+	struct BOX
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+private:
+	// largest number of objects in a leaf, and the number of
+	// bins the object centers are sorted into when splitting
+	static const int MAX_LEAF_OBJECTS = 4;
+	static const int SPLIT_BIN_COUNT = 12;
+
+	// one node of the hierarchy - an interior node has its two
+	// children next to each other, a leaf has a range of objects
+	struct NODE
+	{
+		BOX bounds;
+		int firstChild;
+		int firstObject;
+		int objectCount;
+	};
+
+	// the nodes, with every parent before its children
+	std::vector<NODE> m_nodes;
+	// the object indices, ordered so each leaf has a range
+	std::vector<int> m_objectOrder;
+	// the boxes of the objects by object index
+	std::vector<BOX> m_objectBoxes;
+	// true when object boxes changed since the last refit
+	bool m_bRefitNeeded;
+
+	// split the objects of a node, or keep it as a leaf
+	void SplitNode(int nodeIndex, int depth);
+	// box around the objects in a range of the object order
+	BOX GetRangeBounds(int firstObject, int objectCount) const;
+
+public:
+	// build the hierarchy over the passed in object boxes
+	void Build(const std::vector<BOX>& objectBoxes);
+	// remove every object
+	void Clear();
+	// number of objects the hierarchy was built over
+	size_t GetObjectCount() const;
+
+	// change the box of a moved object - the node boxes are
+	// updated by the next call to Refit()
+	void UpdateObject(int objectIndex, const BOX& bounds);
+	void Refit();
+
+	// methods for finding the objects that touch a volume,
+	// which are appended to the passed in list
+	void QueryFrustum(const ViewFrustum& frustum, std::vector<int>& objects) const;
+	void QuerySphere(const glm::vec3& center, float radius, std::vector<int>& objects) const;
+	void QueryBox(const BOX& bounds, std::vector<int>& objects) const;
+	// find the object whose box is hit first by the ray, or -1
+	int IntersectRay(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+};
@@ -0,0 +1,342 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ==============
+// This file contains the implementation of the `SceneGraph` class, which
+// keeps the transforms of the scene nodes and their cached world matrices.
+//
+// RESPONSIBILITIES:
+// - Add nodes below their parents and keep the arrays breadth-first.
+// - Build the local matrices of the changed nodes in one batched call.
+// - Pass the changes down to the descendants in one flat pass.
+//
+// NOTE: A node whose world matrix was calculated in the current pass is
+// flagged, so its children see the change when the pass reaches them, since
+// every parent comes before its children in the arrays.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+#include "TransformBuilder.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+	m_firstChangedSlot = 0;
+	m_bReorderNeeded = false;
+	m_updatedNodeCount = 0;
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node with the passed in
+ *  local transform below a parent node.  The new node is
+ *  appended to the arrays, and the arrays are put back into
+ *  breadth-first order by the next update when the node is
+ *  less deep than the last one.
+ ***********************************************************/
+int SceneGraph::AddNode(
+	int parentNode,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	int node = static_cast<int>(m_nodeSlots.size());
+	int slot = static_cast<int>(m_slotNodes.size());
+	int parentSlot = -1;
+	int depth = 0;
+
+	if (parentNode >= 0)
+	{
+		parentSlot = m_nodeSlots[parentNode];
+		depth = m_depths[parentSlot] + 1;
+	}
+	if ((m_depths.size() > 0) && (depth < m_depths.back()))
+	{
+		m_bReorderNeeded = true;
+	}
+
+	m_parentSlots.push_back(parentSlot);
+	m_depths.push_back(depth);
+	m_scales.push_back(scaleXYZ);
+	m_rotations.push_back(glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees));
+	m_positions.push_back(positionXYZ);
+	m_localMatrices.push_back(glm::mat4(1.0f));
+	m_worldMatrices.push_back(glm::mat4(1.0f));
+	m_changeFlags.push_back(0);
+	m_nodeSlots.push_back(slot);
+	m_slotNodes.push_back(node);
+
+	MarkChanged(slot);
+
+	return(node);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the nodes.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_parentSlots.clear();
+	m_depths.clear();
+	m_scales.clear();
+	m_rotations.clear();
+	m_positions.clear();
+	m_localMatrices.clear();
+	m_worldMatrices.clear();
+	m_changeFlags.clear();
+	m_nodeSlots.clear();
+	m_slotNodes.clear();
+	m_firstChangedSlot = 0;
+	m_bReorderNeeded = false;
+	m_updatedNodeCount = 0;
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method returns the number of nodes in the hierarchy.
+ ***********************************************************/
+size_t SceneGraph::GetNodeCount() const
+{
+	return(m_nodeSlots.size());
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for changing the scale, rotation and
+ *  position of a node relative to its parent.  Nothing is
+ *  marked when the values are the same as before.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(
+	int node,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	int slot = m_nodeSlots[node];
+	glm::vec3 rotationDegrees(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+
+	if ((m_scales[slot] != scaleXYZ) ||
+		(m_rotations[slot] != rotationDegrees) ||
+		(m_positions[slot] != positionXYZ))
+	{
+		m_scales[slot] = scaleXYZ;
+		m_rotations[slot] = rotationDegrees;
+		m_positions[slot] = positionXYZ;
+		MarkChanged(slot);
+	}
+}
+
+/***********************************************************
+ *  SetLocalPosition()
+ *
+ *  This method is used for moving a node relative to its
+ *  parent, keeping its scale and rotation.
+ ***********************************************************/
+void SceneGraph::SetLocalPosition(int node, glm::vec3 positionXYZ)
+{
+	int slot = m_nodeSlots[node];
+
+	if (m_positions[slot] != positionXYZ)
+	{
+		m_positions[slot] = positionXYZ;
+		MarkChanged(slot);
+	}
+}
+
+/***********************************************************
+ *  MarkChanged()
+ *
+ *  This method is used for flagging the local transform of
+ *  the node in a slot as changed, and for moving the start
+ *  of the next update pass back to it.
+ ***********************************************************/
+void SceneGraph::MarkChanged(int slot)
+{
+	m_changeFlags[slot] |= LOCAL_CHANGED;
+	m_firstChangedSlot = std::min(m_firstChangedSlot, static_cast<size_t>(slot));
+}
+
+/***********************************************************
+ *  ReorderNodes()
+ *
+ *  This method is used for sorting the node arrays by the
+ *  depth of the nodes, keeping the order in which nodes of
+ *  the same depth were added, so that every parent comes
+ *  before its children again.
+ ***********************************************************/
+void SceneGraph::ReorderNodes()
+{
+	size_t slotCount = m_slotNodes.size();
+
+	std::vector<int> order(slotCount);
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		order[i] = static_cast<int>(i);
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[this](int a, int b) { return(m_depths[a] < m_depths[b]); });
+
+	std::vector<int> newSlots(slotCount);
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		newSlots[order[i]] = static_cast<int>(i);
+	}
+
+	std::vector<int> parentSlots(slotCount);
+	std::vector<int> depths(slotCount);
+	std::vector<glm::vec3> scales(slotCount);
+	std::vector<glm::vec3> rotations(slotCount);
+	std::vector<glm::vec3> positions(slotCount);
+	std::vector<glm::mat4> localMatrices(slotCount);
+	std::vector<glm::mat4> worldMatrices(slotCount);
+	std::vector<unsigned char> changeFlags(slotCount);
+	std::vector<int> slotNodes(slotCount);
+	for (size_t i = 0; i < slotCount; i++)
+	{
+		int oldSlot = order[i];
+		int oldParent = m_parentSlots[oldSlot];
+
+		parentSlots[i] = (oldParent >= 0) ? newSlots[oldParent] : -1;
+		depths[i] = m_depths[oldSlot];
+		scales[i] = m_scales[oldSlot];
+		rotations[i] = m_rotations[oldSlot];
+		positions[i] = m_positions[oldSlot];
+		localMatrices[i] = m_localMatrices[oldSlot];
+		worldMatrices[i] = m_worldMatrices[oldSlot];
+		changeFlags[i] = m_changeFlags[oldSlot];
+		slotNodes[i] = m_slotNodes[oldSlot];
+		m_nodeSlots[slotNodes[i]] = static_cast<int>(i);
+	}
+
+	m_parentSlots.swap(parentSlots);
+	m_depths.swap(depths);
+	m_scales.swap(scales);
+	m_rotations.swap(rotations);
+	m_positions.swap(positions);
+	m_localMatrices.swap(localMatrices);
+	m_worldMatrices.swap(worldMatrices);
+	m_changeFlags.swap(changeFlags);
+	m_slotNodes.swap(slotNodes);
+
+	// the changed nodes may have moved anywhere
+	m_firstChangedSlot = 0;
+	m_bReorderNeeded = false;
+}
+
+/***********************************************************
+ *  UpdateWorldMatrices()
+ *
+ *  This method is used for calculating the world matrices
+ *  of the nodes that changed, and of all the nodes below
+ *  them.  The passes start at the first changed slot, since
+ *  no node before it or any of its parents has changed.
+ ***********************************************************/
+void SceneGraph::UpdateWorldMatrices()
+{
+	if (true == m_bReorderNeeded)
+	{
+		ReorderNodes();
+	}
+
+	size_t slotCount = m_slotNodes.size();
+	m_updatedNodeCount = 0;
+
+	// the local matrices of the changed nodes are built
+	// together, so that many moving nodes use the batched path
+	m_composeSlots.clear();
+	m_composeScales.clear();
+	m_composeRotations.clear();
+	m_composePositions.clear();
+	for (size_t slot = m_firstChangedSlot; slot < slotCount; slot++)
+	{
+		if (0 != (m_changeFlags[slot] & LOCAL_CHANGED))
+		{
+			m_composeSlots.push_back(static_cast<int>(slot));
+			m_composeScales.push_back(m_scales[slot]);
+			m_composeRotations.push_back(m_rotations[slot]);
+			m_composePositions.push_back(m_positions[slot]);
+		}
+	}
+	if (m_composeSlots.size() > 0)
+	{
+		m_composeMatrices.resize(m_composeSlots.size());
+		TransformBuilder::ComposeTransforms(
+			m_composeScales.data(),
+			m_composeRotations.data(),
+			m_composePositions.data(),
+			m_composeMatrices.data(),
+			m_composeSlots.size());
+		for (size_t i = 0; i < m_composeSlots.size(); i++)
+		{
+			m_localMatrices[m_composeSlots[i]] = m_composeMatrices[i];
+		}
+	}
+
+	for (size_t slot = m_firstChangedSlot; slot < slotCount; slot++)
+	{
+		int parentSlot = m_parentSlots[slot];
+		bool bParentChanged =
+			(parentSlot >= 0) && (0 != (m_changeFlags[parentSlot] & WORLD_CHANGED));
+
+		if ((0 == m_changeFlags[slot]) && (false == bParentChanged))
+		{
+			continue;
+		}
+
+		if (parentSlot >= 0)
+		{
+			m_worldMatrices[slot] = m_worldMatrices[parentSlot] * m_localMatrices[slot];
+		}
+		else
+		{
+			m_worldMatrices[slot] = m_localMatrices[slot];
+		}
+		m_changeFlags[slot] = WORLD_CHANGED;
+		m_updatedNodeCount++;
+	}
+
+	// the flags are only set from the first changed slot on
+	for (size_t slot = m_firstChangedSlot; slot < slotCount; slot++)
+	{
+		m_changeFlags[slot] = 0;
+	}
+	m_firstChangedSlot = slotCount;
+}
+
+/***********************************************************
+ *  GetWorldMatrix()
+ *
+ *  This method returns the world matrix of a node, as it
+ *  was calculated by the last update.
+ ***********************************************************/
+const glm::mat4& SceneGraph::GetWorldMatrix(int node) const
+{
+	return(m_worldMatrices[m_nodeSlots[node]]);
+}
+
+/***********************************************************
+ *  GetUpdatedNodeCount()
+ *
+ *  This method returns the number of world matrices that
+ *  were calculated by the last update, which is zero when
+ *  nothing in the scene has moved.
+ ***********************************************************/
+unsigned int SceneGraph::GetUpdatedNodeCount() const
+{
+	return(m_updatedNodeCount);
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// Defines the `SceneGraph` class, a retained hierarchy of transform nodes that
+// keeps the world matrix of every node, so that the model matrices of the
+// scene objects are only calculated again when something has moved.
+//
+// RESPONSIBILITIES:
+// - Keep the parent, the local scale, rotation and position, and the world
+//   matrix of every node.
+// - Mark the nodes whose local transform changed.
+// - Update the world matrices of the changed nodes and of their descendants
+//   in a single pass over the nodes.
+//
+// NOTE: The node values are kept in separate arrays, ordered breadth-first so
+// that every parent comes before its children.  The update pass walks the
+// arrays from the first changed node to the end and does nothing at all
+// when no node has changed.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class contains the code for keeping the transforms
+ *  of the scene nodes and propagating their changes.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	// constructor
+	SceneGraph();
+
+private:
+	// flags for the nodes that changed since the last update
+	static const unsigned char LOCAL_CHANGED = 0x01;
+	static const unsigned char WORLD_CHANGED = 0x02;
+
+	// the node values by slot, ordered breadth-first - the
+	// slot of the parent is -1 for a root node
+	std::vector<int> m_parentSlots;
+	std::vector<int> m_depths;
+	std::vector<glm::vec3> m_scales;
+	std::vector<glm::vec3> m_rotations;
+	std::vector<glm::vec3> m_positions;
+	std::vector<glm::mat4> m_localMatrices;
+	std::vector<glm::mat4> m_worldMatrices;
+	std::vector<unsigned char> m_changeFlags;
+	// the slot of each node, and the node in each slot
+	std::vector<int> m_nodeSlots;
+	std::vector<int> m_slotNodes;
+	// first slot that changed since the last update
+	size_t m_firstChangedSlot;
+	// true when added nodes broke the breadth-first order
+	bool m_bReorderNeeded;
+	// number of world matrices calculated by the last update
+	unsigned int m_updatedNodeCount;
+	// the transform values and local matrices of the changed
+	// nodes, gathered for building the matrices together
+	std::vector<int> m_composeSlots;
+	std::vector<glm::vec3> m_composeScales;
+	std::vector<glm::vec3> m_composeRotations;
+	std::vector<glm::vec3> m_composePositions;
+	std::vector<glm::mat4> m_composeMatrices;
+
+	// move the nodes back into breadth-first order
+	void ReorderNodes();
+	// mark the node in a slot as changed
+	void MarkChanged(int slot);
+
+public:
+	// add a node below the parent node, or a root node for a
+	// parent of -1, and return the number of the new node
+	int AddNode(
+		int parentNode,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// remove every node
+	void Clear();
+	// number of nodes in the hierarchy
+	size_t GetNodeCount() const;
+
+	// change the local transform of a node - the world matrices
+	// are calculated by the next call to UpdateWorldMatrices()
+	void SetLocalTransform(
+		int node,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	void SetLocalPosition(int node, glm::vec3 positionXYZ);
+
+	// calculate the world matrices of the changed nodes
+	void UpdateWorldMatrices();
+	// world matrix of a node as of the last update
+	const glm::mat4& GetWorldMatrix(int node) const;
+	// number of world matrices calculated by the last update
+	unsigned int GetUpdatedNodeCount() const;
+};
@@ -24,6 +24,10 @@
 
 
 #include "SceneManager.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
+#include "ZoneProfiler.h"
+#include "TextureCache.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -33,14 +37,41 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+
 // declaration of global variables and defines
 namespace
 {
 	const char* g_ModelName = "model";
 	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UseInstancingName = "bUseInstancing";
+	const char* g_UseBatchingName = "bUseBatching";
+	const char* g_ObjectBlockName = "ObjectBlock";
+
+	// groups of object uniforms that are written together
+	const unsigned int g_ModelUniforms = 0x01;
+	const unsigned int g_ColorUniforms = 0x02;
+	const unsigned int g_TextureUniforms = 0x04;
+	const unsigned int g_UVScaleUniforms = 0x08;
+	const unsigned int g_MaterialUniforms = 0x10;
+	const unsigned int g_AllUniforms = 0x1F;
+
+	// most texture images uploaded in one frame while the
+	// textures are loaded in the background
+	const size_t g_TextureUploadsPerFrame = 2;
+
+	// the image files of the scene textures, and their tags
+	const char* g_SceneTextures[][2] = {
+		{ "textures/rusticwood.jpg", "table" },
+		{ "textures/cheese_wheel.jpg", "cheese_wheel_side" },
+		{ "textures/cheese_top.jpg", "cheese_wheel_top" },
+		{ "textures/breadcrust.jpg", "breadcrust" },
+		{ "textures/backdrop.jpg", "backdrop" },
+		{ "textures/knife_handle.jpg", "knifehandle" },
+		{ "textures/stainless.jpg", "stainless" },
+		{ "textures/cheddar.jpg", "cheddar" },
+		{ "textures/circular-brushed-gold-texture.jpg", "knifescrew" } };
 }
 
 /***********************************************************
@@ -53,14 +84,62 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 	m_pShaderManager = pShaderManager;
 	// create the shape meshes object
 	m_basicMeshes = new ShapeMeshes();
+	m_pGPUProfiler = NULL;
 
 	// initialize the texture collection
-	for (int i = 0; i < 16; i++)
+	m_loadedTextures = 0;
+	m_bAsyncTextureLoading = true;
+	m_pTextureLoader = NULL;
+	m_bCompressTextures = false;
+	m_bTextureArrays = true;
+	m_pTextureArray = NULL;
+
+	// initialize the batched drawing state - the object values
+	// match the defaults of the shader uniforms
+	m_bBatchedRendering = true;
+	m_bBatchingSupported = false;
+	m_bRecordingDraws = false;
+	m_currentObject = {};
+	m_currentObject.model = glm::mat4(1.0f);
+	m_currentObject.color = glm::vec4(1.0f);
+	m_currentObject.UVscale = glm::vec2(1.0f, 1.0f);
+	m_currentObject.textureRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	m_currentTextureSlot = 0;
+	m_currentMaterial = -1;
+	m_bObjectChanged = true;
+	m_changedUniforms = 0;
+	m_drawDepth = 0.0f;
+	m_objectBuffer = 0;
+
+	// the shader variants are defined with the lights
+	m_shaderVariants[0] = -1;
+	m_shaderVariants[1] = -1;
+	m_bShaderInstancing = false;
+	m_bShaderBatching = false;
+
+	// initialize the culling state
+	m_bObjectCounted = false;
+	m_drawnObjectCount = 0;
+	m_culledObjectCount = 0;
+	m_frameNumber = 0;
+	m_nextSceneObject = 0;
+
+	// resolve the per-draw uniforms once so that rendering
+	// never has to look them up by name
+	if (NULL != m_pShaderManager)
 	{
-		m_textureIDs[i].tag = "/0";
-		m_textureIDs[i].ID = -1;
+		m_uniforms.model = m_pShaderManager->getUniformHandle(g_ModelName);
+		m_uniforms.objectColor = m_pShaderManager->getUniformHandle(g_ColorValueName);
+		m_uniforms.objectTexture = m_pShaderManager->getUniformHandle(g_TextureValueName);
+		m_uniforms.useInstancing = m_pShaderManager->getUniformHandle(g_UseInstancingName);
+		m_uniforms.useBatching = m_pShaderManager->getUniformHandle(g_UseBatchingName);
+		m_uniforms.UVscale = m_pShaderManager->getUniformHandle("UVscale");
+		m_uniforms.textureLayer = m_pShaderManager->getUniformHandle("textureLayer");
+		m_uniforms.textureRect = m_pShaderManager->getUniformHandle("textureRect");
+		m_uniforms.diffuseColor = m_pShaderManager->getUniformHandle("material.diffuseColor");
+		m_uniforms.specularColor = m_pShaderManager->getUniformHandle("material.specularColor");
+		m_uniforms.shininess = m_pShaderManager->getUniformHandle("material.shininess");
 	}
-	m_loadedTextures = 0;
 }
 
 /***********************************************************
@@ -78,8 +157,22 @@ SceneManager::~SceneManager()
 		m_basicMeshes = NULL;
 	}
 
+	// stop loading the textures before they are freed
+	if (NULL != m_pTextureLoader)
+	{
+		delete m_pTextureLoader;
+		m_pTextureLoader = NULL;
+	}
+
 	// free the allocated OpenGL textures
 	DestroyGLTextures();
+
+	// free the object data storage buffer
+	if (0 != m_objectBuffer)
+	{
+		glDeleteBuffers(1, &m_objectBuffer);
+		m_objectBuffer = 0;
+	}
 }
 
 /***********************************************************
@@ -87,34 +180,47 @@ SceneManager::~SceneManager()
  *
  *  This method is used for loading textures from image files,
  *  configuring the texture mapping parameters in OpenGL, 
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  uploading the mipmaps from the texture cache, and loading the read texture into
+ *  the next available texture slot in memory.  When the
+ *  textures are loaded in the background, the texture gets
+ *  a placeholder image and the file is only queued here.
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
+	PROFILE_ZONE("SceneManager::CreateGLTexture");
 
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
+	// a tag names one texture, and its texture unit is the handle
+	// of the tag, so a second image with the same tag is refused
+	if (m_textureTags.Find(tag) >= 0)
+	{
+		std::cout << "Could not load image:" << filename << ", the tag " << tag << " is already used" << std::endl;
+		return false;
+	}
 
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename, 
-		&width, 
-		&height, 
-		&colorChannels, 
-		0);
+	if (NULL != m_pTextureLoader)
+	{
+		return(CreatePlaceholderTexture(filename, tag));
+	}
+
+	GLuint textureID = 0;
+
+	// load the image with its mipmap levels from the texture cache,
+	// which only decodes the image file when it has changed
+	CachedTexture image;
 
 	// if the image was successfully read from the image file
-	if (image)
+	if (true == image.Load(filename, m_bCompressTextures))
 	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
+		std::cout << "Successfully loaded image:" << filename << ", width:" << image.GetWidth() << ", height:" << image.GetHeight() << ", channels:" << image.GetColorChannels()
+			<< ((true == image.IsFromCache()) ? ", from the texture cache" : "");
+		if (true == image.IsCompressed())
+		{
+			std::cout << ", " << image.GetFormatName() << ", PSNR:" << image.GetPSNR() << " dB";
+		}
+		std::cout << std::endl;
 
 		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		GLStateCache::BindTexture(0, GL_TEXTURE_2D, textureID);
 
 		// set the texture wrapping parameters
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -123,29 +229,18 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// upload every mipmap level straight from the cache file
+		image.Upload(false);
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+		GLStateCache::BindTexture(0, GL_TEXTURE_2D, 0); // Unbind the texture
 
 		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+		TEXTURE_INFO texture;
+		texture.ID = textureID;
+		texture.tag = tag;
+		texture.layer = 0;
+		texture.rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		RegisterTexture(texture);
 
 		return true;
 	}
@@ -156,6 +251,204 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	return false;
 }
 
+/***********************************************************
+ *  CreatePlaceholderTexture()
+ *
+ *  This method is used for creating a texture with a single
+ *  grey texel in the next available texture slot, and for
+ *  queueing the image file to be loaded into it.  The
+ *  texture can be drawn with until the image arrives.
+ ***********************************************************/
+bool SceneManager::CreatePlaceholderTexture(const char* filename, std::string tag)
+{
+	if (m_loadedTextures >= 16)
+	{
+		std::cout << "Could not load image:" << filename << ", all texture slots are used" << std::endl;
+		return false;
+	}
+
+	const unsigned char placeholderTexel[4] = { 128, 128, 128, 255 };
+	GLuint textureID = 0;
+	int textureSlot = m_loadedTextures;
+
+	glGenTextures(1, &textureID);
+	GLStateCache::BindTexture(textureSlot, GL_TEXTURE_2D, textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholderTexel);
+
+	// register the texture and associate it with the special tag string
+	TEXTURE_INFO texture;
+	texture.ID = textureID;
+	texture.tag = tag;
+	texture.layer = 0;
+	texture.rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	RegisterTexture(texture);
+
+	m_pTextureLoader->Request(filename, textureID, textureSlot, m_bCompressTextures);
+
+	return true;
+}
+
+/***********************************************************
+ *  CreateTextureArray()
+ *
+ *  This method is used for packing all of the scene images
+ *  into the layers of one array texture in texture unit 0,
+ *  and for registering each image with its layer and its
+ *  rectangle of the layer.  The images are loaded in the
+ *  background when the loader is running, and the layers
+ *  are grey until they arrive.
+ ***********************************************************/
+bool SceneManager::CreateTextureArray()
+{
+	PROFILE_ZONE("SceneManager::CreateTextureArray");
+
+	// only the sizes of the images are read to lay out the array
+	m_pTextureArray = new TextureArray();
+	std::vector<int> arrayEntries;
+	for (const auto& sceneTexture : g_SceneTextures)
+	{
+		int arrayEntry = m_pTextureArray->AddImage(sceneTexture[0]);
+		if (arrayEntry < 0)
+		{
+			std::cout << "Could not load image:" << sceneTexture[0] << std::endl;
+		}
+		arrayEntries.push_back(arrayEntry);
+	}
+
+	if (false == m_pTextureArray->Create(0, m_bCompressTextures))
+	{
+		delete m_pTextureArray;
+		m_pTextureArray = NULL;
+		return false;
+	}
+
+	// the images are compressed like the array, which is only
+	// compressed when every image is opaque
+	bool bCompress = m_pTextureArray->IsCompressed();
+	for (size_t i = 0; i < arrayEntries.size(); i++)
+	{
+		if (arrayEntries[i] < 0)
+		{
+			continue;
+		}
+
+		const char* filename = g_SceneTextures[i][0];
+		const TextureArray::ARRAY_ENTRY& arrayEntry = m_pTextureArray->GetEntry(arrayEntries[i]);
+
+		// register the image and associate it with the special tag string
+		TEXTURE_INFO texture;
+		texture.ID = m_pTextureArray->GetTextureID();
+		texture.tag = g_SceneTextures[i][1];
+		texture.layer = arrayEntry.layer;
+		texture.rect = arrayEntry.rect;
+		if (RegisterTexture(texture) < 0)
+		{
+			continue;
+		}
+
+		if (NULL != m_pTextureLoader)
+		{
+			m_pTextureLoader->RequestArrayImage(filename, m_pTextureArray, arrayEntries[i], bCompress);
+			continue;
+		}
+
+		CachedTexture image;
+		if (true == image.Load(filename, bCompress))
+		{
+			std::cout << "Successfully loaded image:" << filename << ", width:" << image.GetWidth() << ", height:" << image.GetHeight()
+				<< ", layer:" << arrayEntry.layer << ((true == image.IsFromCache()) ? ", from the texture cache" : "") << std::endl;
+			m_pTextureArray->UploadImage(arrayEntries[i], image, false);
+		}
+		else
+		{
+			std::cout << "Could not load image:" << filename << std::endl;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  SetAsyncTextureLoading()
+ *
+ *  This method is used for choosing whether the textures
+ *  are loaded in the background, which is the default, or
+ *  one after the other before the scene is drawn.  It has
+ *  to be called before the scene is prepared.
+ ***********************************************************/
+void SceneManager::SetAsyncTextureLoading(bool bAsync)
+{
+	m_bAsyncTextureLoading = bAsync;
+}
+
+/***********************************************************
+ *  SetTextureCompression()
+ *
+ *  This method is used for choosing whether the textures
+ *  are compressed into BC1 or BC3 blocks, which take a
+ *  quarter to an eighth of the memory.  It has to be called
+ *  before the scene is prepared.
+ ***********************************************************/
+void SceneManager::SetTextureCompression(bool bCompress)
+{
+	m_bCompressTextures = bCompress;
+}
+
+/***********************************************************
+ *  SetTextureArrays()
+ *
+ *  This method is used for choosing whether the textures
+ *  are packed into one texture array, which is the default,
+ *  so that the batched draws are not split by texture, or
+ *  kept in a texture for every image.  It has to be called
+ *  before the scene is prepared.
+ ***********************************************************/
+void SceneManager::SetTextureArrays(bool bTextureArrays)
+{
+	m_bTextureArrays = bTextureArrays;
+}
+
+/***********************************************************
+ *  FinishTextureLoading()
+ *
+ *  This method is used for waiting until all of the
+ *  textures that are loaded in the background are ready.
+ ***********************************************************/
+void SceneManager::FinishTextureLoading()
+{
+	if (NULL != m_pTextureLoader)
+	{
+		m_pTextureLoader->Finish();
+		delete m_pTextureLoader;
+		m_pTextureLoader = NULL;
+	}
+}
+
+/***********************************************************
+ *  UpdateTextureLoading()
+ *
+ *  This method is used for uploading a few of the texture
+ *  images that have been loaded in the background since the
+ *  last frame.  The loader threads are stopped once all of
+ *  the textures are ready.
+ ***********************************************************/
+void SceneManager::UpdateTextureLoading()
+{
+	if ((NULL != m_pTextureLoader) && (true == m_pTextureLoader->Update(g_TextureUploadsPerFrame)))
+	{
+		delete m_pTextureLoader;
+		m_pTextureLoader = NULL;
+	}
+}
+
 /***********************************************************
  *  BindGLTextures()
  *
@@ -164,11 +457,17 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
+	if (NULL != m_pTextureArray)
+	{
+		// every image is in the layers of the array texture
+		GLStateCache::BindTexture(m_pTextureArray->GetTextureUnit(), GL_TEXTURE_2D_ARRAY, m_pTextureArray->GetTextureID());
+		return;
+	}
+
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
 		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		GLStateCache::BindTexture(i, GL_TEXTURE_2D, m_textureIDs[i].ID);
 	}
 }
 
@@ -180,133 +479,133 @@ void SceneManager::BindGLTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	if (NULL != m_pTextureArray)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		// the registered images are layers of the array texture,
+		// which is deleted with the array
+		delete m_pTextureArray;
+		m_pTextureArray = NULL;
+	}
+	else
+	{
+		for (int i = 0; i < m_loadedTextures; i++)
+		{
+			glDeleteTextures(1, &m_textureIDs[i].ID);
+		}
 	}
+
+	m_textureIDs.clear();
+	m_textureTags.Clear();
+	m_loadedTextures = 0;
 }
 
 /***********************************************************
- *  FindTextureID()
+ *  RegisterTexture()
  *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for adding a loaded texture under
+ *  its tag.  The handle of the tag is the index of the
+ *  texture and its texture unit.  A tag that was registered
+ *  before is refused with a handle of -1, since the texture
+ *  unit of its handle already holds the earlier texture.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::RegisterTexture(const TEXTURE_INFO& texture)
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (m_textureTags.Find(texture.tag) >= 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		std::cout << "Could not register texture, the tag " << texture.tag << " is already used" << std::endl;
+		return(-1);
 	}
-	
-	return(textureID);
+
+	int textureHandle = m_textureTags.Register(texture.tag);
+	m_textureIDs.push_back(texture);
+	m_loadedTextures = static_cast<int>(m_textureIDs.size());
+
+	return(textureHandle);
 }
 
 /***********************************************************
- *  FindTextureSlot()
+ *  RegisterMaterial()
  *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for adding a defined material under
+ *  its tag.  The handle of the tag is the index of the
+ *  material, and a material with a tag that was registered
+ *  before takes the place of the earlier one.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::RegisterMaterial(const OBJECT_MATERIAL& material)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	int materialHandle = m_materialTags.Register(material.tag);
+	if (materialHandle == static_cast<int>(m_objectMaterials.size()))
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
+		m_objectMaterials.push_back(material);
+	}
+	else
+	{
+		m_objectMaterials[materialHandle] = material;
 	}
 
-	return(textureSlot);
+	return(materialHandle);
 }
 
 /***********************************************************
- *  FindMaterial()
+ *  FindTextureID()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for getting an ID for the previously
+ *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL &material)
+int SceneManager::FindTextureID(const std::string& tag) const
 {
-	if (m_objectMaterials.size() == 0)
+	int textureHandle = m_textureTags.Find(tag);
+	if (textureHandle < 0)
 	{
-		return(false);
+		return(-1);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
-	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
-	}
+	return(static_cast<int>(m_textureIDs[textureHandle].ID));
+}
 
-	return(true);
+/***********************************************************
+ *  FindTextureSlot()
+ *
+ *  This method is used for getting the handle of the
+ *  previously loaded texture associated with the passed in
+ *  tag, which is also its texture slot when every texture
+ *  has its own, or -1 when there is none.
+ ***********************************************************/
+int SceneManager::FindTextureSlot(const std::string& tag) const
+{
+	return(m_textureTags.Find(tag));
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the handle of a material
+ *  in the previously defined materials list that is
+ *  associated with the passed in tag, or -1 when there is
+ *  none.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(const std::string& tag) const
+{
+	return(m_materialTags.Find(tag));
 }
 
 /***********************************************************
  *  SetTransformations()
  *
  *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  from the world matrix of the passed in scene node.  The
+ *  matrix was calculated by the scene graph update, so
+ *  nothing is calculated here.
  ***********************************************************/
 void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+	int sceneNode)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+	m_currentObject.model = m_sceneGraph.GetWorldMatrix(sceneNode);
+	m_bObjectChanged = true;
+	m_bObjectCounted = false;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+	// the uniform is written once the object is known to be visible
+	m_changedUniforms |= g_ModelUniforms;
 }
 
 /***********************************************************
@@ -329,30 +628,35 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+	m_currentObject.color = currentColor;
+	m_currentObject.bUseTexture = false;
+	m_bObjectChanged = true;
+	m_changedUniforms |= g_ColorUniforms;
 }
 
 /***********************************************************
  *  SetShaderTexture()
  *
  *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  associated with the passed in handle into the shader.
+ *  A handle of -1, for a texture that was not loaded,
+ *  leaves the object without a texture slot.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	int textureHandle)
 {
-	if (NULL != m_pShaderManager)
+	m_currentObject.bUseTexture = true;
+	m_currentTextureSlot = ((textureHandle >= 0) && (textureHandle < m_loadedTextures)) ? textureHandle : -1;
+	if ((NULL != m_pTextureArray) && (m_currentTextureSlot >= 0))
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		// the images share the array, and differ by their
+		// layer and rectangle
+		m_currentObject.textureLayer = m_textureIDs[m_currentTextureSlot].layer;
+		m_currentObject.textureRect = m_textureIDs[m_currentTextureSlot].rect;
+		m_currentTextureSlot = static_cast<int>(m_pTextureArray->GetTextureUnit());
 	}
+	m_bObjectChanged = true;
+	m_changedUniforms |= g_TextureUniforms;
 }
 
 /***********************************************************
@@ -363,34 +667,802 @@ void SceneManager::SetShaderTexture(
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	m_currentObject.UVscale = glm::vec2(u, v);
+	m_bObjectChanged = true;
+	m_changedUniforms |= g_UVScaleUniforms;
 }
 
 /***********************************************************
  *  SetShaderMaterial()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for passing the values of the
+ *  material with the passed in handle into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	int materialHandle)
 {
-	if (m_objectMaterials.size() > 0)
+	if ((materialHandle >= 0) && (materialHandle < static_cast<int>(m_objectMaterials.size())))
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		const OBJECT_MATERIAL& material = m_objectMaterials[materialHandle];
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+		m_currentObject.diffuseColor = glm::vec4(material.diffuseColor, material.shininess);
+		m_currentObject.specularColor = glm::vec4(material.specularColor, 0.0f);
+		m_currentMaterial = materialHandle;
+		m_bObjectChanged = true;
+		m_changedUniforms |= g_MaterialUniforms;
+	}
+}
+
+/***********************************************************
+ *  SetShaderInstancing()
+ *
+ *  This method is used for telling the shader whether the
+ *  next draw command takes the model matrix from the model
+ *  uniform or from the per-instance data.  Recorded draws
+ *  set the uniform when they are submitted.
+ ***********************************************************/
+void SceneManager::SetShaderInstancing(
+	bool bUseInstancing)
+{
+	if ((NULL != m_pShaderManager) && (false == m_bRecordingDraws))
+	{
+		m_bShaderInstancing = bUseInstancing;
+		m_pShaderManager->setBoolValue(m_uniforms.useInstancing, bUseInstancing);
+	}
+}
+
+/***********************************************************
+ *  RecordDraw()
+ *
+ *  This method is called by the shape meshes object in
+ *  place of a draw of the packed meshes.  The draw command
+ *  is recorded as a packet together with the current object
+ *  values, and with the model and color of every instance
+ *  for the instanced drawing methods.  The packet is queued
+ *  with a key made from its state and its depth.
+ ***********************************************************/
+void SceneManager::RecordDraw(
+	const ShapeMeshes::DRAW_COMMAND& command,
+	const glm::mat4* models,
+	const glm::vec4* colors)
+{
+	bool bUseTexture = (m_currentObject.bUseTexture != 0);
+	bool bTranslucent = (false == bUseTexture) && (m_currentObject.color.a < 1.0f);
+
+	DRAW_PACKET packet;
+	packet.command = command;
+	packet.textureSlot = m_currentTextureSlot;
+	packet.bInstanced = (NULL != models);
+	packet.firstInstance = m_instanceModels.size();
+	if (NULL != models)
+	{
+		for (GLuint i = 0; i < command.instanceCount; i++)
+		{
+			glm::vec4 instanceColor = (NULL != colors) ? colors[i] : glm::vec4(1.0f);
+			m_instanceModels.push_back(models[i]);
+			m_instanceColors.push_back(instanceColor);
+			if ((false == bUseTexture) && (instanceColor.a < 1.0f))
+			{
+				bTranslucent = true;
+			}
+		}
+	}
+
+	// consecutive draws of the same object share its values
+	if ((true == m_bObjectChanged) || (m_packetObjects.size() == 0))
+	{
+		m_packetObjects.push_back(m_currentObject);
+		m_bObjectChanged = false;
+	}
+	packet.objectIndex = m_packetObjects.size() - 1;
+
+	// the meshes are numbered in the order they are first drawn
+	auto meshID = m_meshSortIDs.find(command.firstIndex);
+	if (meshID == m_meshSortIDs.end())
+	{
+		unsigned int sortID = static_cast<unsigned int>(m_meshSortIDs.size());
+		meshID = m_meshSortIDs.insert(std::make_pair(command.firstIndex, sortID)).first;
+	}
+
+	// the draws are grouped by the shader variant they need
+	RenderQueue::SORT_FIELDS fields;
+	fields.pass = 0;
+	fields.bTranslucent = bTranslucent;
+	fields.program = (true == bUseTexture) ? 1 : 0;
+	fields.mesh = meshID->second;
+	fields.texture = (true == bUseTexture) ? static_cast<unsigned int>(m_currentTextureSlot + 1) : 0;
+	fields.material = static_cast<unsigned int>(m_currentMaterial + 1);
+	fields.depth = m_drawDepth;
+
+	m_renderQueue.AddPacket(RenderQueue::MakeSortKey(fields), static_cast<uint32_t>(m_drawPackets.size()));
+	m_drawPackets.push_back(packet);
+}
+
+/***********************************************************
+ *  FlushDraws()
+ *
+ *  This method is used for submitting the recorded draws in
+ *  the order of their sort keys.  The uniforms are refreshed
+ *  afterwards for any draw that is issued directly.
+ ***********************************************************/
+void SceneManager::FlushDraws()
+{
+	if ((m_drawPackets.size() > 0) && (NULL != m_pShaderManager))
+	{
+		m_renderQueue.Sort();
+
+		BeginGPURegion("SubmitDraws");
+		if (true == IsBatchedRendering())
+		{
+			SubmitBatchedDraws();
+		}
+		else
+		{
+			SubmitDirectDraws();
+		}
+		EndGPURegion();
+	}
+
+	m_drawPackets.clear();
+	m_packetObjects.clear();
+	m_instanceModels.clear();
+	m_instanceColors.clear();
+	m_renderQueue.Clear();
+	m_bObjectChanged = true;
+
+	m_changedUniforms = g_AllUniforms;
+	ApplyObjectUniforms();
+}
+
+/***********************************************************
+ *  SubmitBatchedDraws()
+ *
+ *  This method is used for drawing the sorted packets with
+ *  indirect draw commands.  The object data is uploaded to
+ *  the storage buffer and the draw commands to the indirect
+ *  buffer, and then each batch is drawn with a single
+ *  multi-draw call.  Since the packets are sorted by their
+ *  shader variant and texture, a new batch is only needed
+ *  for each variant and texture.
+ ***********************************************************/
+void SceneManager::SubmitBatchedDraws()
+{
+	size_t lastObjectIndex = m_packetObjects.size();
+
+	for (size_t position = 0; position < m_renderQueue.GetPacketCount(); position++)
+	{
+		const DRAW_PACKET& packet = m_drawPackets[m_renderQueue.GetPacket(position)];
+		const OBJECT_DATA& object = m_packetObjects[packet.objectIndex];
+		bool bUseTexture = (object.bUseTexture != 0);
+		int shaderVariant = (true == bUseTexture) ? 1 : 0;
+
+		// the shader variant and the texture sampler are set once
+		// per batch, so a draw that needs another variant, or a
+		// textured draw that needs another texture, starts a new batch
+		if ((m_drawBatches.size() == 0) ||
+			(m_drawBatches.back().shaderVariant != shaderVariant) ||
+			((true == bUseTexture) && (m_drawBatches.back().textureSlot >= -1) &&
+			 (m_drawBatches.back().textureSlot != packet.textureSlot)))
+		{
+			DRAW_BATCH batch;
+			batch.firstCommand = m_drawCommands.size();
+			batch.commandCount = 0;
+			batch.shaderVariant = shaderVariant;
+			// -2 marks a batch that has no textured draws yet
+			batch.textureSlot = -2;
+			m_drawBatches.push_back(batch);
+		}
+		if (true == bUseTexture)
+		{
+			m_drawBatches.back().textureSlot = packet.textureSlot;
+		}
+
+		ShapeMeshes::DRAW_COMMAND recorded = packet.command;
+		if (true == packet.bInstanced)
+		{
+			// instanced draws get one set of object values per instance,
+			// tinted by the instance color like in the vertex shader
+			recorded.baseInstance = static_cast<GLuint>(m_objectData.size());
+			for (GLuint i = 0; i < packet.command.instanceCount; i++)
+			{
+				OBJECT_DATA instance = object;
+				instance.model = m_instanceModels[packet.firstInstance + i];
+				instance.color *= m_instanceColors[packet.firstInstance + i];
+				m_objectData.push_back(instance);
+			}
+			lastObjectIndex = m_packetObjects.size();
+		}
+		else
+		{
+			// sorted draws of the same object still share its values
+			if (packet.objectIndex != lastObjectIndex)
+			{
+				m_objectData.push_back(object);
+				lastObjectIndex = packet.objectIndex;
+			}
+			recorded.baseInstance = static_cast<GLuint>(m_objectData.size() - 1);
+		}
+
+		m_drawCommands.push_back(recorded);
+		m_drawBatches.back().commandCount++;
+	}
+
+	GLsizeiptr objectDataSize = m_objectData.size() * sizeof(OBJECT_DATA);
+
+	if (0 == m_objectBuffer)
+	{
+		glGenBuffers(1, &m_objectBuffer);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	// orphan the previous contents so the upload does not
+	// have to wait for earlier draws to finish with them
+	glBufferData(GL_SHADER_STORAGE_BUFFER, objectDataSize, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, objectDataSize, m_objectData.data());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BLOCK_BINDING, m_objectBuffer);
+
+	m_basicMeshes->SetIndirectDrawCommands(m_drawCommands.data(), m_drawCommands.size());
+
+	m_bShaderBatching = true;
+	m_pShaderManager->setBoolValue(m_uniforms.useBatching, true);
+	for (const DRAW_BATCH& batch : m_drawBatches)
+	{
+		UseShaderVariant(batch.shaderVariant);
+		if (batch.textureSlot >= -1)
 		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			m_pShaderManager->setSampler2DValue(m_uniforms.objectTexture, batch.textureSlot);
 		}
+		BeginGPURegion("DrawBatch");
+		m_basicMeshes->DrawIndirectCommands(batch.firstCommand, batch.commandCount);
+		EndGPURegion();
 	}
+	m_bShaderBatching = false;
+	m_pShaderManager->setBoolValue(m_uniforms.useBatching, false);
+
+	m_objectData.clear();
+	m_drawCommands.clear();
+	m_drawBatches.clear();
+}
+
+/***********************************************************
+ *  SubmitDirectDraws()
+ *
+ *  This method is used for drawing the sorted packets with
+ *  one draw call each.  The first packet writes all of the
+ *  object uniforms, and every following packet only writes
+ *  the groups of uniforms whose values differ from the ones
+ *  of the packet before it.
+ ***********************************************************/
+void SceneManager::SubmitDirectDraws()
+{
+	// the values of the recording are kept for the draws that
+	// are issued after the submission
+	OBJECT_DATA recordedObject = m_currentObject;
+	int recordedTextureSlot = m_currentTextureSlot;
+
+	m_changedUniforms = g_AllUniforms;
+	for (size_t position = 0; position < m_renderQueue.GetPacketCount(); position++)
+	{
+		const DRAW_PACKET& packet = m_drawPackets[m_renderQueue.GetPacket(position)];
+		const OBJECT_DATA& object = m_packetObjects[packet.objectIndex];
+
+		if (position > 0)
+		{
+			if (object.model != m_currentObject.model)
+			{
+				m_changedUniforms |= g_ModelUniforms;
+			}
+			if ((object.color != m_currentObject.color) ||
+				(object.bUseTexture != m_currentObject.bUseTexture))
+			{
+				m_changedUniforms |= g_ColorUniforms;
+			}
+			if ((0 != object.bUseTexture) &&
+				((packet.textureSlot != m_currentTextureSlot) ||
+				 (object.textureLayer != m_currentObject.textureLayer) ||
+				 (object.textureRect != m_currentObject.textureRect)))
+			{
+				m_changedUniforms |= g_TextureUniforms;
+			}
+			if (object.UVscale != m_currentObject.UVscale)
+			{
+				m_changedUniforms |= g_UVScaleUniforms;
+			}
+			if ((object.diffuseColor != m_currentObject.diffuseColor) ||
+				(object.specularColor != m_currentObject.specularColor))
+			{
+				m_changedUniforms |= g_MaterialUniforms;
+			}
+		}
+
+		m_currentObject = object;
+		// an untextured draw leaves the sampler as it was
+		if ((0 != object.bUseTexture) || (0 == position))
+		{
+			m_currentTextureSlot = packet.textureSlot;
+		}
+		ApplyObjectUniforms();
+
+		// every shader variant keeps its own uniform values, so the
+		// write is skipped when the variant already has this one
+		m_bShaderInstancing = packet.bInstanced;
+		m_pShaderManager->setBoolValue(m_uniforms.useInstancing, packet.bInstanced);
+
+		if (true == packet.bInstanced)
+		{
+			m_basicMeshes->DrawRecordedCommand(
+				packet.command,
+				&m_instanceModels[packet.firstInstance],
+				&m_instanceColors[packet.firstInstance]);
+		}
+		else
+		{
+			m_basicMeshes->DrawRecordedCommand(packet.command, NULL, NULL);
+		}
+	}
+
+	m_bShaderInstancing = false;
+	m_pShaderManager->setBoolValue(m_uniforms.useInstancing, false);
+
+	m_currentObject = recordedObject;
+	m_currentTextureSlot = recordedTextureSlot;
+}
+
+/***********************************************************
+ *  AcceptDraw()
+ *
+ *  This method is called by the shape meshes object before
+ *  every draw.  The bounds of the mesh are transformed by
+ *  the model matrix of the current object, or of each
+ *  instance, and the visibility found for the matching
+ *  scene object is used.  The
+ *  uniforms of a visible object are written only here, so
+ *  a culled object never uploads any of them.  The depth of
+ *  the object is kept for the sort key of a recorded draw.
+ ***********************************************************/
+bool SceneManager::AcceptDraw(
+	const ShapeMeshes::BOUNDING_SPHERE& meshBounds,
+	const glm::mat4* models,
+	size_t instanceCount)
+{
+	bool bVisible = false;
+
+	if (NULL != models)
+	{
+		// an instanced draw is issued when any instance is visible,
+		// but every instance is matched to its scene object - its
+		// depth is the average depth of the instances
+		float depthTotal = 0.0f;
+		for (size_t i = 0; i < instanceCount; i++)
+		{
+			SceneBVH::BOX box = GetObjectBox(meshBounds, models[i]);
+			if (true == IsSceneObjectVisible(box))
+			{
+				bVisible = true;
+			}
+			depthTotal += m_viewFrustum.GetDepth((box.minimum + box.maximum) * 0.5f);
+		}
+		m_drawDepth = (instanceCount > 0) ? depthTotal / instanceCount : 0.0f;
+
+		// every instance counts as an object
+		if (true == bVisible)
+		{
+			m_drawnObjectCount += static_cast<unsigned int>(instanceCount);
+		}
+		else
+		{
+			m_culledObjectCount += static_cast<unsigned int>(instanceCount);
+		}
+	}
+	else
+	{
+		SceneBVH::BOX box = GetObjectBox(meshBounds, m_currentObject.model);
+		bVisible = IsSceneObjectVisible(box);
+		m_drawDepth = m_viewFrustum.GetDepth((box.minimum + box.maximum) * 0.5f);
+
+		// an object drawn in several parts is counted by its first part
+		if (false == m_bObjectCounted)
+		{
+			if (true == bVisible)
+			{
+				m_drawnObjectCount++;
+			}
+			else
+			{
+				m_culledObjectCount++;
+			}
+			m_bObjectCounted = true;
+		}
+	}
+
+	// recorded draws take the object values from the object data
+	if ((true == bVisible) && (false == m_bRecordingDraws))
+	{
+		ApplyObjectUniforms();
+	}
+
+	return(bVisible);
+}
+
+/***********************************************************
+ *  IsSceneObjectVisible()
+ *
+ *  This method is used for matching a draw to the next
+ *  scene object.  The visibility of an object that has not
+ *  moved since the last frame was found by the frustum
+ *  query of the hierarchy.  An object that has moved, or
+ *  is new, is tested against the frustum on its own.
+ ***********************************************************/
+bool SceneManager::IsSceneObjectVisible(const SceneBVH::BOX& bounds)
+{
+	size_t objectIndex = m_nextSceneObject++;
+
+	if (objectIndex >= m_sceneObjects.size())
+	{
+		SCENE_OBJECT object;
+		object.bounds = bounds;
+		object.visibleFrame = 0;
+		m_sceneObjects.push_back(object);
+	}
+	else
+	{
+		SCENE_OBJECT& object = m_sceneObjects[objectIndex];
+		if ((object.bounds.minimum == bounds.minimum) &&
+			(object.bounds.maximum == bounds.maximum))
+		{
+			return(object.visibleFrame == m_frameNumber);
+		}
+
+		object.bounds = bounds;
+		m_sceneBVH.UpdateObject(static_cast<int>(objectIndex), bounds);
+	}
+
+	return(m_viewFrustum.ClassifyBox(bounds.minimum, bounds.maximum) != ViewFrustum::TEST_OUTSIDE);
+}
+
+/***********************************************************
+ *  BeginSceneObjects()
+ *
+ *  This method is used for marking the scene objects that
+ *  are inside of the view frustum before the scene is
+ *  drawn, with a single query of the hierarchy.
+ ***********************************************************/
+void SceneManager::BeginSceneObjects()
+{
+	m_frameNumber++;
+	m_nextSceneObject = 0;
+
+	m_queryObjects.clear();
+	m_sceneBVH.QueryFrustum(m_viewFrustum, m_queryObjects);
+	for (int objectIndex : m_queryObjects)
+	{
+		m_sceneObjects[objectIndex].visibleFrame = m_frameNumber;
+	}
+}
+
+/***********************************************************
+ *  EndSceneObjects()
+ *
+ *  This method is used for updating the hierarchy after the
+ *  scene was drawn.  When the objects that were drawn still
+ *  match the hierarchy, the boxes of the moved objects are
+ *  refit, and otherwise the hierarchy is built again.
+ ***********************************************************/
+void SceneManager::EndSceneObjects()
+{
+	if ((m_nextSceneObject != m_sceneObjects.size()) ||
+		(m_sceneObjects.size() != m_sceneBVH.GetObjectCount()))
+	{
+		m_sceneObjects.resize(m_nextSceneObject);
+
+		std::vector<SceneBVH::BOX> objectBoxes(m_sceneObjects.size());
+		for (size_t i = 0; i < m_sceneObjects.size(); i++)
+		{
+			objectBoxes[i] = m_sceneObjects[i].bounds;
+		}
+		m_sceneBVH.Build(objectBoxes);
+	}
+	else
+	{
+		m_sceneBVH.Refit();
+	}
+}
+
+/***********************************************************
+ *  ApplyObjectUniforms()
+ *
+ *  This method is used for setting the current object values
+ *  that changed since they were last written into the shader
+ *  uniforms, so that the next direct draw matches the values
+ *  the recorded draws were given.  The shader variant that
+ *  matches the object is made current first.
+ ***********************************************************/
+void SceneManager::ApplyObjectUniforms()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	UseShaderVariant((0 != m_currentObject.bUseTexture) ? 1 : 0);
+	if (0 == m_changedUniforms)
+	{
+		return;
+	}
+
+	if (0 != (m_changedUniforms & g_ModelUniforms))
+	{
+		m_pShaderManager->setMat4Value(m_uniforms.model, m_currentObject.model);
+	}
+	if (0 != (m_changedUniforms & g_ColorUniforms))
+	{
+		m_pShaderManager->setVec4Value(m_uniforms.objectColor, m_currentObject.color);
+	}
+	if (0 != (m_changedUniforms & g_TextureUniforms))
+	{
+		m_pShaderManager->setSampler2DValue(m_uniforms.objectTexture, m_currentTextureSlot);
+		m_pShaderManager->setIntValue(m_uniforms.textureLayer, m_currentObject.textureLayer);
+		m_pShaderManager->setVec4Value(m_uniforms.textureRect, m_currentObject.textureRect);
+	}
+	if (0 != (m_changedUniforms & g_UVScaleUniforms))
+	{
+		m_pShaderManager->setVec2Value(m_uniforms.UVscale, m_currentObject.UVscale);
+	}
+	if (0 != (m_changedUniforms & g_MaterialUniforms))
+	{
+		m_pShaderManager->setVec3Value(m_uniforms.diffuseColor, glm::vec3(m_currentObject.diffuseColor));
+		m_pShaderManager->setVec3Value(m_uniforms.specularColor, glm::vec3(m_currentObject.specularColor));
+		m_pShaderManager->setFloatValue(m_uniforms.shininess, m_currentObject.diffuseColor.w);
+	}
+
+	m_changedUniforms = 0;
+}
+
+/***********************************************************
+ *  UseShaderVariant()
+ *
+ *  This method is used for making the untextured (0) or the
+ *  textured (1) shader variant current.  Every variant has
+ *  its own uniforms, so after a switch all of the object
+ *  uniforms are written again, which only issues the ones
+ *  whose values differ from what the variant last had.
+ ***********************************************************/
+void SceneManager::UseShaderVariant(int variant)
+{
+	// the shader manager may be drawing with the fallback
+	// variant while this one is still being compiled
+	if ((m_shaderVariants[variant] < 0) ||
+		(m_pShaderManager->getCurrentProgramVariant() == m_shaderVariants[variant]))
+	{
+		return;
+	}
+
+	int previousVariant = m_pShaderManager->getCurrentProgramVariant();
+	if ((true == m_pShaderManager->useProgramVariant(m_shaderVariants[variant])) &&
+		(m_pShaderManager->getCurrentProgramVariant() != previousVariant))
+	{
+		m_changedUniforms = g_AllUniforms;
+		m_pShaderManager->setBoolValue(m_uniforms.useInstancing, m_bShaderInstancing);
+		m_pShaderManager->setBoolValue(m_uniforms.useBatching, m_bShaderBatching);
+	}
+}
+
+/***********************************************************
+ *  SetBatchedRendering()
+ *
+ *  This method is used for switching between batched
+ *  indirect drawing and issuing one draw call per object,
+ *  which is kept for comparison.
+ ***********************************************************/
+void SceneManager::SetBatchedRendering(bool bBatched)
+{
+	m_bBatchedRendering = bBatched;
+}
+
+/***********************************************************
+ *  IsBatchedRendering()
+ *
+ *  This method returns true when the scene is drawn with
+ *  batched indirect draw commands.
+ ***********************************************************/
+bool SceneManager::IsBatchedRendering() const
+{
+	return(m_bBatchedRendering && m_bBatchingSupported);
+}
+
+/***********************************************************
+ *  SetLODView()
+ *
+ *  This method is used for passing the camera values that
+ *  select the levels of detail to the basic shapes object.
+ ***********************************************************/
+void SceneManager::SetLODView(const ShapeMeshes::LOD_VIEW& view)
+{
+	m_basicMeshes->SetLODView(view);
+}
+
+/***********************************************************
+ *  SetViewFrustum()
+ *
+ *  This method is used for setting the visible volume of
+ *  the camera that the objects are culled against.
+ ***********************************************************/
+void SceneManager::SetViewFrustum(const ViewFrustum& frustum)
+{
+	m_viewFrustum = frustum;
+}
+
+/***********************************************************
+ *  SetGPUProfiler()
+ *
+ *  This method is used for setting the profiler that times
+ *  the regions of the scene rendering on the GPU.  The
+ *  regions are not marked when no profiler is set.
+ ***********************************************************/
+void SceneManager::SetGPUProfiler(GPUProfiler* pProfiler)
+{
+	m_pGPUProfiler = pProfiler;
+}
+
+/***********************************************************
+ *  BeginGPURegion()
+ *
+ *  This method is used for starting a region of the frame
+ *  that is timed on the GPU.
+ ***********************************************************/
+void SceneManager::BeginGPURegion(const char* name)
+{
+	if (NULL != m_pGPUProfiler)
+	{
+		m_pGPUProfiler->BeginRegion(name);
+	}
+}
+
+/***********************************************************
+ *  EndGPURegion()
+ *
+ *  This method is used for ending the region of the frame
+ *  that was started last.
+ ***********************************************************/
+void SceneManager::EndGPURegion()
+{
+	if (NULL != m_pGPUProfiler)
+	{
+		m_pGPUProfiler->EndRegion();
+	}
+}
+
+/***********************************************************
+ *  GetObjectBounds()
+ *
+ *  This method is used for transforming the bounding sphere
+ *  of a mesh by the model matrix of the current object, for
+ *  the level of detail selection.
+ ***********************************************************/
+ShapeMeshes::BOUNDING_SPHERE SceneManager::GetObjectBounds(
+	const ShapeMeshes::BOUNDING_SPHERE& meshBounds) const
+{
+	const glm::mat4& model = m_currentObject.model;
+
+	// the largest scale of the model matrix keeps the
+	// transformed sphere around the whole object
+	float scale = std::max(
+		glm::length(glm::vec3(model[0])),
+		std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+	ShapeMeshes::BOUNDING_SPHERE worldBounds;
+	worldBounds.center = glm::vec3(model * glm::vec4(meshBounds.center, 1.0f));
+	worldBounds.radius = meshBounds.radius * scale;
+	return(worldBounds);
+}
+
+/***********************************************************
+ *  GetObjectBox()
+ *
+ *  This method is used for calculating the world-space box
+ *  around the bounding sphere of a mesh transformed by a
+ *  model matrix.  The sphere becomes an ellipsoid, whose
+ *  extent along each axis is the radius times the length
+ *  of the matching row of the model matrix.
+ ***********************************************************/
+SceneBVH::BOX SceneManager::GetObjectBox(
+	const ShapeMeshes::BOUNDING_SPHERE& meshBounds,
+	const glm::mat4& model) const
+{
+	glm::vec3 center = glm::vec3(model * glm::vec4(meshBounds.center, 1.0f));
+	glm::vec3 extent(
+		glm::length(glm::vec3(model[0][0], model[1][0], model[2][0])),
+		glm::length(glm::vec3(model[0][1], model[1][1], model[2][1])),
+		glm::length(glm::vec3(model[0][2], model[1][2], model[2][2])));
+	extent *= meshBounds.radius;
+
+	SceneBVH::BOX box;
+	box.minimum = center - extent;
+	box.maximum = center + extent;
+	return(box);
+}
+
+/***********************************************************
+ *  GetDrawCallCount()
+ *
+ *  This method returns the number of draw calls that were
+ *  issued for the last rendered frame.
+ ***********************************************************/
+unsigned int SceneManager::GetDrawCallCount() const
+{
+	return(m_basicMeshes->GetDrawCallCount());
+}
+
+/***********************************************************
+ *  GetDrawnObjectCount()
+ *
+ *  This method returns the number of objects that were
+ *  inside of the view frustum for the last rendered frame.
+ ***********************************************************/
+unsigned int SceneManager::GetDrawnObjectCount() const
+{
+	return(m_drawnObjectCount);
+}
+
+/***********************************************************
+ *  GetCulledObjectCount()
+ *
+ *  This method returns the number of objects that were
+ *  skipped for the last rendered frame because they were
+ *  outside of the view frustum.
+ ***********************************************************/
+unsigned int SceneManager::GetCulledObjectCount() const
+{
+	return(m_culledObjectCount);
+}
+
+/***********************************************************
+ *  GetSceneObjectCount()
+ *
+ *  This method returns the number of scene objects that
+ *  were drawn by the last rendered frame, including the
+ *  objects that were culled.
+ ***********************************************************/
+size_t SceneManager::GetSceneObjectCount() const
+{
+	return(m_sceneBVH.GetObjectCount());
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the scene object that
+ *  is hit first by a ray, such as the ray through the
+ *  center of the view.  The number of the object is
+ *  returned, or -1 when the ray misses every object.
+ ***********************************************************/
+int SceneManager::PickObject(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+	return(m_sceneBVH.IntersectRay(origin, direction, distance));
+}
+
+/***********************************************************
+ *  FindObjectsInSphere()
+ *
+ *  This method is used for finding the scene objects whose
+ *  bounds touch the passed in sphere.
+ ***********************************************************/
+void SceneManager::FindObjectsInSphere(const glm::vec3& center, float radius, std::vector<int>& objects) const
+{
+	m_sceneBVH.QuerySphere(center, radius, objects);
+}
+
+/***********************************************************
+ *  FindObjectsInBox()
+ *
+ *  This method is used for finding the scene objects whose
+ *  bounds overlap the passed in box.
+ ***********************************************************/
+void SceneManager::FindObjectsInBox(const glm::vec3& minimum, const glm::vec3& maximum, std::vector<int>& objects) const
+{
+	SceneBVH::BOX bounds;
+	bounds.minimum = minimum;
+	bounds.maximum = maximum;
+	m_sceneBVH.QueryBox(bounds, objects);
 }
 
 /**************************************************************/
@@ -398,6 +1470,40 @@ void SceneManager::SetShaderMaterial(
 /*** rendering the 3D replicated scenes.                    ***/
 /**************************************************************/
 
+/***********************************************************
+ *  BuildTextureCache()
+ *
+ *  This method is used for writing the cache file of every
+ *  scene texture whose image file has changed, or of every
+ *  scene texture when they are rebuilt, with the levels
+ *  compressed or not.  It makes no GL calls, so it can be
+ *  run without a window.
+ ***********************************************************/
+bool SceneManager::BuildTextureCache(bool bRebuild, bool bCompress)
+{
+	bool bSuccess = true;
+	for (const auto& sceneTexture : g_SceneTextures)
+	{
+		CachedTexture image;
+		if (false == image.Load(sceneTexture[0], bCompress, bRebuild))
+		{
+			std::cout << "Could not load image:" << sceneTexture[0] << std::endl;
+			bSuccess = false;
+		}
+		else
+		{
+			std::cout << "INFO: " << sceneTexture[0] << ", " << image.GetLevelCount() << " mipmap levels, "
+				<< image.GetFormatName() << ", " << image.GetPixelSize() / 1024 << " KB";
+			if (true == image.IsCompressed())
+			{
+				std::cout << ", PSNR:" << image.GetPSNR() << " dB";
+			}
+			std::cout << ", " << ((true == image.IsFromCache()) ? "up to date" : "cache file written") << std::endl;
+		}
+	}
+	return(bSuccess);
+}
+
 /***********************************************************
  *  LoadSceneTextures()
  *
@@ -407,43 +1513,42 @@ void SceneManager::SetShaderMaterial(
  ***********************************************************/
 void SceneManager::LoadSceneTextures()
 {
-	bool bReturn = false;
-
-	bReturn = CreateGLTexture(
-		"textures/rusticwood.jpg",
-		"table");
-
-	bReturn = CreateGLTexture(
-		"textures/cheese_wheel.jpg",
-		"cheese_wheel_side");
-
-	bReturn = CreateGLTexture(
-		"textures/cheese_top.jpg",
-		"cheese_wheel_top");
-
-	bReturn = CreateGLTexture(
-		"textures/breadcrust.jpg",
-		"breadcrust");
-
-	bReturn = CreateGLTexture(
-		"textures/backdrop.jpg",
-		"backdrop");
-
-	bReturn = CreateGLTexture(
-		"textures/knife_handle.jpg",
-		"knifehandle");
+	// the compressed levels are uploaded as they are, so the
+	// driver has to support the block formats
+	if ((true == m_bCompressTextures) && (GLEW_EXT_texture_compression_s3tc == GL_FALSE))
+	{
+		std::cout << "INFO: S3TC texture compression is not supported, the textures are not compressed" << std::endl;
+		m_bCompressTextures = false;
+	}
 
-	bReturn = CreateGLTexture(
-		"textures/stainless.jpg",
-		"stainless");
+	// the images are decoded on worker threads while the rest of
+	// the scene is prepared, and the scene is drawn with
+	// placeholder textures until they arrive
+	if ((true == m_bAsyncTextureLoading) && (NULL == m_pTextureLoader))
+	{
+		m_pTextureLoader = new TextureLoader();
+	}
 
-	bReturn = CreateGLTexture(
-		"textures/cheddar.jpg",
-		"cheddar");
+	// the images are packed into one array texture, unless they
+	// are kept in textures of their own
+	bool bTextureArray = (true == m_bTextureArrays) && (true == CreateTextureArray());
+	if (false == bTextureArray)
+	{
+		if (true == m_bTextureArrays)
+		{
+			// the textured variant was defined for the array, so it
+			// is defined again to sample the single textures
+			std::cout << "INFO: The texture array could not be created, the textures are kept apart" << std::endl;
+			m_bTextureArrays = false;
+			DefineTexturedVariant();
+			m_pShaderManager->compileProgramVariantsAsync();
+		}
 
-	bReturn = CreateGLTexture(
-		"textures/circular-brushed-gold-texture.jpg",
-		"knifescrew");
+		for (const auto& sceneTexture : g_SceneTextures)
+		{
+			CreateGLTexture(sceneTexture[0], sceneTexture[1]);
+		}
+	}
 
 	// after the texture image data is loaded into memory, the
 	// loaded textures need to be bound to texture slots - there
@@ -465,7 +1570,7 @@ void SceneManager::DefineObjectMaterials()
 	goldMaterial.shininess = 52.0;
 	goldMaterial.tag = "metal";
 
-	m_objectMaterials.push_back(goldMaterial);
+	RegisterMaterial(goldMaterial);
 
 	OBJECT_MATERIAL woodMaterial;
 	woodMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.3f);
@@ -473,7 +1578,7 @@ void SceneManager::DefineObjectMaterials()
 	woodMaterial.shininess = 0.1;
 	woodMaterial.tag = "wood";
 
-	m_objectMaterials.push_back(woodMaterial);
+	RegisterMaterial(woodMaterial);
 
 	OBJECT_MATERIAL glassMaterial;
 	glassMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
@@ -481,7 +1586,7 @@ void SceneManager::DefineObjectMaterials()
 	glassMaterial.shininess = 95.0;
 	glassMaterial.tag = "glass";
 
-	m_objectMaterials.push_back(glassMaterial);
+	RegisterMaterial(glassMaterial);
 
 	OBJECT_MATERIAL plateMaterial;
 	plateMaterial.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
@@ -489,7 +1594,7 @@ void SceneManager::DefineObjectMaterials()
 	plateMaterial.shininess = 30.0;
 	plateMaterial.tag = "plate";
 
-	m_objectMaterials.push_back(plateMaterial);
+	RegisterMaterial(plateMaterial);
 
 	OBJECT_MATERIAL cheeseMaterial;
 	cheeseMaterial.diffuseColor = glm::vec3(0.6f, 0.5f, 0.3f);
@@ -497,7 +1602,7 @@ void SceneManager::DefineObjectMaterials()
 	cheeseMaterial.shininess = 0.1;
 	cheeseMaterial.tag = "cheese";
 
-	m_objectMaterials.push_back(cheeseMaterial);
+	RegisterMaterial(cheeseMaterial);
 
 	OBJECT_MATERIAL breadMaterial;
 	breadMaterial.diffuseColor = glm::vec3(0.7f, 0.6f, 0.5f);
@@ -505,7 +1610,7 @@ void SceneManager::DefineObjectMaterials()
 	breadMaterial.shininess = 0.001;
 	breadMaterial.tag = "bread";
 
-	m_objectMaterials.push_back(breadMaterial);
+	RegisterMaterial(breadMaterial);
 
 	OBJECT_MATERIAL darkBreadMaterial;
 	darkBreadMaterial.diffuseColor = glm::vec3(0.5f, 0.4f, 0.3f);
@@ -513,7 +1618,7 @@ void SceneManager::DefineObjectMaterials()
 	darkBreadMaterial.shininess = 0.001;
 	darkBreadMaterial.tag = "darkbread";
 
-	m_objectMaterials.push_back(darkBreadMaterial);
+	RegisterMaterial(darkBreadMaterial);
 
 	OBJECT_MATERIAL backdropMaterial;
 	backdropMaterial.diffuseColor = glm::vec3(0.8f, 0.8f, 0.9f);
@@ -521,7 +1626,7 @@ void SceneManager::DefineObjectMaterials()
 	backdropMaterial.shininess = 2.0;
 	backdropMaterial.tag = "backdrop";
 
-	m_objectMaterials.push_back(backdropMaterial);
+	RegisterMaterial(backdropMaterial);
 
 	OBJECT_MATERIAL grapeMaterial;
 	grapeMaterial.diffuseColor = glm::vec3(0.4f, 0.2f, 0.4f);
@@ -529,7 +1634,38 @@ void SceneManager::DefineObjectMaterials()
 	grapeMaterial.shininess = 0.55;
 	grapeMaterial.tag = "grape";
 
-	m_objectMaterials.push_back(grapeMaterial);
+	RegisterMaterial(grapeMaterial);
+}
+
+/***********************************************************
+ *  FindSceneHandles()
+ *
+ *  This method is used for finding the handles of the
+ *  textures and materials of the 3D scene by their tags,
+ *  once, after they are loaded and defined.  A texture
+ *  whose image could not be loaded has a handle of -1.
+ ***********************************************************/
+void SceneManager::FindSceneHandles()
+{
+	m_sceneTextures.table = FindTextureSlot("table");
+	m_sceneTextures.backdrop = FindTextureSlot("backdrop");
+	m_sceneTextures.cheeseWheelSide = FindTextureSlot("cheese_wheel_side");
+	m_sceneTextures.cheeseWheelTop = FindTextureSlot("cheese_wheel_top");
+	m_sceneTextures.breadcrust = FindTextureSlot("breadcrust");
+	m_sceneTextures.knifeHandle = FindTextureSlot("knifehandle");
+	m_sceneTextures.stainless = FindTextureSlot("stainless");
+	m_sceneTextures.cheddar = FindTextureSlot("cheddar");
+	m_sceneTextures.knifeScrew = FindTextureSlot("knifescrew");
+
+	m_sceneMaterials.metal = FindMaterialIndex("metal");
+	m_sceneMaterials.wood = FindMaterialIndex("wood");
+	m_sceneMaterials.glass = FindMaterialIndex("glass");
+	m_sceneMaterials.plate = FindMaterialIndex("plate");
+	m_sceneMaterials.cheese = FindMaterialIndex("cheese");
+	m_sceneMaterials.bread = FindMaterialIndex("bread");
+	m_sceneMaterials.darkBread = FindMaterialIndex("darkbread");
+	m_sceneMaterials.backdrop = FindMaterialIndex("backdrop");
+	m_sceneMaterials.grape = FindMaterialIndex("grape");
 }
 
 /***********************************************************
@@ -540,79 +1676,315 @@ void SceneManager::DefineObjectMaterials()
  ***********************************************************/
 void SceneManager::SetupSceneLights()
 {
-	// Enable lighting in the shader
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
+	// all of the light sources are uploaded to the shaders in a
+	// single uniform buffer - the spotlight position and direction
+	// are refreshed every frame by the view manager
+	LIGHT_BLOCK lights = {};
 
 	// Directional light setup
-	m_pShaderManager->setVec3Value("directionalLight.direction", -0.05f, -0.3f, -0.1f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.6f, 0.6f, 0.6f);
-	m_pShaderManager->setVec3Value("directionalLight.specular", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
+	lights.directionalLight.direction = glm::vec3(-0.05f, -0.3f, -0.1f);
+	lights.directionalLight.ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.directionalLight.diffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+	lights.directionalLight.specular = glm::vec3(0.0f, 0.0f, 0.0f);
+	lights.directionalLight.bActive = true;
 
 	// Point light 1
-	m_pShaderManager->setVec3Value("pointLights[0].position", -4.0f, 8.0f, 0.0f);
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 0.3f, 0.3f, 0.3f);
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setFloatValue("pointLights[0].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[0].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[0].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[0].bActive", true);
+	lights.pointLights[0].position = glm::vec3(-4.0f, 8.0f, 0.0f);
+	lights.pointLights[0].ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.pointLights[0].diffuse = glm::vec3(0.3f, 0.3f, 0.3f);
+	lights.pointLights[0].specular = glm::vec3(0.1f, 0.1f, 0.1f);
+	lights.pointLights[0].bActive = true;
 
 	// Point light 2
-	m_pShaderManager->setVec3Value("pointLights[1].position", 4.0f, 8.0f, 0.0f);
-	m_pShaderManager->setVec3Value("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[1].diffuse", 0.3f, 0.3f, 0.3f);
-	m_pShaderManager->setVec3Value("pointLights[1].specular", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setFloatValue("pointLights[1].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[1].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[1].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
+	lights.pointLights[1].position = glm::vec3(4.0f, 8.0f, 0.0f);
+	lights.pointLights[1].ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.pointLights[1].diffuse = glm::vec3(0.3f, 0.3f, 0.3f);
+	lights.pointLights[1].specular = glm::vec3(0.1f, 0.1f, 0.1f);
+	lights.pointLights[1].bActive = true;
 
 	// Point light 3
-	m_pShaderManager->setVec3Value("pointLights[2].position", 3.8f, 5.5f, 4.0f);
-	m_pShaderManager->setVec3Value("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[2].diffuse", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setVec3Value("pointLights[2].specular", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setFloatValue("pointLights[2].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[2].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[2].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[2].bActive", true);
+	lights.pointLights[2].position = glm::vec3(3.8f, 5.5f, 4.0f);
+	lights.pointLights[2].ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.pointLights[2].diffuse = glm::vec3(0.2f, 0.2f, 0.2f);
+	lights.pointLights[2].specular = glm::vec3(0.8f, 0.8f, 0.8f);
+	lights.pointLights[2].bActive = true;
 
 	// Point light 4
-	m_pShaderManager->setVec3Value("pointLights[3].position", 3.8f, 3.5f, 4.0f);
-	m_pShaderManager->setVec3Value("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[3].diffuse", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setVec3Value("pointLights[3].specular", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setFloatValue("pointLights[3].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[3].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[3].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[3].bActive", true);
+	lights.pointLights[3].position = glm::vec3(3.8f, 3.5f, 4.0f);
+	lights.pointLights[3].ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.pointLights[3].diffuse = glm::vec3(0.2f, 0.2f, 0.2f);
+	lights.pointLights[3].specular = glm::vec3(0.8f, 0.8f, 0.8f);
+	lights.pointLights[3].bActive = true;
 
 	// Point light 5
-	m_pShaderManager->setVec3Value("pointLights[4].position", -3.2f, 6.0f, -4.0f);
-	m_pShaderManager->setVec3Value("pointLights[4].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[4].diffuse", 0.9f, 0.9f, 0.9f);
-	m_pShaderManager->setVec3Value("pointLights[4].specular", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setFloatValue("pointLights[4].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[4].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[4].quadratic", 0.032f);
-	m_pShaderManager->setBoolValue("pointLights[4].bActive", true);
+	lights.pointLights[4].position = glm::vec3(-3.2f, 6.0f, -4.0f);
+	lights.pointLights[4].ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.pointLights[4].diffuse = glm::vec3(0.9f, 0.9f, 0.9f);
+	lights.pointLights[4].specular = glm::vec3(0.1f, 0.1f, 0.1f);
+	lights.pointLights[4].bActive = true;
 
 	// Spotlight setup
-	m_pShaderManager->setVec3Value("spotLight.ambient", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setVec3Value("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setVec3Value("spotLight.specular", 0.7f, 0.7f, 0.7f);
-	m_pShaderManager->setFloatValue("spotLight.constant", 1.0f);
-	m_pShaderManager->setFloatValue("spotLight.linear", 0.09f);
-	m_pShaderManager->setFloatValue("spotLight.quadratic", 0.032f);
-	m_pShaderManager->setFloatValue("spotLight.cutOff", glm::cos(glm::radians(42.5f)));
-	m_pShaderManager->setFloatValue("spotLight.outerCutOff", glm::cos(glm::radians(48.0f)));
-	m_pShaderManager->setBoolValue("spotLight.bActive", true);
+	lights.spotLight.ambient = glm::vec3(0.8f, 0.8f, 0.8f);
+	lights.spotLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+	lights.spotLight.specular = glm::vec3(0.7f, 0.7f, 0.7f);
+	lights.spotLight.constant = 1.0f;
+	lights.spotLight.linear = 0.09f;
+	lights.spotLight.quadratic = 0.032f;
+	lights.spotLight.cutOff = glm::cos(glm::radians(42.5f));
+	lights.spotLight.outerCutOff = glm::cos(glm::radians(48.0f));
+	lights.spotLight.bActive = true;
+
+	// the shaders only loop over the point lights at the front
+	int activePointLights = 0;
+	for (int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+	{
+		if (0 != lights.pointLights[i].bActive)
+		{
+			lights.pointLights[activePointLights++] = lights.pointLights[i];
+		}
+	}
+	for (int i = activePointLights; i < TOTAL_POINT_LIGHTS; i++)
+	{
+		lights.pointLights[i] = {};
+	}
+
+	// the lighting is compiled into the shader variants
+	DefineShaderVariants(lights, activePointLights);
+
+	m_pShaderManager->createUniformBuffer(LIGHT_BLOCK_BINDING, sizeof(LIGHT_BLOCK));
+	m_pShaderManager->bindUniformBlock("LightBlock", LIGHT_BLOCK_BINDING);
+	m_pShaderManager->setUniformBufferData(LIGHT_BLOCK_BINDING, 0, sizeof(LIGHT_BLOCK), &lights);
+}
+
+
+/***********************************************************
+ *  DefineShaderVariants()
+ *
+ *  This method is used for defining the untextured and the
+ *  textured shader variants, which only calculate the light
+ *  sources that are active.  Both are compiled in the
+ *  background, and until they are ready the objects are
+ *  drawn in their colors by the unlit fallback variant.
+ ***********************************************************/
+void SceneManager::DefineShaderVariants(
+	const LIGHT_BLOCK& lights,
+	int activePointLights)
+{
+	// without any active light the lighting adds up to black, as it
+	// did before the variants, so UNLIT is only used by the fallback
+	std::vector<std::string> defines;
+	if (0 != lights.directionalLight.bActive)
+	{
+		defines.push_back("DIRECTIONAL");
+	}
+	defines.push_back("NUM_POINT_LIGHTS " + std::to_string(activePointLights));
+	if (0 != lights.spotLight.bActive)
+	{
+		defines.push_back("SPOT");
+	}
+
+	m_lightDefines = defines;
+	m_shaderVariants[0] = m_pShaderManager->getProgramVariant(defines);
+	DefineTexturedVariant();
+
+	// the fallback is compiled first, so that it is not queued
+	// behind the variants it stands in for
+	m_pShaderManager->setFallbackProgramVariant(
+		m_pShaderManager->getProgramVariant(std::vector<std::string>(1, "UNLIT")));
+	m_pShaderManager->compileProgramVariantsAsync();
+
+	// the variant is made current by the next draw
+	m_changedUniforms = g_AllUniforms;
+}
+
+
+/***********************************************************
+ *  DefineTexturedVariant()
+ *
+ *  This method is used for defining the textured shader
+ *  variant for the active light sources, which samples the
+ *  array texture when the textures are packed into one, and
+ *  the single texture of the object otherwise.
+ ***********************************************************/
+void SceneManager::DefineTexturedVariant()
+{
+	std::vector<std::string> defines = m_lightDefines;
+	defines.push_back("TEXTURED");
+	if (true == m_bTextureArrays)
+	{
+		defines.push_back("TEXTURE_ARRAY");
+	}
+	m_shaderVariants[1] = m_pShaderManager->getProgramVariant(defines);
+
+	// the variant is made current by the next draw
+	m_changedUniforms = g_AllUniforms;
 }
 
 
+/***********************************************************
+ *  DefineSceneNodes()
+ *
+ *  This method is used for adding the nodes that hold the
+ *  transformations of the object parts to the scene graph.
+ *  Every object has a root node at the origin, so moving
+ *  the root moves all of its parts, which keep their scale,
+ *  rotation and position relative to the root.
+ ***********************************************************/
+void SceneManager::DefineSceneNodes()
+{
+	const glm::vec3 unitScale = glm::vec3(1.0f, 1.0f, 1.0f);
+	const glm::vec3 origin = glm::vec3(0.0f, 0.0f, 0.0f);
+
+	m_sceneGraph.Clear();
+
+	// table - the box used for the table top
+	m_sceneNodes.table = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	m_sceneNodes.tableTop = m_sceneGraph.AddNode(m_sceneNodes.table,
+		glm::vec3(20.0f, .6f, 8.0f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.2f, -0.9f));
+
+	// backdrop - the plane standing behind the table
+	m_sceneNodes.backdrop = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	m_sceneNodes.backdropPlane = m_sceneGraph.AddNode(m_sceneNodes.backdrop,
+		glm::vec3(20.0f, 1.0f, 20.0f),
+		90.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 15.0f, -8.0f));
+
+	// cheese wheel - the cylinder drawn with the side and top textures
+	m_sceneNodes.cheeseWheel = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	m_sceneNodes.cheeseWheelBody = m_sceneGraph.AddNode(m_sceneNodes.cheeseWheel,
+		glm::vec3(1.5f, 1.2f, 1.5f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(-2.0f, 0.5f, 0.0f));
+
+	// loaf of bread - the upper and the lower half spheres
+	m_sceneNodes.breadLoaf = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	m_sceneNodes.breadTop = m_sceneGraph.AddNode(m_sceneNodes.breadLoaf,
+		glm::vec3(2.0f, 1.0f, .9f),
+		0.0f, -15.0f, 0.0f,
+		glm::vec3(2.5f, 1.2f, 0.0f));
+	m_sceneNodes.breadBottom = m_sceneGraph.AddNode(m_sceneNodes.breadLoaf,
+		glm::vec3(2.0f, .6f, .9f),
+		180.0f, -15.0f, 0.0f,
+		glm::vec3(2.5f, 1.2f, 0.0f));
+
+	// wine glass - the base, the stem with its tapered ends,
+	// the wine and the bowl
+	m_sceneNodes.wineGlass = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	m_sceneNodes.glassBase = m_sceneGraph.AddNode(m_sceneNodes.wineGlass,
+		glm::vec3(.8f, 0.06f, .8f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.54f, -1.5f));
+	m_sceneNodes.glassStemFoot = m_sceneGraph.AddNode(m_sceneNodes.wineGlass,
+		glm::vec3(0.2f, 0.4f, 0.2f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.6f, -1.5f));
+	m_sceneNodes.glassStem = m_sceneGraph.AddNode(m_sceneNodes.wineGlass,
+		glm::vec3(0.1f, 1.5f, 0.1f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 1.0f, -1.5f));
+	m_sceneNodes.glassStemTop = m_sceneGraph.AddNode(m_sceneNodes.wineGlass,
+		glm::vec3(0.2f, 0.4f, 0.2f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 2.896f, -1.5f));
+	m_sceneNodes.glassWine = m_sceneGraph.AddNode(m_sceneNodes.wineGlass,
+		glm::vec3(1.0f, 0.8f, 1.0f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 3.68f, -1.5f));
+	m_sceneNodes.glassBowl = m_sceneGraph.AddNode(m_sceneNodes.wineGlass,
+		glm::vec3(.99f, 1.5f, .99f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 3.68f, -1.5f));
+
+	// wine bottle - the rounded bottom, the body, the rounded
+	// top, the neck, and the two tori on top of the neck
+	m_sceneNodes.wineBottle = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	m_sceneNodes.bottleBottom = m_sceneGraph.AddNode(m_sceneNodes.wineBottle,
+		glm::vec3(.9f, .3f, .9f),
+		0.0f, 0.0f, 180.0f,
+		glm::vec3(-1.8f, 0.9f, -2.6f));
+	m_sceneNodes.bottleBody = m_sceneGraph.AddNode(m_sceneNodes.wineBottle,
+		glm::vec3(.9f, 4.0f, .9f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(-1.8f, .9f, -2.6f));
+	m_sceneNodes.bottleShoulder = m_sceneGraph.AddNode(m_sceneNodes.wineBottle,
+		glm::vec3(.905f, .9f, .905f),
+		0.0f, -6.0f, 0.0f,
+		glm::vec3(-1.8f, 4.9f, -2.6f));
+	m_sceneNodes.bottleNeck = m_sceneGraph.AddNode(m_sceneNodes.wineBottle,
+		glm::vec3(.3f, 2.0f, .3f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(-1.8f, 5.6f, -2.6f));
+	m_sceneNodes.bottleLip = m_sceneGraph.AddNode(m_sceneNodes.wineBottle,
+		glm::vec3(.32f, .32f, 1.5f),
+		90.0f, 0.0f, 0.0f,
+		glm::vec3(-1.8f, 7.4f, -2.6f));
+	m_sceneNodes.bottleRim = m_sceneGraph.AddNode(m_sceneNodes.wineBottle,
+		glm::vec3(.28f, .28f, 0.4f),
+		90.0f, 0.0f, 0.0f,
+		glm::vec3(-1.8f, 7.6f, -2.6f));
+
+	// grapes - the spheres of the bunch and the stem
+	const struct
+	{
+		glm::vec3 scaleXYZ;
+		glm::vec3 positionXYZ;
+	} grapes[GRAPE_COUNT] =
+	{
+		{ glm::vec3(0.23f, 0.21f, 0.2f), glm::vec3(3.3f, 0.7f, 1.1f) },
+		{ glm::vec3(0.23f, 0.21f, 0.2f), glm::vec3(3.6f, 0.7f, 1.4f) },
+		{ glm::vec3(0.23f, 0.21f, 0.2f), glm::vec3(3.1f, 0.7f, 1.5f) },
+		{ glm::vec3(0.22f, 0.19f, 0.18f), glm::vec3(3.3f, 0.96f, 1.28f) },
+		{ glm::vec3(0.23f, 0.21f, 0.2f), glm::vec3(2.9f, 0.7f, 1.3f) },
+		{ glm::vec3(0.21f, 0.19f, 0.17f), glm::vec3(2.5f, 0.7f, 1.4f) },
+		{ glm::vec3(0.22f, 0.19f, 0.17f), glm::vec3(2.76f, 0.95f, 1.44f) },
+		{ glm::vec3(0.21f, 0.19f, 0.17f), glm::vec3(2.7f, 0.7f, 1.6f) },
+		{ glm::vec3(0.18f, 0.16f, 0.15f), glm::vec3(2.30f, .70f, 1.6f) },
+	};
+
+	m_sceneNodes.grapeBunch = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	for (int i = 0; i < GRAPE_COUNT; i++)
+	{
+		m_sceneNodes.grapes[i] = m_sceneGraph.AddNode(m_sceneNodes.grapeBunch,
+			grapes[i].scaleXYZ,
+			0.0f, 0.0f, 0.0f,
+			grapes[i].positionXYZ);
+	}
+	m_sceneNodes.grapeStem = m_sceneGraph.AddNode(m_sceneNodes.grapeBunch,
+		glm::vec3(0.02f, 0.90f, 0.02f),
+		0.0f, 15.0f, 100.0f,
+		glm::vec3(4.0f, 0.85f, 1.14f));
+
+	// plate and knife - the plate base and dish, the knife
+	// handle, blade and screw, and the wedge of cheese
+	m_sceneNodes.plateAndKnife = m_sceneGraph.AddNode(-1, unitScale, 0.0f, 0.0f, 0.0f, origin);
+	m_sceneNodes.plateBase = m_sceneGraph.AddNode(m_sceneNodes.plateAndKnife,
+		glm::vec3(0.46f, 0.08f, 0.46f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(0.7f, 0.55f, 1.8f));
+	m_sceneNodes.plateDish = m_sceneGraph.AddNode(m_sceneNodes.plateAndKnife,
+		glm::vec3(1.06f, 0.1f, 1.06f),
+		180.0f, 0.0f, 0.0f,
+		glm::vec3(0.7f, .71f, 1.8f));
+	m_sceneNodes.knifeHandle = m_sceneGraph.AddNode(m_sceneNodes.plateAndKnife,
+		glm::vec3(1.3f, 0.18f, 0.20f),
+		0.0f, 20.0f, 4.0f,
+		glm::vec3(-1.2f, .64f, 1.9f));
+	m_sceneNodes.knifeBlade = m_sceneGraph.AddNode(m_sceneNodes.plateAndKnife,
+		glm::vec3(.2f, 2.0f, 0.01f),
+		90.0f, 110.0f, 4.0f,
+		glm::vec3(0.2f, .75f, 1.395f));
+	m_sceneNodes.cheeseWedge = m_sceneGraph.AddNode(m_sceneNodes.plateAndKnife,
+		glm::vec3(.6f, 0.25f, 1.0f),
+		8.0f, -140.0f, -6.4f,
+		glm::vec3(1.1f, .785f, 2.2f));
+	m_sceneNodes.knifeScrew = m_sceneGraph.AddNode(m_sceneNodes.plateAndKnife,
+		glm::vec3(0.05f, 0.186f, 0.05f),
+		0.0f, 0.0f, 4.0f,
+		glm::vec3(-.7f, 0.584f, 1.73f));
+}
+
 /***********************************************************
  *  PrepareScene()
  *
@@ -622,38 +1994,81 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
+	// add and defile the light sources for the 3D scene - this
+	// comes first, since it starts the compiles of the shader
+	// variants, which go on while the textures are loaded
+	SetupSceneLights();
 	// load the texture image files for the textures applied
 	// to objects in the 3D scene
 	LoadSceneTextures();
 	// define the materials that will be used for the objects
 	// in the 3D scene
 	DefineObjectMaterials();
-	// add and defile the light sources for the 3D scene
-	SetupSceneLights();
+	// find the handles the textures and materials are drawn
+	// with, so that no tag is looked up while drawing
+	FindSceneHandles();
+	// add the transformations of the object parts to the
+	// scene graph, which keeps their model matrices
+	DefineSceneNodes();
 
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-
+	// in the rendered 3D scene - all of the meshes are packed
+	// into shared buffers so the scene draws without VAO switches,
+	// and the round meshes are loaded with coarser levels of
+	// detail for the objects that cover few pixels
+	m_basicMeshes->BeginPackedLoad();
 	m_basicMeshes->LoadBoxMesh();
 	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
+	m_basicMeshes->LoadCylinderMeshLOD();
 	m_basicMeshes->LoadConeMesh();
 	m_basicMeshes->LoadPrismMesh();
 	m_basicMeshes->LoadPyramid4Mesh();
-	m_basicMeshes->LoadSphereMesh();
+	m_basicMeshes->LoadSphereMeshLOD();
 	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadTorusMesh();
+	m_basicMeshes->LoadTorusMeshLOD();
+	m_basicMeshes->EndPackedLoad();
+
+	// batched drawing needs indirect draws of the packed meshes
+	// and the per-object storage block in the shaders
+	m_bBatchingSupported =
+		m_basicMeshes->IsIndirectDrawSupported() &&
+		m_pShaderManager->bindStorageBlock(g_ObjectBlockName, OBJECT_BLOCK_BINDING);
 }
 
 /***********************************************************
  *  RenderScene()
  *
  *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  transforming and drawing the basic 3D shapes.  The draws
+ *  are recorded, and submitted at the end in the order of
+ *  their state and depth, batched when that is supported.
+ *  The objects outside of the view frustum are skipped.
  ***********************************************************/
 void SceneManager::RenderScene()
 {
+	PROFILE_ZONE("SceneManager::RenderScene");
+	BeginGPURegion("RenderScene");
+
+	// swap in the textures that finished loading in the background
+	UpdateTextureLoading();
+
+	m_basicMeshes->ResetDrawCallCount();
+	m_drawnObjectCount = 0;
+	m_culledObjectCount = 0;
+	m_bObjectCounted = false;
+	// only the parts that moved since the last frame get new
+	// model matrices, so a still scene calculates none
+	m_sceneGraph.UpdateWorldMatrices();
+	BeginSceneObjects();
+	m_basicMeshes->SetDrawFilter(this);
+
+	m_bRecordingDraws = m_basicMeshes->HasPackedMeshes();
+	if (true == m_bRecordingDraws)
+	{
+		m_basicMeshes->SetDrawRecorder(this);
+	}
+
 	RenderTable();
 	RenderBackdrop();
 	RenderCheeseWheel();
@@ -662,6 +2077,18 @@ void SceneManager::RenderScene()
 	RenderWineGlass();
 	RenderGrapes();
 	RenderPlateAndKnife();
+
+	if (true == m_bRecordingDraws)
+	{
+		FlushDraws();
+		m_basicMeshes->SetDrawRecorder(NULL);
+		m_bRecordingDraws = false;
+	}
+
+	m_basicMeshes->SetDrawFilter(NULL);
+	EndSceneObjects();
+
+	EndGPURegion();
 }
 
 /***********************************************************
@@ -672,38 +2099,13 @@ void SceneManager::RenderScene()
  ***********************************************************/
 void SceneManager::RenderTable()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, .6f, 8.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.2f, -0.9f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.tableTop);
 
 	//SetShaderColor(1, 1, 1, 1);
-	SetShaderTexture("table");
+	SetShaderTexture(m_sceneTextures.table);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	SetShaderMaterial(m_sceneMaterials.wood);
 
 	// draw the mesh with transformation values - this plane is used for the base
 	m_basicMeshes->DrawBoxMesh();
@@ -717,37 +2119,12 @@ void SceneManager::RenderTable()
  ***********************************************************/
 void SceneManager::RenderBackdrop()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 20.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 15.0f, -8.0f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderTexture("backdrop");
+	SetTransformations(m_sceneNodes.backdropPlane);
+
+	SetShaderTexture(m_sceneTextures.backdrop);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("backdrop");
+	SetShaderMaterial(m_sceneMaterials.backdrop);
 
 	// draw the mesh with transformation values - this plane is used for the backdrop
 	m_basicMeshes->DrawPlaneMesh();
@@ -761,46 +2138,21 @@ void SceneManager::RenderBackdrop()
  ***********************************************************/
 void SceneManager::RenderCheeseWheel()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.5f, 1.2f, 1.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-2.0f, 0.5f, 0.0f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.cheeseWheelBody);
 
 	//SetShaderColor(1, 1, 1, 1);
-	SetShaderTexture("cheese_wheel_side");
+	SetShaderTexture(m_sceneTextures.cheeseWheelSide);
 	SetTextureUVScale(5.0, 1.0);
-	SetShaderMaterial("cheese");
+	SetShaderMaterial(m_sceneMaterials.cheese);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawCylinderMesh(false, false, true);
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()), false, false, true);
 
-	SetShaderTexture("cheese_wheel_top");
+	SetShaderTexture(m_sceneTextures.cheeseWheelTop);
 	SetTextureUVScale(1.0, 1.0);
 
-	m_basicMeshes->DrawCylinderMesh(true, false, false);
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()), true, false, false);
 }
 
 /***********************************************************
@@ -811,68 +2163,25 @@ void SceneManager::RenderCheeseWheel()
  ***********************************************************/
 void SceneManager::RenderBreadLoaf()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(2.0f, 1.0f, .9f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = -15.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.5f, 1.2f, 0.0f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.breadTop);
 
 	//SetShaderColor(1, 1, 1, 1);
-	SetShaderTexture("breadcrust");
+	SetShaderTexture(m_sceneTextures.breadcrust);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("bread");
-
-	m_basicMeshes->DrawHalfSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(2.0f, .6f, .9f);
+	SetShaderMaterial(m_sceneMaterials.bread);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = -15.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.5f, 1.2f, 0.0f);
+	m_basicMeshes->DrawHalfSphereMeshLOD(GetObjectBounds(m_basicMeshes->GetSphereBounds()));
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.breadBottom);
 
 	//SetShaderColor(1, 1, 1, 1);
-	SetShaderTexture("breadcrust");
+	SetShaderTexture(m_sceneTextures.breadcrust);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("darkbread");
+	SetShaderMaterial(m_sceneMaterials.darkBread);
 
-	m_basicMeshes->DrawHalfSphereMesh();
+	m_basicMeshes->DrawHalfSphereMeshLOD(GetObjectBounds(m_basicMeshes->GetSphereBounds()));
 }
 
 /***********************************************************
@@ -883,171 +2192,56 @@ void SceneManager::RenderBreadLoaf()
  ***********************************************************/
 void SceneManager::RenderWineGlass()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.8f, 0.06f, .8f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.54f, -1.5f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.glassBase);
 
 	SetShaderColor(.7, .7, .8, 0.3);
-	SetShaderMaterial("glass");
+	SetShaderMaterial(m_sceneMaterials.glass);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawCylinderMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.2f, 0.4f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.6f, -1.5f);
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()));
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.glassStemFoot);
 
 	SetShaderColor(1, 1, 1, 0.3);
-	SetShaderMaterial("glass");
+	SetShaderMaterial(m_sceneMaterials.glass);
 
 	// draw the mesh with transformation values - this plane is used for the base
 	m_basicMeshes->DrawTaperedCylinderMesh(false, false, true);
 
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.1f, 1.5f, 0.1f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 1.0f, -1.5f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.glassStem);
 
 	SetShaderColor(.7, .7, .8, 0.3);
-	SetShaderMaterial("glass");
+	SetShaderMaterial(m_sceneMaterials.glass);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawCylinderMesh(false, false, true);
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.2f, 0.4f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 2.896f, -1.5f);
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()), false, false, true);
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.glassStemTop);
 
 	SetShaderColor(.7, .7, .8, 0.3);
-	SetShaderMaterial("glass");
+	SetShaderMaterial(m_sceneMaterials.glass);
 
 	// draw the mesh with transformation values - this plane is used for the base
 	m_basicMeshes->DrawTaperedCylinderMesh(false, false, true);
 
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.0f, 0.8f, 1.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 3.68f, -1.5f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.glassWine);
 
 	SetShaderColor(0.3, 0.1, 0.4, 0.8);
-	SetShaderMaterial("glass");
+	SetShaderMaterial(m_sceneMaterials.glass);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawHalfSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.99f, 1.5f, .99f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 3.68f, -1.5f);
+	m_basicMeshes->DrawHalfSphereMeshLOD(GetObjectBounds(m_basicMeshes->GetSphereBounds()));
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.glassBowl);
 
 	SetShaderColor(.7, .7, .8, 0.3);
-	SetShaderMaterial("glass");
+	SetShaderMaterial(m_sceneMaterials.glass);
 
 	// draw the mesh with transformation values - this plane is used for the base
 	m_basicMeshes->DrawTaperedCylinderMesh(false, false, true);
@@ -1061,160 +2255,44 @@ void SceneManager::RenderWineGlass()
  ***********************************************************/
 void SceneManager::RenderWineBottle()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-	
-	/*** Set needed transformations before drawing the basic mesh ***/
-	
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.9f, .3f, .9f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 180.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.8f, 0.9f, -2.6f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.bottleBottom);
 
 	SetShaderColor(.07, 0.2, .08, .95);
-	SetShaderMaterial("glass");
+	SetShaderMaterial(m_sceneMaterials.glass);
 
 	// draw the mesh with transformation values - this half sphere is used for the bottom of the bottle
-	m_basicMeshes->DrawHalfSphereMesh();
-	
-	/*** Set needed transformations before drawing the basic mesh ***/
-	
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.9f, 4.0f, .9f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.8f, .9f, -2.6f);
+	m_basicMeshes->DrawHalfSphereMeshLOD(GetObjectBounds(m_basicMeshes->GetSphereBounds()));
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
+	SetTransformations(m_sceneNodes.bottleBody);
 
 	// draw the mesh with transformation values - this cylinder is used for the main bottle section
-	m_basicMeshes->DrawCylinderMesh(false, false, true);
-	
-	/*** Set needed transformations before drawing the basic mesh ***/
-	
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.905f, .9f, .905f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = -6.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.8f, 4.9f, -2.6f);
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()), false, false, true);
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.bottleShoulder);
 
 	// draw the mesh with transformation values - this half spere is used for the rounded bottle top
-	m_basicMeshes->DrawHalfSphereMesh();
-	
-	/*** Set needed transformations before drawing the basic mesh ***/
-	
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.3f, 2.0f, .3f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.8f, 5.6f, -2.6f);
+	m_basicMeshes->DrawHalfSphereMeshLOD(GetObjectBounds(m_basicMeshes->GetSphereBounds()));
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.bottleNeck);
 
 	// draw the mesh with transformation values - this cylinder is used for the bottle top
-	m_basicMeshes->DrawCylinderMesh(false, false, true);
-	
-	/*** Set needed transformations before drawing the basic mesh ***/
-	
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.32f, .32f, 1.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.8f, 7.4f, -2.6f);
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()), false, false, true);
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.bottleLip);
 
 	// draw the mesh with transformation values - this torus is used on the bottle top
-	m_basicMeshes->DrawTorusMesh();
-	
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.28f, .28f, 0.4f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.8f, 7.6f, -2.6f);
+	m_basicMeshes->DrawTorusMeshLOD(GetObjectBounds(m_basicMeshes->GetTorusBounds()));
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.bottleRim);
 
 	// draw the mesh with transformation values - this torus is used for the rim on top of the bottle
-	m_basicMeshes->DrawTorusMesh();
+	m_basicMeshes->DrawTorusMeshLOD(GetObjectBounds(m_basicMeshes->GetTorusBounds()));
 }
 
 /***********************************************************
@@ -1225,282 +2303,33 @@ void SceneManager::RenderWineBottle()
  ***********************************************************/
 void SceneManager::RenderGrapes()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.23f, 0.21f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.3f, 0.7f, 1.1f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.23f, 0.21f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.6f, 0.7f, 1.4f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.23f, 0.21f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.1f, 0.7f, 1.5f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.22f, 0.19f, 0.18f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.3f, 0.96f, 1.28f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.23f, 0.21f, 0.2f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.9f, 0.7f, 1.3f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.21f, 0.19f, 0.17f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.5f, 0.7f, 1.4f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.22f, 0.19f, 0.17f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.76f, 0.95f, 1.44f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.21f, 0.19f, 0.17f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.7f, 0.7f, 1.6f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.18f, 0.16f, 0.15f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.30f, .70f, 1.6f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(.2, 0.1, .4, 1.0);
-	SetShaderMaterial("grape");
-
-	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawSphereMesh();
-
-	/*** Set needed transformations before drawing the basic mesh ***/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.02f, 0.90f, 0.02f);
+	// the grapes are identical spheres that only differ in size
+	// and position, so they are all drawn with one instanced call
+	glm::mat4 grapeModels[GRAPE_COUNT];
+	glm::vec4 grapeColors[GRAPE_COUNT];
+	for (int i = 0; i < GRAPE_COUNT; i++)
+	{
+		grapeModels[i] = m_sceneGraph.GetWorldMatrix(m_sceneNodes.grapes[i]);
+		grapeColors[i] = glm::vec4(.2, 0.1, .4, 1.0);
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 15.0f;
-	ZrotationDegrees = 100.0f;
+	// the per-instance colors are multiplied with the object color
+	SetShaderColor(1, 1, 1, 1.0);
+	SetShaderMaterial(m_sceneMaterials.grape);
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(4.0f, 0.85f, 1.14f);
+	// draw all of the grapes with a single draw call
+	SetShaderInstancing(true);
+	m_basicMeshes->DrawSphereMeshInstanced(grapeModels, grapeColors, GRAPE_COUNT);
+	SetShaderInstancing(false);
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.grapeStem);
 
 	SetShaderColor(.2, 0.4, .2, 1.0);
-	SetShaderMaterial("grape");
+	SetShaderMaterial(m_sceneMaterials.grape);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawCylinderMesh();
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()));
 }
 
 /***********************************************************
@@ -1511,200 +2340,72 @@ void SceneManager::RenderGrapes()
  ***********************************************************/
 void SceneManager::RenderPlateAndKnife()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
 	/*** Set needed transformations before drawing the basic mesh.  ***/
 	/*** This same ordering of code should be used for transforming ***/
 	/*** and drawing all the basic 3D shapes.						***/
 	/******************************************************************/
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.46f, 0.08f, 0.46f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.7f, 0.55f, 1.8f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.plateBase);
 
 	SetShaderColor(1, 1, 1, 1.0);
-	SetShaderMaterial("plate");
+	SetShaderMaterial(m_sceneMaterials.plate);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawCylinderMesh();
-	/******************************************************************/
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()));
 	/******************************************************************/
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.06f, 0.1f, 1.06f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 180.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.7f, .71f, 1.8f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	SetTransformations(m_sceneNodes.plateDish);
 
 	SetShaderColor(1, 1, 1, 1.0);
-	SetShaderMaterial("plate");
+	SetShaderMaterial(m_sceneMaterials.plate);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawHalfSphereMesh();
-	/******************************************************************/
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
+	m_basicMeshes->DrawHalfSphereMeshLOD(GetObjectBounds(m_basicMeshes->GetSphereBounds()));
 	/******************************************************************/
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.3f, 0.18f, 0.20f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 20.0f;
-	ZrotationDegrees = 4.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.2f, .64f, 1.9f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderTexture("knifehandle");
+	SetTransformations(m_sceneNodes.knifeHandle);
+
+	SetShaderTexture(m_sceneTextures.knifeHandle);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
+	SetShaderMaterial(m_sceneMaterials.wood);
 
 	// draw the mesh with transformation values - this plane is used for the base
 	m_basicMeshes->DrawBoxMesh();
 	/******************************************************************/
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.2f, 2.0f, 0.01f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 110.0f;
-	ZrotationDegrees = 4.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.2f, .75f, 1.395f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderTexture("stainless");
+	SetTransformations(m_sceneNodes.knifeBlade);
+
+	SetShaderTexture(m_sceneTextures.stainless);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	SetShaderMaterial(m_sceneMaterials.metal);
 
 	// draw the mesh with transformation values - this plane is used for the base
 	m_basicMeshes->DrawPyramid4Mesh();
 	/******************************************************************/
-	
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(.6f, 0.25f, 1.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 8.0f;
-	YrotationDegrees = -140.0f;
-	ZrotationDegrees = -6.4f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(1.1f, .785f, 2.2f);
 
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderTexture("cheddar");
+	SetTransformations(m_sceneNodes.cheeseWedge);
+
+	SetShaderTexture(m_sceneTextures.cheddar);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("cheese");
+	SetShaderMaterial(m_sceneMaterials.cheese);
 
 	// draw the mesh with transformation values - this plane is used for the base
 	m_basicMeshes->DrawPrismMesh();
 	/******************************************************************/
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(0.05f, 0.186f, 0.05f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 4.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-.7f, 0.584f, 1.73f);
-
 	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderTexture("knifescrew");
+	SetTransformations(m_sceneNodes.knifeScrew);
+
+	SetShaderTexture(m_sceneTextures.knifeScrew);
 	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("metal");
+	SetShaderMaterial(m_sceneMaterials.metal);
 
 	// draw the mesh with transformation values - this plane is used for the base
-	m_basicMeshes->DrawCylinderMesh(true, true, false);
+	m_basicMeshes->DrawCylinderMeshLOD(GetObjectBounds(m_basicMeshes->GetCylinderBounds()), true, true, false);
 	/******************************************************************/
 }
\ No newline at end of file
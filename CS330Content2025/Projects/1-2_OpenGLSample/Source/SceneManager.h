@@ -27,7 +27,17 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "UniformBlocks.h"
+#include "RenderQueue.h"
+#include "SceneBVH.h"
+#include "SceneGraph.h"
+#include "ViewFrustum.h"
+#include "GPUProfiler.h"
+#include "TagRegistry.h"
+#include "TextureArray.h"
+#include "TextureLoader.h"
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -35,9 +45,16 @@
  *  SceneManager
  *
  *  This class contains the code for preparing and rendering
- *  3D scenes, including the shader settings.
+ *  3D scenes, including the shader settings.  In batched
+ *  mode it records the draws of the packed meshes and
+ *  submits them with indirect draw commands.  The objects
+ *  outside of the view frustum are skipped, with the help
+ *  of a bounding volume hierarchy over the drawn objects.
+ *  The model matrices come from a retained scene graph.
+ *  The draws of a frame are sorted by their state and depth
+ *  in a render queue before they are submitted.
  ***********************************************************/
-class SceneManager
+class SceneManager : private ShapeMeshes::DrawRecorder, private ShapeMeshes::DrawFilter
 {
 public:
 	// constructor
@@ -50,6 +67,10 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// the layer and rectangle of the image when the textures
+		// are packed into the texture array
+		int layer;
+		glm::vec4 rect;
 	};
 
 	// properties for object materials
@@ -61,38 +82,248 @@ public:
 		std::string tag;
 	};
 
+	// pre-resolved handles for the uniforms set on every draw
+	struct SHADER_UNIFORMS
+	{
+		ShaderManager::UniformHandle model;
+		ShaderManager::UniformHandle objectColor;
+		ShaderManager::UniformHandle objectTexture;
+		ShaderManager::UniformHandle useInstancing;
+		ShaderManager::UniformHandle useBatching;
+		ShaderManager::UniformHandle UVscale;
+		ShaderManager::UniformHandle textureLayer;
+		ShaderManager::UniformHandle textureRect;
+		ShaderManager::UniformHandle diffuseColor;
+		ShaderManager::UniformHandle specularColor;
+		ShaderManager::UniformHandle shininess;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes *m_basicMeshes;
+	// pointer to the GPU profiler, if the GPU times are measured
+	GPUProfiler* m_pGPUProfiler;
 	// total number of loaded textures
 	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
+	// loaded textures info, indexed by the handles of their tags
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	TagRegistry m_textureTags;
+	// loader of the texture images, while they are loaded in
+	// the background
+	bool m_bAsyncTextureLoading;
+	TextureLoader* m_pTextureLoader;
+	// compress the textures into blocks
+	bool m_bCompressTextures;
+	// pack the textures into the layers of one array texture, so
+	// that textured draws do not have to change the bound texture
+	bool m_bTextureArrays;
+	TextureArray* m_pTextureArray;
+	// defined object materials, indexed by the handles of their tags
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	TagRegistry m_materialTags;
+	// uniform handles used by the per-object shader setters
+	SHADER_UNIFORMS m_uniforms;
+
+	// range of recorded draw commands that use the same shader
+	// variant and texture
+	struct DRAW_BATCH
+	{
+		size_t firstCommand;
+		size_t commandCount;
+		int shaderVariant;
+		int textureSlot;
+	};
+
+	// a recorded draw with the object values it is drawn with -
+	// instanced draws also keep the model and color of every
+	// instance
+	struct DRAW_PACKET
+	{
+		ShapeMeshes::DRAW_COMMAND command;
+		size_t objectIndex;
+		size_t firstInstance;
+		int textureSlot;
+		bool bInstanced;
+	};
+
+	// true when the draws are batched into indirect draw commands
+	bool m_bBatchedRendering;
+	// true when the driver and shaders support batched drawing
+	bool m_bBatchingSupported;
+	// true while the draws of the scene are being recorded
+	bool m_bRecordingDraws;
+	// per-object values set by the shader setters, recorded with
+	// each draw
+	OBJECT_DATA m_currentObject;
+	int m_currentTextureSlot;
+	int m_currentMaterial;
+	// true when the current object values have not been recorded
+	bool m_bObjectChanged;
+	// groups of shader uniforms that are out of date with the
+	// current object values, written before the next direct draw
+	unsigned int m_changedUniforms;
+	// distance of the object of the next recorded draw from the
+	// camera, found while culling it
+	float m_drawDepth;
+	// the draws recorded since the last submission, and the queue
+	// that sorts them
+	std::vector<DRAW_PACKET> m_drawPackets;
+	std::vector<OBJECT_DATA> m_packetObjects;
+	std::vector<glm::mat4> m_instanceModels;
+	std::vector<glm::vec4> m_instanceColors;
+	RenderQueue m_renderQueue;
+	// sort numbers of the recorded meshes, by their first index
+	// in the packed index buffer
+	std::map<GLuint, unsigned int> m_meshSortIDs;
+	// the sorted draws, as submitted in batched mode
+	std::vector<OBJECT_DATA> m_objectData;
+	std::vector<ShapeMeshes::DRAW_COMMAND> m_drawCommands;
+	std::vector<DRAW_BATCH> m_drawBatches;
+	// storage buffer holding the recorded object data
+	GLuint m_objectBuffer;
+	// the shader variants for untextured (0) and textured (1)
+	// objects, and the values of the draw mode uniforms that
+	// every variant is given
+	int m_shaderVariants[2];
+	// the defines of the active light sources, which every
+	// variant is compiled with
+	std::vector<std::string> m_lightDefines;
+	bool m_bShaderInstancing;
+	bool m_bShaderBatching;
+
+	// a drawn object of the scene - the draws of every frame are
+	// matched to the objects in the order they are issued, and
+	// each instance of an instanced draw is an object of its own
+	struct SCENE_OBJECT
+	{
+		SceneBVH::BOX bounds;
+		unsigned int visibleFrame;
+	};
+
+	// visible volume of the camera for the current frame
+	ViewFrustum m_viewFrustum;
+	// the objects drawn by the last RenderScene(), and the
+	// hierarchy over their bounds
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	SceneBVH m_sceneBVH;
+	// number of the current frame, and the object that the next
+	// draw is matched to
+	unsigned int m_frameNumber;
+	size_t m_nextSceneObject;
+	// objects found by the last spatial query
+	std::vector<int> m_queryObjects;
+	// true once the current object has been counted as drawn or culled
+	bool m_bObjectCounted;
+	// number of objects drawn and culled by the last RenderScene()
+	unsigned int m_drawnObjectCount;
+	unsigned int m_culledObjectCount;
+
+	// number of grapes in the bunch, which are drawn together
+	static const int GRAPE_COUNT = 9;
+
+	// the nodes for the parts of the scene - each object has a
+	// root node, with the parts that are drawn below it
+	struct SCENE_NODES
+	{
+		int table;
+		int tableTop;
+		int backdrop;
+		int backdropPlane;
+		int cheeseWheel;
+		int cheeseWheelBody;
+		int breadLoaf;
+		int breadTop;
+		int breadBottom;
+		int wineGlass;
+		int glassBase;
+		int glassStemFoot;
+		int glassStem;
+		int glassStemTop;
+		int glassWine;
+		int glassBowl;
+		int wineBottle;
+		int bottleBottom;
+		int bottleBody;
+		int bottleShoulder;
+		int bottleNeck;
+		int bottleLip;
+		int bottleRim;
+		int grapeBunch;
+		int grapes[GRAPE_COUNT];
+		int grapeStem;
+		int plateAndKnife;
+		int plateBase;
+		int plateDish;
+		int knifeHandle;
+		int knifeBlade;
+		int cheeseWedge;
+		int knifeScrew;
+	};
+
+	// retained transforms of the scene parts, whose world
+	// matrices are only calculated again after they moved
+	SceneGraph m_sceneGraph;
+	SCENE_NODES m_sceneNodes;
+
+	// the handles of the textures and materials the scene is
+	// drawn with, found once by their tags
+	struct SCENE_TEXTURES
+	{
+		int table;
+		int backdrop;
+		int cheeseWheelSide;
+		int cheeseWheelTop;
+		int breadcrust;
+		int knifeHandle;
+		int stainless;
+		int cheddar;
+		int knifeScrew;
+	};
+	struct SCENE_MATERIALS
+	{
+		int metal;
+		int wood;
+		int glass;
+		int plate;
+		int cheese;
+		int bread;
+		int darkBread;
+		int backdrop;
+		int grape;
+	};
+	SCENE_TEXTURES m_sceneTextures;
+	SCENE_MATERIALS m_sceneMaterials;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// create a placeholder texture for an image file that is
+	// loaded in the background
+	bool CreatePlaceholderTexture(const char* filename, std::string tag);
+	// pack all of the scene textures into the texture array
+	bool CreateTextureArray();
+	// upload the texture images loaded since the last frame
+	void UpdateTextureLoading();
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
+	// add a loaded texture, or a defined material, under its
+	// tag - returns the handle of the tag, or -1 for a texture
+	// tag that is already used
+	int RegisterTexture(const TEXTURE_INFO& texture);
+	int RegisterMaterial(const OBJECT_MATERIAL& material);
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(const std::string& tag) const;
+	int FindTextureSlot(const std::string& tag) const;
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(const std::string& tag) const;
 
-	// set the transformation values 
+	// set the world matrix of a scene node
 	// into the transform buffer
 	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
+		int sceneNode);
 
 	// set the color values into the shader
 	void SetShaderColor(
@@ -101,17 +332,70 @@ private:
 		float blueColorValue,
 		float alphaValue);
 
-	// set the texture data into the shader
+	// set the texture data into the shader, by the handle
+	// of the texture
 	void SetShaderTexture(
-		std::string textureTag);
+		int textureHandle);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
 		float u, float v);
 
-	// set the object material into the shader
+	// set the object material into the shader, by the
+	// handle of the material
 	void SetShaderMaterial(
-		std::string materialTag);
+		int materialHandle);
+
+	// switch the shader between the model uniform and
+	// the per-instance model matrices
+	void SetShaderInstancing(
+		bool bUseInstancing);
+
+	// record a draw of the packed meshes with the current
+	// object values, and submit the recorded draws
+	void RecordDraw(
+		const ShapeMeshes::DRAW_COMMAND& command,
+		const glm::mat4* models,
+		const glm::vec4* colors) override;
+	void FlushDraws() override;
+	// submit the sorted draws with indirect draw commands, or
+	// with one draw call each and only the changed uniforms
+	void SubmitBatchedDraws();
+	void SubmitDirectDraws();
+	// skip the draws of the objects outside of the view frustum
+	bool AcceptDraw(
+		const ShapeMeshes::BOUNDING_SPHERE& meshBounds,
+		const glm::mat4* models,
+		size_t instanceCount) override;
+	// set the changed object values into the shader uniforms
+	void ApplyObjectUniforms();
+	// make the untextured or the textured shader variant current
+	void UseShaderVariant(int variant);
+	// define the shader variants for the active light sources
+	void DefineShaderVariants(
+		const LIGHT_BLOCK& lights,
+		int activePointLights);
+	// define the textured shader variant for the array texture
+	// or for the single textures
+	void DefineTexturedVariant();
+	// calculate the world-space bounds of the current object
+	// from the bounds of its mesh
+	ShapeMeshes::BOUNDING_SPHERE GetObjectBounds(
+		const ShapeMeshes::BOUNDING_SPHERE& meshBounds) const;
+	// calculate the world-space box around a transformed mesh
+	SceneBVH::BOX GetObjectBox(
+		const ShapeMeshes::BOUNDING_SPHERE& meshBounds,
+		const glm::mat4& model) const;
+	// match a draw to its scene object and return whether the
+	// object is inside of the view frustum
+	bool IsSceneObjectVisible(const SceneBVH::BOX& bounds);
+	// find the visible scene objects before the scene is drawn,
+	// and rebuild or refit the hierarchy after it was drawn
+	void BeginSceneObjects();
+	void EndSceneObjects();
+	// mark a region of the frame for the GPU profiler
+	void BeginGPURegion(const char* name);
+	void EndGPURegion();
 
 public:
 
@@ -120,12 +404,52 @@ public:
 	// render the objects in the 3D scene
 	void RenderScene();
 
+	// switch between batched indirect drawing and one draw
+	// call per object - batching is used only when supported
+	void SetBatchedRendering(bool bBatched);
+	bool IsBatchedRendering() const;
+	// number of draw calls issued by the last RenderScene()
+	unsigned int GetDrawCallCount() const;
+	// set the camera values that select the levels of detail
+	void SetLODView(const ShapeMeshes::LOD_VIEW& view);
+	// set the visible volume of the camera for culling the objects
+	void SetViewFrustum(const ViewFrustum& frustum);
+	// set the profiler that times the regions of the scene on the GPU
+	void SetGPUProfiler(GPUProfiler* pProfiler);
+	// load the texture images in the background, and wait for them
+	void SetAsyncTextureLoading(bool bAsync);
+	void FinishTextureLoading();
+	// compress the textures into BC1 or BC3 blocks when supported
+	void SetTextureCompression(bool bCompress);
+	// pack the textures into one texture array, or keep a texture
+	// for every image in its own texture unit
+	void SetTextureArrays(bool bTextureArrays);
+	// write the texture cache files of the scene textures, without
+	// a GL context - returns false if an image cannot be loaded
+	static bool BuildTextureCache(bool bRebuild, bool bCompress);
+	// number of objects drawn and skipped by the last RenderScene()
+	unsigned int GetDrawnObjectCount() const;
+	unsigned int GetCulledObjectCount() const;
+
+	// spatial queries over the objects drawn by the last
+	// RenderScene() - objects are numbered in drawing order
+	size_t GetSceneObjectCount() const;
+	int PickObject(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+	void FindObjectsInSphere(const glm::vec3& center, float radius, std::vector<int>& objects) const;
+	void FindObjectsInBox(const glm::vec3& minimum, const glm::vec3& maximum, std::vector<int>& objects) const;
+
 	// load all of the needed textures before rendering
 	void LoadSceneTextures();
 	// define all the object materials before rendering
 	void DefineObjectMaterials();
 	// add and define the light sources before rendering
 	void SetupSceneLights();
+	// add the scene nodes with the transforms of the
+	// object parts before rendering
+	void DefineSceneNodes();
+	// find the handles of the scene textures and materials
+	// before rendering
+	void FindSceneHandles();
 
 	// methods for rendering the various objects in the 3D scene
 	void RenderTable();
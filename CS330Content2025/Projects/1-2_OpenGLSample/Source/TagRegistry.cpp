@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.cpp
+// ===============
+// This file contains the implementation of the `TagRegistry` class, which
+// interns the tags of the scene textures and materials.
+//
+// RESPONSIBILITIES:
+// - Keep the tags in the order of their handles.
+// - Keep the handles in a linearly probed hash table.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TagRegistry.h"
+
+#include "FNVHash.h"
+
+#include <cstring>
+
+namespace
+{
+	// size of the hash table of an empty registry
+	const size_t INITIAL_SLOT_COUNT = 16;
+}
+
+/***********************************************************
+ *  TagRegistry()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TagRegistry::TagRegistry()
+{
+	m_slots.assign(INITIAL_SLOT_COUNT, -1);
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for giving a tag its handle.  A new
+ *  tag gets the next handle, and the table grows before it
+ *  would be more than 3/4 full.
+ ***********************************************************/
+int TagRegistry::Register(const std::string& tag)
+{
+	uint32_t hash = FNVHash::Hash32(tag.c_str(), tag.size());
+	size_t slot = FindSlot(tag.c_str(), tag.size(), hash);
+	if (m_slots[slot] >= 0)
+	{
+		return(m_slots[slot]);
+	}
+
+	if ((m_tags.size() + 1) * 4 > m_slots.size() * 3)
+	{
+		Grow();
+		slot = FindSlot(tag.c_str(), tag.size(), hash);
+	}
+
+	int handle = static_cast<int>(m_tags.size());
+	m_tags.push_back(tag);
+	m_tagHashes.push_back(hash);
+	m_slots[slot] = handle;
+
+	return(handle);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for finding the handle of a tag.
+ *  The tag is not copied into a string to be looked up.
+ ***********************************************************/
+int TagRegistry::Find(const char* tag) const
+{
+	size_t length = strlen(tag);
+	return(m_slots[FindSlot(tag, length, FNVHash::Hash32(tag, length))]);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for finding the handle of a tag.
+ ***********************************************************/
+int TagRegistry::Find(const std::string& tag) const
+{
+	return(m_slots[FindSlot(tag.c_str(), tag.size(), FNVHash::Hash32(tag.c_str(), tag.size()))]);
+}
+
+/***********************************************************
+ *  GetTag()
+ *
+ *  This method returns the tag of a handle.
+ ***********************************************************/
+const std::string& TagRegistry::GetTag(int handle) const
+{
+	return(m_tags[handle]);
+}
+
+/***********************************************************
+ *  GetCount()
+ *
+ *  This method returns the number of registered tags.
+ ***********************************************************/
+int TagRegistry::GetCount() const
+{
+	return(static_cast<int>(m_tags.size()));
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for forgetting every tag, so that
+ *  the handles start from 0 again.
+ ***********************************************************/
+void TagRegistry::Clear()
+{
+	m_tags.clear();
+	m_tagHashes.clear();
+	m_slots.assign(INITIAL_SLOT_COUNT, -1);
+}
+
+/***********************************************************
+ *  FindSlot()
+ *
+ *  This method is used for probing the hash table from the
+ *  slot of the hash to the slot of the tag, or to the first
+ *  empty slot.  The stored hashes are compared before the
+ *  characters, so most of the other tags on the way are
+ *  passed over without reading them.
+ ***********************************************************/
+size_t TagRegistry::FindSlot(const char* tag, size_t length, uint32_t hash) const
+{
+	size_t mask = m_slots.size() - 1;
+	size_t slot = hash & mask;
+	while (m_slots[slot] >= 0)
+	{
+		int handle = m_slots[slot];
+		if ((m_tagHashes[handle] == hash) &&
+			(m_tags[handle].size() == length) &&
+			(0 == memcmp(m_tags[handle].data(), tag, length)))
+		{
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return(slot);
+}
+
+/***********************************************************
+ *  Grow()
+ *
+ *  This method is used for doubling the size of the hash
+ *  table, and putting every handle back in from its stored
+ *  hash.
+ ***********************************************************/
+void TagRegistry::Grow()
+{
+	m_slots.assign(m_slots.size() * 2, -1);
+
+	size_t mask = m_slots.size() - 1;
+	for (size_t handle = 0; handle < m_tags.size(); handle++)
+	{
+		size_t slot = m_tagHashes[handle] & mask;
+		while (m_slots[slot] >= 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+		m_slots[slot] = static_cast<int>(handle);
+	}
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.h
+// =============
+// Defines the `TagRegistry` class, which turns the string tags of the scene
+// textures and materials into dense integer handles.
+//
+// RESPONSIBILITIES:
+// - Give every registered tag the next handle, or the handle it already has.
+// - Find the handle of a tag through an open-addressing hash table.
+// - Give back the tag of a handle.
+//
+// NOTE: The handles number the tags from 0 in the order they were first
+// registered, so they can index the arrays the textures and materials are
+// kept in.  The tags are only looked up while the scene is prepared - the
+// drawing code keeps the handles, and never compares a string.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TagRegistry
+ *
+ *  This class contains the code for interning tags into
+ *  integer handles.
+ ***********************************************************/
+class TagRegistry
+{
+public:
+	// constructor
+	TagRegistry();
+
+	// register a tag - returns its new handle, or the handle it
+	// was given when it was registered before
+	int Register(const std::string& tag);
+	// find the handle of a tag, or -1 if it was never registered
+	int Find(const char* tag) const;
+	int Find(const std::string& tag) const;
+	// the tag of a handle
+	const std::string& GetTag(int handle) const;
+	// number of registered tags
+	int GetCount() const;
+	// forget every tag
+	void Clear();
+
+private:
+	// the tags by handle, and the hash of each
+	std::vector<std::string> m_tags;
+	std::vector<uint32_t> m_tagHashes;
+	// the hash table of handles, with -1 for an empty slot - its
+	// size is a power of two, and it is at most 3/4 full
+	std::vector<int> m_slots;
+
+	// find the slot of a tag, or the empty slot it would go in
+	size_t FindSlot(const char* tag, size_t length, uint32_t hash) const;
+	// double the size of the hash table
+	void Grow();
+};
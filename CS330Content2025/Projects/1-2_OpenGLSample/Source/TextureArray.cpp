@@ -0,0 +1,565 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearray.cpp
+// ================
+// This file contains the implementation of the `TextureArray` class, which
+// packs the scene textures into the layers of an array texture.
+//
+// RESPONSIBILITIES:
+// - Read the sizes of the images and lay them out in the layers.
+// - Create the array texture with storage for all of its levels.
+// - Upload the levels of each image into its rectangle of its layer.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArray.h"
+
+#include "GLStateCache.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	// largest layer size, and most mipmap levels of the array
+	const int MAX_LAYER_SIZE = 2048;
+	const int MAX_ARRAY_LEVELS = 6;
+	// the grey the layers are filled with until their images
+	// arrive, like the placeholder of the single textures
+	const unsigned char PLACEHOLDER_GREY = 128;
+
+	// a row of packed images in a shared layer
+	struct SHELF
+	{
+		int layer;
+		int y;
+		int height;
+		int usedWidth;
+	};
+
+	///////////////////////////////////////////////////
+	//	RoundUp()
+	//
+	//	Round a size up to a multiple of the grid.
+	///////////////////////////////////////////////////
+	int RoundUp(int size, int grid)
+	{
+		return(((size + grid - 1) / grid) * grid);
+	}
+}
+
+/***********************************************************
+ *  TextureArray()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArray::TextureArray()
+{
+	m_textureID = 0;
+	m_textureUnit = 0;
+	m_bCompressed = false;
+	m_layerSize = 0;
+	m_layerCount = 0;
+	m_levelCount = 0;
+	m_gridSize = 4;
+}
+
+/***********************************************************
+ *  ~TextureArray()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArray::~TextureArray()
+{
+	if (0 != m_textureID)
+	{
+		glDeleteTextures(1, &m_textureID);
+		m_textureID = 0;
+	}
+}
+
+/***********************************************************
+ *  AddImage()
+ *
+ *  This method is used for adding an image file to the
+ *  array.  Only the header of the file is read here, for
+ *  the size of the image, so that the array can be laid
+ *  out before any image is decoded.
+ ***********************************************************/
+int TextureArray::AddImage(const std::string& filename)
+{
+	ARRAY_ENTRY entry;
+	entry.filename = filename;
+	entry.width = 0;
+	entry.height = 0;
+	entry.colorChannels = 0;
+	if ((0 == stbi_info(filename.c_str(), &entry.width, &entry.height, &entry.colorChannels)) ||
+		(entry.width <= 0) || (entry.height <= 0))
+	{
+		return(-1);
+	}
+
+	entry.firstLevel = 0;
+	entry.levelWidth = entry.width;
+	entry.levelHeight = entry.height;
+	entry.layer = 0;
+	entry.x = 0;
+	entry.y = 0;
+	entry.rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	m_entries.push_back(entry);
+
+	return(static_cast<int>(m_entries.size()) - 1);
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for laying out the added images and
+ *  creating the array texture.  The storage of every level
+ *  is made here, and filled with grey until the images are
+ *  uploaded into it.  The levels are only compressed into
+ *  BC1 blocks when every image is opaque, since the layers
+ *  all share one format.
+ ***********************************************************/
+bool TextureArray::Create(GLuint textureUnit, bool bCompress)
+{
+	if ((0 != m_textureID) || (m_entries.size() == 0))
+	{
+		return(false);
+	}
+
+	ChooseLayerSize();
+	PlaceImages();
+
+	m_bCompressed = bCompress;
+	for (const ARRAY_ENTRY& entry : m_entries)
+	{
+		if (entry.colorChannels != 3)
+		{
+			m_bCompressed = false;
+		}
+	}
+
+	// every layer of the array has to fit in the driver's limit
+	GLint maxLayerCount = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayerCount);
+	if (m_layerCount > maxLayerCount)
+	{
+		std::cout << "Could not create the texture array: " << m_layerCount << " layers, and at most "
+			<< maxLayerCount << " are supported" << std::endl;
+		return(false);
+	}
+
+	// errors from before are cleared, so that only the errors of
+	// the allocation are checked
+	while (GL_NO_ERROR != glGetError())
+	{
+	}
+
+	m_textureUnit = textureUnit;
+	glGenTextures(1, &m_textureID);
+	GLStateCache::BindTexture(m_textureUnit, GL_TEXTURE_2D_ARRAY, m_textureID);
+
+	// the shader tiles the images inside their rectangles, so the
+	// array itself is never wrapped
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	// set texture filtering parameters like for the single textures
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1);
+
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		int levelSize = m_layerSize >> level;
+		if (true == m_bCompressed)
+		{
+			size_t layerBytes = BlockEncoder::GetImageSize(BlockEncoder::BLOCK_BC1, levelSize, levelSize);
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+				levelSize, levelSize, m_layerCount, 0, static_cast<GLsizei>(layerBytes * m_layerCount), NULL);
+		}
+		else
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8,
+				levelSize, levelSize, m_layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+	}
+	FillLayers();
+
+	GLenum error = glGetError();
+	if (GL_NO_ERROR != error)
+	{
+		std::cout << "Could not create the texture array: GL error 0x" << std::hex << error << std::dec << std::endl;
+		GLStateCache::BindTexture(m_textureUnit, GL_TEXTURE_2D_ARRAY, 0);
+		glDeleteTextures(1, &m_textureID);
+		m_textureID = 0;
+		return(false);
+	}
+
+	std::cout << "INFO: Texture array of " << m_layerCount << " layers of " << m_layerSize << "x" << m_layerSize
+		<< ", " << m_levelCount << " levels, " << (true == m_bCompressed ? "BC1" : "RGBA8")
+		<< ", for " << m_entries.size() << " images" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  UploadImage()
+ *
+ *  This method is used for uploading the levels of a loaded
+ *  image into its rectangle of its layer, starting from the
+ *  level of the image that is stored as the first level of
+ *  the array.  The compressed levels are uploaded in whole
+ *  blocks, which the grid of the rectangles leaves room for.
+ ***********************************************************/
+bool TextureArray::UploadImage(int entry, const CachedTexture& image, bool bFromPixelBuffer) const
+{
+	const ARRAY_ENTRY& arrayEntry = m_entries[entry];
+	if ((image.GetWidth() != arrayEntry.width) ||
+		(image.GetHeight() != arrayEntry.height) ||
+		(image.IsCompressed() != m_bCompressed))
+	{
+		std::cout << "Could not place image in the texture array:" << arrayEntry.filename << std::endl;
+		return(false);
+	}
+
+	GLStateCache::BindTexture(m_textureUnit, GL_TEXTURE_2D_ARRAY, m_textureID);
+	GLenum format = (image.GetColorChannels() == 3) ? GL_RGB : GL_RGBA;
+
+	// the rows of the small levels are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		int imageLevel = arrayEntry.firstLevel + level;
+		if (imageLevel >= image.GetLevelCount())
+		{
+			break;
+		}
+
+		const CachedTexture::MIP_LEVEL& mipLevel = image.GetLevel(imageLevel);
+		const void* pixels = image.GetLevelSource(imageLevel, bFromPixelBuffer);
+		if (true == m_bCompressed)
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level,
+				arrayEntry.x >> level, arrayEntry.y >> level, arrayEntry.layer,
+				RoundUp(mipLevel.width, 4), RoundUp(mipLevel.height, 4), 1,
+				GL_COMPRESSED_RGB_S3TC_DXT1_EXT, static_cast<GLsizei>(mipLevel.size), pixels);
+		}
+		else
+		{
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level,
+				arrayEntry.x >> level, arrayEntry.y >> level, arrayEntry.layer,
+				mipLevel.width, mipLevel.height, 1, format, GL_UNSIGNED_BYTE, pixels);
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetTextureID()
+ *
+ *  This method returns the name of the array texture.
+ ***********************************************************/
+GLuint TextureArray::GetTextureID() const
+{
+	return(m_textureID);
+}
+
+/***********************************************************
+ *  GetTextureUnit()
+ *
+ *  This method returns the texture unit the array texture
+ *  is bound to.
+ ***********************************************************/
+GLuint TextureArray::GetTextureUnit() const
+{
+	return(m_textureUnit);
+}
+
+/***********************************************************
+ *  IsCompressed()
+ *
+ *  This method returns true when the levels of the array
+ *  are BC1 blocks.
+ ***********************************************************/
+bool TextureArray::IsCompressed() const
+{
+	return(m_bCompressed);
+}
+
+/***********************************************************
+ *  GetLayerCount()
+ *
+ *  This method returns the number of layers.
+ ***********************************************************/
+int TextureArray::GetLayerCount() const
+{
+	return(m_layerCount);
+}
+
+/***********************************************************
+ *  GetLayerSize()
+ *
+ *  This method returns the width and height of the layers.
+ ***********************************************************/
+int TextureArray::GetLayerSize() const
+{
+	return(m_layerSize);
+}
+
+/***********************************************************
+ *  GetEntryCount()
+ *
+ *  This method returns the number of added images.
+ ***********************************************************/
+int TextureArray::GetEntryCount() const
+{
+	return(static_cast<int>(m_entries.size()));
+}
+
+/***********************************************************
+ *  GetEntry()
+ *
+ *  This method returns the place of an added image.
+ ***********************************************************/
+const TextureArray::ARRAY_ENTRY& TextureArray::GetEntry(int entry) const
+{
+	return(m_entries[entry]);
+}
+
+/***********************************************************
+ *  FillLayers()
+ *
+ *  This method is used for filling every level of every
+ *  layer with grey, since the storage made without data is
+ *  undefined.  The driver clears the uncompressed levels
+ *  itself when it supports clearing textures, and the other
+ *  levels are uploaded a layer at a time from one buffer of
+ *  grey texels, or of grey BC1 blocks.
+ ***********************************************************/
+void TextureArray::FillLayers() const
+{
+	const unsigned char greyTexel[4] = { PLACEHOLDER_GREY, PLACEHOLDER_GREY, PLACEHOLDER_GREY, 255 };
+
+	if ((false == m_bCompressed) && ((GL_TRUE == GLEW_VERSION_4_4) || (GL_TRUE == GLEW_ARB_clear_texture)))
+	{
+		for (int level = 0; level < m_levelCount; level++)
+		{
+			int levelSize = m_layerSize >> level;
+			glClearTexSubImage(m_textureID, level, 0, 0, 0, levelSize, levelSize, m_layerCount,
+				GL_RGBA, GL_UNSIGNED_BYTE, greyTexel);
+		}
+		return;
+	}
+
+	// a compressed layer is filled with copies of one grey block
+	unsigned char greyBlock[8] = {};
+	if (true == m_bCompressed)
+	{
+		unsigned char greyTexels[4 * 4 * 3];
+		memset(greyTexels, PLACEHOLDER_GREY, sizeof(greyTexels));
+		BlockEncoder::EncodeImage(greyTexels, 4, 4, 3, BlockEncoder::BLOCK_BC1, greyBlock, 1);
+	}
+
+	std::vector<unsigned char> fill;
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		int levelSize = m_layerSize >> level;
+		if (true == m_bCompressed)
+		{
+			size_t layerBytes = BlockEncoder::GetImageSize(BlockEncoder::BLOCK_BC1, levelSize, levelSize);
+			if (fill.size() != layerBytes)
+			{
+				fill.resize(layerBytes);
+				for (size_t offset = 0; offset < layerBytes; offset += sizeof(greyBlock))
+				{
+					memcpy(&fill[offset], greyBlock, sizeof(greyBlock));
+				}
+			}
+			for (int layer = 0; layer < m_layerCount; layer++)
+			{
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelSize, levelSize, 1,
+					GL_COMPRESSED_RGB_S3TC_DXT1_EXT, static_cast<GLsizei>(layerBytes), fill.data());
+			}
+		}
+		else
+		{
+			size_t texelCount = static_cast<size_t>(levelSize) * levelSize;
+			if (fill.size() != texelCount * 4)
+			{
+				fill.resize(texelCount * 4);
+				for (size_t texel = 0; texel < texelCount; texel++)
+				{
+					memcpy(&fill[texel * 4], greyTexel, sizeof(greyTexel));
+				}
+			}
+			for (int layer = 0; layer < m_layerCount; layer++)
+			{
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelSize, levelSize, 1,
+					GL_RGBA, GL_UNSIGNED_BYTE, fill.data());
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ChooseLayerSize()
+ *
+ *  This method is used for choosing the layer size, which
+ *  is the size of the most common square image so that
+ *  those images fill whole layers.  When no size is shared,
+ *  the layers are as large as the largest image.  The size
+ *  is limited by the driver and rounded up to the grid.
+ ***********************************************************/
+void TextureArray::ChooseLayerSize()
+{
+	GLint maxTextureSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	int sizeLimit = ((maxTextureSize > 0) && (maxTextureSize < MAX_LAYER_SIZE)) ? maxTextureSize : MAX_LAYER_SIZE;
+
+	int layerSize = 0;
+	int layerSizeCount = 0;
+	int largestSize = 0;
+	for (const ARRAY_ENTRY& entry : m_entries)
+	{
+		largestSize = std::max(largestSize, std::max(entry.width, entry.height));
+		if ((entry.width != entry.height) || (entry.width > sizeLimit))
+		{
+			continue;
+		}
+
+		int sizeCount = 0;
+		for (const ARRAY_ENTRY& other : m_entries)
+		{
+			if ((other.width == entry.width) && (other.height == entry.height))
+			{
+				sizeCount++;
+			}
+		}
+		if ((sizeCount > layerSizeCount) || ((sizeCount == layerSizeCount) && (entry.width > layerSize)))
+		{
+			layerSize = entry.width;
+			layerSizeCount = sizeCount;
+		}
+	}
+	if (layerSizeCount < 2)
+	{
+		layerSize = std::min(largestSize, sizeLimit);
+	}
+
+	// every level keeps at least a block of texels per layer
+	m_levelCount = 1;
+	while ((m_levelCount < MAX_ARRAY_LEVELS) && ((layerSize >> m_levelCount) >= 4))
+	{
+		m_levelCount++;
+	}
+	m_gridSize = 4 << (m_levelCount - 1);
+	m_layerSize = std::min(RoundUp(layerSize, m_gridSize), (sizeLimit / m_gridSize) * m_gridSize);
+}
+
+/***********************************************************
+ *  PlaceImages()
+ *
+ *  This method is used for giving every image its layer.
+ *  The images of the layer size fill a layer each, and the
+ *  others are packed into shared layers on shelves, from
+ *  the tallest to the shortest, with their sizes rounded up
+ *  to the grid.  Each image goes on the first shelf it fits
+ *  on, or on a new shelf or layer.
+ ***********************************************************/
+void TextureArray::PlaceImages()
+{
+	m_layerCount = 0;
+
+	std::vector<int> packedEntries;
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		ARRAY_ENTRY& entry = m_entries[i];
+		entry.firstLevel = 0;
+		while (((entry.width >> entry.firstLevel) > m_layerSize) || ((entry.height >> entry.firstLevel) > m_layerSize))
+		{
+			entry.firstLevel++;
+		}
+		entry.levelWidth = std::max(1, entry.width >> entry.firstLevel);
+		entry.levelHeight = std::max(1, entry.height >> entry.firstLevel);
+
+		if ((entry.levelWidth == m_layerSize) && (entry.levelHeight == m_layerSize))
+		{
+			entry.layer = m_layerCount++;
+			entry.x = 0;
+			entry.y = 0;
+		}
+		else
+		{
+			packedEntries.push_back(static_cast<int>(i));
+		}
+	}
+
+	std::stable_sort(packedEntries.begin(), packedEntries.end(), [this](int a, int b)
+	{
+		return m_entries[a].levelHeight > m_entries[b].levelHeight;
+	});
+
+	std::vector<SHELF> shelves;
+	std::vector<int> layerHeights;
+	int firstPackedLayer = m_layerCount;
+	for (int index : packedEntries)
+	{
+		ARRAY_ENTRY& entry = m_entries[index];
+		int width = RoundUp(entry.levelWidth, m_gridSize);
+		int height = RoundUp(entry.levelHeight, m_gridSize);
+
+		SHELF* pShelf = NULL;
+		for (SHELF& shelf : shelves)
+		{
+			if ((height <= shelf.height) && (shelf.usedWidth + width <= m_layerSize))
+			{
+				pShelf = &shelf;
+				break;
+			}
+		}
+
+		if (NULL == pShelf)
+		{
+			SHELF shelf;
+			shelf.layer = -1;
+			shelf.height = height;
+			shelf.usedWidth = 0;
+			for (size_t layer = 0; layer < layerHeights.size(); layer++)
+			{
+				if (layerHeights[layer] + height <= m_layerSize)
+				{
+					shelf.layer = firstPackedLayer + static_cast<int>(layer);
+					break;
+				}
+			}
+			if (shelf.layer < 0)
+			{
+				shelf.layer = m_layerCount++;
+				layerHeights.push_back(0);
+			}
+			shelf.y = layerHeights[shelf.layer - firstPackedLayer];
+			layerHeights[shelf.layer - firstPackedLayer] += height;
+			shelves.push_back(shelf);
+			pShelf = &shelves.back();
+		}
+
+		entry.layer = pShelf->layer;
+		entry.x = pShelf->usedWidth;
+		entry.y = pShelf->y;
+		pShelf->usedWidth += width;
+	}
+
+	float layerSize = static_cast<float>(m_layerSize);
+	for (ARRAY_ENTRY& entry : m_entries)
+	{
+		entry.rect = glm::vec4(
+			entry.x / layerSize,
+			entry.y / layerSize,
+			entry.levelWidth / layerSize,
+			entry.levelHeight / layerSize);
+	}
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearray.h
+// ==============
+// Defines the `TextureArray` class, which keeps every scene texture in the
+// layers of a single GL_TEXTURE_2D_ARRAY, so that objects with different
+// textures can be drawn by one draw call.
+//
+// RESPONSIBILITIES:
+// - Choose the size of the layers from the sizes of the images.
+// - Give each image of the layer size a layer of its own, and pack the
+//   other images into shared layers with a shelf packer.
+// - Upload the mipmap levels of the loaded images into their places.
+//
+// NOTE: Each image is drawn through its layer and its rectangle of the layer
+// in texture coordinates, which the shader tiles the image in.  An image
+// that is larger than a layer is stored from its first mipmap level that
+// fits.  The rectangles are placed on a grid that keeps them on whole
+// compressed blocks at every level of the array, and the array has only as
+// many levels as the grid allows.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureCache.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureArray
+ *
+ *  This class contains the code for packing the scene
+ *  textures into the layers of an array texture.
+ ***********************************************************/
+class TextureArray
+{
+public:
+	// constructor
+	TextureArray();
+	// destructor
+	~TextureArray();
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+
+	// the place of an image in the array
+	struct ARRAY_ENTRY
+	{
+		std::string filename;
+		int width;
+		int height;
+		int colorChannels;
+		// the mipmap level of the image stored as the first level
+		// of the array, and its size
+		int firstLevel;
+		int levelWidth;
+		int levelHeight;
+		// the layer, and the texel offset in the layer
+		int layer;
+		int x;
+		int y;
+		// offset and size of the image in texture coordinates
+		glm::vec4 rect;
+	};
+
+	// add an image file, whose size is read from its header -
+	// returns the entry, or -1 if the file cannot be read
+	int AddImage(const std::string& filename);
+	// place the images and create the array texture, bound to the
+	// passed in texture unit - the levels are compressed when asked
+	// for and every image is opaque
+	bool Create(GLuint textureUnit, bool bCompress);
+	// upload the levels of a loaded image into its place, from the
+	// bound pixel buffer when its pixels were copied into it
+	bool UploadImage(int entry, const CachedTexture& image, bool bFromPixelBuffer) const;
+
+	GLuint GetTextureID() const;
+	GLuint GetTextureUnit() const;
+	bool IsCompressed() const;
+	int GetLayerCount() const;
+	int GetLayerSize() const;
+	int GetEntryCount() const;
+	const ARRAY_ENTRY& GetEntry(int entry) const;
+
+private:
+	std::vector<ARRAY_ENTRY> m_entries;
+	GLuint m_textureID;
+	GLuint m_textureUnit;
+	bool m_bCompressed;
+	int m_layerSize;
+	int m_layerCount;
+	int m_levelCount;
+	// spacing of the grid the packed images are placed on
+	int m_gridSize;
+
+	// choose the layer size from the most common image size
+	void ChooseLayerSize();
+	// give every image its layer and its place in the layer
+	void PlaceImages();
+	// fill the layers with grey until the images arrive
+	void FillLayers() const;
+};
@@ -0,0 +1,774 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ================
+// This file contains the implementation of the `MappedFile` and
+// `CachedTexture` classes, which load the texture images with their mipmap
+// levels from cache files.
+//
+// RESPONSIBILITIES:
+// - Map files into memory on Windows and on POSIX systems.
+// - Check, read and write the texture cache files.
+// - Decode the images and build their mipmap levels on a cache miss.
+// - Compress the levels into blocks when it is asked for.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+
+#include "FNVHash.h"
+#include "ZoneProfiler.h"
+#include "stb_image.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// most mipmap levels of an image, enough for 32768 texels
+	const uint32_t MAX_CACHE_LEVELS = 16;
+
+}
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#endif
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a whole file into memory
+ *  for reading.  An empty file cannot be mapped.
+ ***********************************************************/
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef _WIN32
+	m_fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == m_fileHandle)
+	{
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	if ((FALSE == GetFileSizeEx(m_fileHandle, &fileSize)) || (fileSize.QuadPart <= 0))
+	{
+		Close();
+		return(false);
+	}
+
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == m_mappingHandle)
+	{
+		Close();
+		return(false);
+	}
+
+	m_pData = static_cast<const unsigned char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return(false);
+	}
+
+	struct stat fileStatus;
+	if ((fstat(file, &fileStatus) != 0) || (fileStatus.st_size <= 0))
+	{
+		close(file);
+		return(false);
+	}
+
+	void* mapping = mmap(NULL, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping stays valid after the file is closed
+	close(file);
+	if (MAP_FAILED != mapping)
+	{
+		m_pData = static_cast<const unsigned char*>(mapping);
+		m_size = static_cast<size_t>(fileStatus.st_size);
+	}
+#endif
+
+	if (NULL == m_pData)
+	{
+		Close();
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the file.
+ ***********************************************************/
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle(m_mappingHandle);
+		m_mappingHandle = NULL;
+	}
+	if (INVALID_HANDLE_VALUE != m_fileHandle)
+	{
+		CloseHandle(m_fileHandle);
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (NULL != m_pData)
+	{
+		munmap(const_cast<unsigned char*>(m_pData), m_size);
+	}
+#endif
+	m_pData = NULL;
+	m_size = 0;
+}
+
+/***********************************************************
+ *  GetData()
+ *
+ *  This method returns the mapped bytes of the file.
+ ***********************************************************/
+const unsigned char* MappedFile::GetData() const
+{
+	return(m_pData);
+}
+
+/***********************************************************
+ *  GetSize()
+ *
+ *  This method returns the size of the mapped file.
+ ***********************************************************/
+size_t MappedFile::GetSize() const
+{
+	return(m_size);
+}
+
+/***********************************************************
+ *  CachedTexture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CachedTexture::CachedTexture()
+{
+	m_width = 0;
+	m_height = 0;
+	m_colorChannels = 0;
+	m_bFromCache = false;
+	m_format = FORMAT_UNCOMPRESSED;
+	m_psnr = 0.0;
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for loading an image with all of its
+ *  mipmap levels.  The image file is hashed to find its
+ *  cache file, whose levels are used straight from the
+ *  mapped file.  Only when there is no valid cache file, or
+ *  when it is rebuilt, is the image decoded and the cache
+ *  file written.  The compressed levels have a cache file
+ *  of their own, and are encoded on the passed in number
+ *  of threads, or on every core for 0, which a caller that
+ *  already loads on several threads keeps at 1.  This
+ *  method makes no GL calls, so it can be run on any
+ *  thread.
+ ***********************************************************/
+bool CachedTexture::Load(const std::string& filename, bool bCompress, bool bRebuild, unsigned int threadCount)
+{
+	PROFILE_ZONE("CachedTexture::Load");
+
+	m_width = 0;
+	m_height = 0;
+	m_colorChannels = 0;
+	m_bFromCache = false;
+	m_format = FORMAT_UNCOMPRESSED;
+	m_psnr = 0.0;
+	m_levels.clear();
+	m_builtPixels.clear();
+	m_cacheFile.Close();
+
+	unsigned long long sourceHash = 0;
+	{
+		MappedFile sourceFile;
+		if (false == sourceFile.Open(filename))
+		{
+			return(false);
+		}
+		sourceHash = FNVHash::Hash64(sourceFile.GetData(), sourceFile.GetSize());
+	}
+
+	std::string cacheFilename = GetCacheFilename(filename, sourceHash, bCompress);
+	if ((false == bRebuild) && (true == m_cacheFile.Open(cacheFilename)))
+	{
+		if (true == ReadCacheFile(sourceHash, bCompress))
+		{
+			m_bFromCache = true;
+			return(true);
+		}
+		// a stale or damaged cache file is replaced below
+		m_levels.clear();
+		m_format = FORMAT_UNCOMPRESSED;
+		m_colorChannels = 0;
+		m_cacheFile.Close();
+	}
+
+	if (false == BuildLevels(filename))
+	{
+		return(false);
+	}
+	if (true == bCompress)
+	{
+		if (0 == threadCount)
+		{
+			threadCount = std::thread::hardware_concurrency();
+		}
+		CompressLevels((threadCount > 0) ? threadCount : 1);
+	}
+	WriteCacheFile(cacheFilename, sourceHash);
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsFromCache()
+ *
+ *  This method returns true when the image was loaded from
+ *  its cache file.
+ ***********************************************************/
+bool CachedTexture::IsFromCache() const
+{
+	return(m_bFromCache);
+}
+
+/***********************************************************
+ *  IsCompressed()
+ *
+ *  This method returns true when the levels are compressed
+ *  into blocks.
+ ***********************************************************/
+bool CachedTexture::IsCompressed() const
+{
+	return(FORMAT_UNCOMPRESSED != m_format);
+}
+
+/***********************************************************
+ *  GetFormatName()
+ *
+ *  This method returns the name of the format of the levels.
+ ***********************************************************/
+const char* CachedTexture::GetFormatName() const
+{
+	if (BlockEncoder::BLOCK_BC1 == m_format)
+	{
+		return("BC1");
+	}
+	if (BlockEncoder::BLOCK_BC3 == m_format)
+	{
+		return("BC3");
+	}
+	return((m_colorChannels == 3) ? "RGB8" : "RGBA8");
+}
+
+/***********************************************************
+ *  GetPSNR()
+ *
+ *  This method returns the peak signal to noise ratio in dB
+ *  of the compressed image against the decoded image, or 0
+ *  when the levels are not compressed.
+ ***********************************************************/
+double CachedTexture::GetPSNR() const
+{
+	return(m_psnr);
+}
+
+/***********************************************************
+ *  GetWidth()
+ *
+ *  This method returns the width of the image.
+ ***********************************************************/
+int CachedTexture::GetWidth() const
+{
+	return(m_width);
+}
+
+/***********************************************************
+ *  GetHeight()
+ *
+ *  This method returns the height of the image.
+ ***********************************************************/
+int CachedTexture::GetHeight() const
+{
+	return(m_height);
+}
+
+/***********************************************************
+ *  GetColorChannels()
+ *
+ *  This method returns the number of color channels of the
+ *  image, which is 3 or 4.
+ ***********************************************************/
+int CachedTexture::GetColorChannels() const
+{
+	return(m_colorChannels);
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method returns the number of mipmap levels.
+ ***********************************************************/
+int CachedTexture::GetLevelCount() const
+{
+	return(static_cast<int>(m_levels.size()));
+}
+
+/***********************************************************
+ *  GetLevel()
+ *
+ *  This method returns a mipmap level of the image.
+ ***********************************************************/
+const CachedTexture::MIP_LEVEL& CachedTexture::GetLevel(int level) const
+{
+	return(m_levels[level]);
+}
+
+/***********************************************************
+ *  GetPixelSize()
+ *
+ *  This method returns the total size of the pixels of all
+ *  of the mipmap levels.
+ ***********************************************************/
+size_t CachedTexture::GetPixelSize() const
+{
+	size_t pixelSize = 0;
+	for (const MIP_LEVEL& level : m_levels)
+	{
+		pixelSize += level.size;
+	}
+	return(pixelSize);
+}
+
+/***********************************************************
+ *  CopyPixels()
+ *
+ *  This method is used for copying the pixels of all of the
+ *  mipmap levels into a buffer, one level after another.
+ ***********************************************************/
+void CachedTexture::CopyPixels(unsigned char* destination) const
+{
+	for (const MIP_LEVEL& level : m_levels)
+	{
+		memcpy(destination, level.pixels, level.size);
+		destination += level.size;
+	}
+}
+
+/***********************************************************
+ *  GetLevelSource()
+ *
+ *  This method returns the pointer that an upload of a level
+ *  reads the pixels from, which is the offset of the level
+ *  when the pixels of all of the levels were copied into
+ *  the bound pixel buffer.
+ ***********************************************************/
+const void* CachedTexture::GetLevelSource(int level, bool bFromPixelBuffer) const
+{
+	if (false == bFromPixelBuffer)
+	{
+		return(m_levels[level].pixels);
+	}
+
+	size_t bufferOffset = 0;
+	for (int i = 0; i < level; i++)
+	{
+		bufferOffset += m_levels[i].size;
+	}
+	return(reinterpret_cast<const void*>(bufferOffset));
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for uploading every mipmap level of
+ *  the image into the texture that is bound to
+ *  GL_TEXTURE_2D, so the driver does not have to generate
+ *  the mipmaps.  The levels are read from the bound pixel
+ *  buffer when the pixels were copied into it, and straight
+ *  from the mapped cache file otherwise.  The compressed
+ *  levels are uploaded as they are, without the driver
+ *  converting them.
+ ***********************************************************/
+void CachedTexture::Upload(bool bFromPixelBuffer) const
+{
+	PROFILE_ZONE("CachedTexture::Upload");
+
+	GLenum internalFormat = (m_colorChannels == 3) ? GL_RGB8 : GL_RGBA8;
+	GLenum format = (m_colorChannels == 3) ? GL_RGB : GL_RGBA;
+	if (BlockEncoder::BLOCK_BC1 == m_format)
+	{
+		internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+	else if (BlockEncoder::BLOCK_BC3 == m_format)
+	{
+		internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	}
+
+	// the rows of the small levels are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (size_t i = 0; i < m_levels.size(); i++)
+	{
+		const MIP_LEVEL& level = m_levels[i];
+		const void* pixels = GetLevelSource(static_cast<int>(i), bFromPixelBuffer);
+		if (FORMAT_UNCOMPRESSED != m_format)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), internalFormat,
+				level.width, level.height, 0, static_cast<GLsizei>(level.size), pixels);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), internalFormat,
+				level.width, level.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(m_levels.size()) - 1);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/***********************************************************
+ *  GetCacheFilename()
+ *
+ *  This method is used to build the name of the cache file
+ *  of an image, which is kept in the folder of the image.
+ ***********************************************************/
+std::string CachedTexture::GetCacheFilename(const std::string& filename, unsigned long long sourceHash, bool bCompressed)
+{
+	size_t separator = filename.find_last_of("/\\");
+	std::string directory = (separator != std::string::npos) ? filename.substr(0, separator) : ".";
+
+	char name[64];
+	snprintf(name, sizeof(name), (true == bCompressed) ? "/texture_%016llx_bc.bin" : "/texture_%016llx.bin", sourceHash);
+
+	return directory + name;
+}
+
+/***********************************************************
+ *  ReadCacheFile()
+ *
+ *  This method is used to check the mapped cache file, and
+ *  to point the mipmap levels at its pixels.  Returns false
+ *  when the file was made from another image or by another
+ *  version, or when it is cut short.
+ ***********************************************************/
+bool CachedTexture::ReadCacheFile(unsigned long long sourceHash, bool bCompressed)
+{
+	const unsigned char* data = m_cacheFile.GetData();
+	size_t size = m_cacheFile.GetSize();
+
+	CACHE_HEADER header;
+	if (size < sizeof(header))
+	{
+		return(false);
+	}
+	memcpy(&header, data, sizeof(header));
+	if ((header.magic != CACHE_MAGIC) ||
+		(header.version != CACHE_VERSION) ||
+		(header.sourceHash != sourceHash) ||
+		((header.colorChannels != 3) && (header.colorChannels != 4)) ||
+		(header.levelCount == 0) ||
+		(header.levelCount > MAX_CACHE_LEVELS) ||
+		((FORMAT_UNCOMPRESSED != header.format) != bCompressed) ||
+		(header.format > BlockEncoder::BLOCK_BC3))
+	{
+		return(false);
+	}
+	m_format = header.format;
+	m_colorChannels = static_cast<int>(header.colorChannels);
+	if (sizeof(header) + header.levelCount * sizeof(CACHE_LEVEL) > size)
+	{
+		return(false);
+	}
+
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		CACHE_LEVEL entry;
+		memcpy(&entry, data + sizeof(header) + i * sizeof(CACHE_LEVEL), sizeof(entry));
+		uint64_t levelSize = GetLevelSize(static_cast<int>(entry.width), static_cast<int>(entry.height));
+		if ((entry.width == 0) || (entry.height == 0) ||
+			(entry.size != levelSize) ||
+			(entry.offset > size) || (entry.size > size - entry.offset))
+		{
+			return(false);
+		}
+
+		MIP_LEVEL level;
+		level.width = static_cast<int>(entry.width);
+		level.height = static_cast<int>(entry.height);
+		level.pixels = data + entry.offset;
+		level.size = static_cast<size_t>(entry.size);
+		m_levels.push_back(level);
+	}
+
+	m_width = m_levels[0].width;
+	m_height = m_levels[0].height;
+	m_psnr = header.psnr;
+	return(true);
+}
+
+/***********************************************************
+ *  BuildLevels()
+ *
+ *  This method is used to decode the image, and to build
+ *  every mipmap level down to a single texel.  Each texel
+ *  of a level is the average of 2x2 texels of the level
+ *  above it, with the last row and column repeated when a
+ *  size is odd.
+ ***********************************************************/
+bool CachedTexture::BuildLevels(const std::string& filename)
+{
+	PROFILE_ZONE("CachedTexture::BuildLevels");
+
+	// the setting is kept per thread, so it is made here for
+	// whichever thread loads the image
+	stbi_set_flip_vertically_on_load_thread(true);
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	unsigned char* image = stbi_load(filename.c_str(), &width, &height, &colorChannels, 0);
+	if (NULL == image)
+	{
+		return(false);
+	}
+	if ((colorChannels != 3) && (colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		stbi_image_free(image);
+		return(false);
+	}
+
+	// lay out the levels one after another
+	std::vector<MIP_LEVEL> levels;
+	size_t pixelSize = 0;
+	int levelWidth = width;
+	int levelHeight = height;
+	for (;;)
+	{
+		MIP_LEVEL level;
+		level.width = levelWidth;
+		level.height = levelHeight;
+		level.pixels = NULL;
+		level.size = static_cast<size_t>(levelWidth) * levelHeight * colorChannels;
+		levels.push_back(level);
+		pixelSize += level.size;
+
+		if ((levelWidth == 1) && (levelHeight == 1))
+		{
+			break;
+		}
+		levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+		levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+	}
+
+	m_builtPixels.resize(pixelSize);
+	memcpy(&m_builtPixels[0], image, levels[0].size);
+	stbi_image_free(image);
+
+	size_t offset = 0;
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		levels[i].pixels = &m_builtPixels[offset];
+		offset += levels[i].size;
+	}
+
+	for (size_t i = 1; i < levels.size(); i++)
+	{
+		const MIP_LEVEL& source = levels[i - 1];
+		MIP_LEVEL& target = levels[i];
+		unsigned char* targetPixels = const_cast<unsigned char*>(target.pixels);
+		for (int y = 0; y < target.height; y++)
+		{
+			int y0 = (2 * y < source.height) ? 2 * y : source.height - 1;
+			int y1 = (2 * y + 1 < source.height) ? 2 * y + 1 : source.height - 1;
+			const unsigned char* row0 = source.pixels + static_cast<size_t>(y0) * source.width * colorChannels;
+			const unsigned char* row1 = source.pixels + static_cast<size_t>(y1) * source.width * colorChannels;
+			for (int x = 0; x < target.width; x++)
+			{
+				int x0 = ((2 * x < source.width) ? 2 * x : source.width - 1) * colorChannels;
+				int x1 = ((2 * x + 1 < source.width) ? 2 * x + 1 : source.width - 1) * colorChannels;
+				for (int c = 0; c < colorChannels; c++)
+				{
+					int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+					*targetPixels++ = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	m_levels = levels;
+	m_width = width;
+	m_height = height;
+	m_colorChannels = colorChannels;
+	return(true);
+}
+
+/***********************************************************
+ *  CompressLevels()
+ *
+ *  This method is used to compress the built levels into
+ *  BC1 blocks, or into BC3 blocks when a texel is not
+ *  opaque, with the blocks of each level encoded on the
+ *  passed in number of threads.  The quality is measured on
+ *  the first level.
+ ***********************************************************/
+void CachedTexture::CompressLevels(unsigned int threadCount)
+{
+	PROFILE_ZONE("CachedTexture::CompressLevels");
+
+	BlockEncoder::BLOCK_FORMAT blockFormat = BlockEncoder::BLOCK_BC1;
+	if (m_colorChannels == 4)
+	{
+		const MIP_LEVEL& level = m_levels[0];
+		for (size_t i = 3; i < level.size; i += 4)
+		{
+			if (level.pixels[i] != 255)
+			{
+				blockFormat = BlockEncoder::BLOCK_BC3;
+				break;
+			}
+		}
+	}
+	m_format = blockFormat;
+
+	std::vector<MIP_LEVEL> levels = m_levels;
+	size_t blockSize = 0;
+	for (MIP_LEVEL& level : levels)
+	{
+		level.size = GetLevelSize(level.width, level.height);
+		blockSize += level.size;
+	}
+
+	std::vector<unsigned char> blocks(blockSize);
+	size_t offset = 0;
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		BlockEncoder::EncodeImage(m_levels[i].pixels, m_levels[i].width, m_levels[i].height,
+			m_colorChannels, blockFormat, &blocks[offset], threadCount);
+		levels[i].pixels = &blocks[offset];
+		offset += levels[i].size;
+	}
+	m_psnr = BlockEncoder::CalculatePSNR(m_levels[0].pixels, m_width, m_height,
+		m_colorChannels, blockFormat, levels[0].pixels);
+
+	// the pixels of the levels stay where the vector put them
+	m_builtPixels.swap(blocks);
+	m_levels = levels;
+}
+
+/***********************************************************
+ *  GetLevelSize()
+ *
+ *  This method returns the size of a level in the format
+ *  of the levels.
+ ***********************************************************/
+size_t CachedTexture::GetLevelSize(int width, int height) const
+{
+	if (FORMAT_UNCOMPRESSED != m_format)
+	{
+		return(BlockEncoder::GetImageSize(static_cast<BlockEncoder::BLOCK_FORMAT>(m_format), width, height));
+	}
+	return(static_cast<size_t>(width) * height * m_colorChannels);
+}
+
+/***********************************************************
+ *  WriteCacheFile()
+ *
+ *  This method is used to write the built mipmap levels to
+ *  the cache file of the image.
+ ***********************************************************/
+bool CachedTexture::WriteCacheFile(const std::string& cacheFilename, unsigned long long sourceHash) const
+{
+	CACHE_HEADER header;
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.width = static_cast<uint32_t>(m_width);
+	header.height = static_cast<uint32_t>(m_height);
+	header.colorChannels = static_cast<uint32_t>(m_colorChannels);
+	header.levelCount = static_cast<uint32_t>(m_levels.size());
+	header.format = m_format;
+	header.psnr = static_cast<float>(m_psnr);
+
+	std::vector<CACHE_LEVEL> entries(m_levels.size());
+	uint64_t offset = sizeof(header) + entries.size() * sizeof(CACHE_LEVEL);
+	for (size_t i = 0; i < m_levels.size(); i++)
+	{
+		entries[i].width = static_cast<uint32_t>(m_levels[i].width);
+		entries[i].height = static_cast<uint32_t>(m_levels[i].height);
+		entries[i].offset = offset;
+		entries[i].size = m_levels[i].size;
+		offset += m_levels[i].size;
+	}
+
+	std::ofstream file(cacheFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (false == file.is_open())
+	{
+		std::cout << "Could not write the texture cache " << cacheFilename << std::endl;
+		return(false);
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(&entries[0]), entries.size() * sizeof(CACHE_LEVEL));
+	for (const MIP_LEVEL& level : m_levels)
+	{
+		file.write(reinterpret_cast<const char*>(level.pixels), level.size);
+	}
+	return(file.good());
+}
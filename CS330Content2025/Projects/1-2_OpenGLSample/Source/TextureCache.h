@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ==============
+// Defines the `CachedTexture` class, which keeps the decoded pixels of a
+// texture image and all of its mipmap levels in a cache file next to the
+// image, and the `MappedFile` class that the files are read through.
+//
+// RESPONSIBILITIES:
+// - Find the cache file of an image from a hash of the image file.
+// - Map a valid cache file into memory, so that its levels are uploaded
+//   straight from the file without decoding or copying them.
+// - Decode the image on a cache miss, build its mipmap levels with a box
+//   filter, and write them to the cache file for the next start.
+// - Optionally compress the levels into BC1 blocks, or BC3 blocks for an
+//   image with transparent texels, and measure the quality they keep.
+//
+// NOTE: A cache file is named texture_<hash>.bin after the 64-bit FNV-1a
+// hash of the image file, so an edited image gets a new cache file, and the
+// compressed levels are kept in texture_<hash>_bc.bin.  The
+// file starts with a header and a table of the levels, which are checked
+// against the size of the file before any level is used.  The images are
+// flipped vertically for the texture coordinates of OpenGL.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BlockEncoder.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class contains the code for mapping a file into
+ *  memory for reading.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// map the whole file - returns false if it cannot be mapped
+	bool Open(const std::string& filename);
+	void Close();
+
+	const unsigned char* GetData() const;
+	size_t GetSize() const;
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+};
+
+/***********************************************************
+ *  CachedTexture
+ *
+ *  This class contains the code for loading a texture image
+ *  with its mipmap levels through the texture cache.
+ ***********************************************************/
+class CachedTexture
+{
+public:
+	// constructor
+	CachedTexture();
+
+	CachedTexture(const CachedTexture&) = delete;
+	CachedTexture& operator=(const CachedTexture&) = delete;
+
+	// one mipmap level of the image
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		const unsigned char* pixels;
+		size_t size;
+	};
+
+	// load the image from its cache file, or decode it and write
+	// the cache file, compressing the levels on the passed in number
+	// of threads, or on every core for 0 - returns false if the
+	// image cannot be loaded
+	bool Load(const std::string& filename, bool bCompress = false, bool bRebuild = false,
+		unsigned int threadCount = 0);
+	// true when the image was loaded from its cache file
+	bool IsFromCache() const;
+	// true when the levels are compressed, and the quality in dB of
+	// the compressed image against the decoded one
+	bool IsCompressed() const;
+	const char* GetFormatName() const;
+	double GetPSNR() const;
+
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetColorChannels() const;
+	int GetLevelCount() const;
+	const MIP_LEVEL& GetLevel(int level) const;
+	// total size of the pixels of all of the levels
+	size_t GetPixelSize() const;
+
+	// copy the pixels of all of the levels, one after another
+	void CopyPixels(unsigned char* destination) const;
+	// where a level is read from by an upload - its offset in the
+	// bound pixel buffer when the pixels were copied into it
+	const void* GetLevelSource(int level, bool bFromPixelBuffer) const;
+	// upload every level into the texture bound to GL_TEXTURE_2D,
+	// from the bound pixel buffer when it holds the copied pixels
+	void Upload(bool bFromPixelBuffer) const;
+
+private:
+	// the first bytes of a cache file, and its version
+	static const uint32_t CACHE_MAGIC = 0x48435854;
+	static const uint32_t CACHE_VERSION = 2;
+	// the format of the levels in a cache file
+	static const uint32_t FORMAT_UNCOMPRESSED = 0;
+
+	// the start of a cache file
+	struct CACHE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t width;
+		uint32_t height;
+		uint32_t colorChannels;
+		uint32_t levelCount;
+		uint32_t format;
+		float psnr;
+	};
+
+	// the place of a level in a cache file
+	struct CACHE_LEVEL
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	int m_width;
+	int m_height;
+	int m_colorChannels;
+	bool m_bFromCache;
+	uint32_t m_format;
+	double m_psnr;
+	std::vector<MIP_LEVEL> m_levels;
+	// the mapped cache file, or the pixels built on a cache miss
+	MappedFile m_cacheFile;
+	std::vector<unsigned char> m_builtPixels;
+
+	// get the cache file name of an image with the passed in hash
+	static std::string GetCacheFilename(const std::string& filename, unsigned long long sourceHash, bool bCompressed);
+	// use the levels of a mapped cache file, if it is valid
+	bool ReadCacheFile(unsigned long long sourceHash, bool bCompressed);
+	// decode the image and build its levels
+	bool BuildLevels(const std::string& filename);
+	// compress the built levels into blocks on a number of threads
+	void CompressLevels(unsigned int threadCount);
+	// size of a level with the passed in size in the cache format
+	size_t GetLevelSize(int width, int height) const;
+	// write the built levels to a cache file
+	bool WriteCacheFile(const std::string& cacheFilename, unsigned long long sourceHash) const;
+};
@@ -0,0 +1,331 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// =================
+// This file contains the implementation of the `TextureLoader` class, which
+// loads texture images on worker threads and uploads them on the GL thread.
+//
+// RESPONSIBILITIES:
+// - Run the worker threads that load the images through the texture cache.
+// - Upload the mipmap levels of the images through a pixel buffer object.
+// - Report how long it took to load all of the requested images.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+#include "GLStateCache.h"
+#include "ZoneProfiler.h"
+
+#include <cstring>
+#include <iostream>
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader(unsigned int threadCount)
+{
+	m_bStopping = false;
+	m_uploadedCount = 0;
+	m_cachedCount = 0;
+	m_uploadedSize = 0;
+	m_pixelBuffer = 0;
+	m_startTime = std::chrono::steady_clock::now();
+
+	if (0 == threadCount)
+	{
+		unsigned int coreCount = std::thread::hardware_concurrency();
+		threadCount = (coreCount > 1) ? coreCount - 1 : 1;
+	}
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_bStopping = true;
+		m_jobs.clear();
+	}
+	m_jobReady.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	// free the images that were never uploaded
+	DECODED_IMAGE image;
+	while (true == m_decoded.Pop(image))
+	{
+		delete image.image;
+	}
+
+	if (0 != m_pixelBuffer)
+	{
+		glDeleteBuffers(1, &m_pixelBuffer);
+		m_pixelBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method returns the number of worker threads.
+ ***********************************************************/
+unsigned int TextureLoader::GetThreadCount() const
+{
+	return(static_cast<unsigned int>(m_workers.size()));
+}
+
+/***********************************************************
+ *  Request()
+ *
+ *  This method is used for queueing an image file to be
+ *  loaded by the next free worker thread.
+ ***********************************************************/
+void TextureLoader::Request(const std::string& filename, GLuint texture, GLuint textureUnit, bool bCompress)
+{
+	TEXTURE_REQUEST request;
+	request.filename = filename;
+	request.texture = texture;
+	request.textureUnit = textureUnit;
+	request.pArray = NULL;
+	request.arrayEntry = -1;
+	QueueRequest(request, bCompress);
+}
+
+/***********************************************************
+ *  RequestArrayImage()
+ *
+ *  This method is used for queueing an image file to be
+ *  loaded into its place in a texture array.  The array is
+ *  owned by the caller, and has to outlive the request.
+ ***********************************************************/
+void TextureLoader::RequestArrayImage(const std::string& filename, const TextureArray* pArray, int arrayEntry, bool bCompress)
+{
+	TEXTURE_REQUEST request;
+	request.filename = filename;
+	request.texture = pArray->GetTextureID();
+	request.textureUnit = pArray->GetTextureUnit();
+	request.pArray = pArray;
+	request.arrayEntry = arrayEntry;
+	QueueRequest(request, bCompress);
+}
+
+/***********************************************************
+ *  QueueRequest()
+ *
+ *  This method is used for keeping a request and handing
+ *  its image file to the worker threads.
+ ***********************************************************/
+void TextureLoader::QueueRequest(const TEXTURE_REQUEST& request, bool bCompress)
+{
+	if (m_requests.size() == m_uploadedCount)
+	{
+		// the loading time starts with the first request of a batch
+		m_startTime = std::chrono::steady_clock::now();
+		m_cachedCount = 0;
+		m_uploadedSize = 0;
+	}
+
+	m_requests.push_back(request);
+
+	DECODE_JOB job;
+	job.request = m_requests.size() - 1;
+	job.filename = request.filename;
+	job.bCompress = bCompress;
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_jobs.push_back(job);
+	}
+	m_jobReady.notify_one();
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is run by every worker thread.  It loads the
+ *  queued image files until the loader is destroyed, from
+ *  their cache files when they are up to date.
+ ***********************************************************/
+void TextureLoader::WorkerLoop()
+{
+	PROFILE_THREAD_NAME("TextureLoader");
+
+	for (;;)
+	{
+		DECODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobReady.wait(lock, [this] { return (true == m_bStopping) || (m_jobs.size() > 0); });
+			if (true == m_bStopping)
+			{
+				return;
+			}
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		DECODED_IMAGE image;
+		image.request = job.request;
+		image.image = new CachedTexture();
+		// the workers already keep the cores busy, so each one
+		// compresses its image on its own thread
+		image.image->Load(job.filename, job.bCompress, false, 1);
+
+		// the GL thread empties the queue every frame, so a full
+		// queue only has to be waited out for a moment
+		while (false == m_decoded.Push(image))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the images that have
+ *  been loaded so far, up to the passed in number, so that
+ *  a frame is not held up by too many uploads at once.
+ ***********************************************************/
+bool TextureLoader::Update(size_t maxUploads)
+{
+	DECODED_IMAGE image;
+	size_t uploads = 0;
+	while ((uploads < maxUploads) && (true == m_decoded.Pop(image)))
+	{
+		UploadImage(image);
+		uploads++;
+	}
+
+	return(IsComplete());
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for waiting until every requested
+ *  image has been loaded, and uploading them all.
+ ***********************************************************/
+void TextureLoader::Finish()
+{
+	while (false == IsComplete())
+	{
+		DECODED_IMAGE image;
+		if (true == m_decoded.Pop(image))
+		{
+			UploadImage(image);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  IsComplete()
+ *
+ *  This method returns true once every requested image has
+ *  been uploaded, or could not be loaded.
+ ***********************************************************/
+bool TextureLoader::IsComplete() const
+{
+	return(m_uploadedCount == m_requests.size());
+}
+
+/***********************************************************
+ *  UploadImage()
+ *
+ *  This method is used for uploading a loaded image into
+ *  the texture it was requested for.  The pixels of all of
+ *  the mipmap levels are copied into a pixel buffer object,
+ *  from which the driver copies them into the texture
+ *  without holding up the GL thread.  A texture whose image
+ *  could not be loaded keeps its placeholder image.  The
+ *  image of a texture array only fills its own place.
+ ***********************************************************/
+void TextureLoader::UploadImage(const DECODED_IMAGE& image)
+{
+	PROFILE_ZONE("TextureLoader::UploadImage");
+
+	const TEXTURE_REQUEST& request = m_requests[image.request];
+	m_uploadedCount++;
+
+	const CachedTexture* cachedTexture = image.image;
+	if (0 == cachedTexture->GetLevelCount())
+	{
+		std::cout << "Could not load image:" << request.filename << std::endl;
+	}
+	else
+	{
+		std::cout << "Successfully loaded image:" << request.filename << ", width:" << cachedTexture->GetWidth()
+			<< ", height:" << cachedTexture->GetHeight() << ", channels:" << cachedTexture->GetColorChannels()
+			<< ((true == cachedTexture->IsFromCache()) ? ", from the texture cache" : "");
+		if (true == cachedTexture->IsCompressed())
+		{
+			std::cout << ", " << cachedTexture->GetFormatName() << ", PSNR:" << cachedTexture->GetPSNR() << " dB";
+		}
+		std::cout << std::endl;
+		if (true == cachedTexture->IsFromCache())
+		{
+			m_cachedCount++;
+		}
+		m_uploadedSize += cachedTexture->GetPixelSize();
+
+		GLsizeiptr imageSize = static_cast<GLsizeiptr>(cachedTexture->GetPixelSize());
+		if (0 == m_pixelBuffer)
+		{
+			glGenBuffers(1, &m_pixelBuffer);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+		// orphan the previous contents so the copy does not have
+		// to wait for the last upload to finish with them
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, imageSize, NULL, GL_STREAM_DRAW);
+
+		bool bFromPixelBuffer = false;
+		void* mappedBuffer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (NULL != mappedBuffer)
+		{
+			cachedTexture->CopyPixels(static_cast<unsigned char*>(mappedBuffer));
+			bFromPixelBuffer = (GL_TRUE == glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+		}
+		if (false == bFromPixelBuffer)
+		{
+			// upload straight from the loaded pixels instead
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		if (NULL != request.pArray)
+		{
+			request.pArray->UploadImage(request.arrayEntry, *cachedTexture, bFromPixelBuffer);
+		}
+		else
+		{
+			GLStateCache::BindTexture(request.textureUnit, GL_TEXTURE_2D, request.texture);
+			cachedTexture->Upload(bFromPixelBuffer);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	delete image.image;
+
+	if (true == IsComplete())
+	{
+		std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - m_startTime;
+		std::cout << "INFO: " << m_requests.size() << " texture images loaded on "
+			<< m_workers.size() << " threads in " << loadTime.count() << " ms, "
+			<< m_cachedCount << " from the texture cache, "
+			<< m_uploadedSize / 1024 << " KB of texture data" << std::endl;
+	}
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ===============
+// Defines the `TextureLoader` class, which loads texture image files on a
+// pool of worker threads and uploads them into their textures on the GL
+// thread.
+//
+// RESPONSIBILITIES:
+// - Load the requested images through the texture cache on the worker
+//   threads, all at once.
+// - Hand the loaded images to the GL thread through a lock-free queue.
+// - Upload every mipmap level through a pixel buffer object into the
+//   texture that was created for the image.
+//
+// NOTE: The textures are created by the caller with a placeholder image and
+// can be drawn with right away.  Their names stay the same when the real
+// images are uploaded, so nothing that refers to them has to change.  All
+// of the GL calls are made by Update() and Finish(), on the GL thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LockFreeQueue.h"
+#include "TextureArray.h"
+#include "TextureCache.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class contains the code for loading the texture
+ *  images in the background.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor - with no thread count, one thread is used
+	// for every processor core but the one of the GL thread
+	explicit TextureLoader(unsigned int threadCount = 0);
+	// destructor
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+private:
+	// most decoded images that wait for their upload at once
+	static const size_t DECODED_CAPACITY = 64;
+
+	// an image file to load into a texture, or into its
+	// place in a texture array
+	struct TEXTURE_REQUEST
+	{
+		std::string filename;
+		GLuint texture;
+		GLuint textureUnit;
+		const TextureArray* pArray;
+		int arrayEntry;
+	};
+
+	// an image file for a worker thread to decode
+	struct DECODE_JOB
+	{
+		size_t request;
+		std::string filename;
+		bool bCompress;
+	};
+
+	// a loaded image, with all of its mipmap levels - an
+	// image that could not be loaded has no levels
+	struct DECODED_IMAGE
+	{
+		size_t request;
+		CachedTexture* image;
+	};
+
+	// the worker threads, and the jobs they wait for
+	std::vector<std::thread> m_workers;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobReady;
+	std::deque<DECODE_JOB> m_jobs;
+	bool m_bStopping;
+	// the decoded images, from the worker threads to the GL thread
+	LockFreeQueue<DECODED_IMAGE, DECODED_CAPACITY> m_decoded;
+
+	// the requests, which are only used on the GL thread
+	std::vector<TEXTURE_REQUEST> m_requests;
+	size_t m_uploadedCount;
+	// number of the uploaded images that came from the cache,
+	// and the size of all of the uploaded levels
+	size_t m_cachedCount;
+	size_t m_uploadedSize;
+	// pixel buffer the images are uploaded through
+	GLuint m_pixelBuffer;
+	// time of the first request, for the loading time
+	std::chrono::steady_clock::time_point m_startTime;
+
+	// queue a request for the worker threads
+	void QueueRequest(const TEXTURE_REQUEST& request, bool bCompress);
+	// the loop of a worker thread
+	void WorkerLoop();
+	// upload a loaded image into its texture
+	void UploadImage(const DECODED_IMAGE& image);
+
+public:
+	// number of worker threads
+	unsigned int GetThreadCount() const;
+
+	// load an image file in the background, to be uploaded into
+	// the passed in texture, which is bound to the texture unit -
+	// the levels are compressed into blocks when asked for
+	void Request(const std::string& filename, GLuint texture, GLuint textureUnit, bool bCompress = false);
+	// load an image file in the background, to be uploaded into
+	// its place in the passed in texture array
+	void RequestArrayImage(const std::string& filename, const TextureArray* pArray, int arrayEntry, bool bCompress);
+	// upload up to a number of the images loaded so far - returns
+	// true once every requested image has been uploaded
+	bool Update(size_t maxUploads);
+	// wait for every requested image, and upload it
+	void Finish();
+	// true once every requested image has been uploaded
+	bool IsComplete() const;
+};
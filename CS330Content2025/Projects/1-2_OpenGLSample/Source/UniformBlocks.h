@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.h
+// ===============
+// Defines the CPU side layout of the uniform blocks that are shared by the
+// vertex and fragment shaders of the 3D scene.
+//
+// RESPONSIBILITIES:
+// - Mirror the std140 layout of `CameraBlock` and `LightBlock` in the GLSL
+//   shaders so that each block can be uploaded with a single buffer update.
+// - Mirror the std430 layout of the `ObjectBlock` storage block that holds
+//   the per-object values when the scene is drawn in batches.
+// - Define the binding points that connect the blocks to their buffers.
+//
+// NOTE: std140 aligns every vec3 to 16 bytes, so the padding members below
+// must be kept in sync with the struct definitions in the shaders.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// binding points for the shared uniform buffers
+const unsigned int CAMERA_BLOCK_BINDING = 0;
+const unsigned int LIGHT_BLOCK_BINDING = 1;
+const unsigned int OBJECT_BLOCK_BINDING = 0;
+
+// number of point lights declared in the fragment shader
+const int TOTAL_POINT_LIGHTS = 5;
+
+// per-frame camera data - layout of CameraBlock
+struct CAMERA_BLOCK
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 viewPosition;
+};
+
+// layout of the DirectionalLight struct in LightBlock
+struct DIRECTIONAL_LIGHT
+{
+	glm::vec3 direction;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// layout of the PointLight struct in LightBlock
+struct POINT_LIGHT
+{
+	glm::vec3 position;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// layout of the SpotLight struct in LightBlock
+struct SPOT_LIGHT
+{
+	glm::vec3 position;
+	float padding0;
+	glm::vec3 direction;
+	float cutOff;
+	float outerCutOff;
+	float constant;
+	float linear;
+	float quadratic;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// all of the light sources - layout of LightBlock
+struct LIGHT_BLOCK
+{
+	DIRECTIONAL_LIGHT directionalLight;
+	POINT_LIGHT pointLights[TOTAL_POINT_LIGHTS];
+	SPOT_LIGHT spotLight;
+};
+
+// per-object values for batched drawing - layout of one ObjectData
+// element in the ObjectBlock storage block
+struct OBJECT_DATA
+{
+	glm::mat4 model;
+	glm::vec4 color;
+	glm::vec4 diffuseColor;     // material diffuse color, shininess in w
+	glm::vec4 specularColor;
+	glm::vec2 UVscale;
+	int bUseTexture;
+	int textureLayer;
+	glm::vec4 textureRect;      // offset and size of the image in its layer
+};
+
+static_assert(sizeof(CAMERA_BLOCK) == 144, "CAMERA_BLOCK does not match the std140 layout");
+static_assert(sizeof(DIRECTIONAL_LIGHT) == 64, "DIRECTIONAL_LIGHT does not match the std140 layout");
+static_assert(sizeof(POINT_LIGHT) == 64, "POINT_LIGHT does not match the std140 layout");
+static_assert(sizeof(SPOT_LIGHT) == 96, "SPOT_LIGHT does not match the std140 layout");
+static_assert(sizeof(LIGHT_BLOCK) == 480, "LIGHT_BLOCK does not match the std140 layout");
+static_assert(sizeof(OBJECT_DATA) == 144, "OBJECT_DATA does not match the std430 layout");
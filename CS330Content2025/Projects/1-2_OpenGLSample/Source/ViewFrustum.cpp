@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+// viewfrustum.cpp
+// ===============
+// This file contains the implementation of the `ViewFrustum` class, which
+// tests bounding spheres against the visible volume of the camera.
+//
+// RESPONSIBILITIES:
+// - Extract the six frustum planes from the clip space matrix.
+// - Report whether a bounding sphere may be inside of the frustum.
+//
+// NOTE: The planes are taken from the rows of the combined matrix, as in
+// "Fast Extraction of Viewing Frustum Planes from the World-View-Projection
+// Matrix" by Gribb and Hartmann, and work for both perspective and
+// orthographic projections.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ViewFrustum.h"
+
+/***********************************************************
+ *  ViewFrustum()
+ *
+ *  The constructor for the class.  Until the planes are
+ *  set, every sphere is reported as visible.
+ ***********************************************************/
+ViewFrustum::ViewFrustum()
+{
+	for (int i = 0; i < PLANE_COUNT; ++i)
+	{
+		m_planes[i] = glm::vec4(0.0f);
+	}
+}
+
+/***********************************************************
+ *  SetMatrix()
+ *
+ *  This method is used for extracting the frustum planes
+ *  from the projection matrix multiplied by the view
+ *  matrix, so that the planes are in world coordinates.
+ ***********************************************************/
+void ViewFrustum::SetMatrix(const glm::mat4& viewProjection)
+{
+	// the rows of the matrix - GLM stores the matrix by columns
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; ++row)
+	{
+		rows[row] = glm::vec4(
+			viewProjection[0][row],
+			viewProjection[1][row],
+			viewProjection[2][row],
+			viewProjection[3][row]);
+	}
+
+	// a point is inside when -w <= x, y, z <= w in clip space
+	m_planes[PLANE_LEFT] = rows[3] + rows[0];
+	m_planes[PLANE_RIGHT] = rows[3] - rows[0];
+	m_planes[PLANE_BOTTOM] = rows[3] + rows[1];
+	m_planes[PLANE_TOP] = rows[3] - rows[1];
+	m_planes[PLANE_NEAR] = rows[3] + rows[2];
+	m_planes[PLANE_FAR] = rows[3] - rows[2];
+
+	// normalize the planes so that the distance of a point
+	// from a plane can be compared against a radius
+	for (int i = 0; i < PLANE_COUNT; ++i)
+	{
+		float length = glm::length(glm::vec3(m_planes[i]));
+		if (length > 0.0f)
+		{
+			m_planes[i] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsSphereVisible()
+ *
+ *  This method is used for checking whether a sphere in
+ *  world coordinates is at least partly inside of the
+ *  frustum.
+ ***********************************************************/
+bool ViewFrustum::IsSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (int i = 0; i < PLANE_COUNT; ++i)
+	{
+		float distance = glm::dot(glm::vec3(m_planes[i]), center) + m_planes[i].w;
+		if (distance < -radius)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  ClassifyBox()
+ *
+ *  This method is used for checking whether an axis-aligned
+ *  box in world coordinates is outside of the frustum, cut
+ *  by one of its planes, or completely inside of it.
+ ***********************************************************/
+ViewFrustum::FRUSTUM_TEST ViewFrustum::ClassifyBox(const glm::vec3& minimum, const glm::vec3& maximum) const
+{
+	FRUSTUM_TEST result = TEST_INSIDE;
+
+	for (int i = 0; i < PLANE_COUNT; ++i)
+	{
+		glm::vec3 normal(m_planes[i]);
+
+		// the corners of the box farthest in front of and
+		// farthest behind the plane
+		glm::vec3 front(
+			(normal.x >= 0.0f) ? maximum.x : minimum.x,
+			(normal.y >= 0.0f) ? maximum.y : minimum.y,
+			(normal.z >= 0.0f) ? maximum.z : minimum.z);
+		glm::vec3 back(
+			(normal.x >= 0.0f) ? minimum.x : maximum.x,
+			(normal.y >= 0.0f) ? minimum.y : maximum.y,
+			(normal.z >= 0.0f) ? minimum.z : maximum.z);
+
+		if (glm::dot(normal, front) + m_planes[i].w < 0.0f)
+		{
+			return(TEST_OUTSIDE);
+		}
+		if (glm::dot(normal, back) + m_planes[i].w < 0.0f)
+		{
+			result = TEST_INTERSECTING;
+		}
+	}
+
+	return(result);
+}
+
+/***********************************************************
+ *  GetDepth()
+ *
+ *  This method is used for getting the distance of a point
+ *  in world coordinates in front of the near plane, which
+ *  is negative for a point behind the camera.
+ ***********************************************************/
+float ViewFrustum::GetDepth(const glm::vec3& point) const
+{
+	return(glm::dot(glm::vec3(m_planes[PLANE_NEAR]), point) + m_planes[PLANE_NEAR].w);
+}
@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// viewfrustum.h
+// =============
+// Defines the `ViewFrustum` class, which holds the six planes bounding the
+// volume that is visible through the camera, so that the objects outside of
+// the view can be skipped before anything is sent to OpenGL.
+//
+// RESPONSIBILITIES:
+// - Extract the frustum planes from the combined projection and view matrix.
+// - Test bounding spheres and boxes in world coordinates against the planes.
+//
+// NOTE: The tests are conservative - a volume is only reported as hidden when
+// it lies completely behind one of the planes, so a few objects near the
+// corners of the frustum are drawn even though they are not visible.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ViewFrustum
+ *
+ *  This class contains the code for testing bounding
+ *  volumes against the visible volume of the camera.
+ ***********************************************************/
+class ViewFrustum
+{
+public:
+	// constructor
+	ViewFrustum();
+
+	// indices of the planes of the frustum
+	enum FRUSTUM_PLANE
+	{
+		PLANE_LEFT = 0,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_COUNT
+	};
+
+	// results of testing a volume against the frustum
+	enum FRUSTUM_TEST
+	{
+		TEST_OUTSIDE = 0,
+		TEST_INTERSECTING,
+		TEST_INSIDE
+	};
+
+private:
+	// the planes as (normal, distance), with the normals
+	// pointing into the frustum and of unit length
+	glm::vec4 m_planes[PLANE_COUNT];
+
+public:
+	// extract the planes from the projection matrix times the view matrix
+	void SetMatrix(const glm::mat4& viewProjection);
+	// true when any part of the sphere may be inside the frustum
+	bool IsSphereVisible(const glm::vec3& center, float radius) const;
+	// whether an axis-aligned box is outside, partly inside or inside
+	FRUSTUM_TEST ClassifyBox(const glm::vec3& minimum, const glm::vec3& maximum) const;
+	// distance of a point in front of the near plane, which
+	// orders the drawn objects by their depth from the camera
+	float GetDepth(const glm::vec3& point) const;
+};
@@ -24,6 +24,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
+#include "ZoneProfiler.h"
 
 // GLM Math Header inclusions
 #define GLM_ENABLE_EXPERIMENTAL
@@ -31,14 +34,15 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <algorithm>
+
 // declarations for the global variables and defines
 namespace
 {
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
+	const char* g_CameraBlockName = "CameraBlock";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -56,6 +60,10 @@ namespace
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
+
+	// largest screen-space error, in pixels, allowed when the
+	// coarser levels of detail of the meshes are selected
+	const float LOD_PIXEL_THRESHOLD = 1.0f;
 }
 
 /***********************************************************
@@ -76,6 +84,13 @@ ViewManager::ViewManager(
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
 	g_pCamera->MovementSpeed = 20;
+	// the camera buffer is created on first use, since the
+	// OpenGL functions are not loaded until after construction
+	m_bCameraBufferReady = false;
+	m_lodView = {};
+	m_inverseViewProjection = glm::mat4(1.0f);
+	m_bPickButtonDown = false;
+	m_bPickRequested = false;
 }
 
 /***********************************************************
@@ -127,9 +142,62 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// tell GLFW to capture all mouse events
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
+	// the state of the new context is not known yet
+	GLStateCache::Invalidate();
+
 	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLStateCache::SetCapability(GL_BLEND, true);
+	GLStateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	m_pWindow = window;
+
+	return(window);
+}
+
+/***********************************************************
+ *  CreateHeadlessWindow()
+ *
+ *  This method is used to create a hidden window whose
+ *  OpenGL context renders in software, so that the scene
+ *  can be rendered on machines without a display.  GLFW
+ *  must have been initialized with the null platform.  The
+ *  frames are rendered into an offscreen framebuffer.
+ ***********************************************************/
+GLFWwindow* ViewManager::CreateHeadlessWindow(const char* windowTitle)
+{
+	GLFWwindow* window = nullptr;
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	// try an OSMesa context first, then an EGL context
+	const int contextAPIs[] = { GLFW_OSMESA_CONTEXT_API, GLFW_EGL_CONTEXT_API };
+	for (int contextAPI : contextAPIs)
+	{
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextAPI);
+		window = glfwCreateWindow(
+			WINDOW_WIDTH,
+			WINDOW_HEIGHT,
+			windowTitle,
+			NULL, NULL);
+		if (window != NULL)
+		{
+			break;
+		}
+	}
+	if (window == NULL)
+	{
+		std::cout << "Failed to create headless GLFW window" << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+	glfwMakeContextCurrent(window);
+
+	// the state of the new context is not known yet
+	GLStateCache::Invalidate();
+
+	// enable blending for supporting tranparent rendering
+	GLStateCache::SetCapability(GL_BLEND, true);
+	GLStateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	m_pWindow = window;
 
@@ -270,6 +338,15 @@ void ViewManager::ProcessKeyboardEvents()
 		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 		g_pCamera->Zoom = 80;
 	}
+
+	// pick the object in the middle of the view once per press
+	// of the left mouse button, since the cursor is captured
+	bool bPickButtonDown = (glfwGetMouseButton(m_pWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+	if ((true == bPickButtonDown) && (false == m_bPickButtonDown))
+	{
+		m_bPickRequested = true;
+	}
+	m_bPickButtonDown = bPickButtonDown;
 }
 
 /***********************************************************
@@ -281,6 +358,8 @@ void ViewManager::ProcessKeyboardEvents()
  ***********************************************************/
 void ViewManager::PrepareSceneView()
 {
+	PROFILE_ZONE("ViewManager::PrepareSceneView");
+
 	glm::mat4 view;
 	glm::mat4 projection;
 
@@ -322,18 +401,107 @@ void ViewManager::PrepareSceneView()
 		}
 	}
 
+	// keep the frustum planes for skipping the objects that are
+	// outside of the view
+	m_viewFrustum.SetMatrix(projection * view);
+	m_inverseViewProjection = glm::inverse(projection * view);
+
+	// keep the camera values for selecting the levels of detail -
+	// the projection scale is the number of pixels covered by one
+	// unit at a distance of one, or at any distance when orthographic
+	m_lodView.cameraPosition = g_pCamera->Position;
+	m_lodView.bOrthographic = bOrthographicProjection;
+	m_lodView.pixelThreshold = LOD_PIXEL_THRESHOLD;
+	if (bOrthographicProjection == false)
+	{
+		m_lodView.projectionScale = WINDOW_HEIGHT / (2.0f * tan(glm::radians(g_pCamera->Zoom) / 2.0f));
+	}
+	else
+	{
+		// the orthographic views are ten units across the longer side
+		m_lodView.projectionScale = std::max(WINDOW_WIDTH, WINDOW_HEIGHT) / 10.0f;
+	}
+
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
-		// attach the spotlight to the camera and aim it towards the front of the camera
-		m_pShaderManager->setVec3Value("spotLight.position", g_pCamera->Position);
-		m_pShaderManager->setVec3Value("spotLight.direction", g_pCamera->Front);
+		if (false == m_bCameraBufferReady)
+		{
+			m_pShaderManager->createUniformBuffer(CAMERA_BLOCK_BINDING, sizeof(CAMERA_BLOCK));
+			m_pShaderManager->bindUniformBlock(g_CameraBlockName, CAMERA_BLOCK_BINDING);
+			m_bCameraBufferReady = true;
+		}
 
+		// set the view and projection matrices and the view position
+		// of the camera into the shader with one buffer update
+		CAMERA_BLOCK camera;
+		camera.view = view;
+		camera.projection = projection;
+		camera.viewPosition = glm::vec4(g_pCamera->Position, 1.0f);
+		m_pShaderManager->setUniformBufferData(CAMERA_BLOCK_BINDING, 0, sizeof(CAMERA_BLOCK), &camera);
+
+		// attach the spotlight to the camera and aim it towards the front
+		// of the camera - only the position and direction are updated
+		SPOT_LIGHT spotLight;
+		spotLight.position = g_pCamera->Position;
+		spotLight.padding0 = 0.0f;
+		spotLight.direction = g_pCamera->Front;
+		m_pShaderManager->setUniformBufferData(
+			LIGHT_BLOCK_BINDING,
+			offsetof(LIGHT_BLOCK, spotLight) + offsetof(SPOT_LIGHT, position),
+			offsetof(SPOT_LIGHT, cutOff) - offsetof(SPOT_LIGHT, position),
+			&spotLight.position);
 	}
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  GetLODView()
+ *
+ *  This method is used for getting the camera values that
+ *  select the levels of detail of the drawn meshes, as set
+ *  by the last call to PrepareSceneView()
+ ***********************************************************/
+const ShapeMeshes::LOD_VIEW& ViewManager::GetLODView() const
+{
+	return(m_lodView);
+}
+
+/***********************************************************
+ *  GetViewFrustum()
+ *
+ *  This method is used for getting the visible volume of
+ *  the camera, as set by the last call to
+ *  PrepareSceneView()
+ ***********************************************************/
+const ViewFrustum& ViewManager::GetViewFrustum() const
+{
+	return(m_viewFrustum);
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used for getting the ray through the
+ *  center of the view once the left mouse button has been
+ *  pressed.  The ray starts on the near plane, so it works
+ *  for both the perspective and orthographic projections.
+ *  False is returned when no pick was requested.
+ ***********************************************************/
+bool ViewManager::GetPickRay(glm::vec3& origin, glm::vec3& direction)
+{
+	if (false == m_bPickRequested)
+	{
+		return(false);
+	}
+	m_bPickRequested = false;
+
+	// the center of the view on the near and far planes
+	glm::vec4 nearPoint = m_inverseViewProjection * glm::vec4(0.0f, 0.0f, -1.0f, 1.0f);
+	glm::vec4 farPoint = m_inverseViewProjection * glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	origin = glm::vec3(nearPoint);
+	direction = glm::normalize(glm::vec3(farPoint - nearPoint));
+	return(true);
+}
@@ -27,6 +27,8 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShapeMeshes.h"
+#include "ViewFrustum.h"
 #include "camera.h"
 
 // GLFW library
@@ -52,6 +54,19 @@ private:
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// true once the camera uniform buffer has been created
+	bool m_bCameraBufferReady;
+	// camera values for selecting the levels of detail
+	ShapeMeshes::LOD_VIEW m_lodView;
+	// visible volume of the camera for culling the scene objects
+	ViewFrustum m_viewFrustum;
+	// inverse of the projection matrix times the view matrix,
+	// for turning points on the screen into rays
+	glm::mat4 m_inverseViewProjection;
+	// true while the picking mouse button is held, and true
+	// after it was pressed until the pick ray is taken
+	bool m_bPickButtonDown;
+	bool m_bPickRequested;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -59,7 +74,17 @@ private:
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// create a hidden window with a software OpenGL context
+	// for rendering without a display
+	GLFWwindow* CreateHeadlessWindow(const char* windowTitle);
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+	// camera values for selecting the levels of detail of the meshes
+	const ShapeMeshes::LOD_VIEW& GetLODView() const;
+	// visible volume of the camera for culling the scene objects
+	const ViewFrustum& GetViewFrustum() const;
+	// ray through the center of the view after the left mouse
+	// button was pressed, for picking the object in the middle
+	bool GetPickRay(glm::vec3& origin, glm::vec3& direction);
 };
\ No newline at end of file
@@ -1,9 +1,29 @@
 #version 330 core
+// the shader is compiled into variants, with these defines
+// added after the version line:
+//   TEXTURED            - the base color is read from objectTexture
+//   TEXTURE_ARRAY       - objectTexture is a texture array, and the image
+//                         is tiled inside its rectangle of its layer
+//   UNLIT               - the base color is output without lighting
+//   DIRECTIONAL         - the directional light is calculated
+//   NUM_POINT_LIGHTS n  - the first n point lights are calculated
+//   SPOT                - the spot light is calculated
+#ifndef NUM_POINT_LIGHTS
+#define NUM_POINT_LIGHTS 0
+#endif
+
 out vec4 fragmentColor;
 
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+// per-object values passed on by the vertex shader
+flat in vec4 fragmentObjectColor;
+flat in vec4 fragmentDiffuseColor;   // shininess in w
+flat in vec3 fragmentSpecularColor;
+flat in vec2 fragmentUVscale;
+flat in int fragmentTextureLayer;
+flat in vec4 fragmentTextureRect;
 
 struct Material {
     vec3 diffuseColor;
@@ -50,88 +70,97 @@ struct SpotLight {
 
 #define TOTAL_POINT_LIGHTS 5
 
-uniform bool bUseTexture=false;
-uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
-uniform vec3 viewPosition;
-uniform DirectionalLight directionalLight;
-uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform Material material;
+// per-frame camera data shared by every draw
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
+
+// light sources shared by every draw - the active point
+// lights are kept at the front of the array
+layout (std140) uniform LightBlock
+{
+    DirectionalLight directionalLight;
+    PointLight pointLights[TOTAL_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+
+#ifdef TEXTURED
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray objectTexture;
+#else
 uniform sampler2D objectTexture;
-uniform vec2 UVscale = vec2(1.0f, 1.0f);
+#endif
+#endif
 
-// the scaled texture coordinate to use in calculations
-vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
+// the per-object values to use in calculations
+Material material;
 
 // function prototypes
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 baseColor);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 baseColor);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 baseColor);
 
 void main()
 {   
-    if(bUseLighting == true)
+    material = Material(fragmentDiffuseColor.rgb, fragmentSpecularColor, fragmentDiffuseColor.w);
+
+#if defined(TEXTURED) && defined(TEXTURE_ARRAY)
+    // the image is repeated inside its rectangle, kept half a texel
+    // from the edges so the filter does not reach its neighbors -
+    // the gradients are taken before the repeat so that its seams
+    // do not select the smallest mipmap level
+    vec2 tiledCoordinate = fragmentTextureCoordinate * fragmentUVscale;
+    vec2 halfTexel = 0.5f / vec2(textureSize(objectTexture, 0).xy);
+    vec2 layerCoordinate = fragmentTextureRect.xy +
+        clamp(fract(tiledCoordinate) * fragmentTextureRect.zw, halfTexel, fragmentTextureRect.zw - halfTexel);
+    vec4 baseColor = textureGrad(objectTexture, vec3(layerCoordinate, float(fragmentTextureLayer)),
+        dFdx(tiledCoordinate) * fragmentTextureRect.zw, dFdy(tiledCoordinate) * fragmentTextureRect.zw);
+#elif defined(TEXTURED)
+    vec4 baseColor = texture(objectTexture, fragmentTextureCoordinate * fragmentUVscale);
+#else
+    vec4 baseColor = fragmentObjectColor;
+#endif
+
+#ifdef UNLIT
+    fragmentColor = baseColor;
+#else
+    vec3 phongResult = vec3(0.0f);
+    // properties
+    vec3 norm = normalize(fragmentVertexNormal);
+    vec3 viewDir = normalize(viewPosition.xyz - fragmentPosition);
+
+    // == =====================================================
+    // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
+    // For each phase, a calculate function is defined that calculates the corresponding color
+    // per light source. In the main() function we take all the calculated colors and sum them 
+    // up for this fragment's final color.  Only the phases of the active lights are compiled.
+    // == =====================================================
+    // phase 1: directional lighting
+#ifdef DIRECTIONAL
+    phongResult += CalcDirectionalLight(directionalLight, norm, viewDir, baseColor.rgb);
+#endif
+    // phase 2: point lights
+#if NUM_POINT_LIGHTS > 0
+    for(int i = 0; i < NUM_POINT_LIGHTS; i++)
     {
-        vec3 phongResult = vec3(0.0f);
-        // properties
-        vec3 norm = normalize(fragmentVertexNormal);
-        vec3 viewDir = normalize(viewPosition - fragmentPosition);
-    
-        // == =====================================================
-        // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
-        // For each phase, a calculate function is defined that calculates the corresponding color
-        // per light source. In the main() function we take all the calculated colors and sum them 
-        // up for this fragment's final color.
-        // == =====================================================
-        // phase 1: directional lighting
-        if(directionalLight.bActive == true)
-        {
-            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
-        }
-        // phase 2: point lights
-        for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
-        {
-	    if(pointLights[i].bActive == true)
-            {
-                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
-            }
-        } 
-        // phase 3: spot light
-        if(spotLight.bActive == true)
-        {
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
-        }
-    
-        if(bUseTexture == true)
-        {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinateScaled)).a);
-        }
-        else
-        {
-            fragmentColor = vec4(phongResult, objectColor.a);
-        }
-    }
-    else
-    {
-        if(bUseTexture == true)
-        {
-            fragmentColor = texture(objectTexture, fragmentTextureCoordinateScaled);
-        }
-        else
-        {
-            fragmentColor = objectColor;
-        }
+        phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir, baseColor.rgb);
     }
+#endif
+    // phase 3: spot light
+#ifdef SPOT
+    phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir, baseColor.rgb);
+#endif
+
+    fragmentColor = vec4(phongResult, baseColor.a);
+#endif
 }
 
 // calculates the color when using a directional light.
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, vec3 baseColor)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
     vec3 lightDirection = normalize(-light.direction);
     // diffuse shading
     float diff = max(dot(normal, lightDirection), 0.0);
@@ -139,29 +168,16 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
     vec3 reflectDir = reflect(-lightDirection, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
+    vec3 ambient = light.ambient * baseColor;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * baseColor;
+    vec3 specular = light.specular * spec * material.specularColor * baseColor;
     
     return (ambient + diffuse + specular);
 }
 
 // calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 baseColor)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular= vec3(0.0f);
-
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
@@ -171,29 +187,16 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
    
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * specularComponent * material.specularColor;
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * specularComponent * material.specularColor;
-    }
+    vec3 ambient = light.ambient * baseColor;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * baseColor;
+    vec3 specular = light.specular * specularComponent * material.specularColor;
     
     return (ambient + diffuse + specular);
 }
 
 // calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 baseColor)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
@@ -208,18 +211,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
+    vec3 ambient = light.ambient * baseColor;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * baseColor;
+    vec3 specular = light.specular * spec * material.specularColor * baseColor;
     
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
@@ -1,20 +1,106 @@
 #version 330 core
+// the per-object storage block of batched draws is only
+// available when the driver supports storage buffers
+#extension GL_ARB_shader_storage_buffer_object : enable
+
 layout (location = 0) in vec3 inVertexPosition;
 layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance attributes used by the instanced draw methods
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+// per-object index used by the batched indirect draws
+layout (location = 8) in int inObjectIndex;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+// per-object values, taken from the uniforms or from the
+// object data of batched draws
+flat out vec4 fragmentObjectColor;
+flat out vec4 fragmentDiffuseColor;   // shininess in w
+flat out vec3 fragmentSpecularColor;
+flat out vec2 fragmentUVscale;
+flat out int fragmentTextureLayer;
+flat out vec4 fragmentTextureRect;
+
+struct Material {
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+};
+
+// per-frame camera data shared by every draw
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+};
+
+#ifdef GL_ARB_shader_storage_buffer_object
+struct ObjectData {
+    mat4 model;
+    vec4 color;
+    vec4 diffuseColor;   // shininess in w
+    vec4 specularColor;
+    vec2 UVscale;
+    int bUseTexture;
+    int textureLayer;
+    vec4 textureRect;   // offset and size of the image in its layer
+};
+
+// per-object values of batched draws
+layout (std430) buffer ObjectBlock
+{
+    ObjectData objects[];
+};
+#endif
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform bool bUseInstancing = false;
+uniform bool bUseBatching = false;
+uniform vec4 objectColor = vec4(1.0f);
+uniform Material material;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// layer and rectangle of the image in the texture array
+uniform int textureLayer = 0;
+uniform vec4 textureRect = vec4(0.0f, 0.0f, 1.0f, 1.0f);
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
+   mat4 objectModel = model;
+   fragmentObjectColor = objectColor;
+   fragmentDiffuseColor = vec4(material.diffuseColor, material.shininess);
+   fragmentSpecularColor = material.specularColor;
+   fragmentUVscale = UVscale;
+   fragmentTextureLayer = textureLayer;
+   fragmentTextureRect = textureRect;
+
+#ifdef GL_ARB_shader_storage_buffer_object
+   // batched draws take every per-object value from the object data
+   if(bUseBatching == true)
+   {
+      objectModel = objects[inObjectIndex].model;
+      fragmentObjectColor = objects[inObjectIndex].color;
+      fragmentDiffuseColor = objects[inObjectIndex].diffuseColor;
+      fragmentSpecularColor = objects[inObjectIndex].specularColor.rgb;
+      fragmentUVscale = objects[inObjectIndex].UVscale;
+      fragmentTextureLayer = objects[inObjectIndex].textureLayer;
+      fragmentTextureRect = objects[inObjectIndex].textureRect;
+   }
+   else
+#endif
+   // instanced draws take the model matrix from the instance data,
+   // and the instance color tints the object color
+   if(bUseInstancing == true)
+   {
+      objectModel = inInstanceModel;
+      fragmentObjectColor = objectColor * inInstanceColor;
+   }
+
+   fragmentPosition = vec3(objectModel * vec4(inVertexPosition, 1.0));
+   gl_Position = projection * view * objectModel * vec4(inVertexPosition, 1.0f);
    fragmentVertexNormal = inVertexNormal;
    fragmentTextureCoordinate = inTextureCoordinate;
-}
\ No newline at end of file
+}
@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// fnvhash.h
+// =========
+// calculate the FNV-1a hashes of blocks of bytes
+//
+// The 64-bit hash names the cache files of the shader programs and of the
+// textures, and the 32-bit hash finds the tags of the scene textures and
+// materials.  A hash can be carried on over several blocks by passing the
+// hash of the blocks before them, which starts at the offset basis.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FNVHash
+{
+	// the offset bases the hashes start from
+	const uint32_t OFFSET_BASIS_32 = 2166136261U;
+	const unsigned long long OFFSET_BASIS_64 = 14695981039346656037ULL;
+
+	///////////////////////////////////////////////////
+	//	FNVHash::Hash32()
+	//
+	//	Calculate the 32-bit FNV-1a hash of a block of
+	//	bytes, going on from the passed in hash.
+	///////////////////////////////////////////////////
+	inline uint32_t Hash32(const void* data, size_t size, uint32_t hash = OFFSET_BASIS_32)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 16777619U;
+		}
+		return(hash);
+	}
+
+	///////////////////////////////////////////////////
+	//	FNVHash::Hash64()
+	//
+	//	Calculate the 64-bit FNV-1a hash of a block of
+	//	bytes, going on from the passed in hash.
+	///////////////////////////////////////////////////
+	inline unsigned long long Hash64(const void* data, size_t size, unsigned long long hash = OFFSET_BASIS_64)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return(hash);
+	}
+}
@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ================
+// shadow the OpenGL state that is set while rendering, and skip the calls
+// that would set it to the value it already has
+//
+// Every shadowed value starts out unknown, so the first call of each kind
+// is always issued.  The texture bindings are kept per texture unit, and the
+// active texture unit is only changed when a binding has to change.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+
+namespace
+{
+	// number of texture units and capabilities that are shadowed
+	constexpr GLuint MAX_TEXTURE_UNITS = 32;
+	constexpr int MAX_CAPABILITIES = 8;
+
+	// a shadowed value, which is unknown until it was first set
+	template <typename T>
+	struct SHADOW_VALUE
+	{
+		T value;
+		bool bKnown;
+	};
+
+	// the texture bound to a texture unit
+	struct TEXTURE_BINDING
+	{
+		GLenum target;
+		GLuint texture;
+		bool bKnown;
+	};
+
+	// whether a capability is enabled
+	struct CAPABILITY_STATE
+	{
+		GLenum capability;
+		bool bEnabled;
+	};
+
+	// the shadowed state of the current context
+	struct STATE_SHADOW
+	{
+		SHADOW_VALUE<GLuint> program;
+		SHADOW_VALUE<GLuint> vertexArray;
+		SHADOW_VALUE<GLuint> activeTextureUnit;
+		TEXTURE_BINDING textures[MAX_TEXTURE_UNITS];
+		CAPABILITY_STATE capabilities[MAX_CAPABILITIES];
+		int capabilityCount;
+		SHADOW_VALUE<GLenum> blendSource;
+		SHADOW_VALUE<GLenum> blendDestination;
+		SHADOW_VALUE<GLenum> depthFunction;
+		SHADOW_VALUE<bool> depthWrite;
+	};
+
+	STATE_SHADOW g_State = {};
+	unsigned int g_ElidedCallCount = 0;
+
+	///////////////////////////////////////////////////
+	//	IsSet()
+	//
+	//	Check whether a shadowed value already holds the
+	//	passed in value, and remember the value when it
+	//	does not, so that the caller issues the call.
+	///////////////////////////////////////////////////
+	template <typename T>
+	inline bool IsSet(SHADOW_VALUE<T>& shadow, T value)
+	{
+		if (shadow.bKnown && shadow.value == value)
+		{
+			++g_ElidedCallCount;
+			return true;
+		}
+
+		shadow.value = value;
+		shadow.bKnown = true;
+		return false;
+	}
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::Invalidate()
+//
+//	Mark every shadowed value as unknown.
+///////////////////////////////////////////////////
+void GLStateCache::Invalidate()
+{
+	g_State = {};
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::UseProgram()
+//
+//	Make the passed in program current.
+///////////////////////////////////////////////////
+void GLStateCache::UseProgram(GLuint program)
+{
+	if (IsSet(g_State.program, program) == false)
+	{
+		glUseProgram(program);
+	}
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::BindVertexArray()
+//
+//	Bind the passed in vertex array object.
+///////////////////////////////////////////////////
+void GLStateCache::BindVertexArray(GLuint vertexArray)
+{
+	if (IsSet(g_State.vertexArray, vertexArray) == false)
+	{
+		glBindVertexArray(vertexArray);
+	}
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::BindTexture()
+//
+//	Bind a texture to a texture unit.  The units past
+//	the shadowed ones are always bound.
+///////////////////////////////////////////////////
+void GLStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	if (unit < MAX_TEXTURE_UNITS)
+	{
+		TEXTURE_BINDING& binding = g_State.textures[unit];
+		if (binding.bKnown && binding.target == target && binding.texture == texture)
+		{
+			++g_ElidedCallCount;
+			return;
+		}
+
+		binding.target = target;
+		binding.texture = texture;
+		binding.bKnown = true;
+	}
+
+	if (IsSet(g_State.activeTextureUnit, unit) == false)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	glBindTexture(target, texture);
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::SetCapability()
+//
+//	Enable or disable a capability.  Once all of the
+//	slots for capabilities are used, the others are
+//	always set.
+///////////////////////////////////////////////////
+void GLStateCache::SetCapability(GLenum capability, bool bEnabled)
+{
+	int index = 0;
+	while (index < g_State.capabilityCount && g_State.capabilities[index].capability != capability)
+	{
+		index++;
+	}
+
+	if (index < g_State.capabilityCount)
+	{
+		if (g_State.capabilities[index].bEnabled == bEnabled)
+		{
+			++g_ElidedCallCount;
+			return;
+		}
+		g_State.capabilities[index].bEnabled = bEnabled;
+	}
+	else if (index < MAX_CAPABILITIES)
+	{
+		g_State.capabilities[index].capability = capability;
+		g_State.capabilities[index].bEnabled = bEnabled;
+		g_State.capabilityCount++;
+	}
+
+	if (bEnabled)
+	{
+		glEnable(capability);
+	}
+	else
+	{
+		glDisable(capability);
+	}
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::BlendFunc()
+//
+//	Set the source and destination blend factors.
+///////////////////////////////////////////////////
+void GLStateCache::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	bool bSourceSet = g_State.blendSource.bKnown && g_State.blendSource.value == sourceFactor;
+	bool bDestinationSet = g_State.blendDestination.bKnown && g_State.blendDestination.value == destinationFactor;
+
+	if (bSourceSet && bDestinationSet)
+	{
+		++g_ElidedCallCount;
+		return;
+	}
+
+	g_State.blendSource = { sourceFactor, true };
+	g_State.blendDestination = { destinationFactor, true };
+	glBlendFunc(sourceFactor, destinationFactor);
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::DepthFunc()
+//
+//	Set the depth comparison function.
+///////////////////////////////////////////////////
+void GLStateCache::DepthFunc(GLenum function)
+{
+	if (IsSet(g_State.depthFunction, function) == false)
+	{
+		glDepthFunc(function);
+	}
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::DepthMask()
+//
+//	Enable or disable the writes to the depth buffer.
+///////////////////////////////////////////////////
+void GLStateCache::DepthMask(bool bWrite)
+{
+	if (IsSet(g_State.depthWrite, bWrite) == false)
+	{
+		glDepthMask(bWrite ? GL_TRUE : GL_FALSE);
+	}
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::CountElidedCall()
+//
+//	Count a call that another class skipped because
+//	it would not have changed anything.
+///////////////////////////////////////////////////
+void GLStateCache::CountElidedCall()
+{
+	++g_ElidedCallCount;
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::GetElidedCallCount()
+//
+//	Get the number of skipped calls since the count
+//	was last reset.
+///////////////////////////////////////////////////
+unsigned int GLStateCache::GetElidedCallCount()
+{
+	return g_ElidedCallCount;
+}
+
+///////////////////////////////////////////////////
+//	GLStateCache::ResetElidedCallCount()
+//
+//	Reset the number of skipped calls, usually at the
+//	start of each frame.
+///////////////////////////////////////////////////
+void GLStateCache::ResetElidedCallCount()
+{
+	g_ElidedCallCount = 0;
+}
@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ==============
+// shadow the OpenGL state that is set while rendering, and skip the calls
+// that would set it to the value it already has
+//
+// The current program, vertex array object, texture bindings, enabled
+// capabilities and the blend and depth functions are kept for the current
+// context.  All of the binds of this state must go through these functions,
+// since a direct OpenGL call leaves the shadowed value out of date.  The
+// skipped calls, including the uniform and uniform buffer writes skipped by
+// the shader manager, are counted so they can be reported per frame.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+namespace GLStateCache
+{
+	// forget all of the shadowed state, so that the next call of
+	// every kind is issued - needed once a context was made current
+	void Invalidate();
+
+	// bind the program, vertex array object or texture
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+	// enable or disable a capability such as GL_BLEND or
+	// GL_DEPTH_TEST, and set the blend and depth functions
+	void SetCapability(GLenum capability, bool bEnabled);
+	void BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+	void DepthFunc(GLenum function);
+	void DepthMask(bool bWrite);
+
+	// count a call that was skipped outside of the state cache
+	void CountElidedCall();
+	// number of calls skipped since the count was last reset
+	unsigned int GetElidedCallCount();
+	void ResetElidedCallCount();
+}
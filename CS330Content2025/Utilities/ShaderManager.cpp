@@ -16,6 +16,16 @@
  * - Compiles vertex and fragment shaders and checks for errors.
  * - Links shaders into an OpenGL shader program.
  * - Outputs detailed error messages for debugging shader compilation and linking.
+ * - Caches the location of every active uniform once the program is linked.
+ * - Creates uniform buffers and attaches uniform blocks to their binding points.
+ * - Forgets the last written uniform values whenever a program is linked.
+ * - Keeps the binaries of the linked programs on disk, named by a hash of the
+ *   shader sources and the driver, and loads them instead of compiling the
+ *   sources again on the next start.
+ * - Compiles variants of the loaded shaders with added #define lines when
+ *   they are first used, each with its own uniform tables.
+ * - Submits the compiles of the programs without waiting for them, so that
+ *   a driver with parallel shader compiles works on them in the background.
  *
  * USAGE:
  * - Use `LoadShaders()` to load, compile, and link shaders from file paths.
@@ -36,6 +46,7 @@
 #include <fstream>
 #include <algorithm>
 #include <sstream>
+#include <chrono>
 using namespace std;
 
 #include <stdlib.h>
@@ -44,19 +55,122 @@ using namespace std;
 #include <GL/glew.h>
 
 #include "ShaderManager.h"
+#include "FNVHash.h"
+
+/***********************************************************
+ *  ~ShaderManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderManager::~ShaderManager()
+{
+	// free the created uniform buffers
+	for (auto& uniformBuffer : m_uniformBuffers)
+	{
+		glDeleteBuffers(1, &uniformBuffer.second.buffer);
+	}
+	m_uniformBuffers.clear();
+}
 
 /***********************************************************
  *  LoadShaders()
  *
  *  This method is called to load the shader data from 
- *  external GLSL compatible files.
+ *  external GLSL compatible files.  The linked program is
+ *  loaded from the binary cache when the same sources were
+ *  linked before by the same driver, and compiled from the
+ *  sources otherwise.
  ***********************************************************/
 GLuint ShaderManager::LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+	if (false == LoadShaderSources(vertex_file_path, fragment_file_path))
+	{
+		return 0;
+	}
+	m_variants[0].bRequested = true;
+
+	// record the uniform locations once the program is linked
+	// so the setters never need to query the driver during rendering
+	StartVariantBuild(0);
+	FinishVariantBuild(0);
+
+	return m_programID;
+}
+
+/***********************************************************
+ *  LoadShadersAsync()
+ *
+ *  This method is called to load the shader data from 
+ *  external GLSL compatible files without waiting for the
+ *  program to be compiled and linked.  Where the driver
+ *  supports parallel shader compiles, it compiles the
+ *  program on its own threads while the application goes
+ *  on loading, and the program is finished by
+ *  pollProgramVariants() or when it is first used.
+ ***********************************************************/
+GLuint ShaderManager::LoadShadersAsync(const char* vertex_file_path, const char* fragment_file_path)
+{
+	if (false == m_bAsyncCompileEnabled)
+	{
+		return LoadShaders(vertex_file_path, fragment_file_path);
+	}
+
+	if (false == LoadShaderSources(vertex_file_path, fragment_file_path))
+	{
+		return 0;
+	}
+	m_variants[0].bRequested = true;
+
+	EnableParallelCompile();
+	StartVariantBuild(0);
+
+	// nothing can be looked up before the program is linked, so
+	// the uniform writes are dropped until then
+	m_programID = m_variants[0].programID;
+	m_uniformLocations.clear();
+	m_uniformValues.clear();
+	m_handleLocations.assign(m_handleNames.size(), -1);
+
+	return m_programID;
+}
+
+/***********************************************************
+ *  LoadShaderVariants()
+ *
+ *  This method is called to load the shader data from 
+ *  external GLSL compatible files for the variants that
+ *  are compiled from them.  No program is compiled here,
+ *  and the program without any defines is only compiled
+ *  when it is asked for with getProgramVariant(), so an
+ *  application that only draws with variants does not
+ *  compile it.  Returns false if the files cannot be read.
+ ***********************************************************/
+bool ShaderManager::LoadShaderVariants(const char* vertex_file_path, const char* fragment_file_path)
+{
+	if (false == LoadShaderSources(vertex_file_path, fragment_file_path))
+	{
+		return false;
+	}
+
+	// nothing can be looked up before a variant is made current,
+	// so the uniform writes are dropped until then
+	m_uniformLocations.clear();
+	m_uniformValues.clear();
+	m_handleLocations.assign(m_handleNames.size(), -1);
+
+	return true;
+}
 
+/***********************************************************
+ *  LoadShaderSources()
+ *
+ *  This method is called to read the shader sources that
+ *  the program and its variants are compiled from.  The
+ *  programs of the sources loaded before are deleted, and
+ *  their variants are compiled again when next used.
+ ***********************************************************/
+bool ShaderManager::LoadShaderSources(const char* vertex_file_path, const char* fragment_file_path)
+{
 	// Read the Vertex Shader code from the file
 	std::string VertexShaderCode;
 	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
@@ -68,7 +182,7 @@ GLuint ShaderManager::LoadShaders(const char * vertex_file_path,const char * fra
 	}else{
 		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
 		getchar();
-		return 0;
+		return false;
 	}
 
 	// Read the Fragment Shader code from the file
@@ -81,70 +195,1050 @@ GLuint ShaderManager::LoadShaders(const char * vertex_file_path,const char * fra
 		FragmentShaderStream.close();
 	}
 
-	GLint Result = GL_FALSE;
-	int InfoLogLength;
+	// the sources are kept for compiling the variants later
+	m_vertexShaderPath = vertex_file_path;
+	m_fragmentShaderPath = fragment_file_path;
+	m_vertexShaderCode = VertexShaderCode;
+	m_fragmentShaderCode = FragmentShaderCode;
 
+	// the variants keep their numbers, but are compiled again
+	// from the new sources
+	if (m_variants.size() == 0)
+	{
+		m_variants.push_back(ProgramVariant());
+	}
+	for (ProgramVariant& variant : m_variants)
+	{
+		if (true == variant.bPending)
+		{
+			glDeleteShader(variant.build.vertexShaderID);
+			glDeleteShader(variant.build.fragmentShaderID);
+		}
+		if (0 != variant.programID)
+		{
+			glDeleteProgram(variant.programID);
+		}
+		variant.programID = 0;
+		variant.bPending = false;
+		variant.bCompiled = false;
+		variant.bFailed = false;
+		variant.bTablesBuilt = false;
+		variant.uniformLocations.clear();
+		variant.handleLocations.clear();
+		variant.uniformValues.clear();
+	}
+	m_currentVariant = 0;
+	m_programID = 0;
 
-	// Compile Vertex Shader
-	printf("Compiling shader : %s...", vertex_file_path);
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
-	glCompileShader(VertexShaderID);
+	return true;
+}
+
+/***********************************************************
+ *  StartBuild()
+ *
+ *  This method is called to start creating a program from
+ *  the passed in shader sources.  The program is loaded
+ *  from the binary cache when the same sources were linked
+ *  before by the same driver.  Otherwise the shaders are
+ *  compiled and linked, without asking for the results,
+ *  so a driver with parallel shader compiles does not have
+ *  to finish them before returning.
+ ***********************************************************/
+ShaderManager::ProgramBuild ShaderManager::StartBuild(
+	const std::string& VertexShaderCode,
+	const std::string& FragmentShaderCode,
+	const std::string& variantKey)
+{
+	ProgramBuild build;
+	build.startTime = std::chrono::steady_clock::now();
+	build.name = "Shader program";
+	if (false == variantKey.empty())
+	{
+		build.name = "Shader variant [" + variantKey + "]";
+	}
 
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-		printf("\n%s\n", &VertexShaderErrorMessage[0]);
+	// a cached binary is only valid for the same sources on the
+	// same driver, so both are part of its file name
+	if ((true == m_bProgramCacheEnabled) && (true == IsProgramBinarySupported()))
+	{
+		build.cacheFilename = GetProgramCacheFilename(m_vertexShaderPath.c_str(), VertexShaderCode, FragmentShaderCode);
+		build.programID = LoadProgramBinary(build.cacheFilename);
+		build.bFromCache = (0 != build.programID);
+	}
+	if (true == build.bFromCache)
+	{
+		return build;
 	}
 
-	printf("success\n");
+	// Compile the shaders
+	build.vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	char const * VertexSourcePointer = VertexShaderCode.c_str();
+	glShaderSource(build.vertexShaderID, 1, &VertexSourcePointer , NULL);
+	glCompileShader(build.vertexShaderID);
 
-	// Compile Fragment Shader
-	printf("Compiling shader : %s...", fragment_file_path);
+	build.fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
-	glCompileShader(FragmentShaderID);
+	glShaderSource(build.fragmentShaderID, 1, &FragmentSourcePointer , NULL);
+	glCompileShader(build.fragmentShaderID);
+
+	// Link the program
+	build.programID = glCreateProgram();
+	glAttachShader(build.programID, build.vertexShaderID);
+	glAttachShader(build.programID, build.fragmentShaderID);
+	if (true == IsProgramBinarySupported())
+	{
+		glProgramParameteri(build.programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(build.programID);
+
+	return build;
+}
 
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-		printf("\n%s\n", &FragmentShaderErrorMessage[0]);
+/***********************************************************
+ *  IsBuildComplete()
+ *
+ *  This method returns true when finishing the program
+ *  would not wait for the driver.  Without parallel shader
+ *  compiles the driver cannot be asked, so the program is
+ *  taken as complete and finishing it may wait.
+ ***********************************************************/
+bool ShaderManager::IsBuildComplete(const ProgramBuild& build) const
+{
+	if ((true == build.bFromCache) || (false == m_bParallelCompile))
+	{
+		return true;
 	}
 
-	printf("success\n");
+	GLint bComplete = GL_FALSE;
+	glGetProgramiv(build.programID, GL_COMPLETION_STATUS_KHR, &bComplete);
+
+	return (GL_FALSE != bComplete);
+}
+
+/***********************************************************
+ *  FinishBuild()
+ *
+ *  This method is called to check the results of compiling
+ *  and linking a program, which waits for the driver if it
+ *  has not finished them yet.  A linked program is saved to
+ *  the binary cache.
+ ***********************************************************/
+GLuint ShaderManager::FinishBuild(ProgramBuild& build)
+{
+	if (false == build.bFromCache)
+	{
+		GLint Result = GL_FALSE;
+		int InfoLogLength;
+
+		// Check Vertex Shader
+		printf("Compiling shader : %s...", m_vertexShaderPath.c_str());
+		glGetShaderiv(build.vertexShaderID, GL_COMPILE_STATUS, &Result);
+		glGetShaderiv(build.vertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+		if ( InfoLogLength > 0 ){
+			std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
+			glGetShaderInfoLog(build.vertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
+			printf("\n%s\n", &VertexShaderErrorMessage[0]);
+		}
+
+		printf("success\n");
+
+		// Check Fragment Shader
+		printf("Compiling shader : %s...", m_fragmentShaderPath.c_str());
+		glGetShaderiv(build.fragmentShaderID, GL_COMPILE_STATUS, &Result);
+		glGetShaderiv(build.fragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+		if ( InfoLogLength > 0 ){
+			std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
+			glGetShaderInfoLog(build.fragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
+			printf("\n%s\n", &FragmentShaderErrorMessage[0]);
+		}
+
+		printf("success\n");
+
+		// Check the program
+		printf("Linking shader program...");
+		glGetProgramiv(build.programID, GL_LINK_STATUS, &Result);
+		glGetProgramiv(build.programID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+		if ( InfoLogLength > 1 ){
+			std::vector<char> ProgramErrorMessage(InfoLogLength+1);
+			glGetProgramInfoLog(build.programID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
+			printf("\n%s\n", &ProgramErrorMessage[0]);
+		}
+
+		printf("success\n");
+		
+		glDetachShader(build.programID, build.vertexShaderID);
+		glDetachShader(build.programID, build.fragmentShaderID);
+		
+		glDeleteShader(build.vertexShaderID);
+		glDeleteShader(build.fragmentShaderID);
+		build.vertexShaderID = 0;
+		build.fragmentShaderID = 0;
+
+		if (false == build.cacheFilename.empty())
+		{
+			SaveProgramBinary(build.programID, build.cacheFilename);
+		}
+	}
+
+	// a program compiled in the background includes the time
+	// the application spent loading in the meantime
+	std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - build.startTime;
+	if (true == build.bFromCache)
+	{
+		std::cout << "INFO: " << build.name << " loaded from the binary cache in "
+			<< loadTime.count() << " ms (warm start)" << std::endl;
+	}
+	else
+	{
+		std::cout << "INFO: " << build.name << " compiled from source in "
+			<< loadTime.count() << " ms (cold start)" << std::endl;
+	}
+
+	return build.programID;
+}
+
+/***********************************************************
+ *  StartVariantBuild()
+ *
+ *  This method is called to start creating the program of
+ *  a variant from the loaded sources and its defines.
+ ***********************************************************/
+void ShaderManager::StartVariantBuild(int variant)
+{
+	ProgramVariant& target = m_variants[variant];
+
+	target.build = StartBuild(
+		InjectDefines(m_vertexShaderCode, target.defines),
+		InjectDefines(m_fragmentShaderCode, target.defines),
+		target.key);
+	target.programID = target.build.programID;
+	target.bPending = true;
+}
+
+/***********************************************************
+ *  FinishVariantBuild()
+ *
+ *  This method is called to finish the program of a
+ *  variant.  The uniforms of the current variant are
+ *  recorded right away, and those of the others when they
+ *  are first made current.  Returns false if the variant
+ *  did not compile.
+ ***********************************************************/
+bool ShaderManager::FinishVariantBuild(int variant)
+{
+	ProgramVariant& target = m_variants[variant];
+
+	FinishBuild(target.build);
+	target.bPending = false;
+
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(target.programID, GL_LINK_STATUS, &bLinked);
+	if (GL_FALSE == bLinked)
+	{
+		std::cout << target.build.name << " did not compile" << std::endl;
+		glDeleteProgram(target.programID);
+		target.programID = 0;
+		target.bFailed = true;
+		if (variant == m_currentVariant)
+		{
+			m_programID = 0;
+		}
+		return false;
+	}
+	target.bCompiled = true;
+
+	if (variant == m_currentVariant)
+	{
+		m_programID = target.programID;
+		BuildUniformCache();
+		ApplyBlockBindings();
+		target.bTablesBuilt = true;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  EnableParallelCompile()
+ *
+ *  This method is called to let the driver compile shaders
+ *  on as many threads as it likes, when it supports
+ *  parallel shader compiles.
+ ***********************************************************/
+void ShaderManager::EnableParallelCompile()
+{
+	if (true == m_bParallelCompile)
+	{
+		return;
+	}
+
+	// 0xFFFFFFFF leaves the number of threads to the driver
+	if (GLEW_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		m_bParallelCompile = true;
+	}
+	else if (GLEW_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		m_bParallelCompile = true;
+	}
+
+	std::cout << "INFO: Parallel shader compiles are "
+		<< ((true == m_bParallelCompile) ? "supported" : "not supported") << std::endl;
+}
+
+/***********************************************************
+ *  getProgramVariant()
+ *
+ *  This method is used to get the number of the variant of
+ *  the loaded shaders that is compiled with the passed in
+ *  defines.  The variant is only registered here, and is
+ *  compiled the first time it is used.
+ ***********************************************************/
+int ShaderManager::getProgramVariant(const std::vector<std::string>& defines)
+{
+	std::string key;
+	std::string defineLines;
+	for (const std::string& define : defines)
+	{
+		if (false == key.empty())
+		{
+			key += ";";
+		}
+		key += define;
+		defineLines += "#define " + define + "\n";
+	}
+
+	// the program loaded from the sources is variant 0
+	if (m_variants.size() == 0)
+	{
+		m_variants.push_back(ProgramVariant());
+	}
+
+	for (size_t i = 0; i < m_variants.size(); i++)
+	{
+		if (m_variants[i].key == key)
+		{
+			m_variants[i].bRequested = true;
+			return (int)i;
+		}
+	}
+
+	ProgramVariant variant;
+	variant.key = key;
+	variant.defines = defineLines;
+	variant.bRequested = true;
+	m_variants.push_back(variant);
+
+	return (int)(m_variants.size() - 1);
+}
+
+/***********************************************************
+ *  useProgramVariant()
+ *
+ *  This method is used to make a variant the current
+ *  program, compiling it the first time.  A variant that is
+ *  still compiling in the background is replaced by the
+ *  fallback variant, if there is one.  The uniform tables of
+ *  the program that was current are kept with it, so every
+ *  program keeps its own locations and last written values.
+ *  Returns false, keeping the current program, if the
+ *  variant does not compile.
+ ***********************************************************/
+bool ShaderManager::useProgramVariant(int variant)
+{
+	if ((variant < 0) || (variant >= (int)m_variants.size()) || (true == m_vertexShaderCode.empty()))
+	{
+		return false;
+	}
+
+	if (true == m_variants[variant].bPending)
+	{
+		// the fallback stands in for a variant that the driver is
+		// still compiling, and without one the compile is waited for
+		bool bFallbackReady = (m_fallbackVariant >= 0) && (true == m_variants[m_fallbackVariant].bCompiled);
+		if ((true == bFallbackReady) && (false == IsBuildComplete(m_variants[variant].build)))
+		{
+			variant = m_fallbackVariant;
+		}
+		else
+		{
+			FinishVariantBuild(variant);
+		}
+	}
+	else if ((false == m_variants[variant].bCompiled) && (false == m_variants[variant].bFailed))
+	{
+		StartVariantBuild(variant);
+		FinishVariantBuild(variant);
+	}
+
+	ProgramVariant& target = m_variants[variant];
+	if (true == target.bFailed)
+	{
+		return false;
+	}
+
+	if (variant != m_currentVariant)
+	{
+		ProgramVariant& current = m_variants[m_currentVariant];
+		current.uniformLocations = std::move(m_uniformLocations);
+		current.handleLocations = std::move(m_handleLocations);
+		current.uniformValues = std::move(m_uniformValues);
+		m_uniformLocations = std::move(target.uniformLocations);
+		m_handleLocations = std::move(target.handleLocations);
+		m_uniformValues = std::move(target.uniformValues);
+		m_programID = target.programID;
+		m_currentVariant = variant;
+
+		if (false == target.bTablesBuilt)
+		{
+			BuildUniformCache();
+			ApplyBlockBindings();
+			target.bTablesBuilt = true;
+		}
+		else
+		{
+			// resolve the handles given out while another program was current
+			for (size_t i = m_handleLocations.size(); i < m_handleNames.size(); i++)
+			{
+				auto found = m_uniformLocations.find(m_handleNames[i]);
+				m_handleLocations.push_back((found != m_uniformLocations.end()) ? found->second : -1);
+			}
+		}
+	}
+
+	GLStateCache::UseProgram(m_programID);
+
+	return true;
+}
+
+/***********************************************************
+ *  setAsyncCompileEnabled()
+ *
+ *  This method is used to turn the background compiles of
+ *  LoadShadersAsync() and compileProgramVariantsAsync() on
+ *  or off.  When off, every program is compiled when it is
+ *  loaded or first used.  It is on by default.
+ ***********************************************************/
+void ShaderManager::setAsyncCompileEnabled(bool bEnabled)
+{
+	m_bAsyncCompileEnabled = bEnabled;
+}
+
+/***********************************************************
+ *  compileProgramVariantsAsync()
+ *
+ *  This method is used to submit the compiles of every
+ *  variant that was asked for and is not compiled yet, so
+ *  that the driver can work on all of them at the same
+ *  time.  The
+ *  variants are finished by pollProgramVariants(), or when
+ *  they are first used.
+ ***********************************************************/
+void ShaderManager::compileProgramVariantsAsync()
+{
+	if ((false == m_bAsyncCompileEnabled) || (true == m_vertexShaderCode.empty()))
+	{
+		return;
+	}
+
+	EnableParallelCompile();
+	for (size_t i = 0; i < m_variants.size(); i++)
+	{
+		ProgramVariant& variant = m_variants[i];
+		if ((true == variant.bRequested) && (false == variant.bCompiled) &&
+			(false == variant.bPending) && (false == variant.bFailed))
+		{
+			StartVariantBuild((int)i);
+		}
+	}
+}
+
+/***********************************************************
+ *  setFallbackProgramVariant()
+ *
+ *  This method is used to set the variant that is used in
+ *  place of the variants that are still being compiled.
+ *  It should be quick to compile, since it is compiled
+ *  right away when the compiles are asynchronous.
+ ***********************************************************/
+void ShaderManager::setFallbackProgramVariant(int variant)
+{
+	if ((variant < 0) || (variant >= (int)m_variants.size()))
+	{
+		m_fallbackVariant = -1;
+		return;
+	}
+
+	m_fallbackVariant = variant;
+	if ((true == m_bAsyncCompileEnabled) && (false == m_vertexShaderCode.empty()))
+	{
+		ProgramVariant& fallback = m_variants[variant];
+		if ((false == fallback.bPending) && (false == fallback.bCompiled) && (false == fallback.bFailed))
+		{
+			StartVariantBuild(variant);
+		}
+		if (true == fallback.bPending)
+		{
+			FinishVariantBuild(variant);
+		}
+	}
+}
+
+/***********************************************************
+ *  pollProgramVariants()
+ *
+ *  This method is used to finish the variants that the
+ *  driver has compiled in the background, without waiting
+ *  for the others.  Returns true when no variant is still
+ *  being compiled.
+ ***********************************************************/
+bool ShaderManager::pollProgramVariants()
+{
+	bool bAllFinished = true;
+
+	for (size_t i = 0; i < m_variants.size(); i++)
+	{
+		if (true == m_variants[i].bPending)
+		{
+			if (true == IsBuildComplete(m_variants[i].build))
+			{
+				FinishVariantBuild((int)i);
+			}
+			else
+			{
+				bAllFinished = false;
+			}
+		}
+	}
+
+	return bAllFinished;
+}
+
+/***********************************************************
+ *  finishProgramVariants()
+ *
+ *  This method is used to wait for every variant that is
+ *  still being compiled.
+ ***********************************************************/
+void ShaderManager::finishProgramVariants()
+{
+	for (size_t i = 0; i < m_variants.size(); i++)
+	{
+		if (true == m_variants[i].bPending)
+		{
+			FinishVariantBuild((int)i);
+		}
+	}
+}
+
+/***********************************************************
+ *  getCurrentProgramVariant()
+ *
+ *  This method returns the number of the current variant.
+ ***********************************************************/
+int ShaderManager::getCurrentProgramVariant() const
+{
+	return m_currentVariant;
+}
+
+/***********************************************************
+ *  getCompiledVariantCount()
+ *
+ *  This method returns the number of variants that have
+ *  been compiled, including the program of LoadShaders().
+ ***********************************************************/
+size_t ShaderManager::getCompiledVariantCount() const
+{
+	size_t compiledCount = 0;
+	for (const ProgramVariant& variant : m_variants)
+	{
+		if (true == variant.bCompiled)
+		{
+			compiledCount++;
+		}
+	}
+	return compiledCount;
+}
+
+/***********************************************************
+ *  InjectDefines()
+ *
+ *  This method is used to add the define lines of a variant
+ *  to shader source code, after its version line, which
+ *  has to stay the first line.
+ ***********************************************************/
+std::string ShaderManager::InjectDefines(const std::string& code, const std::string& defineLines)
+{
+	size_t version = code.find("#version");
+	if (version == std::string::npos)
+	{
+		return defineLines + code;
+	}
+
+	size_t lineEnd = code.find('\n', version);
+	if (lineEnd == std::string::npos)
+	{
+		return code + "\n" + defineLines;
+	}
+
+	return code.substr(0, lineEnd + 1) + defineLines + code.substr(lineEnd + 1);
+}
+
+/***********************************************************
+ *  ApplyBlockBindings()
+ *
+ *  This method is called after a program is linked to
+ *  attach its uniform and storage blocks to the binding
+ *  points that were requested before.
+ ***********************************************************/
+void ShaderManager::ApplyBlockBindings()
+{
+	for (auto& blockBinding : m_blockBindings)
+	{
+		ApplyUniformBlockBinding(m_programID, blockBinding.first, blockBinding.second);
+	}
+	for (auto& blockBinding : m_storageBlockBindings)
+	{
+		ApplyStorageBlockBinding(m_programID, blockBinding.first, blockBinding.second);
+	}
+}
+
+/***********************************************************
+ *  setProgramCacheEnabled()
+ *
+ *  This method is used to turn the binary cache of the
+ *  linked programs on or off.  It is off by default, so
+ *  only an application that asks for it writes binaries
+ *  next to its shaders.
+ ***********************************************************/
+void ShaderManager::setProgramCacheEnabled(bool bEnabled)
+{
+	m_bProgramCacheEnabled = bEnabled;
+}
+
+/***********************************************************
+ *  setProgramCacheDirectory()
+ *
+ *  This method is used to set the existing directory that
+ *  the program binaries are kept in.  When it is not set,
+ *  they are kept next to the vertex shader file.
+ ***********************************************************/
+void ShaderManager::setProgramCacheDirectory(const std::string& directory)
+{
+	m_programCacheDirectory = directory;
+}
+
+/***********************************************************
+ *  IsProgramBinarySupported()
+ *
+ *  This method returns true when the driver can give out
+ *  and take back program binaries in at least one format.
+ ***********************************************************/
+bool ShaderManager::IsProgramBinarySupported() const
+{
+	if ((GLEW_VERSION_4_1 == GL_FALSE) && (GLEW_ARB_get_program_binary == GL_FALSE))
+	{
+		return(false);
+	}
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+	return(formatCount > 0);
+}
+
+/***********************************************************
+ *  GetProgramCacheFilename()
+ *
+ *  This method is used to build the name of the cached
+ *  binary from a hash of the shader sources and of the
+ *  vendor, renderer and version of the OpenGL driver.
+ ***********************************************************/
+std::string ShaderManager::GetProgramCacheFilename(
+	const char* vertex_file_path,
+	const std::string& VertexShaderCode,
+	const std::string& FragmentShaderCode) const
+{
+	const char* driverStrings[3] = {
+		(const char*)glGetString(GL_VENDOR),
+		(const char*)glGetString(GL_RENDERER),
+		(const char*)glGetString(GL_VERSION) };
+
+	// 64-bit FNV-1a over every string, each followed by a zero
+	// byte so that moving text between them changes the hash
+	unsigned long long hash = FNVHash::OFFSET_BASIS_64;
+	auto hashBytes = [&hash](const char* bytes, size_t count)
+	{
+		const char terminator = 0;
+		hash = FNVHash::Hash64(bytes, count, hash);
+		hash = FNVHash::Hash64(&terminator, 1, hash);
+	};
+	hashBytes(VertexShaderCode.c_str(), VertexShaderCode.size());
+	hashBytes(FragmentShaderCode.c_str(), FragmentShaderCode.size());
+	for (const char* driverString : driverStrings)
+	{
+		if (NULL != driverString)
+		{
+			hashBytes(driverString, strlen(driverString));
+		}
+	}
+
+	std::string directory = m_programCacheDirectory;
+	if (true == directory.empty())
+	{
+		std::string vertexPath = vertex_file_path;
+		size_t separator = vertexPath.find_last_of("/\\");
+		directory = (separator != std::string::npos) ? vertexPath.substr(0, separator) : ".";
+	}
+
+	char name[64];
+	snprintf(name, sizeof(name), "/program_%016llx.bin", hash);
+
+	return directory + name;
+}
+
+/***********************************************************
+ *  LoadProgramBinary()
+ *
+ *  This method is used to create a program from a cached
+ *  binary.  Returns 0 when there is no cached binary, when
+ *  the length in its header does not match the rest of the
+ *  file, or when the driver does not accept it, so that the
+ *  program is compiled from source instead.
+ ***********************************************************/
+GLuint ShaderManager::LoadProgramBinary(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+	if (false == file.is_open())
+	{
+		return 0;
+	}
+	std::streamoff fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+	if ((fileSize < (std::streamoff)sizeof(ProgramBinaryHeader)) || (false == file.good()))
+	{
+		return 0;
+	}
+
+	ProgramBinaryHeader header;
+	file.read((char*)&header, sizeof(header));
+	if (((size_t)file.gcount() != sizeof(header)) ||
+		(header.magic != PROGRAM_BINARY_MAGIC) ||
+		(header.length == 0) ||
+		(header.length > MAX_PROGRAM_BINARY_LENGTH) ||
+		((std::streamoff)header.length != fileSize - (std::streamoff)sizeof(header)))
+	{
+		std::cout << "INFO: Cached shader program " << filename << " is damaged, compiling from source" << std::endl;
+		return 0;
+	}
+
+	std::vector<char> binary(header.length);
+	file.read(&binary[0], header.length);
+	if ((size_t)file.gcount() != binary.size())
+	{
+		return 0;
+	}
 
-	// Link the program
-	printf("Linking shader program...");
 	GLuint ProgramID = glCreateProgram();
-	m_programID = ProgramID;
-	glAttachShader(ProgramID, VertexShaderID);
-	glAttachShader(ProgramID, FragmentShaderID);
-	glLinkProgram(ProgramID);
-
-	// Check the program
-	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
-	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 1 ){
-		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
-		glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
-		printf("\n%s\n", &ProgramErrorMessage[0]);
-	}
-
-	printf("success\n");
-	
-	glDetachShader(ProgramID, VertexShaderID);
-	glDetachShader(ProgramID, FragmentShaderID);
-	
-	glDeleteShader(VertexShaderID);
-	glDeleteShader(FragmentShaderID);
+	glProgramBinary(ProgramID, header.format, &binary[0], (GLsizei)header.length);
+
+	// a driver update can reject a binary made by the old driver
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &bLinked);
+	if (GL_FALSE == bLinked)
+	{
+		std::cout << "INFO: Cached shader program was rejected, compiling from source" << std::endl;
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
 
 	return ProgramID;
 }
 
+/***********************************************************
+ *  SaveProgramBinary()
+ *
+ *  This method is used to write the binary of a linked
+ *  program to the cache.
+ ***********************************************************/
+void ShaderManager::SaveProgramBinary(GLuint programID, const std::string& filename) const
+{
+	GLint bLinked = GL_FALSE;
+	GLint binaryLength = 0;
+	glGetProgramiv(programID, GL_LINK_STATUS, &bLinked);
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if ((GL_FALSE == bLinked) || (binaryLength <= 0))
+	{
+		return;
+	}
+
+	ProgramBinaryHeader header;
+	std::vector<char> binary(binaryLength);
+	GLsizei writtenLength = 0;
+	glGetProgramBinary(programID, binaryLength, &writtenLength, &header.format, &binary[0]);
+	if (writtenLength <= 0)
+	{
+		return;
+	}
+	header.magic = PROGRAM_BINARY_MAGIC;
+	header.length = (unsigned int)writtenLength;
+
+	std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (false == file.is_open())
+	{
+		std::cout << "Could not write the shader program cache " << filename << std::endl;
+		return;
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write(&binary[0], writtenLength);
+}
+
+/***********************************************************
+ *  BuildUniformCache()
+ *
+ *  This method is called after linking to enumerate the
+ *  active uniforms of the program and record their locations.
+ ***********************************************************/
+void ShaderManager::BuildUniformCache()
+{
+	m_uniformLocations.clear();
+
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<char> nameBuffer(maxNameLength + 1);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_programID, i, (GLsizei)nameBuffer.size(), &nameLength, &arraySize, &type, &nameBuffer[0]);
+
+		std::string name(&nameBuffer[0], nameLength);
+		GLint location = glGetUniformLocation(m_programID, name.c_str());
+		if (location < 0)
+		{
+			// uniforms that live in a uniform block have no location
+			continue;
+		}
+		m_uniformLocations[name] = location;
+
+		// arrays are reported as "name[0]" - also register the bare
+		// name and the location of every other element
+		size_t bracket = name.rfind("[0]");
+		if ((bracket != std::string::npos) && (bracket + 3 == name.size()))
+		{
+			std::string baseName = name.substr(0, bracket);
+			m_uniformLocations[baseName] = location;
+			for (GLint element = 1; element < arraySize; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				m_uniformLocations[elementName] = glGetUniformLocation(m_programID, elementName.c_str());
+			}
+		}
+	}
+
+	// the new program has none of the values written to the old one
+	GLint maxLocation = -1;
+	for (auto& uniformLocation : m_uniformLocations)
+	{
+		maxLocation = std::max(maxLocation, uniformLocation.second);
+	}
+	m_uniformValues.assign(maxLocation + 1, UniformValue());
+
+	// refresh the locations behind any handles already given out
+	m_handleLocations.resize(m_handleNames.size());
+	for (size_t i = 0; i < m_handleNames.size(); i++)
+	{
+		auto found = m_uniformLocations.find(m_handleNames[i]);
+		m_handleLocations[i] = (found != m_uniformLocations.end()) ? found->second : -1;
+	}
+}
+
+/***********************************************************
+ *  getUniformHandle()
+ *
+ *  This method is used to get a handle for the named uniform
+ *  that can be kept by the caller and passed to the setters
+ *  without any string lookup.  Handles may be requested
+ *  before the program is loaded.
+ ***********************************************************/
+ShaderManager::UniformHandle ShaderManager::getUniformHandle(const std::string& name)
+{
+	UniformHandle handle;
+
+	for (size_t i = 0; i < m_handleNames.size(); i++)
+	{
+		if (m_handleNames[i] == name)
+		{
+			handle.id = (int)i;
+			return handle;
+		}
+	}
+
+	auto found = m_uniformLocations.find(name);
+	m_handleNames.push_back(name);
+	m_handleLocations.push_back((found != m_uniformLocations.end()) ? found->second : -1);
+	handle.id = (int)(m_handleNames.size() - 1);
+
+	return handle;
+}
+
+/***********************************************************
+ *  createUniformBuffer()
+ *
+ *  This method is used to create a uniform buffer of the
+ *  passed in size and bind it to the passed in binding
+ *  point.  The buffer contents are then updated through
+ *  setUniformBufferData() with the same binding point.
+ ***********************************************************/
+GLuint ShaderManager::createUniformBuffer(GLuint bindingPoint, GLsizeiptr size)
+{
+	GLuint uniformBuffer = 0;
+
+	// replace any buffer that was already bound at this point
+	auto found = m_uniformBuffers.find(bindingPoint);
+	if (found != m_uniformBuffers.end())
+	{
+		glDeleteBuffers(1, &found->second.buffer);
+		m_uniformBuffers.erase(found);
+	}
+
+	// the buffer starts out cleared, so that the kept copy of
+	// its contents matches it from the start
+	UniformBuffer& created = m_uniformBuffers[bindingPoint];
+	created.contents.assign(size, 0);
+
+	glGenBuffers(1, &uniformBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, created.contents.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, uniformBuffer);
+
+	created.buffer = uniformBuffer;
 
+	return uniformBuffer;
+}
+
+/***********************************************************
+ *  bindUniformBlock()
+ *
+ *  This method is used to attach the named uniform block in
+ *  the shader program to a binding point.  The binding is
+ *  remembered and applied again whenever shaders are loaded.
+ ***********************************************************/
+void ShaderManager::bindUniformBlock(const std::string& blockName, GLuint bindingPoint)
+{
+	bool bFound = false;
+
+	for (auto& blockBinding : m_blockBindings)
+	{
+		if (blockBinding.first == blockName)
+		{
+			blockBinding.second = bindingPoint;
+			bFound = true;
+		}
+	}
+	if (false == bFound)
+	{
+		m_blockBindings.push_back(std::make_pair(blockName, bindingPoint));
+	}
+
+	// every compiled variant gets the binding
+	for (const ProgramVariant& variant : m_variants)
+	{
+		if (true == variant.bCompiled)
+		{
+			ApplyUniformBlockBinding(variant.programID, blockName, bindingPoint);
+		}
+	}
+}
+
+/***********************************************************
+ *  ApplyUniformBlockBinding()
+ *
+ *  This method is used to attach the named uniform block of
+ *  the current shader program to a binding point.
+ ***********************************************************/
+void ShaderManager::ApplyUniformBlockBinding(GLuint programID, const std::string& blockName, GLuint bindingPoint)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(programID, blockName.c_str());
+	if (GL_INVALID_INDEX == blockIndex)
+	{
+		std::cout << "Uniform block " << blockName << " is not used by the shader program" << std::endl;
+		return;
+	}
+
+	glUniformBlockBinding(programID, blockIndex, bindingPoint);
+}
+
+/***********************************************************
+ *  bindStorageBlock()
+ *
+ *  This method is used to attach the named shader storage
+ *  block in the shader program to a binding point.  The
+ *  binding is remembered and applied again whenever shaders
+ *  are loaded.  Returns false if no compiled program has
+ *  such a block, for example when the driver does not
+ *  support it.
+ ***********************************************************/
+bool ShaderManager::bindStorageBlock(const std::string& blockName, GLuint bindingPoint)
+{
+	bool bFound = false;
+
+	for (auto& blockBinding : m_storageBlockBindings)
+	{
+		if (blockBinding.first == blockName)
+		{
+			blockBinding.second = bindingPoint;
+			bFound = true;
+		}
+	}
+	if (false == bFound)
+	{
+		m_storageBlockBindings.push_back(std::make_pair(blockName, bindingPoint));
+	}
+
+	// every compiled variant gets the binding - they share the
+	// sources, so the block is found if any of them has it, and
+	// a variant that is still compiling is not waited for
+	bool bBound = false;
+	for (const ProgramVariant& variant : m_variants)
+	{
+		if (true == variant.bCompiled)
+		{
+			bBound = ApplyStorageBlockBinding(variant.programID, blockName, bindingPoint) || bBound;
+		}
+	}
+
+	return(bBound);
+}
+
+/***********************************************************
+ *  ApplyStorageBlockBinding()
+ *
+ *  This method is used to attach the named shader storage
+ *  block of the current shader program to a binding point.
+ ***********************************************************/
+bool ShaderManager::ApplyStorageBlockBinding(GLuint programID, const std::string& blockName, GLuint bindingPoint)
+{
+	if ((GLEW_VERSION_4_3 == GL_FALSE) && (GLEW_ARB_shader_storage_buffer_object == GL_FALSE))
+	{
+		return(false);
+	}
+
+	GLuint blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, blockName.c_str());
+	if (GL_INVALID_INDEX == blockIndex)
+	{
+		std::cout << "Storage block " << blockName << " is not used by the shader program" << std::endl;
+		return(false);
+	}
+
+	glShaderStorageBlockBinding(programID, blockIndex, bindingPoint);
+
+	return(true);
+}
@@ -17,6 +17,22 @@
  *    - Matrices (2x2, 3x3, 4x4)
  *    - Sampler2D for texture units.
  * - Inline functions for efficient and direct interaction with the OpenGL API.
+ * - Uniform locations are cached when the program is linked, and callers can
+ *   keep pre-resolved `UniformHandle` objects for the per-draw path.
+ * - Uniform buffer objects for state shared by every draw, such as the
+ *   camera and lights, attached to uniform blocks by binding point.
+ * - The last value written to every uniform and uniform buffer is kept, and
+ *   writing the same value again is skipped and counted by the state cache.
+ * - Linked programs can be cached on disk as driver binaries, so that a
+ *   warm start skips compiling and linking the shader sources.
+ * - Variants of the loaded shaders, specialized at compile time with
+ *   #define lines, are compiled on first use and switched with
+ *   `useProgramVariant()`.
+ * - `LoadShaderVariants` only reads the sources, for callers that draw with
+ *   variants alone, so the program without defines is not compiled.
+ * - `LoadShadersAsync` and `compileProgramVariantsAsync` submit the compiles
+ *   without waiting, using KHR_parallel_shader_compile where available, and
+ *   a fallback variant is drawn with until a variant is ready.
  *
  * USAGE:
  * - Create an instance of `ShaderManager`.
@@ -36,12 +52,18 @@
 
 #include <GL/glew.h>        // GLEW library
 
+#include "GLStateCache.h"
+
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <chrono>
+#include <cstring>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -49,90 +71,397 @@
 class ShaderManager
 {
 public:
-	unsigned int m_programID;
+	unsigned int m_programID = 0;
+
+	// pre-resolved reference to a named uniform - the handle stays
+	// valid across program reloads, only its location is refreshed
+	struct UniformHandle
+	{
+		int id = -1;
+	};
 	
+	~ShaderManager();
+
 	GLuint LoadShaders(
 		const char* vertex_file_path, 
 		const char* fragment_file_path);
+	// load the shaders without waiting for the program to be
+	// compiled - it is finished by pollProgramVariants()
+	GLuint LoadShadersAsync(
+		const char* vertex_file_path,
+		const char* fragment_file_path);
+	// load the shaders that the variants are compiled from, without
+	// compiling the program of the sources without any defines
+	bool LoadShaderVariants(
+		const char* vertex_file_path,
+		const char* fragment_file_path);
+
+	// program binary cache - off unless it is turned on, and the
+	// binaries are kept next to the vertex shader file unless
+	// another existing directory is set
+	void setProgramCacheEnabled(bool bEnabled);
+	void setProgramCacheDirectory(const std::string &directory);
+
+	// shader variants - the same sources compiled with the passed in
+	// defines, where variant 0 is the program without any defines
+	int getProgramVariant(const std::vector<std::string> &defines);
+	bool useProgramVariant(int variant);
+	int getCurrentProgramVariant() const;
+	size_t getCompiledVariantCount() const;
+
+	// background compiles - the variants are compiled at the same
+	// time where the driver supports parallel shader compiles, and
+	// the fallback variant is used until a variant is ready
+	void setAsyncCompileEnabled(bool bEnabled);
+	void compileProgramVariantsAsync();
+	void setFallbackProgramVariant(int variant);
+	bool pollProgramVariants();
+	void finishProgramVariants();
 
 	// activate the shader
 	// ------------------------------------------------------------------------
 	inline void use()
 	{
-		glUseProgram(m_programID);
+		GLStateCache::UseProgram(m_programID);
+	}
+
+	// uniform location cache
+	// ------------------------------------------------------------------------
+	UniformHandle getUniformHandle(const std::string &name);
+
+	inline GLint getUniformLocation(const std::string &name) const
+	{
+		// every active uniform was recorded when the program was linked,
+		// so a name missing from the table is not active in the program
+		auto found = m_uniformLocations.find(name);
+		GLint location = (found != m_uniformLocations.end()) ? found->second : -1;
+		countCachedLookup(location);
+		return location;
+	}
+
+	inline GLint getUniformLocation(UniformHandle handle) const
+	{
+		GLint location = (handle.id >= 0) ? m_handleLocations[handle.id] : -1;
+		countCachedLookup(location);
+		return location;
+	}
+
+	// number of glGetUniformLocation() calls replaced by the cache,
+	// which are the lookups of a location after its first one
+	inline unsigned long long getUniformLookupsAvoided() const
+	{
+		return m_uniformLookupsAvoided;
+	}
+
+	// uniform buffer objects
+	// ------------------------------------------------------------------------
+	GLuint createUniformBuffer(GLuint bindingPoint, GLsizeiptr size);
+	void bindUniformBlock(const std::string &blockName, GLuint bindingPoint);
+	// shader storage blocks need OpenGL 4.3 or ARB_shader_storage_buffer_object
+	bool bindStorageBlock(const std::string &blockName, GLuint bindingPoint);
+
+	inline void setUniformBufferData(GLuint bindingPoint, GLintptr offset, GLsizeiptr size, const void *data) const
+	{
+		auto found = m_uniformBuffers.find(bindingPoint);
+		if (found != m_uniformBuffers.end())
+		{
+			// the buffer contents are kept, so that an update with
+			// the values already in the buffer is skipped
+			std::vector<unsigned char> &contents = found->second.contents;
+			if ((offset + size) <= (GLsizeiptr)contents.size())
+			{
+				if (memcmp(&contents[offset], data, size) == 0)
+				{
+					GLStateCache::CountElidedCall();
+					return;
+				}
+				memcpy(&contents[offset], data, size);
+			}
+
+			glBindBuffer(GL_UNIFORM_BUFFER, found->second.buffer);
+			glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+		}
 	}
 
 	// utility uniform functions
 	// ------------------------------------------------------------------------
-	inline void setBoolValue(const std::string &name, bool value) const
+	template <typename T>
+	inline void setBoolValue(const T &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), (int)value);
+		GLint location = getUniformLocation(name);
+		int intValue = (int)value;
+		if (isUniformChanged(location, &intValue, sizeof(intValue)))
+			glUniform1i(location, intValue);
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setIntValue(const std::string &name, int value) const
+	template <typename T>
+	inline void setIntValue(const T &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &value, sizeof(value)))
+			glUniform1i(location, value);
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setFloatValue(const std::string &name, float value) const
+	template <typename T>
+	inline void setFloatValue(const T &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(m_programID, name.c_str()), value);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &value, sizeof(value)))
+			glUniform1f(location, value);
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setVec2Value(const std::string &name, const glm::vec2 &value) const
+	template <typename T>
+	inline void setVec2Value(const T &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &value[0], sizeof(value)))
+			glUniform2fv(location, 1, &value[0]);
 	}
 
-	inline void setVec2Value(const std::string &name, float x, float y) const
+	template <typename T>
+	inline void setVec2Value(const T &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_programID, name.c_str()), x, y);
+		setVec2Value(name, glm::vec2(x, y));
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setVec3Value(const std::string &name, const glm::vec3 &value) const
+	template <typename T>
+	inline void setVec3Value(const T &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &value[0], sizeof(value)))
+			glUniform3fv(location, 1, &value[0]);
 	}
-	inline void setVec3Value(const std::string &name, float x, float y, float z) const
+	template <typename T>
+	inline void setVec3Value(const T &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_programID, name.c_str()), x, y, z);
+		setVec3Value(name, glm::vec3(x, y, z));
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setVec4Value(const std::string &name, const glm::vec4 &value) const
+	template <typename T>
+	inline void setVec4Value(const T &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &value[0], sizeof(value)))
+			glUniform4fv(location, 1, &value[0]);
 	}
-	inline void setVec4Value(const std::string &name, float x, float y, float z, float w)
+	template <typename T>
+	inline void setVec4Value(const T &name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(m_programID, name.c_str()), x, y, z, w);
+		setVec4Value(name, glm::vec4(x, y, z, w));
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setMat2Value(const std::string &name, const glm::mat2 &mat) const
+	template <typename T>
+	inline void setMat2Value(const T &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &mat[0][0], sizeof(mat)))
+			glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]);
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setMat3Value(const std::string &name, const glm::mat3 &mat) const
+	template <typename T>
+	inline void setMat3Value(const T &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &mat[0][0], sizeof(mat)))
+			glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setMat4Value(const std::string &name, const glm::mat4 &mat) const
+	template <typename T>
+	inline void setMat4Value(const T &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, glm::value_ptr(mat), sizeof(mat)))
+			glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
 	}
 
 	// ------------------------------------------------------------------------
-	inline void setSampler2DValue(const std::string& name, const int &value) const
+	template <typename T>
+	inline void setSampler2DValue(const T &name, const int &value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		GLint location = getUniformLocation(name);
+		if (isUniformChanged(location, &value, sizeof(value)))
+			glUniform1i(location, value);
 	}
+
+private:
+	// the last value written to a uniform location, and whether the
+	// location has been looked up
+	struct UniformValue
+	{
+		size_t size = 0;
+		unsigned char data[sizeof(glm::mat4)];
+		bool bLookedUp = false;
+	};
+
+	// a program whose shaders the driver may still be compiling
+	struct ProgramBuild
+	{
+		GLuint programID = 0;
+		GLuint vertexShaderID = 0;
+		GLuint fragmentShaderID = 0;
+		bool bFromCache = false;
+		std::string cacheFilename;
+		std::string name;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+	// a variant of the loaded shaders, and the uniform tables of its
+	// program while another variant is the current one
+	struct ProgramVariant
+	{
+		std::string key;
+		std::string defines;
+		GLuint programID = 0;
+		bool bPending = false;
+		bool bCompiled = false;
+		bool bFailed = false;
+		bool bTablesBuilt = false;
+		// set when the variant is asked for, so that the program of
+		// the plain sources is only compiled when something uses it
+		bool bRequested = false;
+		ProgramBuild build;
+		std::unordered_map<std::string, GLint> uniformLocations;
+		std::vector<GLint> handleLocations;
+		std::vector<UniformValue> uniformValues;
+	};
+
+	// the start of a cached program binary file
+	static const unsigned int PROGRAM_BINARY_MAGIC = 0x42504C47;
+	// the largest program binary that is read from a cache file
+	static const unsigned int MAX_PROGRAM_BINARY_LENGTH = 64 * 1024 * 1024;
+	struct ProgramBinaryHeader
+	{
+		unsigned int magic = 0;
+		GLenum format = 0;
+		unsigned int length = 0;
+	};
+
+	// a uniform buffer and a copy of its contents
+	struct UniformBuffer
+	{
+		GLuint buffer = 0;
+		std::vector<unsigned char> contents;
+	};
+
+	// count a lookup of a location as avoided unless it is the first
+	// one - without the cache, that one would still call the driver
+	inline void countCachedLookup(GLint location) const
+	{
+		if ((location < 0) || ((size_t)location >= m_uniformValues.size()))
+		{
+			return;
+		}
+
+		UniformValue &current = m_uniformValues[location];
+		if (true == current.bLookedUp)
+		{
+			++m_uniformLookupsAvoided;
+		}
+		current.bLookedUp = true;
+	}
+
+	// true when the value differs from the one last written to the
+	// location, which is then remembered - the write is skipped and
+	// counted when it would not change anything
+	inline bool isUniformChanged(GLint location, const void *value, size_t size) const
+	{
+		if ((location < 0) || ((size_t)location >= m_uniformValues.size()))
+		{
+			// a write to a missing uniform is ignored by OpenGL anyway
+			if (location < 0)
+			{
+				GLStateCache::CountElidedCall();
+				return false;
+			}
+			return true;
+		}
+
+		UniformValue &current = m_uniformValues[location];
+		if ((current.size == size) && (memcmp(current.data, value, size) == 0))
+		{
+			GLStateCache::CountElidedCall();
+			return false;
+		}
+		memcpy(current.data, value, size);
+		current.size = size;
+		return true;
+	}
+
+	// name to location table for every active uniform in the linked program
+	std::unordered_map<std::string, GLint> m_uniformLocations;
+	// names and current locations of the handles given out to callers
+	std::vector<std::string> m_handleNames;
+	std::vector<GLint> m_handleLocations;
+	// count of driver lookups that were served from the cache
+	mutable unsigned long long m_uniformLookupsAvoided = 0;
+	// values last written to the uniforms, indexed by location
+	mutable std::vector<UniformValue> m_uniformValues;
+	// uniform buffers by binding point, and the blocks attached to them
+	mutable std::unordered_map<GLuint, UniformBuffer> m_uniformBuffers;
+	std::vector<std::pair<std::string, GLuint>> m_blockBindings;
+	std::vector<std::pair<std::string, GLuint>> m_storageBlockBindings;
+	// whether linked programs are cached, and the directory they
+	// are kept in - next to the vertex shader when empty
+	bool m_bProgramCacheEnabled = false;
+	std::string m_programCacheDirectory;
+	// the loaded shader sources, which the variants are compiled from
+	std::string m_vertexShaderPath;
+	std::string m_fragmentShaderPath;
+	std::string m_vertexShaderCode;
+	std::string m_fragmentShaderCode;
+	// the registered variants, and the one that is current
+	std::vector<ProgramVariant> m_variants;
+	int m_currentVariant = 0;
+	// the variant used while the others are compiling, if any
+	int m_fallbackVariant = -1;
+	// whether the programs are compiled in the background, and
+	// whether the driver was asked for parallel shader compiles
+	bool m_bAsyncCompileEnabled = true;
+	bool m_bParallelCompile = false;
+
+	// read the shader sources and reset the variants
+	bool LoadShaderSources(
+		const char *vertex_file_path,
+		const char *fragment_file_path);
+	// start creating a program from the shader sources, from the
+	// binary cache when possible, and finish it once the driver
+	// has compiled it
+	ProgramBuild StartBuild(
+		const std::string &VertexShaderCode,
+		const std::string &FragmentShaderCode,
+		const std::string &variantKey);
+	bool IsBuildComplete(const ProgramBuild &build) const;
+	GLuint FinishBuild(ProgramBuild &build);
+	// create the program of a variant
+	void StartVariantBuild(int variant);
+	bool FinishVariantBuild(int variant);
+	// let the driver compile shaders on several threads
+	void EnableParallelCompile();
+	// add the define lines after the version line of a shader
+	static std::string InjectDefines(const std::string &code, const std::string &defineLines);
+
+	// load and save the binaries of the linked programs
+	bool IsProgramBinarySupported() const;
+	std::string GetProgramCacheFilename(
+		const char *vertex_file_path,
+		const std::string &VertexShaderCode,
+		const std::string &FragmentShaderCode) const;
+	GLuint LoadProgramBinary(const std::string &filename);
+	void SaveProgramBinary(GLuint programID, const std::string &filename) const;
+	// enumerate the active uniforms of the linked program
+	void BuildUniformCache();
+	// attach the blocks of the current program to their binding points
+	void ApplyBlockBindings();
+	// attach the named uniform block of a program to a binding point
+	void ApplyUniformBlockBinding(GLuint programID, const std::string &blockName, GLuint bindingPoint);
+	// attach the named storage block of a program to a binding point
+	bool ApplyStorageBlockBinding(GLuint programID, const std::string &blockName, GLuint bindingPoint);
 };
\ No newline at end of file
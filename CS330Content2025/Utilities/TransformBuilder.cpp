@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbuilder.cpp
+// ====================
+// build model matrices directly from scale, rotation and position values
+//
+// With the rotation matrices multiplied out, the upper 3x3 block of the model
+// matrix is R = Rz * Ry * Rx with the columns scaled, and the last column is
+// the position, so only the sines and cosines of the three angles are needed.
+//
+// The batched version keeps one matrix element of four objects in each
+// glm_vec4, computes the sines and cosines of four angles at once with a
+// polynomial, and transposes the elements into the matrix columns.
+// The GLM SIMD functions need GLM_FORCE_INTRINSICS, which the project
+// defines for every file, like for the mesh generator.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBuilder.h"
+
+#include <glm/simd/common.h>
+#include <glm/simd/matrix.h>
+
+#include <cmath>     // Required for std::sin and std::cos
+
+namespace
+{
+	constexpr float g_DegreesToRadians = 3.14159265358979f / 180.0f;
+
+	///////////////////////////////////////////////////
+	//	WriteTransform()
+	//
+	//	Write the model matrix for the passed in scale,
+	//	sines and cosines of the angles, and position.
+	///////////////////////////////////////////////////
+	inline void WriteTransform(
+		float* matrix,
+		const glm::vec3& scaleXYZ,
+		float sinX, float cosX,
+		float sinY, float cosY,
+		float sinZ, float cosZ,
+		const glm::vec3& positionXYZ)
+	{
+		float sinYsinX = sinY * sinX;
+		float sinYcosX = sinY * cosX;
+
+		matrix[0] = cosZ * cosY * scaleXYZ.x;
+		matrix[1] = sinZ * cosY * scaleXYZ.x;
+		matrix[2] = -sinY * scaleXYZ.x;
+		matrix[3] = 0.0f;
+
+		matrix[4] = (cosZ * sinYsinX - sinZ * cosX) * scaleXYZ.y;
+		matrix[5] = (sinZ * sinYsinX + cosZ * cosX) * scaleXYZ.y;
+		matrix[6] = cosY * sinX * scaleXYZ.y;
+		matrix[7] = 0.0f;
+
+		matrix[8] = (cosZ * sinYcosX + sinZ * sinX) * scaleXYZ.z;
+		matrix[9] = (sinZ * sinYcosX - cosZ * sinX) * scaleXYZ.z;
+		matrix[10] = cosY * cosX * scaleXYZ.z;
+		matrix[11] = 0.0f;
+
+		matrix[12] = positionXYZ.x;
+		matrix[13] = positionXYZ.y;
+		matrix[14] = positionXYZ.z;
+		matrix[15] = 1.0f;
+	}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	// one matrix element of four objects
+	typedef glm_vec4 LANES;
+
+	inline LANES SplatLanes(float value) { return(_mm_set1_ps(value)); }
+	inline LANES AddLanes(LANES a, LANES b) { return(glm_vec4_add(a, b)); }
+	inline LANES SubLanes(LANES a, LANES b) { return(glm_vec4_sub(a, b)); }
+	inline LANES MulLanes(LANES a, LANES b) { return(glm_vec4_mul(a, b)); }
+
+	///////////////////////////////////////////////////
+	//	LoadLanes()
+	//
+	//	Gather one component of four consecutive values.
+	///////////////////////////////////////////////////
+	inline LANES LoadLanes(const glm::vec3* values, int component)
+	{
+		return(_mm_setr_ps(
+			values[0][component],
+			values[1][component],
+			values[2][component],
+			values[3][component]));
+	}
+
+	///////////////////////////////////////////////////
+	//	SinCosLanes()
+	//
+	//	Calculate the sines and cosines of four angles in
+	//	radians.  The angle is reduced to the nearest
+	//	multiple of pi/4 in three steps for precision, and
+	//	the octant selects the polynomial and the signs.
+	//	The error stays below 1e-6 for angles up to a few
+	//	thousand radians.
+	///////////////////////////////////////////////////
+	inline void SinCosLanes(LANES angles, LANES& sines, LANES& cosines)
+	{
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+
+		__m128 sinSign = _mm_and_ps(angles, signMask);
+		__m128 x = _mm_andnot_ps(signMask, angles);
+
+		// octant of the angle, rounded up to an even number
+		__m128i octant = _mm_cvttps_epi32(MulLanes(x, SplatLanes(1.27323954473516f)));
+		octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+		octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+		__m128 y = _mm_cvtepi32_ps(octant);
+
+		sinSign = _mm_xor_ps(sinSign,
+			_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+		__m128 sinPolyMask = _mm_castsi128_ps(
+			_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+		x = SubLanes(x, MulLanes(y, SplatLanes(0.78515625f)));
+		x = SubLanes(x, MulLanes(y, SplatLanes(2.4187564849853515625e-4f)));
+		x = SubLanes(x, MulLanes(y, SplatLanes(3.77489497744594108e-8f)));
+		__m128 z = MulLanes(x, x);
+
+		__m128 cosPoly = SplatLanes(2.443315711809948e-5f);
+		cosPoly = AddLanes(MulLanes(cosPoly, z), SplatLanes(-1.388731625493765e-3f));
+		cosPoly = AddLanes(MulLanes(cosPoly, z), SplatLanes(4.166664568298827e-2f));
+		cosPoly = MulLanes(MulLanes(cosPoly, z), z);
+		cosPoly = SubLanes(cosPoly, MulLanes(z, SplatLanes(0.5f)));
+		cosPoly = AddLanes(cosPoly, SplatLanes(1.0f));
+
+		__m128 sinPoly = SplatLanes(-1.9515295891e-4f);
+		sinPoly = AddLanes(MulLanes(sinPoly, z), SplatLanes(8.3321608736e-3f));
+		sinPoly = AddLanes(MulLanes(sinPoly, z), SplatLanes(-1.6666654611e-1f));
+		sinPoly = AddLanes(MulLanes(MulLanes(sinPoly, z), x), x);
+
+		sines = _mm_or_ps(_mm_and_ps(sinPolyMask, sinPoly), _mm_andnot_ps(sinPolyMask, cosPoly));
+		cosines = _mm_or_ps(_mm_and_ps(sinPolyMask, cosPoly), _mm_andnot_ps(sinPolyMask, sinPoly));
+		sines = _mm_xor_ps(sines, sinSign);
+		cosines = _mm_xor_ps(cosines, cosSign);
+	}
+
+	///////////////////////////////////////////////////
+	//	ComposeFourTransforms()
+	//
+	//	Build the model matrices of four consecutive
+	//	objects.
+	///////////////////////////////////////////////////
+	inline void ComposeFourTransforms(
+		const glm::vec3* scales,
+		const glm::vec3* rotationsDegrees,
+		const glm::vec3* positions,
+		glm::mat4* matrices)
+	{
+		const LANES toRadians = SplatLanes(g_DegreesToRadians);
+		const LANES zero = SplatLanes(0.0f);
+		const LANES one = SplatLanes(1.0f);
+
+		LANES sinX, cosX, sinY, cosY, sinZ, cosZ;
+		SinCosLanes(MulLanes(LoadLanes(rotationsDegrees, 0), toRadians), sinX, cosX);
+		SinCosLanes(MulLanes(LoadLanes(rotationsDegrees, 1), toRadians), sinY, cosY);
+		SinCosLanes(MulLanes(LoadLanes(rotationsDegrees, 2), toRadians), sinZ, cosZ);
+
+		LANES scaleX = LoadLanes(scales, 0);
+		LANES scaleY = LoadLanes(scales, 1);
+		LANES scaleZ = LoadLanes(scales, 2);
+		LANES sinYsinX = MulLanes(sinY, sinX);
+		LANES sinYcosX = MulLanes(sinY, cosX);
+
+		// the elements of each matrix column, one object per lane
+		LANES columns[4][4];
+		columns[0][0] = MulLanes(MulLanes(cosZ, cosY), scaleX);
+		columns[0][1] = MulLanes(MulLanes(sinZ, cosY), scaleX);
+		columns[0][2] = MulLanes(SubLanes(zero, sinY), scaleX);
+		columns[0][3] = zero;
+
+		columns[1][0] = MulLanes(SubLanes(MulLanes(cosZ, sinYsinX), MulLanes(sinZ, cosX)), scaleY);
+		columns[1][1] = MulLanes(AddLanes(MulLanes(sinZ, sinYsinX), MulLanes(cosZ, cosX)), scaleY);
+		columns[1][2] = MulLanes(MulLanes(cosY, sinX), scaleY);
+		columns[1][3] = zero;
+
+		columns[2][0] = MulLanes(AddLanes(MulLanes(cosZ, sinYcosX), MulLanes(sinZ, sinX)), scaleZ);
+		columns[2][1] = MulLanes(SubLanes(MulLanes(sinZ, sinYcosX), MulLanes(cosZ, sinX)), scaleZ);
+		columns[2][2] = MulLanes(MulLanes(cosY, cosX), scaleZ);
+		columns[2][3] = zero;
+
+		columns[3][0] = LoadLanes(positions, 0);
+		columns[3][1] = LoadLanes(positions, 1);
+		columns[3][2] = LoadLanes(positions, 2);
+		columns[3][3] = one;
+
+		for (int column = 0; column < 4; ++column)
+		{
+			glm_vec4 objectColumns[4];
+			glm_mat4_transpose(columns[column], objectColumns);
+
+			for (int k = 0; k < 4; ++k)
+			{
+				_mm_storeu_ps(&matrices[k][column][0], objectColumns[k]);
+			}
+		}
+	}
+#endif
+}
+
+///////////////////////////////////////////////////
+//	TransformBuilder::ComposeTransform()
+//
+//	Build the model matrix for one object.
+///////////////////////////////////////////////////
+glm::mat4 TransformBuilder::ComposeTransform(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	glm::vec3 radians = rotationDegrees * g_DegreesToRadians;
+	glm::mat4 matrix;
+
+	WriteTransform(
+		&matrix[0][0],
+		scaleXYZ,
+		std::sin(radians.x), std::cos(radians.x),
+		std::sin(radians.y), std::cos(radians.y),
+		std::sin(radians.z), std::cos(radians.z),
+		positionXYZ);
+
+	return(matrix);
+}
+
+///////////////////////////////////////////////////
+//	TransformBuilder::ComposeTransforms()
+//
+//	Build the model matrices for a number of objects,
+//	four at a time where the GLM SIMD functions are
+//	available, and the remaining ones one at a time.
+///////////////////////////////////////////////////
+void TransformBuilder::ComposeTransforms(
+	const glm::vec3* scales,
+	const glm::vec3* rotationsDegrees,
+	const glm::vec3* positions,
+	glm::mat4* matrices,
+	size_t count)
+{
+	size_t i = 0;
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+	for (; i + 4 <= count; i += 4)
+	{
+		ComposeFourTransforms(scales + i, rotationsDegrees + i, positions + i, matrices + i);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		matrices[i] = ComposeTransform(scales[i], rotationsDegrees[i], positions[i]);
+	}
+}
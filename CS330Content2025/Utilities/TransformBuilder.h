@@ -0,0 +1,35 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbuilder.h
+// ==================
+// build model matrices directly from scale, rotation and position values
+//
+// The matrices equal translation * rotationZ * rotationY * rotationX * scale,
+// with the rotations in degrees, but each element is written once from the
+// sines and cosines of the angles instead of multiplying five 4x4 matrices.
+// The batched version builds four matrices at a time with the GLM SIMD
+// functions, from separate arrays of scales, rotations and positions.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+namespace TransformBuilder
+{
+	// build the model matrix from the passed in transform values
+	glm::mat4 ComposeTransform(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+
+	// build the model matrices of a number of objects, whose
+	// transform values are read from the passed in arrays
+	void ComposeTransforms(
+		const glm::vec3* scales,
+		const glm::vec3* rotationsDegrees,
+		const glm::vec3* positions,
+		glm::mat4* matrices,
+		size_t count);
+}
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// zoneprofiler.cpp
+// ================
+// record the timed zones of every thread and write them as a Chrome trace
+//
+// Each thread gets a ring buffer the first time it records a zone.  Only that
+// thread writes to it, so a zone is recorded with a single store of the write
+// count.  The rings are kept after their thread ends, so that the trace still
+// has its zones.  The time stamp counter ticks are converted to microseconds
+// by comparing the ticks with the steady clock over the whole run.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef ENABLE_ZONE_PROFILER
+
+#include "ZoneProfiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	// number of zones kept per thread, a power of two
+	constexpr uint64_t RING_CAPACITY = 1 << 16;
+
+	// a finished zone
+	struct ZONE_RECORD
+	{
+		const char* name;
+		uint64_t startTicks;
+		uint64_t endTicks;
+	};
+
+	// the most recent zones of one thread
+	struct THREAD_RING
+	{
+		unsigned int threadID;
+		const char* threadName;
+		std::atomic<uint64_t> writeCount;
+		ZONE_RECORD records[RING_CAPACITY];
+	};
+
+	// a timestamp taken together with the steady clock, used to
+	// convert the timestamp ticks into microseconds
+	struct CLOCK_SAMPLE
+	{
+		uint64_t ticks;
+		std::chrono::steady_clock::time_point time;
+	};
+
+	/***********************************************************
+	 *  SampleClocks()
+	 *
+	 *  This function is used for reading the timestamp and
+	 *  the steady clock together.
+	 ***********************************************************/
+	CLOCK_SAMPLE SampleClocks()
+	{
+		CLOCK_SAMPLE sample;
+		sample.ticks = ZoneProfiler::ReadTimestamp();
+		sample.time = std::chrono::steady_clock::now();
+		return(sample);
+	}
+
+	// the rings of all threads, which are only locked when a thread
+	// records its first zone and while the trace is written
+	std::mutex g_RingMutex;
+	std::vector<std::unique_ptr<THREAD_RING>> g_Rings;
+
+	// the clocks when the application started
+	const CLOCK_SAMPLE g_StartSample = SampleClocks();
+
+	thread_local THREAD_RING* t_pRing = nullptr;
+
+	/***********************************************************
+	 *  GetThreadRing()
+	 *
+	 *  This function is used for getting the ring of the
+	 *  calling thread, which is created for the first zone
+	 *  of the thread.
+	 ***********************************************************/
+	THREAD_RING* GetThreadRing()
+	{
+		if (t_pRing == nullptr)
+		{
+			std::unique_ptr<THREAD_RING> ring(new THREAD_RING);
+			ring->threadName = nullptr;
+			ring->writeCount.store(0, std::memory_order_relaxed);
+
+			std::lock_guard<std::mutex> lock(g_RingMutex);
+			ring->threadID = static_cast<unsigned int>(g_Rings.size()) + 1;
+			t_pRing = ring.get();
+			g_Rings.push_back(std::move(ring));
+		}
+		return(t_pRing);
+	}
+
+	/***********************************************************
+	 *  WriteJSONString()
+	 *
+	 *  This function is used for writing a string value
+	 *  with its quotes, and the backslashes and quotes in
+	 *  it escaped.
+	 ***********************************************************/
+	void WriteJSONString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* character = text; *character != '\0'; character++)
+		{
+			if (*character == '"' || *character == '\\')
+			{
+				fputc('\\', file);
+			}
+			fputc(*character, file);
+		}
+		fputc('"', file);
+	}
+}
+
+/***********************************************************
+ *  ZoneProfiler::RecordZone()
+ *
+ *  This function is used for storing a finished zone in
+ *  the ring of the calling thread, over the oldest zone
+ *  once the ring is full.
+ ***********************************************************/
+void ZoneProfiler::RecordZone(const char* name, uint64_t startTicks, uint64_t endTicks)
+{
+	THREAD_RING* ring = GetThreadRing();
+	uint64_t index = ring->writeCount.load(std::memory_order_relaxed);
+
+	ZONE_RECORD& record = ring->records[index & (RING_CAPACITY - 1)];
+	record.name = name;
+	record.startTicks = startTicks;
+	record.endTicks = endTicks;
+
+	ring->writeCount.store(index + 1, std::memory_order_release);
+}
+
+/***********************************************************
+ *  ZoneProfiler::SetThreadName()
+ *
+ *  This function is used for naming the calling thread
+ *  in the trace.
+ ***********************************************************/
+void ZoneProfiler::SetThreadName(const char* name)
+{
+	GetThreadRing()->threadName = name;
+}
+
+/***********************************************************
+ *  ZoneProfiler::WriteChromeTrace()
+ *
+ *  This function is used for writing the recorded zones
+ *  as complete events of the Chrome trace event format,
+ *  in microseconds since the application started.
+ ***********************************************************/
+bool ZoneProfiler::WriteChromeTrace(const std::string& filename)
+{
+	FILE* file = fopen(filename.c_str(), "w");
+	if (NULL == file)
+	{
+		std::cout << "Could not write the profiler trace to " << filename << std::endl;
+		return(false);
+	}
+
+	CLOCK_SAMPLE endSample = SampleClocks();
+	double elapsedMicroseconds =
+		std::chrono::duration<double, std::micro>(endSample.time - g_StartSample.time).count();
+	double ticksPerMicrosecond = 1.0;
+	if ((elapsedMicroseconds > 0.0) && (endSample.ticks > g_StartSample.ticks))
+	{
+		ticksPerMicrosecond = static_cast<double>(endSample.ticks - g_StartSample.ticks) / elapsedMicroseconds;
+	}
+
+	std::lock_guard<std::mutex> lock(g_RingMutex);
+
+	size_t zoneCount = 0;
+	bool bFirstEvent = true;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	for (const std::unique_ptr<THREAD_RING>& ring : g_Rings)
+	{
+		if (ring->threadName != nullptr)
+		{
+			fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+				(true == bFirstEvent) ? "" : ",", ring->threadID);
+			WriteJSONString(file, ring->threadName);
+			fprintf(file, "}}");
+			bFirstEvent = false;
+		}
+
+		// once the ring has wrapped around, only the last
+		// zones it can hold are still in it
+		uint64_t writeCount = ring->writeCount.load(std::memory_order_acquire);
+		uint64_t first = (writeCount > RING_CAPACITY) ? writeCount - RING_CAPACITY : 0;
+		for (uint64_t index = first; index < writeCount; index++)
+		{
+			const ZONE_RECORD& record = ring->records[index & (RING_CAPACITY - 1)];
+			double start = static_cast<double>(record.startTicks - g_StartSample.ticks) / ticksPerMicrosecond;
+			double duration = static_cast<double>(record.endTicks - record.startTicks) / ticksPerMicrosecond;
+
+			fprintf(file, "%s\n{\"name\":", (true == bFirstEvent) ? "" : ",");
+			WriteJSONString(file, record.name);
+			fprintf(file, ",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				ring->threadID, start, duration);
+			bFirstEvent = false;
+		}
+		zoneCount += static_cast<size_t>(writeCount - first);
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	std::cout << "INFO: " << zoneCount << " profiler zones written to " << filename << std::endl;
+	return(true);
+}
+
+#endif
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// zoneprofiler.h
+// ==============
+// time scoped zones of the code on every thread, and write them to a Chrome
+// trace event file that can be opened in chrome://tracing or Perfetto
+//
+// A zone is timed from the PROFILE_ZONE() line to the end of the enclosing
+// scope.  The zone names must be string literals, since only the pointer to
+// the name is kept.  Every thread records its zones into its own ring
+// buffer, which keeps the most recent zones and needs no locking, and the
+// timestamps are read from the processor time stamp counter where there is
+// one, or from the steady clock otherwise.
+//
+// The profiler is only compiled in when ENABLE_ZONE_PROFILER is defined.
+// Otherwise the macros expand to nothing and this header declares nothing.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef ENABLE_ZONE_PROFILER
+
+#include <cstdint>
+#include <string>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ZONE_PROFILER_USE_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define ZONE_PROFILER_USE_TSC
+#else
+#include <chrono>
+#endif
+
+namespace ZoneProfiler
+{
+	// read the current timestamp, in ticks that are converted to
+	// microseconds when the trace is written
+	inline uint64_t ReadTimestamp()
+	{
+#ifdef ZONE_PROFILER_USE_TSC
+		return(__rdtsc());
+#else
+		return(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+#endif
+	}
+
+	// record a finished zone in the ring buffer of the calling thread
+	void RecordZone(const char* name, uint64_t startTicks, uint64_t endTicks);
+	// name the calling thread in the trace
+	void SetThreadName(const char* name);
+	// write the recorded zones of all threads - the other threads
+	// should not be recording while the trace is written
+	bool WriteChromeTrace(const std::string& filename);
+
+	// times the scope it is declared in
+	class ScopedZone
+	{
+	public:
+		explicit ScopedZone(const char* name)
+			: m_name(name), m_startTicks(ReadTimestamp())
+		{
+		}
+		~ScopedZone()
+		{
+			RecordZone(m_name, m_startTicks, ReadTimestamp());
+		}
+
+		ScopedZone(const ScopedZone&) = delete;
+		ScopedZone& operator=(const ScopedZone&) = delete;
+
+	private:
+		const char* m_name;
+		uint64_t m_startTicks;
+	};
+}
+
+#define PROFILE_ZONE_VARIABLE_JOIN(prefix, line) prefix##line
+#define PROFILE_ZONE_VARIABLE(prefix, line) PROFILE_ZONE_VARIABLE_JOIN(prefix, line)
+
+// the empty literals only compile for a string literal name
+#define PROFILE_ZONE(name) \
+	ZoneProfiler::ScopedZone PROFILE_ZONE_VARIABLE(profileZone, __LINE__)("" name "")
+#define PROFILE_THREAD_NAME(name) ZoneProfiler::SetThreadName("" name "")
+#define PROFILE_WRITE_TRACE(filename) ZoneProfiler::WriteChromeTrace(filename)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_WRITE_TRACE(filename) (false)
+
+#endif